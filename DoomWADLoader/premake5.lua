@@ -1,6 +1,8 @@
 project "DoomWADLoader"
     kind "ConsoleApp"
     language "C++"
+    -- ExpandToRGBA's gather path is only compiled in with AVX2 on
+    vectorextensions "AVX2"
 
 -- Output Directories ===============
     rootdir = "../"
@@ -14,6 +16,7 @@ project "DoomWADLoader"
         "src/**.cpp",
         "src/**.hpp",
         rootdir .. "Vendor/stb/stb/stb_image.h",
+        rootdir .. "Vendor/stb/stb/stb_image_write.h",
 
         -- The ImGui premake file did not want to work so here we are
         rootdir .. "Vendor/ImGui/ImGui/*.h",
@@ -35,7 +38,8 @@ project "DoomWADLoader"
     }
 
     defines {
-        "STB_IMAGE_IMPLEMENTATION"
+        "STB_IMAGE_IMPLEMENTATION",
+        "STB_IMAGE_WRITE_IMPLEMENTATION"
     }
 
 -- Link libraries ===================
@@ -0,0 +1,113 @@
+#include "Analyze.h"
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <stdio.h>
+#include "NodeBuilder.h"
+
+static void AnalyzeMap(const Map& map, MapReport* report)
+{
+	report->name = map.name;
+	report->things = map.things.size();
+	report->vertices = map.vertices.size();
+	report->lineDefs = map.lineDefs.size();
+	report->sideDefs = map.sideDefs.size();
+	report->sectors = map.sectors.size();
+	report->segments = map.segments.size();
+	report->subSectors = map.subSectors.size();
+	report->nodes = map.nodes.size();
+	report->hasReject = !map.reject.empty();
+	report->hasBlockMap = !map.blockMap.data.empty();
+
+	if (map.vertices.size()) {
+		auto [minX, maxX] = std::minmax_element(map.vertices.x.begin(), map.vertices.x.end());
+		auto [minY, maxY] = std::minmax_element(map.vertices.y.begin(), map.vertices.y.end());
+		report->bounds = { *maxY, *minY, *minX, *maxX };
+	}
+
+	// The BSP check walks segs and vertices, so only run it once the indices are known to be good
+	report->valid = ValidateMap(&map, &report->error);
+	if (report->valid && map.nodes.size()) report->valid = ValidateBSP(&map, &report->error);
+}
+
+void AnalyzeWAD(const std::string& path, WADReport* report)
+{
+	auto start = std::chrono::steady_clock::now();
+	report->path = path;
+
+	WAD wad;
+	report->loaded = TryLoadWAD(path, &wad, &report->error);
+	report->bytes = wad.file.Size();
+	report->signature = wad.signature;
+	report->lumpCount = (uint32_t)wad.lumps.size();
+
+	if (report->loaded) {
+		std::vector<std::pair<uint32_t, uint64_t>> blocks;
+		for (auto& [id, range] : wad.mapBlocks) blocks.push_back({ range.first, id });
+		std::sort(blocks.begin(), blocks.end());
+
+		report->maps.resize(blocks.size());
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			Map map;
+			map.name = UnpackLumpName(blocks[i].second);
+			LoadMap(&wad, &map);
+			AnalyzeMap(map, &report->maps[i]);
+		}
+	}
+
+	report->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string EscapeJSON(const std::string& text)
+{
+	std::string escaped;
+	escaped.reserve(text.size() + 2);
+	for (char c : text) {
+		switch (c) {
+		case '"':  escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\n': escaped += "\\n";  break;
+		case '\r': escaped += "\\r";  break;
+		case '\t': escaped += "\\t";  break;
+		default:
+			if ((uint8_t)c < 0x20) {
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", (uint8_t)c);
+				escaped += code;
+			}
+			else escaped.push_back(c);
+		}
+	}
+	return escaped;
+}
+
+void WriteReportLines(const WADReport& report, std::string* out)
+{
+	std::stringstream lines;
+	std::string file = EscapeJSON(report.path);
+
+	lines << "{\"type\":\"wad\",\"file\":\"" << file << "\",\"bytes\":" << report.bytes
+		<< ",\"loaded\":" << (report.loaded ? "true" : "false");
+	if (!report.loaded) lines << ",\"error\":\"" << EscapeJSON(report.error) << "\"";
+	else {
+		lines << ",\"signature\":\"" << EscapeJSON(report.signature) << "\",\"lumps\":" << report.lumpCount
+			<< ",\"maps\":" << report.maps.size();
+	}
+	lines << ",\"milliseconds\":" << report.milliseconds << "}\n";
+
+	for (const MapReport& map : report.maps) {
+		lines << "{\"type\":\"map\",\"file\":\"" << file << "\",\"map\":\"" << EscapeJSON(map.name) << "\""
+			<< ",\"things\":" << map.things << ",\"vertices\":" << map.vertices
+			<< ",\"lineDefs\":" << map.lineDefs << ",\"sideDefs\":" << map.sideDefs
+			<< ",\"sectors\":" << map.sectors << ",\"segs\":" << map.segments
+			<< ",\"subSectors\":" << map.subSectors << ",\"nodes\":" << map.nodes
+			<< ",\"bounds\":{\"left\":" << map.bounds.left << ",\"bottom\":" << map.bounds.bottom
+			<< ",\"right\":" << map.bounds.right << ",\"top\":" << map.bounds.top << "}"
+			<< ",\"reject\":" << (map.hasReject ? "true" : "false")
+			<< ",\"blockMap\":" << (map.hasBlockMap ? "true" : "false")
+			<< ",\"valid\":" << (map.valid ? "true" : "false");
+		if (!map.valid) lines << ",\"error\":\"" << EscapeJSON(map.error) << "\"";
+		lines << "}\n";
+	}
+	*out += lines.str();
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "Map.h"
+
+struct MapReport {
+	std::string name;
+	size_t things = 0;
+	size_t vertices = 0;
+	size_t lineDefs = 0;
+	size_t sideDefs = 0;
+	size_t sectors = 0;
+	size_t segments = 0;
+	size_t subSectors = 0;
+	size_t nodes = 0;
+	// Bounds of the map's vertices
+	BoundingBox bounds = { 0, 0, 0, 0 };
+	bool hasReject = false;
+	bool hasBlockMap = false;
+	// Set by ValidateMap and ValidateBSP
+	bool valid = false;
+	std::string error;
+};
+
+struct WADReport {
+	std::string path;
+	uint64_t bytes = 0;
+	bool loaded = false;
+	// Why the WAD failed to load
+	std::string error;
+	std::string signature;
+	uint32_t lumpCount = 0;
+	// In the order the maps appear in the WAD
+	std::vector<MapReport> maps;
+	double milliseconds = 0.0;
+};
+
+// Loads a WAD, decodes and validates every map in it. Never fatal, problems end up in the report
+void AnalyzeWAD(const std::string& path, WADReport* report);
+
+// Appends the report as JSON Lines, one "wad" line followed by one "map" line per map
+void WriteReportLines(const WADReport& report, std::string* out);
+std::string EscapeJSON(const std::string& text);
@@ -0,0 +1,196 @@
+#include "BSP.h"
+#include <math.h>
+
+#define PI 3.14159265358979323846
+
+Angle RadiansToAngle(float radians)
+{
+	// Wrap through a 64 bit int so negative angles come out as the matching binary angle
+	double turns = radians / (2.0 * PI);
+	return (Angle)(int64_t)llround((turns - floor(turns)) * 4294967296.0);
+}
+Angle PointToAngle(float x, float y)
+{
+	return RadiansToAngle((float)atan2((double)y, (double)x));
+}
+
+int BSP::PointOnSide(float x, float y, const BSPNode& node)
+{
+	// Axis aligned partitions, same as Doom's R_PointOnSide
+	if (node.xDelta == 0) {
+		if (x <= node.x) return node.yDelta > 0;
+		return node.yDelta < 0;
+	}
+	if (node.yDelta == 0) {
+		if (y <= node.y) return node.xDelta < 0;
+		return node.xDelta > 0;
+	}
+
+	float left = node.yDelta * (x - node.x);
+	float right = (y - node.y) * node.xDelta;
+	return (right < left) ? 0 : 1;
+}
+
+bool BSP::BoxInView(const BoundingBox& box, const BSPView& view, Angle viewAngle, Angle clipAngle)
+{
+	// Which of the 9 regions around the box the view is in
+	int boxX = (view.x <= box.left) ? 0 : (view.x < box.right) ? 1 : 2;
+	int boxY = (view.y >= box.top) ? 0 : (view.y > box.bottom) ? 1 : 2;
+	int boxPos = (boxY << 2) + boxX;
+	if (boxPos == 5) return true;
+
+	// The two corners that make up the box's silhouette from each region
+	// Indexes into { top, bottom, left, right }
+	static const int checkCoord[12][4] = {
+		{ 3, 0, 2, 1 }, { 3, 0, 2, 0 }, { 3, 1, 2, 0 }, { 0, 0, 0, 0 },
+		{ 2, 0, 2, 1 }, { 0, 0, 0, 0 }, { 3, 1, 3, 0 }, { 0, 0, 0, 0 },
+		{ 2, 0, 3, 1 }, { 2, 1, 3, 1 }, { 2, 1, 3, 0 }, { 0, 0, 0, 0 }
+	};
+	const int16_t coords[4] = { box.top, box.bottom, box.left, box.right };
+	const int* check = checkCoord[boxPos];
+
+	Angle angle1 = PointToAngle(coords[check[0]] - view.x, coords[check[1]] - view.y) - viewAngle;
+	Angle angle2 = PointToAngle(coords[check[2]] - view.x, coords[check[3]] - view.y) - viewAngle;
+
+	// Box wraps around the view
+	Angle span = angle1 - angle2;
+	if (span >= ANGLE_180) return true;
+
+	Angle tspan = angle1 + clipAngle;
+	if (tspan > 2 * clipAngle) {
+		tspan -= 2 * clipAngle;
+		// Totally off the left edge
+		if (tspan >= span) return false;
+	}
+	tspan = clipAngle - angle2;
+	if (tspan > 2 * clipAngle) {
+		tspan -= 2 * clipAngle;
+		// Totally off the right edge
+		if (tspan >= span) return false;
+	}
+	return true;
+}
+
+static_assert(sizeof(BSPNode) == 32, "BSPNode should stay 32 bytes");
+
+uint16_t BSP::FindSubSector(float x, float y) const
+{
+	if (nodes.empty()) return 0;
+
+	uint16_t child = 0;
+	while (!(child & SUBSECTOR_FLAG)) {
+		const BSPNode& node = nodes[child];
+		child = node.children[PointOnSide(x, y, node)];
+	}
+	return child & ~SUBSECTOR_FLAG;
+}
+
+void BSP::FindSubSectors(const float* x, const float* y, size_t count, uint16_t* subSectors) const
+{
+	if (nodes.empty()) {
+		for (size_t i = 0; i < count; ++i) subSectors[i] = 0;
+		return;
+	}
+
+	// Each point's walk is a chain of dependent loads, interleaving a group of
+	// walks lets their cache misses overlap instead of waiting on one at a time
+	const size_t GROUP = 8;
+	for (size_t first = 0; first < count; first += GROUP) {
+		size_t groupSize = (count - first < GROUP) ? count - first : GROUP;
+		uint16_t current[GROUP];
+		for (size_t i = 0; i < groupSize; ++i) current[i] = 0;
+
+		size_t remaining = groupSize;
+		while (remaining) {
+			remaining = 0;
+			for (size_t i = 0; i < groupSize; ++i) {
+				if (current[i] & SUBSECTOR_FLAG) continue;
+				const BSPNode& node = nodes[current[i]];
+				current[i] = node.children[PointOnSide(x[first + i], y[first + i], node)];
+				if (!(current[i] & SUBSECTOR_FLAG)) ++remaining;
+			}
+		}
+
+		for (size_t i = 0; i < groupSize; ++i) subSectors[first + i] = current[i] & ~SUBSECTOR_FLAG;
+	}
+}
+
+void BSP::FrontToBack(const BSPView& view, std::vector<uint16_t>* subSectors) const
+{
+	subSectors->clear();
+	TraverseFrontToBack(view, [subSectors](uint16_t subSector) {
+		subSectors->push_back(subSector);
+		return true;
+	});
+}
+
+void BuildBSP(const Map* map, BSP* bsp)
+{
+	const Nodes& source = map->nodes;
+	bsp->nodes.clear();
+	bsp->subSectorCount = (uint32_t)map->subSectors.size();
+	if (source.size() == 0) return;
+	if (source.size() >= SUBSECTOR_FLAG) {
+		FATAL_ERROR("Map has too many nodes ( " + map->name + " )");
+		return;
+	}
+
+	// Doom stores the root last, renumber the nodes in depth first order starting at the root
+	const uint16_t unvisited = 0xFFFF;
+	std::vector<uint16_t> newIndex(source.size(), unvisited);
+	std::vector<uint16_t> order;
+	order.reserve(source.size());
+
+	std::vector<uint16_t> stack;
+	stack.push_back((uint16_t)(source.size() - 1));
+	while (!stack.empty()) {
+		uint16_t node = stack.back();
+		stack.pop_back();
+		if (newIndex[node] != unvisited) continue;
+
+		newIndex[node] = (uint16_t)order.size();
+		order.push_back(node);
+
+		// Right child is pushed last so it's visited next and lands right after its parent
+		for (int side = 1; side >= 0; --side) {
+			uint16_t child = (side == 0) ? source.rightChild[node] : source.leftChild[node];
+			if (child & SUBSECTOR_FLAG) continue;
+			if (child >= source.size()) {
+				SOFT_ERROR("Node has an invalid child ( " + std::to_string(child) + " )");
+				continue;
+			}
+			stack.push_back(child);
+		}
+	}
+
+	bsp->nodes.resize(order.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		uint16_t old = order[i];
+		BSPNode& node = bsp->nodes[i];
+		node.x = source.x[old];
+		node.y = source.y[old];
+		node.xDelta = source.xDelta[old];
+		node.yDelta = source.yDelta[old];
+		node.box[0] = source.rightBox[old];
+		node.box[1] = source.leftBox[old];
+		node.padding = 0;
+
+		uint16_t children[2] = { source.rightChild[old], source.leftChild[old] };
+		for (int side = 0; side < 2; ++side) {
+			uint16_t child = children[side];
+			if (child & SUBSECTOR_FLAG) {
+				if ((child & ~SUBSECTOR_FLAG) >= bsp->subSectorCount) {
+					SOFT_ERROR("Node points to an invalid sub sector ( " + std::to_string(child & ~SUBSECTOR_FLAG) + " )");
+					child = SUBSECTOR_FLAG;
+				}
+				node.children[side] = child;
+			}
+			else if (child >= source.size() || newIndex[child] == unvisited) {
+				node.children[side] = SUBSECTOR_FLAG;
+			}
+			else {
+				node.children[side] = newIndex[child];
+			}
+		}
+	}
+}
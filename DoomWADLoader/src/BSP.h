@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "Map.h"
+
+// Binary angles like Doom uses, the full circle is 2^32
+typedef uint32_t Angle;
+#define ANGLE_90  0x40000000u
+#define ANGLE_180 0x80000000u
+
+Angle PointToAngle(float x, float y);
+Angle RadiansToAngle(float radians);
+
+// Node laid out for traversal, 32 bytes so two nodes share a cache line
+// Nodes are stored in depth first order from the root so the front child is usually next in memory
+struct BSPNode {
+	int16_t x;
+	int16_t y;
+	int16_t xDelta;
+	int16_t yDelta;
+	// [ 0 ] is the right ( front ) child, [ 1 ] is the left ( back ) child
+	BoundingBox box[2];
+	uint16_t children[2];
+	uint32_t padding;
+};
+
+struct BSPView {
+	float x;
+	float y;
+	// Radians, counter clockwise from east like Doom's map space
+	float angle;
+	float fov;
+};
+
+struct BSP {
+	std::vector<BSPNode> nodes;
+	uint32_t subSectorCount = 0;
+
+	// 0 if the point is on the right ( front ) side of the node's partition line, 1 otherwise
+	static int PointOnSide(float x, float y, const BSPNode& node);
+	// Same as Doom's R_CheckBBox without the screen space clip test
+	static bool BoxInView(const BoundingBox& box, const BSPView& view, Angle viewAngle, Angle clipAngle);
+
+	uint16_t FindSubSector(float x, float y) const;
+	// Locates many points at once, walks several points down the tree together to hide memory latency
+	void FindSubSectors(const float* x, const float* y, size_t count, uint16_t* subSectors) const;
+
+	// Sub sectors in front to back order, skipping any whose bounding box is outside the view cone
+	void FrontToBack(const BSPView& view, std::vector<uint16_t>* subSectors) const;
+	// Calls visit( subSector ) front to back, stops early when visit returns false
+	template<typename Func>
+	void TraverseFrontToBack(const BSPView& view, Func&& visit) const;
+};
+
+void BuildBSP(const Map* map, BSP* bsp);
+
+template<typename Func>
+void BSP::TraverseFrontToBack(const BSPView& view, Func&& visit) const
+{
+	if (nodes.empty()) {
+		if (subSectorCount) visit((uint16_t)0);
+		return;
+	}
+
+	Angle viewAngle = RadiansToAngle(view.angle);
+	Angle clipAngle = RadiansToAngle(view.fov * 0.5f);
+
+	// Back children wait on the stack until everything in front of them is visited
+	std::vector<uint16_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		uint16_t child = stack.back();
+		stack.pop_back();
+
+		bool culled = false;
+		while (!(child & SUBSECTOR_FLAG)) {
+			const BSPNode& node = nodes[child];
+			int side = PointOnSide(view.x, view.y, node);
+
+			if (BoxInView(node.box[side ^ 1], view, viewAngle, clipAngle)) {
+				stack.push_back(node.children[side ^ 1]);
+			}
+			if (!BoxInView(node.box[side], view, viewAngle, clipAngle)) {
+				culled = true;
+				break;
+			}
+			child = node.children[side];
+		}
+
+		if (culled) continue;
+		if (!visit((uint16_t)(child & ~SUBSECTOR_FLAG))) return;
+	}
+}
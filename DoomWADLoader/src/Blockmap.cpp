@@ -0,0 +1,395 @@
+#include "Blockmap.h"
+#include <math.h>
+#include <algorithm>
+
+namespace {
+
+	// Sign of the cross product, which side of a -> b the point is on
+	inline int Orientation(float ax, float ay, float bx, float by, float px, float py) {
+		float value = (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+		return (value > 0.0f) - (value < 0.0f);
+	}
+	inline bool OnSegment(float ax, float ay, float bx, float by, float px, float py) {
+		return px >= std::min(ax, bx) && px <= std::max(ax, bx) && py >= std::min(ay, by) && py <= std::max(ay, by);
+	}
+
+	bool SegmentsIntersect(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy) {
+		int o1 = Orientation(ax, ay, bx, by, cx, cy);
+		int o2 = Orientation(ax, ay, bx, by, dx, dy);
+		int o3 = Orientation(cx, cy, dx, dy, ax, ay);
+		int o4 = Orientation(cx, cy, dx, dy, bx, by);
+
+		if (o1 != o2 && o3 != o4) return true;
+		if (o1 == 0 && OnSegment(ax, ay, bx, by, cx, cy)) return true;
+		if (o2 == 0 && OnSegment(ax, ay, bx, by, dx, dy)) return true;
+		if (o3 == 0 && OnSegment(cx, cy, dx, dy, ax, ay)) return true;
+		if (o4 == 0 && OnSegment(cx, cy, dx, dy, bx, by)) return true;
+		return false;
+	}
+
+	// Closed box, touching the edge counts
+	bool SegmentIntersectsBox(float x1, float y1, float x2, float y2, float left, float bottom, float right, float top) {
+		if (std::max(x1, x2) < left || std::min(x1, x2) > right) return false;
+		if (std::max(y1, y2) < bottom || std::min(y1, y2) > top) return false;
+
+		// Boxes overlap, the segment misses only if every corner is on the same side of it
+		int s0 = Orientation(x1, y1, x2, y2, left, bottom);
+		int s1 = Orientation(x1, y1, x2, y2, right, bottom);
+		int s2 = Orientation(x1, y1, x2, y2, right, top);
+		int s3 = Orientation(x1, y1, x2, y2, left, top);
+		if (s0 > 0 && s1 > 0 && s2 > 0 && s3 > 0) return false;
+		if (s0 < 0 && s1 < 0 && s2 < 0 && s3 < 0) return false;
+		return true;
+	}
+
+	// Line and vertex ids come from the map's lumps, false if either doesn't exist
+	bool LineEnds(const Map* map, uint16_t line, float* x1, float* y1, float* x2, float* y2) {
+		const Vertices& vertices = map->vertices;
+		if (line >= map->lineDefs.size()) return false;
+		uint16_t v1 = map->lineDefs.startVertex[line];
+		uint16_t v2 = map->lineDefs.endVertex[line];
+		if (v1 >= vertices.size() || v2 >= vertices.size()) return false;
+		*x1 = vertices.x[v1];
+		*y1 = vertices.y[v1];
+		*x2 = vertices.x[v2];
+		*y2 = vertices.y[v2];
+		return true;
+	}
+
+	// Starts a new query, the stamps are sized for the map the first time it's used
+	void BeginQuery(const Map* map, BlockmapScratch* scratch) {
+		if (scratch->lineStamps.size() != map->lineDefs.size()) {
+			scratch->lineStamps.assign(map->lineDefs.size(), 0);
+			scratch->stamp = 0;
+		}
+		if (++scratch->stamp == 0) {
+			std::fill(scratch->lineStamps.begin(), scratch->lineStamps.end(), 0);
+			scratch->stamp = 1;
+		}
+	}
+
+	// False if the query already looked at the line
+	inline bool Stamp(BlockmapScratch* scratch, uint16_t line) {
+		if (scratch->lineStamps[line] == scratch->stamp) return false;
+		scratch->lineStamps[line] = scratch->stamp;
+		return true;
+	}
+
+	// Calls func( column, row ) for every block the line def touches
+	template<typename Func>
+	void ForEachLineBlock(const Blockmap* blockmap, float x1, float y1, float x2, float y2, Func&& func) {
+		int32_t firstColumn = (int32_t)floorf((std::min(x1, x2) - blockmap->originX) / BLOCK_SIZE);
+		int32_t lastColumn  = (int32_t)floorf((std::max(x1, x2) - blockmap->originX) / BLOCK_SIZE);
+		int32_t firstRow    = (int32_t)floorf((std::min(y1, y2) - blockmap->originY) / BLOCK_SIZE);
+		int32_t lastRow     = (int32_t)floorf((std::max(y1, y2) - blockmap->originY) / BLOCK_SIZE);
+		firstColumn = std::max(firstColumn, 0);
+		firstRow    = std::max(firstRow, 0);
+		lastColumn  = std::min(lastColumn, blockmap->columns - 1);
+		lastRow     = std::min(lastRow, blockmap->rows - 1);
+
+		for (int32_t row = firstRow; row <= lastRow; ++row) {
+			for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+				float left = (float)(blockmap->originX + column * BLOCK_SIZE);
+				float bottom = (float)(blockmap->originY + row * BLOCK_SIZE);
+				if (SegmentIntersectsBox(x1, y1, x2, y2, left, bottom, left + BLOCK_SIZE, bottom + BLOCK_SIZE)) {
+					func(column, row);
+				}
+			}
+		}
+	}
+
+	// Things outside the grid go in the nearest edge block so they're still found near the edge
+	uint32_t ThingBlock(const Blockmap* blockmap, int16_t x, int16_t y) {
+		int32_t column = (int32_t)floorf((float)(x - blockmap->originX) / BLOCK_SIZE);
+		int32_t row = (int32_t)floorf((float)(y - blockmap->originY) / BLOCK_SIZE);
+		column = std::min(std::max(column, 0), blockmap->columns - 1);
+		row = std::min(std::max(row, 0), blockmap->rows - 1);
+		return (uint32_t)(row * blockmap->columns + column);
+	}
+
+	void BuildThingLists(const Map* map, Blockmap* blockmap) {
+		const Things& things = map->things;
+		size_t blockCount = (size_t)blockmap->columns * blockmap->rows;
+
+		std::vector<uint32_t> blockOfThing(things.size());
+		blockmap->thingOffsets.assign(blockCount + 1, 0);
+		for (size_t i = 0; i < things.size(); ++i) {
+			blockOfThing[i] = ThingBlock(blockmap, things.x[i], things.y[i]);
+			++blockmap->thingOffsets[blockOfThing[i] + 1];
+		}
+		for (size_t b = 0; b < blockCount; ++b) blockmap->thingOffsets[b + 1] += blockmap->thingOffsets[b];
+
+		std::vector<uint32_t> next(blockmap->thingOffsets.begin(), blockmap->thingOffsets.end() - 1);
+		blockmap->things.resize(things.size());
+		for (size_t i = 0; i < things.size(); ++i) {
+			blockmap->things[next[blockOfThing[i]]++] = (uint16_t)i;
+		}
+	}
+}
+
+bool Blockmap::BlockAt(float x, float y, int32_t* column, int32_t* row) const
+{
+	*column = (int32_t)floorf((x - originX) / BLOCK_SIZE);
+	*row = (int32_t)floorf((y - originY) / BLOCK_SIZE);
+	return *column >= 0 && *column < columns && *row >= 0 && *row < rows;
+}
+
+void Blockmap::LinesInBox(float left, float bottom, float right, float top, std::vector<uint16_t>* result) const
+{
+	LinesInBox(left, bottom, right, top, result, &m_Scratch);
+}
+
+void Blockmap::LinesInBox(float left, float bottom, float right, float top, std::vector<uint16_t>* result, BlockmapScratch* scratch) const
+{
+	result->clear();
+	if (!map || columns == 0 || rows == 0) return;
+	BeginQuery(map, scratch);
+
+	int32_t firstColumn = std::max((int32_t)floorf((left - originX) / BLOCK_SIZE), 0);
+	int32_t lastColumn  = std::min((int32_t)floorf((right - originX) / BLOCK_SIZE), columns - 1);
+	int32_t firstRow    = std::max((int32_t)floorf((bottom - originY) / BLOCK_SIZE), 0);
+	int32_t lastRow     = std::min((int32_t)floorf((top - originY) / BLOCK_SIZE), rows - 1);
+
+	for (int32_t row = firstRow; row <= lastRow; ++row) {
+		for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+			uint32_t block = row * columns + column;
+			for (uint32_t i = lineOffsets[block]; i < lineOffsets[block + 1]; ++i) {
+				uint16_t line = lines[i];
+				if (!Stamp(scratch, line)) continue;
+
+				float x1, y1, x2, y2;
+				if (!LineEnds(map, line, &x1, &y1, &x2, &y2)) continue;
+				if (SegmentIntersectsBox(x1, y1, x2, y2, left, bottom, right, top)) result->push_back(line);
+			}
+		}
+	}
+}
+
+void Blockmap::LinesAlongSegment(float x1, float y1, float x2, float y2, std::vector<uint16_t>* result) const
+{
+	LinesAlongSegment(x1, y1, x2, y2, result, &m_Scratch);
+}
+
+void Blockmap::LinesAlongSegment(float x1, float y1, float x2, float y2, std::vector<uint16_t>* result, BlockmapScratch* scratch) const
+{
+	result->clear();
+	if (!map || columns == 0 || rows == 0) return;
+	BeginQuery(map, scratch);
+
+	auto visitBlock = [&](int32_t column, int32_t row) {
+		if (column < 0 || column >= columns || row < 0 || row >= rows) return;
+		uint32_t block = row * columns + column;
+		for (uint32_t l = lineOffsets[block]; l < lineOffsets[block + 1]; ++l) {
+			uint16_t line = lines[l];
+			if (!Stamp(scratch, line)) continue;
+
+			float lx1, ly1, lx2, ly2;
+			if (!LineEnds(map, line, &lx1, &ly1, &lx2, &ly2)) continue;
+			if (SegmentsIntersect(x1, y1, x2, y2, lx1, ly1, lx2, ly2)) result->push_back(line);
+		}
+	};
+
+	// Grid DDA, walks the blocks the segment passes through in order
+	float startX = (x1 - originX) / BLOCK_SIZE;
+	float startY = (y1 - originY) / BLOCK_SIZE;
+	float endX = (x2 - originX) / BLOCK_SIZE;
+	float endY = (y2 - originY) / BLOCK_SIZE;
+
+	int32_t column = (int32_t)floorf(startX);
+	int32_t row = (int32_t)floorf(startY);
+	int32_t lastColumn = (int32_t)floorf(endX);
+	int32_t lastRow = (int32_t)floorf(endY);
+
+	float deltaX = endX - startX;
+	float deltaY = endY - startY;
+	int32_t stepX = (lastColumn > column) - (lastColumn < column);
+	int32_t stepY = (lastRow > row) - (lastRow < row);
+
+	// How far along the segment ( 0 to 1 ) the next column / row boundary is
+	float nextX = (stepX != 0) ? ((column + (stepX > 0) - startX) / deltaX) : INFINITY;
+	float nextY = (stepY != 0) ? ((row + (stepY > 0) - startY) / deltaY) : INFINITY;
+	float stepLengthX = (stepX != 0) ? fabsf(1.0f / deltaX) : INFINITY;
+	float stepLengthY = (stepY != 0) ? fabsf(1.0f / deltaY) : INFINITY;
+
+	// Stepping is decided on the block coordinates so rounding in nextX / nextY can't walk past
+	// the last block, once a row or column is used up only the other one moves
+	visitBlock(column, row);
+	while (column != lastColumn || row != lastRow) {
+		if (column != lastColumn && row != lastRow && fabsf(nextX - nextY) < 1e-5f) {
+			// Through a corner, or close enough that rounding could pick the wrong side of it
+			visitBlock(column + stepX, row);
+			visitBlock(column, row + stepY);
+			column += stepX;
+			row += stepY;
+			nextX += stepLengthX;
+			nextY += stepLengthY;
+		}
+		else if (row == lastRow || (column != lastColumn && nextX < nextY)) {
+			column += stepX;
+			nextX += stepLengthX;
+		}
+		else {
+			row += stepY;
+			nextY += stepLengthY;
+		}
+		visitBlock(column, row);
+	}
+}
+
+void Blockmap::ThingsNearPoint(float x, float y, float radius, std::vector<uint16_t>* result) const
+{
+	result->clear();
+	if (!map || columns == 0 || rows == 0) return;
+
+	int32_t firstColumn = std::max((int32_t)floorf((x - radius - originX) / BLOCK_SIZE), 0);
+	int32_t lastColumn  = std::min((int32_t)floorf((x + radius - originX) / BLOCK_SIZE), columns - 1);
+	int32_t firstRow    = std::max((int32_t)floorf((y - radius - originY) / BLOCK_SIZE), 0);
+	int32_t lastRow     = std::min((int32_t)floorf((y + radius - originY) / BLOCK_SIZE), rows - 1);
+
+	const Things& thingData = map->things;
+	float radiusSquared = radius * radius;
+	for (int32_t row = firstRow; row <= lastRow; ++row) {
+		for (int32_t column = firstColumn; column <= lastColumn; ++column) {
+			uint32_t block = row * columns + column;
+			for (uint32_t i = thingOffsets[block]; i < thingOffsets[block + 1]; ++i) {
+				uint16_t thing = things[i];
+				float dx = thingData.x[thing] - x;
+				float dy = thingData.y[thing] - y;
+				if (dx * dx + dy * dy <= radiusSquared) result->push_back(thing);
+			}
+		}
+	}
+}
+
+void InitBlockmap(const Map* map, Blockmap* blockmap)
+{
+	if (!LoadBlockmap(map, blockmap)) BuildBlockmap(map, blockmap);
+}
+
+bool LoadBlockmap(const Map* map, Blockmap* blockmap)
+{
+	const BlockMapLump& lump = map->blockMap;
+	size_t size = lump.data.size();
+	if (size < 4 || lump.columns == 0 || lump.rows == 0) return false;
+
+	size_t blockCount = (size_t)lump.columns * lump.rows;
+	if (4 + blockCount > size) {
+		SOFT_ERROR("BLOCKMAP is too small for its grid ( " + map->name + " )");
+		return false;
+	}
+
+	blockmap->originX = lump.originX;
+	blockmap->originY = lump.originY;
+	blockmap->columns = lump.columns;
+	blockmap->rows = lump.rows;
+	blockmap->lineOffsets.resize(blockCount + 1);
+	blockmap->lines.clear();
+
+	size_t lineCount = map->lineDefs.size();
+	for (size_t b = 0; b < blockCount; ++b) {
+		blockmap->lineOffsets[b] = (uint32_t)blockmap->lines.size();
+
+		size_t offset = lump.data[4 + b];
+		if (offset >= size) {
+			SOFT_ERROR("BLOCKMAP block points outside of the lump ( " + map->name + " )");
+			return false;
+		}
+		// Lists start with a 0 that isn't a line
+		if (lump.data[offset] == 0) ++offset;
+		for (; offset < size && lump.data[offset] != 0xFFFF; ++offset) {
+			uint16_t line = lump.data[offset];
+			if (line < lineCount) blockmap->lines.push_back(line);
+		}
+	}
+	blockmap->lineOffsets[blockCount] = (uint32_t)blockmap->lines.size();
+
+	blockmap->map = map;
+	BuildThingLists(map, blockmap);
+	return true;
+}
+
+void BuildBlockmap(const Map* map, Blockmap* blockmap)
+{
+	const Vertices& vertices = map->vertices;
+	const LineDefs& lineDefs = map->lineDefs;
+
+	int32_t minX = 0, minY = 0, maxX = 0, maxY = 0;
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		if (i == 0 || vertices.x[i] < minX) minX = vertices.x[i];
+		if (i == 0 || vertices.y[i] < minY) minY = vertices.y[i];
+		if (i == 0 || vertices.x[i] > maxX) maxX = vertices.x[i];
+		if (i == 0 || vertices.y[i] > maxY) maxY = vertices.y[i];
+	}
+
+	// Same origin and size rules as the original node builder
+	blockmap->originX = minX - 8;
+	blockmap->originY = minY - 8;
+	blockmap->columns = (maxX - blockmap->originX) / BLOCK_SIZE + 1;
+	blockmap->rows = (maxY - blockmap->originY) / BLOCK_SIZE + 1;
+	blockmap->map = map;
+
+	// Count every block's lines first so the lists can be filled in place
+	size_t blockCount = (size_t)blockmap->columns * blockmap->rows;
+	blockmap->lineOffsets.assign(blockCount + 1, 0);
+	for (size_t i = 0; i < lineDefs.size(); ++i) {
+		float x1, y1, x2, y2;
+		if (!LineEnds(map, (uint16_t)i, &x1, &y1, &x2, &y2)) continue;
+		ForEachLineBlock(blockmap, x1, y1, x2, y2, [blockmap](int32_t column, int32_t row) {
+			++blockmap->lineOffsets[row * blockmap->columns + column + 1];
+		});
+	}
+	for (size_t b = 0; b < blockCount; ++b) blockmap->lineOffsets[b + 1] += blockmap->lineOffsets[b];
+
+	std::vector<uint32_t> next(blockmap->lineOffsets.begin(), blockmap->lineOffsets.end() - 1);
+	blockmap->lines.resize(blockmap->lineOffsets[blockCount]);
+	for (size_t i = 0; i < lineDefs.size(); ++i) {
+		float x1, y1, x2, y2;
+		if (!LineEnds(map, (uint16_t)i, &x1, &y1, &x2, &y2)) continue;
+		ForEachLineBlock(blockmap, x1, y1, x2, y2, [blockmap, &next, i](int32_t column, int32_t row) {
+			blockmap->lines[next[row * blockmap->columns + column]++] = (uint16_t)i;
+		});
+	}
+
+	BuildThingLists(map, blockmap);
+}
+
+bool EncodeBlockmap(const Blockmap* blockmap, std::vector<uint8_t>* lump)
+{
+	size_t blockCount = (size_t)blockmap->columns * blockmap->rows;
+	std::vector<uint16_t> words;
+	words.reserve(4 + blockCount * 2 + blockmap->lines.size());
+	words.push_back((uint16_t)blockmap->originX);
+	words.push_back((uint16_t)blockmap->originY);
+	words.push_back((uint16_t)blockmap->columns);
+	words.push_back((uint16_t)blockmap->rows);
+	words.resize(4 + blockCount);
+
+	// Every empty block shares one list
+	size_t emptyList = SIZE_MAX;
+	for (size_t b = 0; b < blockCount; ++b) {
+		uint32_t first = blockmap->lineOffsets[b];
+		uint32_t last = blockmap->lineOffsets[b + 1];
+		if (first == last && emptyList != SIZE_MAX) {
+			words[4 + b] = (uint16_t)emptyList;
+			continue;
+		}
+
+		size_t offset = words.size();
+		if (first == last) emptyList = offset;
+		if (offset > 0xFFFF) {
+			SOFT_ERROR("BLOCKMAP is too big for 16 bit offsets");
+			return false;
+		}
+		words[4 + b] = (uint16_t)offset;
+		words.push_back(0);
+		for (uint32_t i = first; i < last; ++i) words.push_back(blockmap->lines[i]);
+		words.push_back(0xFFFF);
+	}
+
+	lump->resize(words.size() * 2);
+	for (size_t i = 0; i < words.size(); ++i) {
+		(*lump)[i * 2] = (uint8_t)(words[i] & 0xFF);
+		(*lump)[i * 2 + 1] = (uint8_t)(words[i] >> 8);
+	}
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "Map.h"
+
+// Doom's block size in map units
+#define BLOCK_SIZE 128
+
+// Stamps for lines a query has already looked at, like Doom's validcount
+// Give each thread its own to query one Blockmap from several threads
+struct BlockmapScratch {
+	std::vector<uint32_t> lineStamps;
+	uint32_t stamp = 0;
+};
+
+// Uniform grid over a map, each block lists the line defs and things that touch it
+// Lists are stored flat, block b's lines are lines[ lineOffsets[ b ] ] up to lines[ lineOffsets[ b + 1 ] ]
+// The line queries without a scratch share one inside the Blockmap, so even though they're const
+// they can only be called from one thread at a time
+struct Blockmap {
+	int32_t originX = 0;
+	int32_t originY = 0;
+	int32_t columns = 0;
+	int32_t rows = 0;
+
+	std::vector<uint32_t> lineOffsets;
+	std::vector<uint16_t> lines;
+
+	std::vector<uint32_t> thingOffsets;
+	std::vector<uint16_t> things;
+
+	// Line defs that intersect the box
+	void LinesInBox(float left, float bottom, float right, float top, std::vector<uint16_t>* result) const;
+	void LinesInBox(float left, float bottom, float right, float top, std::vector<uint16_t>* result, BlockmapScratch* scratch) const;
+	// Line defs that cross the segment, roughly ordered from the start of the segment to the end
+	void LinesAlongSegment(float x1, float y1, float x2, float y2, std::vector<uint16_t>* result) const;
+	void LinesAlongSegment(float x1, float y1, float x2, float y2, std::vector<uint16_t>* result, BlockmapScratch* scratch) const;
+	// Things whose position is within radius of the point, safe from any thread
+	void ThingsNearPoint(float x, float y, float radius, std::vector<uint16_t>* result) const;
+
+	// False if the point is outside the grid
+	bool BlockAt(float x, float y, int32_t* column, int32_t* row) const;
+
+	// Set by InitBlockmap, the map has to outlive the Blockmap
+	const Map* map = nullptr;
+
+private:
+	mutable BlockmapScratch m_Scratch;
+};
+
+// Uses the map's BLOCKMAP lump if it has a valid one, builds one from LINEDEFS otherwise
+void InitBlockmap(const Map* map, Blockmap* blockmap);
+// Reads the BLOCKMAP lump, returns false if it's missing or broken
+bool LoadBlockmap(const Map* map, Blockmap* blockmap);
+void BuildBlockmap(const Map* map, Blockmap* blockmap);
+
+// Encodes the line lists as a BLOCKMAP lump, returns false if it's too big for 16 bit offsets
+bool EncodeBlockmap(const Blockmap* blockmap, std::vector<uint8_t>* lump);
@@ -1,8 +1,409 @@
 #include <iostream>
-#include "WAD.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <math.h>
+#include <stb/stb_image_write.h>
+#include "Map.h"
+#include "Textures.h"
+#include "NodeBuilder.h"
+#include "SoftwareRenderer.h"
+#include "Analyze.h"
+#include "WADWriter.h"
+#include "Blockmap.h"
+#include "Tests.h"
 
-int main() {
+// render <wad> <map> <frames> <outdir> [ width ] [ height ]
+// Renders frames along a path that walks out from the player start and back while turning
+// a full circle, writes them as PNGs and reports how fast they rendered
+static int RenderCommand(int argc, char** argv) {
+	if (argc < 6) {
+		std::cout << "Usage: render <wad> <map> <frames> <outdir> [ width ] [ height ]" << std::endl;
+		return 1;
+	}
+	std::string outDir = argv[5];
+	int frames = std::max(1, atoi(argv[4]));
+	uint32_t width = (argc > 6) ? (uint32_t)atoi(argv[6]) : 640;
+	uint32_t height = (argc > 7) ? (uint32_t)atoi(argv[7]) : 400;
+	if (width < 16 || height < 16) {
+		std::cout << "Frame size is too small" << std::endl;
+		return 1;
+	}
 
+	WAD wad;
+	Map map;
+	map.name = argv[3];
+	LoadWAD(argv[2], &wad);
+	LoadMap(&wad, &map);
+	if (map.lineDefs.size() == 0) {
+		std::cout << "Map " << map.name << " not found" << std::endl;
+		return 1;
+	}
+
+	ThreadPool pool;
+	if (map.nodes.size() == 0) {
+		NodeBuilderSettings settings;
+		settings.pool = &pool;
+		BuildNodes(&map, settings);
+	}
+
+	BSP bsp;
+	BuildBSP(&map, &bsp);
+	TextureAtlas atlas;
+	BuildTextureAtlas(&wad, &pool, &atlas);
+	SoftwareRenderer renderer(&wad, &map, &bsp, &atlas, width, height);
+
+	// Start where player 1 does, or in the middle of the map if there's no start
+	float startX = 0.0f, startY = 0.0f, startAngle = 0.0f;
+	bool foundStart = false;
+	for (size_t i = 0; i < map.things.size(); ++i) {
+		if (map.things.type[i] != 1) continue;
+		startX = map.things.x[i];
+		startY = map.things.y[i];
+		startAngle = map.things.angle[i] * 3.14159265f / 180.0f;
+		foundStart = true;
+		break;
+	}
+	if (!foundStart && map.vertices.size()) {
+		auto [minX, maxX] = std::minmax_element(map.vertices.x.begin(), map.vertices.x.end());
+		auto [minY, maxY] = std::minmax_element(map.vertices.y.begin(), map.vertices.y.end());
+		startX = (*minX + *maxX) * 0.5f;
+		startY = (*minY + *maxY) * 0.5f;
+	}
+
+	std::filesystem::create_directories(outDir);
+	double renderSeconds = 0.0;
+	auto totalStart = std::chrono::steady_clock::now();
+
+	for (int frame = 0; frame < frames; ++frame) {
+		float t = (float)frame / frames;
+		RenderCamera camera;
+		camera.angle = startAngle + t * 2.0f * 3.14159265f;
+		float walk = sinf(t * 3.14159265f) * 128.0f;
+		camera.x = startX + cosf(startAngle) * walk;
+		camera.y = startY + sinf(startAngle) * walk;
+		camera.z = renderer.GetFloorHeight(camera.x, camera.y) + PLAYER_HEIGHT;
+
+		auto frameStart = std::chrono::steady_clock::now();
+		renderer.Render(camera, &pool);
+		renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+
+		char name[32];
+		snprintf(name, sizeof(name), "frame_%04d.png", frame);
+		std::string path = (std::filesystem::path(outDir) / name).string();
+		if (!stbi_write_png(path.c_str(), width, height, 4, renderer.GetFramebuffer().data(), width * 4)) {
+			SOFT_ERROR("Failed to write frame ( " + path + " )");
+		}
+	}
+	double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - totalStart).count();
+
+	const RenderStats& stats = renderer.GetStats();
+	std::cout << "Render =======================" << std::endl;
+	std::cout << "Frames: " << frames << " at " << width << "x" << height << " on " << pool.GetThreadCount() << " threads" << std::endl;
+	std::cout << "Render: " << frames / renderSeconds << " frames/sec ( " << renderSeconds * 1000.0 / frames << "ms per frame )" << std::endl;
+	std::cout << "Total: " << frames / totalSeconds << " frames/sec with PNG output" << std::endl;
+	std::cout << "Last Frame: " << stats.subSectors << " sub sectors, " << stats.segments << " segs, "
+		<< stats.wallColumns << " wall columns, " << stats.visplanes << " visplanes, " << stats.spans << " spans" << std::endl;
+	return 0;
+}
+
+// analyze [ -o report.jsonl ] [ -j threads ] <wad or directory> ...
+// Loads and validates every WAD on a thread pool and streams a JSON Lines report, each file's
+// lines are written as soon as it's done. The last line is a summary with the throughput.
+// Debug builds print soft errors to stdout, so use -o to keep the report clean
+static int AnalyzeCommand(int argc, char** argv) {
+	std::string outPath;
+	size_t threads = 0;
+	std::vector<std::string> files;
+
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc) {
+			outPath = argv[++i];
+			continue;
+		}
+		if (arg == "-j" && i + 1 < argc) {
+			threads = (size_t)std::max(1, atoi(argv[++i]));
+			continue;
+		}
+
+		// Directories are searched for anything ending in .wad, files are taken as they are
+		std::error_code error;
+		if (!std::filesystem::is_directory(arg, error)) {
+			files.push_back(arg);
+			continue;
+		}
+		for (auto& entry : std::filesystem::recursive_directory_iterator(arg, std::filesystem::directory_options::skip_permission_denied, error)) {
+			if (!entry.is_regular_file(error)) continue;
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			if (extension == ".wad") files.push_back(entry.path().string());
+		}
+	}
+	if (files.empty()) {
+		std::cout << "Usage: analyze [ -o report.jsonl ] [ -j threads ] <wad or directory> ..." << std::endl;
+		return 1;
+	}
+	// Largest first so a big file picked up last doesn't leave the other threads idle
+	std::vector<std::pair<uintmax_t, std::string>> sized;
+	for (auto& file : files) {
+		std::error_code error;
+		uintmax_t size = std::filesystem::file_size(file, error);
+		sized.push_back({ error ? 0 : size, file });
+	}
+	std::sort(sized.begin(), sized.end(), [](auto& a, auto& b) { return a.first > b.first; });
+
+	std::ofstream outFile;
+	if (!outPath.empty()) {
+		outFile.open(outPath, std::ios::binary);
+		if (!outFile) {
+			std::cout << "Failed to open ( " << outPath << " )" << std::endl;
+			return 1;
+		}
+	}
+	std::ostream& out = outPath.empty() ? std::cout : outFile;
+
+	ThreadPool pool(threads);
+	std::mutex outMutex;
+	size_t failed = 0, maps = 0, invalidMaps = 0;
+	uint64_t bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	pool.ParallelFor(sized.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			WADReport report;
+			AnalyzeWAD(sized[i].second, &report);
+			std::string lines;
+			WriteReportLines(report, &lines);
+
+			std::lock_guard<std::mutex> lock(outMutex);
+			out << lines;
+			out.flush();
+			bytes += report.bytes;
+			maps += report.maps.size();
+			if (!report.loaded) failed++;
+			for (auto& map : report.maps) if (!map.valid) invalidMaps++;
+		}
+	});
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	out << "{\"type\":\"summary\",\"files\":" << sized.size() << ",\"failed\":" << failed
+		<< ",\"maps\":" << maps << ",\"invalidMaps\":" << invalidMaps << ",\"bytes\":" << bytes
+		<< ",\"threads\":" << pool.GetThreadCount() << ",\"seconds\":" << seconds
+		<< ",\"filesPerSecond\":" << sized.size() / seconds
+		<< ",\"mbPerSecond\":" << bytes / (1024.0 * 1024.0) / seconds << "}" << std::endl;
+	return failed ? 2 : 0;
+}
+
+// repack <in> <out> [ alignment ]
+// Rewrites a WAD with aligned and deduplicated lumps, then loads both and checks every lump came through the same
+static int RepackCommand(int argc, char** argv) {
+	if (argc < 4) {
+		std::cout << "Usage: repack <in> <out> [ alignment ]" << std::endl;
+		return 1;
+	}
+	uint32_t alignment = (argc > 4) ? (uint32_t)std::max(1, atoi(argv[4])) : 4;
+
+	std::string error;
+	WADWriterStats stats;
+	auto start = std::chrono::steady_clock::now();
+	if (!RepackWAD(argv[2], argv[3], alignment, &stats, &error)) {
+		std::cout << error << std::endl;
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	WAD before, after;
+	std::string difference;
+	bool same = TryLoadWAD(argv[2], &before, &error) && TryLoadWAD(argv[3], &after, &error) && CompareWADs(&before, &after, &difference);
+	double inputMB = before.file.Size() / (1024.0 * 1024.0);
+
+	std::cout << "Repack =======================" << std::endl;
+	std::cout << "Lumps: " << stats.lumps << " ( " << stats.uniquePayloads << " unique payloads )" << std::endl;
+	std::cout << "Size: " << before.file.Size() << " -> " << stats.bytesWritten << " bytes ( "
+		<< stats.bytesShared << " shared, " << stats.paddingBytes << " padding )" << std::endl;
+	std::cout << "Time: " << seconds * 1000.0 << "ms ( " << inputMB / seconds << " MB/sec )" << std::endl;
+	std::cout << "Round Trip: " << (same ? "identical" : "MISMATCH " + difference + error) << std::endl;
+	return same ? 0 : 2;
+}
+
+// blockmap <wad> <map> [ queries ]
+// Times random box, segment and thing queries against the map's blockmap, then the same queries
+// spread over a thread pool with a scratch per batch
+static int BlockmapCommand(int argc, char** argv) {
+	if (argc < 4) {
+		std::cout << "Usage: blockmap <wad> <map> [ queries ]" << std::endl;
+		return 1;
+	}
+	size_t queryCount = (argc > 4) ? (size_t)std::max(1, atoi(argv[4])) : 200000;
+
+	WAD wad;
+	Map map;
+	map.name = argv[3];
+	LoadWAD(argv[2], &wad);
+	LoadMap(&wad, &map);
+	if (map.lineDefs.size() == 0) {
+		std::cout << "Map " << map.name << " not found" << std::endl;
+		return 1;
+	}
+
+	Blockmap blockmap;
+	bool loaded = LoadBlockmap(&map, &blockmap);
+	if (!loaded) BuildBlockmap(&map, &blockmap);
+
+	// Roughly what a game asks for, boxes the size of a monster's move and segments up to a hitscan's range
+	struct Query {
+		float x1, y1, x2, y2;
+		float radius;
+	};
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float width = (float)(blockmap.columns * BLOCK_SIZE), height = (float)(blockmap.rows * BLOCK_SIZE);
+	std::vector<Query> queries(queryCount);
+	for (Query& query : queries) {
+		query.x1 = blockmap.originX + unit(random) * width;
+		query.y1 = blockmap.originY + unit(random) * height;
+		float angle = unit(random) * 6.2831853f, length = unit(random) * 2048.0f;
+		query.x2 = query.x1 + cosf(angle) * length;
+		query.y2 = query.y1 + sinf(angle) * length;
+		query.radius = 16.0f + unit(random) * 112.0f;
+	}
+
+	size_t boxLines = 0, segmentLines = 0, things = 0;
+	std::vector<uint16_t> result;
+	auto time = [&](auto&& func) {
+		auto start = std::chrono::steady_clock::now();
+		for (const Query& query : queries) func(query);
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	double boxSeconds = time([&](const Query& query) {
+		blockmap.LinesInBox(query.x1 - query.radius, query.y1 - query.radius, query.x1 + query.radius, query.y1 + query.radius, &result);
+		boxLines += result.size();
+	});
+	double segmentSeconds = time([&](const Query& query) {
+		blockmap.LinesAlongSegment(query.x1, query.y1, query.x2, query.y2, &result);
+		segmentLines += result.size();
+	});
+	double thingSeconds = time([&](const Query& query) {
+		blockmap.ThingsNearPoint(query.x1, query.y1, query.radius * 4.0f, &result);
+		things += result.size();
+	});
+
+	ThreadPool pool;
+	auto poolStart = std::chrono::steady_clock::now();
+	pool.ParallelFor(queries.size(), 1024, [&](size_t begin, size_t end) {
+		BlockmapScratch scratch;
+		std::vector<uint16_t> lines;
+		for (size_t i = begin; i < end; ++i) {
+			const Query& query = queries[i];
+			blockmap.LinesInBox(query.x1 - query.radius, query.y1 - query.radius, query.x1 + query.radius, query.y1 + query.radius, &lines, &scratch);
+			blockmap.LinesAlongSegment(query.x1, query.y1, query.x2, query.y2, &lines, &scratch);
+			blockmap.ThingsNearPoint(query.x1, query.y1, query.radius * 4.0f, &lines);
+		}
+	});
+	double poolSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - poolStart).count();
+
+	double count = (double)queries.size();
+	std::cout << "Blockmap =====================" << std::endl;
+	std::cout << "Grid: " << blockmap.columns << "x" << blockmap.rows << ", " << map.lineDefs.size() << " lines, "
+		<< map.things.size() << " things" << (loaded ? "" : " ( built, no BLOCKMAP lump )") << std::endl;
+	std::cout << "Box: " << count / boxSeconds << " queries/sec ( " << boxLines / count << " lines per query )" << std::endl;
+	std::cout << "Segment: " << count / segmentSeconds << " queries/sec ( " << segmentLines / count << " lines per query )" << std::endl;
+	std::cout << "Things: " << count / thingSeconds << " queries/sec ( " << things / count << " things per query )" << std::endl;
+	std::cout << "All Three: " << count / poolSeconds << " queries/sec on " << pool.GetThreadCount() << " threads" << std::endl;
+	return 0;
+}
+
+// pictures <wad> [ passes ]
+// Decodes every patch, sprite and flat in the WAD and expands them to RGBA, reports megapixels/sec
+// for decoding and for the RGBA expansion with and without SIMD
+static int PicturesCommand(int argc, char** argv) {
+	if (argc < 3) {
+		std::cout << "Usage: pictures <wad> [ passes ]" << std::endl;
+		return 1;
+	}
+	int passes = (argc > 3) ? std::max(1, atoi(argv[3])) : 10;
+
+	WAD wad;
+	LoadWAD(argv[2], &wad);
+	std::vector<Palette> palettes;
+	if (!LoadPalettes(&wad, &palettes)) {
+		// Greys so WADs without a PLAYPAL can still be timed
+		palettes.resize(1);
+		for (int i = 0; i < 256; ++i) palettes[0].colors[i][0] = palettes[0].colors[i][1] = palettes[0].colors[i][2] = (uint8_t)i;
+	}
+	RGBALookup lookup;
+	BuildLookup(palettes[0], nullptr, &lookup);
+
+	// Patches can be in P_ or S_, flats in F_
+	std::vector<std::pair<uint32_t, bool>> pictures;
+	for (const char* prefix : { "P", "S", "F" }) {
+		LumpRange range;
+		if (!wad.GetNamespace(prefix, &range)) continue;
+		for (uint32_t i = range.first; i < range.last; ++i) {
+			if (wad.lumps[i].size) pictures.push_back({ i, prefix[0] == 'F' });
+		}
+	}
+
+	std::vector<Image> images(pictures.size());
+	size_t failed = 0;
+	uint64_t pixels = 0;
+	auto decodeStart = std::chrono::steady_clock::now();
+	for (int pass = 0; pass < passes; ++pass) {
+		failed = 0;
+		pixels = 0;
+		for (size_t i = 0; i < pictures.size(); ++i) {
+			const Lump& lump = wad.lumps[pictures[i].first];
+			bool decoded = pictures[i].second ? DecodeFlat(lump, &images[i]) : DecodePatch(lump, &images[i]);
+			if (!decoded) {
+				images[i] = Image();
+				failed++;
+			}
+			pixels += (uint64_t)images[i].width * images[i].height;
+		}
+	}
+	double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+
+	std::vector<uint32_t> rgba;
+	auto time = [&](auto expand) {
+		auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; ++pass) {
+			for (const Image& image : images) {
+				size_t count = (size_t)image.width * image.height;
+				rgba.resize(count);
+				expand(image.pixels.data(), image.mask.data(), count, lookup, rgba.data());
+			}
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	double expandSeconds = time(ExpandToRGBA);
+	double scalarSeconds = time(ExpandToRGBAScalar);
+
+	double megapixels = (double)pixels * passes / 1000000.0;
+#ifdef __AVX2__
+	const char* expandPath = "AVX2";
+#else
+	const char* expandPath = "scalar";
+#endif
+	std::cout << "Pictures =====================" << std::endl;
+	std::cout << "Count: " << pictures.size() << " ( " << failed << " failed to decode ), " << pixels << " pixels" << std::endl;
+	std::cout << "Decode: " << megapixels / decodeSeconds << " MP/sec" << std::endl;
+	std::cout << "RGBA: " << megapixels / expandSeconds << " MP/sec ( " << expandPath << " ), "
+		<< megapixels / scalarSeconds << " MP/sec ( scalar )" << std::endl;
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1 && std::string(argv[1]) == "render") return RenderCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "analyze") return AnalyzeCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "repack") return RepackCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "blockmap") return BlockmapCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "pictures") return PicturesCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "test") return TestCommand(argc, argv);
+	if (argc > 1 && std::string(argv[1]) == "bench") return BenchCommand(argc, argv);
 
 	WAD wad;
 	Map map;
@@ -16,5 +417,16 @@ int main() {
 
 	std::cout << GenerateConsoleText(&wad, &map, &config) << std::endl;
 
+	ThreadPool pool;
+	TextureAtlas atlas;
+	TextureAtlasStats atlasStats;
+	if (BuildTextureAtlas(&wad, &pool, &atlas, &atlasStats, "assets/textures.cache")) {
+		std::cout << "Textures =====================" << std::endl;
+		std::cout << "Count: " << atlasStats.textures << " ( " << atlasStats.uniquePatches << " unique patches )" << std::endl;
+		std::cout << "Compose Time: " << atlasStats.composeMilliseconds << "ms" << (atlasStats.fromCache ? " ( cached )" : "") << std::endl;
+		std::cout << "Pack Time: " << atlasStats.packMilliseconds << "ms" << std::endl;
+		std::cout << "Atlas: " << atlas.image.width << "x" << atlas.image.height << ", " << (int)(atlasStats.occupancy * 100.0) << "% used" << std::endl;
+	}
+
 	return 0;
-}
\ No newline at end of file
+}
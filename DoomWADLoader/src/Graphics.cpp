@@ -0,0 +1,191 @@
+#include "Graphics.h"
+#include <math.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+bool LoadPalettes(WAD* wad, std::vector<Palette>* palettes)
+{
+	palettes->clear();
+	int32_t id = wad->FindLump("PLAYPAL");
+	if (id < 0) return false;
+
+	const Lump& lump = wad->lumps[id];
+	size_t count = lump.size / PALETTE_SIZE;
+	palettes->resize(count);
+	if (count) memcpy(palettes->data(), lump.data, count * PALETTE_SIZE);
+	return count != 0;
+}
+
+bool LoadColorMaps(WAD* wad, std::vector<ColorMap>* colorMaps)
+{
+	colorMaps->clear();
+	int32_t id = wad->FindLump("COLORMAP");
+	if (id < 0) return false;
+
+	const Lump& lump = wad->lumps[id];
+	size_t count = lump.size / COLORMAP_SIZE;
+	colorMaps->resize(count);
+	if (count) memcpy(colorMaps->data(), lump.data, count * COLORMAP_SIZE);
+	return count != 0;
+}
+
+bool DecodeFlat(const Lump& lump, Image* image)
+{
+	// Anything square works, vanilla flats are always 64 x 64
+	uint32_t size = (uint32_t)sqrt((double)lump.size);
+	if (size == 0 || size * size > lump.size) return false;
+
+	image->width = size;
+	image->height = size;
+	image->leftOffset = 0;
+	image->topOffset = 0;
+	image->pixels.assign(lump.data, lump.data + size * size);
+	image->mask.assign(size * size, 1);
+	return true;
+}
+
+bool DecodePatch(const Lump& lump, Image* image)
+{
+	const uint8_t* data = lump.data;
+	if (lump.size < 8) return false;
+
+	uint32_t width = ReadUInt16(data);
+	uint32_t height = ReadUInt16(data + 2);
+	if (width == 0 || height == 0 || 8 + width * 4 > lump.size) return false;
+
+	image->width = width;
+	image->height = height;
+	image->leftOffset = ReadInt16(data + 4);
+	image->topOffset = ReadInt16(data + 6);
+	image->pixels.assign(width * height, 0);
+	image->mask.assign(width * height, 0);
+
+	for (uint32_t x = 0; x < width; ++x) {
+		uint32_t offset = ReadUInt32(data + 8 + x * 4);
+		int32_t top = -1;
+
+		// Each post is: top delta, length, padding, pixels, padding. 0xFF ends the column
+		while (offset < lump.size && data[offset] != 0xFF) {
+			if (offset + 2 > lump.size) return false;
+			uint32_t delta = data[offset];
+			uint32_t length = data[offset + 1];
+
+			// Tall patches add to the previous top once the delta stops increasing
+			if ((int32_t)delta <= top) top += delta;
+			else top = delta;
+
+			const uint8_t* post = data + offset + 3;
+			if (offset + 4 + length > lump.size) return false;
+
+			for (uint32_t y = 0; y < length; ++y) {
+				uint32_t row = top + y;
+				if (row >= height) break;
+				image->pixels[row * width + x] = post[y];
+				image->mask[row * width + x] = 1;
+			}
+			offset += 4 + length;
+		}
+	}
+	return true;
+}
+
+void BuildLookup(const Palette& palette, const ColorMap* colorMap, RGBALookup* lookup)
+{
+	for (int i = 0; i < 256; ++i) {
+		uint8_t index = colorMap ? colorMap->indices[i] : (uint8_t)i;
+		const uint8_t* color = palette.colors[index];
+		lookup->colors[i] = (uint32_t)color[0] | ((uint32_t)color[1] << 8) | ((uint32_t)color[2] << 16) | 0xFF000000u;
+	}
+}
+
+void BuildShadedLookups(const Palette& palette, const std::vector<ColorMap>& colorMaps, std::vector<RGBALookup>* lookups)
+{
+	lookups->resize(colorMaps.size());
+	for (size_t i = 0; i < colorMaps.size(); ++i) {
+		BuildLookup(palette, &colorMaps[i], &(*lookups)[i]);
+	}
+}
+
+void ExpandToRGBA(const uint8_t* pixels, const uint8_t* mask, size_t count, const RGBALookup& lookup, uint32_t* rgba)
+{
+	size_t i = 0;
+
+#ifdef __AVX2__
+	// 8 pixels at a time, the indices are widened to ints and gathered straight out of the lookup
+	const int* table = (const int*)lookup.colors;
+	const __m256i zero = _mm256_setzero_si256();
+	for (; i + 8 <= count; i += 8) {
+		__m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(pixels + i)));
+		__m256i colors = _mm256_i32gather_epi32(table, indices, 4);
+		if (mask) {
+			__m256i visible = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + i)));
+			colors = _mm256_andnot_si256(_mm256_cmpeq_epi32(visible, zero), colors);
+		}
+		_mm256_storeu_si256((__m256i*)(rgba + i), colors);
+	}
+#endif
+
+	ExpandToRGBAScalar(pixels + i, mask ? mask + i : nullptr, count - i, lookup, rgba + i);
+}
+
+void ExpandToRGBAScalar(const uint8_t* pixels, const uint8_t* mask, size_t count, const RGBALookup& lookup, uint32_t* rgba)
+{
+	if (mask) {
+		for (size_t i = 0; i < count; ++i) rgba[i] = mask[i] ? lookup.colors[pixels[i]] : 0;
+	}
+	else {
+		for (size_t i = 0; i < count; ++i) rgba[i] = lookup.colors[pixels[i]];
+	}
+}
+
+void ImageToRGBA(const Image& image, const RGBALookup& lookup, std::vector<uint32_t>* rgba)
+{
+	size_t count = (size_t)image.width * image.height;
+	rgba->resize(count);
+	ExpandToRGBA(image.pixels.data(), image.mask.data(), count, lookup, rgba->data());
+}
+
+const Image* ImageCache::GetPatch(uint32_t lumpIndex)
+{
+	return Get(lumpIndex, false);
+}
+const Image* ImageCache::GetFlat(uint32_t lumpIndex)
+{
+	return Get(lumpIndex, true);
+}
+
+const Image* ImageCache::Get(uint32_t lumpIndex, bool flat)
+{
+	if (lumpIndex >= m_WAD->lumps.size()) return nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto it = m_Images.find(lumpIndex);
+		if (it != m_Images.end()) return it->second.width ? &it->second : nullptr;
+	}
+
+	// Decode without holding the lock, if another thread beat us to it its image is kept
+	Image image;
+	const Lump& lump = m_WAD->lumps[lumpIndex];
+	bool decoded = flat ? DecodeFlat(lump, &image) : DecodePatch(lump, &image);
+	if (!decoded) {
+		SOFT_ERROR("Failed to decode picture ( " + lump.name + " )");
+		image = Image();
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto result = m_Images.emplace(lumpIndex, std::move(image));
+	return result.first->second.width ? &result.first->second : nullptr;
+}
+
+size_t ImageCache::GetSize()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Images.size();
+}
+void ImageCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Images.clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <stdint.h>
+#include "WAD.h"
+
+#define PALETTE_SIZE  (sizeof(char) * 768)
+#define COLORMAP_SIZE (sizeof(char) * 256)
+#define FLAT_SIZE     64
+
+struct Palette {
+	uint8_t colors[256][3];
+};
+// Maps a palette index to a darker ( or inverted ) palette index, COLORMAP has 34 of them
+struct ColorMap {
+	uint8_t indices[256];
+};
+
+// 8 bit picture, pixels index a palette and mask is 0 where the picture is see through
+// Stored row by row from the top left
+struct Image {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	int16_t leftOffset = 0;
+	int16_t topOffset = 0;
+	std::vector<uint8_t> pixels;
+	std::vector<uint8_t> mask;
+};
+
+// Palette index to a packed RGBA8 color ( r in the low byte ), built once per palette and light level
+struct RGBALookup {
+	uint32_t colors[256];
+};
+
+bool LoadPalettes(WAD* wad, std::vector<Palette>* palettes);
+bool LoadColorMaps(WAD* wad, std::vector<ColorMap>* colorMaps);
+
+// Flats are raw square blocks of pixels, usually 64 x 64
+bool DecodeFlat(const Lump& lump, Image* image);
+// Patches are stored as columns of posts, supports tall patches that use relative post offsets
+bool DecodePatch(const Lump& lump, Image* image);
+
+// colorMap can be null for full brightness
+void BuildLookup(const Palette& palette, const ColorMap* colorMap, RGBALookup* lookup);
+// One lookup per color map, so shading at any light level is a single table lookup
+void BuildShadedLookups(const Palette& palette, const std::vector<ColorMap>& colorMaps, std::vector<RGBALookup>* lookups);
+
+// Expands count indices to RGBA, masked out pixels become 0 ( transparent black )
+// mask can be null if every pixel is solid. Uses AVX2 gathers when built with AVX2
+void ExpandToRGBA(const uint8_t* pixels, const uint8_t* mask, size_t count, const RGBALookup& lookup, uint32_t* rgba);
+// One pixel at a time, what the AVX2 path is tested and timed against
+void ExpandToRGBAScalar(const uint8_t* pixels, const uint8_t* mask, size_t count, const RGBALookup& lookup, uint32_t* rgba);
+void ImageToRGBA(const Image& image, const RGBALookup& lookup, std::vector<uint32_t>* rgba);
+
+// Decoded pictures keyed by lump index, safe to use from several threads
+// Returned images stay valid until the cache is cleared or destroyed
+class ImageCache {
+public:
+	ImageCache(WAD* wad)
+		: m_WAD(wad) { }
+
+	const Image* GetPatch(uint32_t lumpIndex);
+	const Image* GetFlat(uint32_t lumpIndex);
+
+	size_t GetSize();
+	void Clear();
+
+private:
+	const Image* Get(uint32_t lumpIndex, bool flat);
+
+private:
+	WAD* m_WAD;
+	std::mutex m_Mutex;
+	// Images that failed to decode are stored with a width of 0 so they aren't retried
+	std::unordered_map<uint32_t, Image> m_Images;
+};
@@ -0,0 +1,257 @@
+#include "Map.h"
+
+void Things::resize(size_t count) {
+	x.resize(count);
+	y.resize(count);
+	angle.resize(count);
+	type.resize(count);
+	flags.resize(count);
+}
+void Vertices::resize(size_t count) {
+	x.resize(count);
+	y.resize(count);
+}
+void LineDefs::resize(size_t count) {
+	startVertex.resize(count);
+	endVertex.resize(count);
+	flags.resize(count);
+	special.resize(count);
+	tag.resize(count);
+	frontSide.resize(count);
+	backSide.resize(count);
+}
+void SideDefs::resize(size_t count) {
+	xOffset.resize(count);
+	yOffset.resize(count);
+	upperTexture.resize(count);
+	lowerTexture.resize(count);
+	middleTexture.resize(count);
+	sector.resize(count);
+}
+void Segments::resize(size_t count) {
+	startVertex.resize(count);
+	endVertex.resize(count);
+	angle.resize(count);
+	lineDef.resize(count);
+	direction.resize(count);
+	offset.resize(count);
+}
+void SubSectors::resize(size_t count) {
+	segmentCount.resize(count);
+	firstSegment.resize(count);
+}
+void Nodes::resize(size_t count) {
+	x.resize(count);
+	y.resize(count);
+	xDelta.resize(count);
+	yDelta.resize(count);
+	rightBox.resize(count);
+	leftBox.resize(count);
+	rightChild.resize(count);
+	leftChild.resize(count);
+}
+void Sectors::resize(size_t count) {
+	floorHeight.resize(count);
+	ceilingHeight.resize(count);
+	floorTexture.resize(count);
+	ceilingTexture.resize(count);
+	lightLevel.resize(count);
+	specialType.resize(count);
+	tagNumber.resize(count);
+}
+
+// Copies one field of every record straight out of the lump into dst
+// Going a field at a time keeps each loop a fixed stride copy the compiler can unroll
+template<typename T>
+void DecodeField(std::vector<T>& dst, const uint8_t* data, size_t stride, size_t offset) {
+	T* out = dst.data();
+	size_t count = dst.size();
+	data += offset;
+	for (size_t i = 0; i < count; ++i) {
+		memcpy(&out[i], data + i * stride, sizeof(T));
+	}
+}
+// Texture names, "-" means no texture and is stored as 0
+void DecodeNameField(std::vector<uint64_t>& dst, const uint8_t* data, size_t stride, size_t offset) {
+	const uint64_t none = PackLumpName("-");
+	size_t count = dst.size();
+	data += offset;
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t name = PackLumpName((const char*)data + i * stride, 8);
+		dst[i] = (name == none) ? 0 : name;
+	}
+}
+
+// Returns the lump called name inside the map block or nullptr, count is how many whole records it holds
+const Lump* FindMapLump(WAD* wad, const LumpRange& block, const std::string& name, size_t recordSize, size_t* count) {
+	*count = 0;
+	int32_t id = wad->FindLump(name, block.first, block.last);
+	if (id < 0) return nullptr;
+
+	const Lump& lump = wad->lumps[id];
+	if (lump.size % recordSize != 0) {
+		SOFT_ERROR("Lump size isn't a multiple of its record size ( " + name + " )");
+	}
+	*count = lump.size / recordSize;
+	return &lump;
+}
+
+void LoadMap(WAD* wad, Map* map)
+{
+	LumpRange block;
+	if (!wad->GetMapLumps(map->name, &block)) {
+		FATAL_ERROR("Map doesn't exist ( " + map->name + " )");
+		return;
+	}
+
+	const Lump* lump;
+	size_t count;
+
+	if ((lump = FindMapLump(wad, block, "THINGS", THING_SIZE, &count))) {
+		Things& things = map->things;
+		things.resize(count);
+		DecodeField(things.x,     lump->data, THING_SIZE, 0);
+		DecodeField(things.y,     lump->data, THING_SIZE, 2);
+		DecodeField(things.angle, lump->data, THING_SIZE, 4);
+		DecodeField(things.type,  lump->data, THING_SIZE, 6);
+		DecodeField(things.flags, lump->data, THING_SIZE, 8);
+	}
+
+	if ((lump = FindMapLump(wad, block, "LINEDEFS", LINEDEF_SIZE, &count))) {
+		LineDefs& lineDefs = map->lineDefs;
+		lineDefs.resize(count);
+		DecodeField(lineDefs.startVertex, lump->data, LINEDEF_SIZE, 0);
+		DecodeField(lineDefs.endVertex,   lump->data, LINEDEF_SIZE, 2);
+		DecodeField(lineDefs.flags,       lump->data, LINEDEF_SIZE, 4);
+		DecodeField(lineDefs.special,     lump->data, LINEDEF_SIZE, 6);
+		DecodeField(lineDefs.tag,         lump->data, LINEDEF_SIZE, 8);
+		DecodeField(lineDefs.frontSide,   lump->data, LINEDEF_SIZE, 10);
+		DecodeField(lineDefs.backSide,    lump->data, LINEDEF_SIZE, 12);
+	}
+
+	if ((lump = FindMapLump(wad, block, "SIDEDEFS", SIDEDEF_SIZE, &count))) {
+		SideDefs& sideDefs = map->sideDefs;
+		sideDefs.resize(count);
+		DecodeField(sideDefs.xOffset,           lump->data, SIDEDEF_SIZE, 0);
+		DecodeField(sideDefs.yOffset,           lump->data, SIDEDEF_SIZE, 2);
+		DecodeNameField(sideDefs.upperTexture,  lump->data, SIDEDEF_SIZE, 4);
+		DecodeNameField(sideDefs.lowerTexture,  lump->data, SIDEDEF_SIZE, 12);
+		DecodeNameField(sideDefs.middleTexture, lump->data, SIDEDEF_SIZE, 20);
+		DecodeField(sideDefs.sector,            lump->data, SIDEDEF_SIZE, 28);
+	}
+
+	if ((lump = FindMapLump(wad, block, "VERTEXES", VERTEX_SIZE, &count))) {
+		Vertices& vertices = map->vertices;
+		vertices.resize(count);
+		DecodeField(vertices.x, lump->data, VERTEX_SIZE, 0);
+		DecodeField(vertices.y, lump->data, VERTEX_SIZE, 2);
+	}
+
+	if ((lump = FindMapLump(wad, block, "SEGS", SEG_SIZE, &count))) {
+		Segments& segments = map->segments;
+		segments.resize(count);
+		DecodeField(segments.startVertex, lump->data, SEG_SIZE, 0);
+		DecodeField(segments.endVertex,   lump->data, SEG_SIZE, 2);
+		DecodeField(segments.angle,       lump->data, SEG_SIZE, 4);
+		DecodeField(segments.lineDef,     lump->data, SEG_SIZE, 6);
+		DecodeField(segments.direction,   lump->data, SEG_SIZE, 8);
+		DecodeField(segments.offset,      lump->data, SEG_SIZE, 10);
+	}
+
+	if ((lump = FindMapLump(wad, block, "SSECTORS", SSECTOR_SIZE, &count))) {
+		SubSectors& subSectors = map->subSectors;
+		subSectors.resize(count);
+		DecodeField(subSectors.segmentCount, lump->data, SSECTOR_SIZE, 0);
+		DecodeField(subSectors.firstSegment, lump->data, SSECTOR_SIZE, 2);
+	}
+
+	if ((lump = FindMapLump(wad, block, "NODES", NODE_SIZE, &count))) {
+		Nodes& nodes = map->nodes;
+		nodes.resize(count);
+		DecodeField(nodes.x,          lump->data, NODE_SIZE, 0);
+		DecodeField(nodes.y,          lump->data, NODE_SIZE, 2);
+		DecodeField(nodes.xDelta,     lump->data, NODE_SIZE, 4);
+		DecodeField(nodes.yDelta,     lump->data, NODE_SIZE, 6);
+		// Boxes are stored top, bottom, left, right which matches BoundingBox
+		DecodeField(nodes.rightBox,   lump->data, NODE_SIZE, 8);
+		DecodeField(nodes.leftBox,    lump->data, NODE_SIZE, 16);
+		DecodeField(nodes.rightChild, lump->data, NODE_SIZE, 24);
+		DecodeField(nodes.leftChild,  lump->data, NODE_SIZE, 26);
+	}
+
+	if ((lump = FindMapLump(wad, block, "SECTORS", SECTOR_SIZE, &count))) {
+		Sectors& sectors = map->sectors;
+		sectors.resize(count);
+		DecodeField(sectors.floorHeight,        lump->data, SECTOR_SIZE, 0);
+		DecodeField(sectors.ceilingHeight,      lump->data, SECTOR_SIZE, 2);
+		DecodeNameField(sectors.floorTexture,   lump->data, SECTOR_SIZE, 4);
+		DecodeNameField(sectors.ceilingTexture, lump->data, SECTOR_SIZE, 12);
+		DecodeField(sectors.lightLevel,         lump->data, SECTOR_SIZE, 20);
+		DecodeField(sectors.specialType,        lump->data, SECTOR_SIZE, 22);
+		DecodeField(sectors.tagNumber,          lump->data, SECTOR_SIZE, 24);
+	}
+
+	if ((lump = FindMapLump(wad, block, "REJECT", 1, &count))) {
+		map->reject.assign(lump->data, lump->data + count);
+	}
+
+	if ((lump = FindMapLump(wad, block, "BLOCKMAP", 2, &count)) && count >= 4) {
+		BlockMapLump& blockMap = map->blockMap;
+		blockMap.data.resize(count);
+		DecodeField(blockMap.data, lump->data, 2, 0);
+		blockMap.originX = (int16_t)blockMap.data[0];
+		blockMap.originY = (int16_t)blockMap.data[1];
+		blockMap.columns = blockMap.data[2];
+		blockMap.rows    = blockMap.data[3];
+	}
+}
+
+bool ValidateMap(const Map* map, std::string* error)
+{
+	auto fail = [&](const std::string& message) {
+		*error = message;
+		return false;
+	};
+
+	if (map->lineDefs.size() == 0) return fail("Map has no line defs");
+	if (map->sectors.size() == 0) return fail("Map has no sectors");
+
+	const LineDefs& lineDefs = map->lineDefs;
+	for (size_t i = 0; i < lineDefs.size(); ++i) {
+		if (lineDefs.startVertex[i] >= map->vertices.size() || lineDefs.endVertex[i] >= map->vertices.size())
+			return fail("Line def " + std::to_string(i) + " uses a vertex that doesn't exist");
+		if (lineDefs.frontSide[i] >= map->sideDefs.size())
+			return fail("Line def " + std::to_string(i) + " has no front side");
+		if (lineDefs.backSide[i] != NO_SIDEDEF && lineDefs.backSide[i] >= map->sideDefs.size())
+			return fail("Line def " + std::to_string(i) + " uses a side def that doesn't exist");
+	}
+
+	for (size_t i = 0; i < map->sideDefs.size(); ++i) {
+		if (map->sideDefs.sector[i] >= map->sectors.size())
+			return fail("Side def " + std::to_string(i) + " uses a sector that doesn't exist");
+	}
+
+	const Segments& segments = map->segments;
+	for (size_t i = 0; i < segments.size(); ++i) {
+		if (segments.startVertex[i] >= map->vertices.size() || segments.endVertex[i] >= map->vertices.size())
+			return fail("Seg " + std::to_string(i) + " uses a vertex that doesn't exist");
+		if (segments.lineDef[i] >= lineDefs.size())
+			return fail("Seg " + std::to_string(i) + " uses a line def that doesn't exist");
+	}
+
+	for (size_t i = 0; i < map->subSectors.size(); ++i) {
+		if ((size_t)map->subSectors.firstSegment[i] + map->subSectors.segmentCount[i] > segments.size())
+			return fail("Sub sector " + std::to_string(i) + " uses segs that don't exist");
+	}
+
+	const Nodes& nodes = map->nodes;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		for (uint16_t child : { nodes.rightChild[i], nodes.leftChild[i] }) {
+			bool valid = (child & SUBSECTOR_FLAG)
+				? (size_t)(child & ~SUBSECTOR_FLAG) < map->subSectors.size()
+				: child < nodes.size();
+			if (!valid) return fail("Node " + std::to_string(i) + " has a child that doesn't exist");
+		}
+	}
+	return true;
+}
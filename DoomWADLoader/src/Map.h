@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "WAD.h"
+
+#define THING_SIZE   (sizeof(char) * 10)
+#define LINEDEF_SIZE (sizeof(char) * 14)
+#define SIDEDEF_SIZE (sizeof(char) * 30)
+#define VERTEX_SIZE  (sizeof(char) * 4)
+#define SEG_SIZE     (sizeof(char) * 12)
+#define SSECTOR_SIZE (sizeof(char) * 4)
+#define NODE_SIZE    (sizeof(char) * 28)
+#define SECTOR_SIZE  (sizeof(char) * 26)
+
+// Side and child values with special meaning
+#define NO_SIDEDEF       0xFFFF
+#define SUBSECTOR_FLAG   0x8000
+
+// Map data is stored as structure of arrays, entry i of every array in a struct
+// belongs to record i of the lump
+// Texture and flat names are packed with PackLumpName, 0 means no texture ( "-" )
+
+struct Things {
+	std::vector<int16_t> x;
+	std::vector<int16_t> y;
+	std::vector<int16_t> angle;
+	std::vector<int16_t> type;
+	std::vector<int16_t> flags;
+
+	size_t size() const { return x.size(); }
+	void resize(size_t count);
+};
+struct Vertices {
+	std::vector<int16_t> x;
+	std::vector<int16_t> y;
+
+	size_t size() const { return x.size(); }
+	void resize(size_t count);
+};
+struct LineDefs {
+	std::vector<uint16_t> startVertex;
+	std::vector<uint16_t> endVertex;
+	std::vector<uint16_t> flags;
+	std::vector<uint16_t> special;
+	std::vector<uint16_t> tag;
+	// NO_SIDEDEF if the line is one sided
+	std::vector<uint16_t> frontSide;
+	std::vector<uint16_t> backSide;
+
+	size_t size() const { return startVertex.size(); }
+	void resize(size_t count);
+};
+struct SideDefs {
+	std::vector<int16_t> xOffset;
+	std::vector<int16_t> yOffset;
+	std::vector<uint64_t> upperTexture;
+	std::vector<uint64_t> lowerTexture;
+	std::vector<uint64_t> middleTexture;
+	std::vector<uint16_t> sector;
+
+	size_t size() const { return xOffset.size(); }
+	void resize(size_t count);
+};
+struct Segments {
+	std::vector<uint16_t> startVertex;
+	std::vector<uint16_t> endVertex;
+	// Binary angle, 0x4000 is 90 degrees
+	std::vector<int16_t> angle;
+	std::vector<uint16_t> lineDef;
+	// 0 if the seg runs the same way as its line def, 1 if it's on the back side
+	std::vector<int16_t> direction;
+	std::vector<int16_t> offset;
+
+	size_t size() const { return startVertex.size(); }
+	void resize(size_t count);
+};
+struct SubSectors {
+	std::vector<uint16_t> segmentCount;
+	std::vector<uint16_t> firstSegment;
+
+	size_t size() const { return segmentCount.size(); }
+	void resize(size_t count);
+};
+
+struct BoundingBox {
+	int16_t top;
+	int16_t bottom;
+	int16_t left;
+	int16_t right;
+};
+struct Nodes {
+	// Partition line
+	std::vector<int16_t> x;
+	std::vector<int16_t> y;
+	std::vector<int16_t> xDelta;
+	std::vector<int16_t> yDelta;
+	std::vector<BoundingBox> rightBox;
+	std::vector<BoundingBox> leftBox;
+	// Child is a sub sector if SUBSECTOR_FLAG is set
+	std::vector<uint16_t> rightChild;
+	std::vector<uint16_t> leftChild;
+
+	size_t size() const { return x.size(); }
+	void resize(size_t count);
+};
+struct Sectors {
+	std::vector<int16_t> floorHeight;
+	std::vector<int16_t> ceilingHeight;
+	std::vector<uint64_t> floorTexture;
+	std::vector<uint64_t> ceilingTexture;
+	std::vector<int16_t> lightLevel;
+	std::vector<int16_t> specialType;
+	std::vector<int16_t> tagNumber;
+
+	size_t size() const { return floorHeight.size(); }
+	void resize(size_t count);
+};
+
+struct BlockMapLump {
+	int16_t originX = 0;
+	int16_t originY = 0;
+	uint16_t columns = 0;
+	uint16_t rows = 0;
+	// The whole lump as 16 bit words, block offsets index into this
+	std::vector<uint16_t> data;
+};
+
+struct Map {
+	std::string name;
+
+	Things things;
+	Vertices vertices;
+	LineDefs lineDefs;
+	SideDefs sideDefs;
+	Segments segments;
+	SubSectors subSectors;
+	Nodes nodes;
+	Sectors sectors;
+
+	// One bit per sector pair, empty if the map has no REJECT lump
+	std::vector<uint8_t> reject;
+	BlockMapLump blockMap;
+};
+
+// Decodes every lump of a map, lumps that are missing are left empty
+void LoadMap(WAD* wad, Map* map);
+// Checks that every index in the map points at something that exists, error describes the first problem found
+bool ValidateMap(const Map* map, std::string* error);
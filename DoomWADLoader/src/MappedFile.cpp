@@ -0,0 +1,95 @@
+#include "MappedFile.h"
+
+#ifdef PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef PLATFORM_WINDOWS
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	m_File = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	m_Size = (size_t)size.QuadPart;
+
+	m_Mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m_Mapping) {
+		Close();
+		return false;
+	}
+
+	m_Data = (const uint8_t*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_Data) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_Data) UnmapViewOfFile(m_Data);
+	if (m_Mapping) CloseHandle(m_Mapping);
+	if (m_File) CloseHandle(m_File);
+	m_Data = nullptr;
+	m_Mapping = nullptr;
+	m_File = nullptr;
+	m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File < 0) return false;
+
+	struct stat info;
+	if (fstat(m_File, &info) != 0 || info.st_size == 0) {
+		Close();
+		return false;
+	}
+	m_Size = (size_t)info.st_size;
+
+	void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+	m_Data = (const uint8_t*)data;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_Data) munmap((void*)m_Data, m_Size);
+	if (m_File >= 0) close(m_File);
+	m_Data = nullptr;
+	m_File = -1;
+	m_Size = 0;
+}
+
+#endif
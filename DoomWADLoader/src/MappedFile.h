@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+// Read only memory mapping of a whole file
+// The mapping stays valid until Close is called or the MappedFile is destroyed
+class MappedFile {
+public:
+	MappedFile() { }
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+	const uint8_t* Data() const { return m_Data; }
+	size_t Size() const { return m_Size; }
+
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#ifdef PLATFORM_WINDOWS
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+};
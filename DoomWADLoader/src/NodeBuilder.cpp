@@ -0,0 +1,530 @@
+#include "NodeBuilder.h"
+#include "BSP.h"
+#include <chrono>
+#include <limits>
+#include <math.h>
+
+namespace {
+
+	// Every seg endpoint is a whole map unit vertex, so sides can be worked out exactly with ints
+	struct BuildSeg {
+		int32_t x1, y1;
+		int32_t x2, y2;
+		uint16_t v1, v2;
+		uint16_t lineDef;
+		int16_t direction;
+		// Distance from the start of the line def ( or its end on the back side ) to the seg's start
+		double offset;
+	};
+
+	struct Partition {
+		int32_t x, y;
+		int32_t xDelta, yDelta;
+	};
+
+	enum SegSide {
+		SideFront,
+		SideBack,
+		SideSplit
+	};
+
+	// > 0 in front ( right ) of the partition, < 0 behind it, same convention as BSP::PointOnSide
+	inline int64_t SideValue(const Partition& p, int64_t x, int64_t y) {
+		return (int64_t)p.yDelta * (x - p.x) - (int64_t)p.xDelta * (y - p.y);
+	}
+
+	Partition MakePartition(const BuildSeg& seg) {
+		Partition p = { seg.x1, seg.y1, seg.x2 - seg.x1, seg.y2 - seg.y1 };
+		// Nodes store the delta as 16 bit, halving keeps the direction
+		while (p.xDelta > INT16_MAX || p.xDelta < INT16_MIN || p.yDelta > INT16_MAX || p.yDelta < INT16_MIN) {
+			p.xDelta /= 2;
+			p.yDelta /= 2;
+		}
+		return p;
+	}
+
+	// Where the seg ends up, for a split the intersection is returned in ix, iy
+	SegSide ClassifySeg(const Partition& p, const BuildSeg& seg, int32_t* ix = nullptr, int32_t* iy = nullptr) {
+		int64_t a = SideValue(p, seg.x1, seg.y1);
+		int64_t b = SideValue(p, seg.x2, seg.y2);
+
+		if (a == 0 && b == 0) {
+			// On the partition line, goes in front if it faces the same way
+			int64_t dot = (int64_t)(seg.x2 - seg.x1) * p.xDelta + (int64_t)(seg.y2 - seg.y1) * p.yDelta;
+			return (dot > 0) ? SideFront : SideBack;
+		}
+		if (a >= 0 && b >= 0) return SideFront;
+		if (a <= 0 && b <= 0) return SideBack;
+
+		// Split point gets rounded to a whole vertex, if that lands on an end the seg isn't really split
+		double t = (double)a / (double)(a - b);
+		int32_t x = (int32_t)lround(seg.x1 + t * (seg.x2 - seg.x1));
+		int32_t y = (int32_t)lround(seg.y1 + t * (seg.y2 - seg.y1));
+		if ((x == seg.x1 && y == seg.y1) || (x == seg.x2 && y == seg.y2)) {
+			int64_t far = (llabs(a) > llabs(b)) ? a : b;
+			return (far > 0) ? SideFront : SideBack;
+		}
+
+		if (ix) *ix = x;
+		if (iy) *iy = y;
+		return SideSplit;
+	}
+
+	BoundingBox EmptyBox() {
+		return { INT16_MIN, INT16_MAX, INT16_MAX, INT16_MIN };
+	}
+	void AddToBox(BoundingBox& box, int32_t x, int32_t y) {
+		if (y > box.top)    box.top = (int16_t)y;
+		if (y < box.bottom) box.bottom = (int16_t)y;
+		if (x < box.left)   box.left = (int16_t)x;
+		if (x > box.right)  box.right = (int16_t)x;
+	}
+
+	class NodeBuilder {
+	public:
+		NodeBuilder(Map* map, const NodeBuilderSettings& settings, NodeBuilderStats* stats)
+			: m_Map(map), m_Settings(settings), m_Stats(stats) { }
+
+		bool Build() {
+			std::vector<BuildSeg> segs;
+			CreateSegs(segs);
+			m_Stats->segments = segs.size();
+
+			m_Map->segments.resize(0);
+			m_Map->subSectors.resize(0);
+			m_Map->nodes.resize(0);
+			m_Failed = false;
+
+			if (segs.empty()) {
+				m_Failed = true;
+				SOFT_ERROR("Map has no line defs to build nodes from ( " + m_Map->name + " )");
+				return false;
+			}
+
+			BoundingBox box;
+			BuildChild(segs, &box);
+
+			m_Stats->nodes = m_Map->nodes.size();
+			m_Stats->subSectors = m_Map->subSectors.size();
+			m_Stats->segments = m_Map->segments.size();
+			return !m_Failed;
+		}
+
+	private:
+		void CreateSegs(std::vector<BuildSeg>& segs) {
+			const LineDefs& lineDefs = m_Map->lineDefs;
+			const Vertices& vertices = m_Map->vertices;
+			segs.reserve(lineDefs.size() * 2);
+
+			for (size_t i = 0; i < lineDefs.size(); ++i) {
+				uint16_t v1 = lineDefs.startVertex[i];
+				uint16_t v2 = lineDefs.endVertex[i];
+				if (v1 >= vertices.size() || v2 >= vertices.size()) {
+					SOFT_ERROR("Line def has an invalid vertex ( " + std::to_string(i) + " )");
+					continue;
+				}
+				if (vertices.x[v1] == vertices.x[v2] && vertices.y[v1] == vertices.y[v2]) continue;
+
+				BuildSeg seg;
+				seg.lineDef = (uint16_t)i;
+				seg.offset = 0.0;
+				if (lineDefs.frontSide[i] != NO_SIDEDEF) {
+					seg.v1 = v1;
+					seg.v2 = v2;
+					seg.direction = 0;
+					SetPosition(seg);
+					segs.push_back(seg);
+				}
+				if (lineDefs.backSide[i] != NO_SIDEDEF) {
+					seg.v1 = v2;
+					seg.v2 = v1;
+					seg.direction = 1;
+					SetPosition(seg);
+					segs.push_back(seg);
+				}
+			}
+		}
+		void SetPosition(BuildSeg& seg) {
+			seg.x1 = m_Map->vertices.x[seg.v1];
+			seg.y1 = m_Map->vertices.y[seg.v1];
+			seg.x2 = m_Map->vertices.x[seg.v2];
+			seg.y2 = m_Map->vertices.y[seg.v2];
+		}
+
+		// Returns the child id ( SUBSECTOR_FLAG set for sub sectors ) and the box around all of segs
+		uint16_t BuildChild(std::vector<BuildSeg>& segs, BoundingBox* box) {
+			*box = EmptyBox();
+			for (auto& seg : segs) {
+				AddToBox(*box, seg.x1, seg.y1);
+				AddToBox(*box, seg.x2, seg.y2);
+			}
+
+			size_t partition = ChoosePartition(segs);
+			if (partition == SIZE_MAX) return AddSubSector(segs);
+
+			Partition p = MakePartition(segs[partition]);
+			std::vector<BuildSeg> front;
+			std::vector<BuildSeg> back;
+			SplitSegs(p, segs, front, back);
+			// The caller's list isn't needed anymore, free it before going deeper
+			std::vector<BuildSeg>().swap(segs);
+
+			BoundingBox frontBox;
+			BoundingBox backBox;
+			uint16_t frontChild = BuildChild(front, &frontBox);
+			uint16_t backChild = BuildChild(back, &backBox);
+
+			return AddNode(p, frontBox, backBox, frontChild, backChild);
+		}
+
+		// Index of the best seg to split along, SIZE_MAX if segs is already convex
+		size_t ChoosePartition(const std::vector<BuildSeg>& segs) {
+			size_t count = segs.size();
+			size_t stride = 1;
+			if (m_Settings.candidateLimit && count > m_Settings.candidateLimit) {
+				stride = (count + m_Settings.candidateLimit - 1) / m_Settings.candidateLimit;
+			}
+			size_t candidateCount = (count + stride - 1) / stride;
+
+			const int64_t invalid = std::numeric_limits<int64_t>::max();
+			std::vector<int64_t> costs(candidateCount, invalid);
+
+			auto evaluate = [&](size_t begin, size_t end) {
+				for (size_t c = begin; c < end; ++c) {
+					Partition p = MakePartition(segs[c * stride]);
+					int64_t front = 0;
+					int64_t back = 0;
+					int64_t splits = 0;
+					for (const BuildSeg& seg : segs) {
+						switch (ClassifySeg(p, seg)) {
+						case SideFront: ++front; break;
+						case SideBack:  ++back;  break;
+						case SideSplit: ++splits; break;
+						}
+					}
+					// A partition has to leave something on both sides or nothing gets smaller
+					if (front + splits == 0 || back + splits == 0) continue;
+					costs[c] = splits * m_Settings.splitWeight + llabs(front - back);
+				}
+			};
+
+			if (m_Settings.pool && count >= m_Settings.parallelThreshold) {
+				m_Settings.pool->ParallelFor(candidateCount, 16, evaluate);
+			}
+			else {
+				evaluate(0, candidateCount);
+			}
+
+			// Lowest index wins ties so the output doesn't depend on thread timing
+			size_t best = SIZE_MAX;
+			for (size_t c = 0; c < candidateCount; ++c) {
+				if (costs[c] == invalid) continue;
+				if (best == SIZE_MAX || costs[c] < costs[best]) best = c;
+			}
+			if (best != SIZE_MAX) return best * stride;
+
+			// Sampling can miss the only useful lines, check every seg before calling this convex
+			if (stride != 1) {
+				for (size_t i = 0; i < count; ++i) {
+					Partition p = MakePartition(segs[i]);
+					bool hasFront = false;
+					bool hasBack = false;
+					for (const BuildSeg& seg : segs) {
+						SegSide side = ClassifySeg(p, seg);
+						if (side != SideBack) hasFront = true;
+						if (side != SideFront) hasBack = true;
+						if (hasFront && hasBack) return i;
+					}
+				}
+			}
+			return SIZE_MAX;
+		}
+
+		void SplitSegs(const Partition& p, const std::vector<BuildSeg>& segs, std::vector<BuildSeg>& front, std::vector<BuildSeg>& back) {
+			front.reserve(segs.size());
+			back.reserve(segs.size());
+
+			for (const BuildSeg& seg : segs) {
+				int32_t x, y;
+				SegSide side = ClassifySeg(p, seg, &x, &y);
+				if (side == SideFront) {
+					front.push_back(seg);
+					continue;
+				}
+				if (side == SideBack) {
+					back.push_back(seg);
+					continue;
+				}
+
+				uint16_t vertex = AddVertex(x, y);
+				BuildSeg first = seg;
+				first.v2 = vertex;
+				first.x2 = x;
+				first.y2 = y;
+
+				BuildSeg second = seg;
+				second.v1 = vertex;
+				second.x1 = x;
+				second.y1 = y;
+				second.offset = seg.offset + hypot((double)(x - seg.x1), (double)(y - seg.y1));
+
+				++m_Stats->splits;
+				if (SideValue(p, seg.x1, seg.y1) > 0) {
+					front.push_back(first);
+					back.push_back(second);
+				}
+				else {
+					back.push_back(first);
+					front.push_back(second);
+				}
+			}
+		}
+
+		uint16_t AddVertex(int32_t x, int32_t y) {
+			Vertices& vertices = m_Map->vertices;
+			if (vertices.size() >= 0xFFFF) {
+				if (!m_Failed) SOFT_ERROR("Too many vertices for the VERTEXES lump ( " + m_Map->name + " )");
+				m_Failed = true;
+				return 0;
+			}
+			vertices.x.push_back((int16_t)x);
+			vertices.y.push_back((int16_t)y);
+			++m_Stats->newVertices;
+			return (uint16_t)(vertices.size() - 1);
+		}
+
+		uint16_t AddSubSector(const std::vector<BuildSeg>& segs) {
+			Segments& out = m_Map->segments;
+			SubSectors& subSectors = m_Map->subSectors;
+			if (subSectors.size() >= SUBSECTOR_FLAG || out.size() + segs.size() > 0xFFFF) {
+				if (!m_Failed) SOFT_ERROR("Too many segs for the SSECTORS lump ( " + m_Map->name + " )");
+				m_Failed = true;
+				return SUBSECTOR_FLAG;
+			}
+
+			subSectors.firstSegment.push_back((uint16_t)out.size());
+			subSectors.segmentCount.push_back((uint16_t)segs.size());
+
+			for (const BuildSeg& seg : segs) {
+				Angle angle = PointToAngle((float)(seg.x2 - seg.x1), (float)(seg.y2 - seg.y1));
+				out.startVertex.push_back(seg.v1);
+				out.endVertex.push_back(seg.v2);
+				out.angle.push_back((int16_t)(angle >> 16));
+				out.lineDef.push_back(seg.lineDef);
+				out.direction.push_back(seg.direction);
+				out.offset.push_back((int16_t)lround(seg.offset));
+			}
+			return (uint16_t)((subSectors.size() - 1) | SUBSECTOR_FLAG);
+		}
+
+		uint16_t AddNode(const Partition& p, const BoundingBox& frontBox, const BoundingBox& backBox, uint16_t frontChild, uint16_t backChild) {
+			Nodes& nodes = m_Map->nodes;
+			if (nodes.size() >= SUBSECTOR_FLAG) {
+				if (!m_Failed) SOFT_ERROR("Too many nodes for the NODES lump ( " + m_Map->name + " )");
+				m_Failed = true;
+				return SUBSECTOR_FLAG;
+			}
+
+			// Children are added first, so the root ends up last like Doom expects
+			nodes.x.push_back((int16_t)p.x);
+			nodes.y.push_back((int16_t)p.y);
+			nodes.xDelta.push_back((int16_t)p.xDelta);
+			nodes.yDelta.push_back((int16_t)p.yDelta);
+			nodes.rightBox.push_back(frontBox);
+			nodes.leftBox.push_back(backBox);
+			nodes.rightChild.push_back(frontChild);
+			nodes.leftChild.push_back(backChild);
+			return (uint16_t)(nodes.size() - 1);
+		}
+
+	private:
+		Map* m_Map;
+		const NodeBuilderSettings& m_Settings;
+		NodeBuilderStats* m_Stats;
+		bool m_Failed = false;
+	};
+
+	void Write16(std::vector<uint8_t>& data, uint16_t value) {
+		data.push_back((uint8_t)(value & 0xFF));
+		data.push_back((uint8_t)(value >> 8));
+	}
+	void WriteBox(std::vector<uint8_t>& data, const BoundingBox& box) {
+		Write16(data, (uint16_t)box.top);
+		Write16(data, (uint16_t)box.bottom);
+		Write16(data, (uint16_t)box.left);
+		Write16(data, (uint16_t)box.right);
+	}
+
+	struct Validator {
+		const Map* map;
+		std::string* error;
+		std::vector<uint8_t> nodeSeen;
+		std::vector<uint8_t> subSectorSeen;
+		std::vector<uint8_t> segSeen;
+
+		// Ancestors of the current child and which side of them it's on
+		struct Step {
+			uint16_t node;
+			int side;
+		};
+		std::vector<Step> path;
+
+		bool Fail(const std::string& message) {
+			if (error) *error = message;
+			return false;
+		}
+
+		bool CheckChild(uint16_t child) {
+			if (child & SUBSECTOR_FLAG) return CheckSubSector(child & ~SUBSECTOR_FLAG);
+
+			const Nodes& nodes = map->nodes;
+			if (child >= nodes.size()) return Fail("Node " + std::to_string(child) + " doesn't exist");
+			if (nodeSeen[child]) return Fail("Node " + std::to_string(child) + " is reached more than once");
+			nodeSeen[child] = 1;
+			if (nodes.xDelta[child] == 0 && nodes.yDelta[child] == 0) return Fail("Node " + std::to_string(child) + " has no partition line");
+
+			path.push_back({ child, 0 });
+			if (!CheckChild(nodes.rightChild[child])) return false;
+			path.back().side = 1;
+			if (!CheckChild(nodes.leftChild[child])) return false;
+			path.pop_back();
+			return true;
+		}
+
+		bool CheckSubSector(uint16_t subSector) {
+			const SubSectors& subSectors = map->subSectors;
+			const Segments& segments = map->segments;
+			const Vertices& vertices = map->vertices;
+			std::string name = "Sub sector " + std::to_string(subSector);
+
+			if (subSector >= subSectors.size()) return Fail(name + " doesn't exist");
+			if (subSectorSeen[subSector]) return Fail(name + " is reached more than once");
+			subSectorSeen[subSector] = 1;
+
+			size_t first = subSectors.firstSegment[subSector];
+			size_t count = subSectors.segmentCount[subSector];
+			if (count == 0) return Fail(name + " has no segs");
+			if (first + count > segments.size()) return Fail(name + " has segs past the end of SEGS");
+
+			for (size_t s = first; s < first + count; ++s) {
+				std::string segName = "Seg " + std::to_string(s);
+				if (segSeen[s]) return Fail(segName + " belongs to more than one sub sector");
+				segSeen[s] = 1;
+
+				uint16_t v1 = segments.startVertex[s];
+				uint16_t v2 = segments.endVertex[s];
+				if (v1 >= vertices.size() || v2 >= vertices.size()) return Fail(segName + " has an invalid vertex");
+				if (segments.lineDef[s] >= map->lineDefs.size()) return Fail(segName + " has an invalid line def");
+
+				double x1 = vertices.x[v1], y1 = vertices.y[v1];
+				double x2 = vertices.x[v2], y2 = vertices.y[v2];
+				double mx = (x1 + x2) * 0.5;
+				double my = (y1 + y2) * 0.5;
+
+				for (const Step& step : path) {
+					const Nodes& nodes = map->nodes;
+					const BoundingBox& box = (step.side == 0) ? nodes.rightBox[step.node] : nodes.leftBox[step.node];
+					if (x1 < box.left || x1 > box.right || x2 < box.left || x2 > box.right ||
+						y1 < box.bottom || y1 > box.top || y2 < box.bottom || y2 > box.top) {
+						return Fail(segName + " is outside the box of node " + std::to_string(step.node));
+					}
+
+					// Split points are rounded to whole units, so allow segs to be a unit off the line
+					double dx = nodes.xDelta[step.node];
+					double dy = nodes.yDelta[step.node];
+					double distance = (dy * (mx - nodes.x[step.node]) - dx * (my - nodes.y[step.node])) / sqrt(dx * dx + dy * dy);
+					if (distance > 1.0 && step.side == 1) return Fail(segName + " is in front of node " + std::to_string(step.node) + " but on its back side");
+					if (distance < -1.0 && step.side == 0) return Fail(segName + " is behind node " + std::to_string(step.node) + " but on its front side");
+				}
+			}
+			return true;
+		}
+	};
+}
+
+bool BuildNodes(Map* map, const NodeBuilderSettings& settings, NodeBuilderStats* stats)
+{
+	NodeBuilderStats localStats;
+	if (!stats) stats = &localStats;
+	*stats = NodeBuilderStats();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	NodeBuilder builder(map, settings, stats);
+	bool result = builder.Build();
+	auto end = std::chrono::high_resolution_clock::now();
+	stats->milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	return result;
+}
+
+void EncodeNodeLumps(const Map* map, NodeLumps* lumps)
+{
+	const Vertices& vertices = map->vertices;
+	lumps->vertices.clear();
+	lumps->vertices.reserve(vertices.size() * VERTEX_SIZE);
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		Write16(lumps->vertices, (uint16_t)vertices.x[i]);
+		Write16(lumps->vertices, (uint16_t)vertices.y[i]);
+	}
+
+	const Segments& segments = map->segments;
+	lumps->segments.clear();
+	lumps->segments.reserve(segments.size() * SEG_SIZE);
+	for (size_t i = 0; i < segments.size(); ++i) {
+		Write16(lumps->segments, segments.startVertex[i]);
+		Write16(lumps->segments, segments.endVertex[i]);
+		Write16(lumps->segments, (uint16_t)segments.angle[i]);
+		Write16(lumps->segments, segments.lineDef[i]);
+		Write16(lumps->segments, (uint16_t)segments.direction[i]);
+		Write16(lumps->segments, (uint16_t)segments.offset[i]);
+	}
+
+	const SubSectors& subSectors = map->subSectors;
+	lumps->subSectors.clear();
+	lumps->subSectors.reserve(subSectors.size() * SSECTOR_SIZE);
+	for (size_t i = 0; i < subSectors.size(); ++i) {
+		Write16(lumps->subSectors, subSectors.segmentCount[i]);
+		Write16(lumps->subSectors, subSectors.firstSegment[i]);
+	}
+
+	const Nodes& nodes = map->nodes;
+	lumps->nodes.clear();
+	lumps->nodes.reserve(nodes.size() * NODE_SIZE);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		Write16(lumps->nodes, (uint16_t)nodes.x[i]);
+		Write16(lumps->nodes, (uint16_t)nodes.y[i]);
+		Write16(lumps->nodes, (uint16_t)nodes.xDelta[i]);
+		Write16(lumps->nodes, (uint16_t)nodes.yDelta[i]);
+		WriteBox(lumps->nodes, nodes.rightBox[i]);
+		WriteBox(lumps->nodes, nodes.leftBox[i]);
+		Write16(lumps->nodes, nodes.rightChild[i]);
+		Write16(lumps->nodes, nodes.leftChild[i]);
+	}
+}
+
+bool ValidateBSP(const Map* map, std::string* error)
+{
+	Validator validator;
+	validator.map = map;
+	validator.error = error;
+	validator.nodeSeen.assign(map->nodes.size(), 0);
+	validator.subSectorSeen.assign(map->subSectors.size(), 0);
+	validator.segSeen.assign(map->segments.size(), 0);
+
+	if (map->subSectors.size() == 0) return validator.Fail("Map has no sub sectors");
+
+	// A map without nodes is a single sub sector
+	uint16_t root = (map->nodes.size() == 0) ? SUBSECTOR_FLAG : (uint16_t)(map->nodes.size() - 1);
+	if (!validator.CheckChild(root)) return false;
+
+	for (size_t i = 0; i < validator.nodeSeen.size(); ++i) {
+		if (!validator.nodeSeen[i]) return validator.Fail("Node " + std::to_string(i) + " can't be reached from the root");
+	}
+	for (size_t i = 0; i < validator.subSectorSeen.size(); ++i) {
+		if (!validator.subSectorSeen[i]) return validator.Fail("Sub sector " + std::to_string(i) + " can't be reached from the root");
+	}
+	for (size_t i = 0; i < validator.segSeen.size(); ++i) {
+		if (!validator.segSeen[i]) return validator.Fail("Seg " + std::to_string(i) + " doesn't belong to a sub sector");
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "Map.h"
+#include "ThreadPool.h"
+
+struct NodeBuilderSettings {
+	// Cost of splitting one seg compared to one seg of imbalance between the two sides
+	int64_t splitWeight = 8;
+	// Most partition lines tried per node, segs are sampled evenly past this ( 0 tries every seg )
+	size_t candidateLimit = 1024;
+	// Nodes with fewer segs than this evaluate their candidates on the calling thread
+	size_t parallelThreshold = 256;
+	// Candidates are evaluated on this pool if set
+	ThreadPool* pool = nullptr;
+};
+
+struct NodeBuilderStats {
+	size_t segments = 0;
+	size_t splits = 0;
+	size_t nodes = 0;
+	size_t subSectors = 0;
+	size_t newVertices = 0;
+	double milliseconds = 0.0;
+};
+
+// Builds SEGS, SSECTORS and NODES from the map's line defs, replacing whatever the map had
+// Split points are added to the map's vertices. Returns false if the map is too big for the lump format
+bool BuildNodes(Map* map, const NodeBuilderSettings& settings = {}, NodeBuilderStats* stats = nullptr);
+
+// Raw lump data for the BSP part of a map, ready to be written to a WAD
+struct NodeLumps {
+	std::vector<uint8_t> vertices;
+	std::vector<uint8_t> segments;
+	std::vector<uint8_t> subSectors;
+	std::vector<uint8_t> nodes;
+};
+void EncodeNodeLumps(const Map* map, NodeLumps* lumps);
+
+// Structural check of a map's BSP
+// Every node and sub sector has to be reached exactly once from the root, every seg has to belong
+// to exactly one sub sector, and every seg has to be inside its ancestors' boxes and on the right
+// side of their partition lines. error describes the first problem found
+bool ValidateBSP(const Map* map, std::string* error);
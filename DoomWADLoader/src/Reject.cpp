@@ -0,0 +1,312 @@
+#include "Reject.h"
+#include <chrono>
+#include <algorithm>
+#include <math.h>
+
+#define PI        3.14159265358979323846
+// Slack on every angle test so lines through shared portal corners still count
+#define ARC_SLACK 1e-9
+// Times a portal's directions are widened before it's given all of them
+#define MAX_WIDEN 4
+
+namespace {
+	// Two sided line between two different sectors, seen from one of them
+	struct Portal {
+		uint32_t toSector;
+		uint32_t line;
+		// Unique for each direction through each line
+		uint32_t id;
+		// Corners on the left and right of someone walking through the portal
+		double leftX, leftY;
+		double rightX, rightY;
+	};
+
+	// Directions on the unit circle, [ start, start + width ]
+	struct Arc {
+		double start;
+		double width;
+	};
+
+	// Keeps the directions n of arc where n . ( x, y ) >= 0, false if none are left
+	bool ClipArc(Arc* arc, double x, double y) {
+		if (fabs(x) + fabs(y) < 1e-12) return true;
+		double center = atan2(y, x);
+		double halfStart = center - PI * 0.5 - ARC_SLACK;
+		double halfWidth = PI + ARC_SLACK * 2.0;
+		if (arc->width >= PI * 2.0) {
+			*arc = { halfStart, halfWidth };
+			return true;
+		}
+
+		// Half circle start relative to the arc, in ( -2 pi, 0 ]
+		double relative = fmod(halfStart - arc->start, PI * 2.0);
+		if (relative > 0.0) relative -= PI * 2.0;
+
+		// The half circle covers [ relative, relative + halfWidth ] and the same again 2 pi later
+		double low1 = std::max(0.0, relative), high1 = std::min(arc->width, relative + halfWidth);
+		double low2 = std::max(0.0, relative + PI * 2.0), high2 = std::min(arc->width, relative + PI * 2.0 + halfWidth);
+		bool hit1 = low1 <= high1, hit2 = low2 <= high2;
+		if (!hit1 && !hit2) return false;
+
+		// Both only happens around the slack, keeping the hull stays conservative
+		double low = hit1 ? low1 : low2;
+		double high = hit2 ? high2 : high1;
+		arc->start += low;
+		arc->width = high - low;
+		return true;
+	}
+
+	// Where b starts going around from a, in [ 0, 2 pi )
+	double ArcOffset(const Arc& a, const Arc& b) {
+		double offset = fmod(b.start - a.start, PI * 2.0);
+		return (offset < 0.0) ? offset + PI * 2.0 : offset;
+	}
+
+	bool ArcContains(const Arc& outer, const Arc& inner) {
+		if (outer.width >= PI * 2.0) return true;
+		return ArcOffset(outer, inner) + inner.width <= outer.width;
+	}
+
+	// Smallest arc covering both
+	Arc ArcHull(const Arc& a, const Arc& b) {
+		double fromA = std::max(a.width, ArcOffset(a, b) + b.width);
+		double fromB = std::max(b.width, ArcOffset(b, a) + a.width);
+		Arc hull = (fromA <= fromB) ? Arc{ a.start, fromA } : Arc{ b.start, fromB };
+		if (hull.width >= PI * 2.0) hull = { 0.0, PI * 2.0 };
+		return hull;
+	}
+
+	class RejectBuilder {
+	public:
+		const Map* map;
+		const RejectBuildSettings* settings;
+		// Portals leaving each sector
+		std::vector<std::vector<Portal>> portals;
+		uint32_t portalCount = 0;
+		// Connected area of each sector, what an over budget sector falls back to
+		std::vector<uint32_t> area;
+		size_t rowWords = 0;
+		// One bit per sector pair, row from is written only by the job for from
+		std::vector<uint64_t> visible;
+
+		void FindPortals() {
+			uint32_t sectorCount = (uint32_t)map->sectors.size();
+			portals.assign(sectorCount, {});
+
+			const LineDefs& lineDefs = map->lineDefs;
+			const SideDefs& sideDefs = map->sideDefs;
+			const Vertices& vertices = map->vertices;
+			for (uint32_t i = 0; i < lineDefs.size(); ++i) {
+				uint16_t front = lineDefs.frontSide[i], back = lineDefs.backSide[i];
+				if (front >= sideDefs.size() || back >= sideDefs.size()) continue;
+				uint16_t frontSector = sideDefs.sector[front], backSector = sideDefs.sector[back];
+				if (frontSector == backSector || frontSector >= sectorCount || backSector >= sectorCount) continue;
+				if (lineDefs.startVertex[i] >= vertices.size() || lineDefs.endVertex[i] >= vertices.size()) continue;
+
+				double x1 = vertices.x[lineDefs.startVertex[i]], y1 = vertices.y[lineDefs.startVertex[i]];
+				double x2 = vertices.x[lineDefs.endVertex[i]], y2 = vertices.y[lineDefs.endVertex[i]];
+				// Walking from the front ( right ) side the start vertex is on the left
+				portals[frontSector].push_back({ backSector, i, portalCount++, x1, y1, x2, y2 });
+				portals[backSector].push_back({ frontSector, i, portalCount++, x2, y2, x1, y1 });
+			}
+
+			// Connected areas with a flood fill
+			area.assign(sectorCount, UINT32_MAX);
+			std::vector<uint32_t> stack;
+			for (uint32_t sector = 0; sector < sectorCount; ++sector) {
+				if (area[sector] != UINT32_MAX) continue;
+				area[sector] = sector;
+				stack.push_back(sector);
+				while (!stack.empty()) {
+					uint32_t current = stack.back();
+					stack.pop_back();
+					for (const Portal& portal : portals[current]) {
+						if (area[portal.toSector] != UINT32_MAX) continue;
+						area[portal.toSector] = sector;
+						stack.push_back(portal.toSector);
+					}
+				}
+			}
+		}
+
+		void MarkVisible(uint32_t from, uint32_t to) {
+			visible[from * rowWords + (to >> 6)] |= 1ull << (to & 63);
+		}
+
+		struct Step {
+			uint32_t sector;
+			uint32_t nextPortal;
+			Arc arc;
+			// Portal this step came in through, null for the source
+			const Portal* entry;
+		};
+
+		// Depth first walk through portals from one sector, keeping the directions a line
+		// through every portal so far could have. A new portal is only checked against the one
+		// it's entered from and the first one out of the source, the rest of the path is only
+		// kept through the directions. Portal order along the line isn't checked either, both
+		// can only make more sectors visible.
+		// So past the first portal a step only depends on its directions, the portal it came in
+		// through and the first portal. Under one first portal, a portal that was already walked
+		// through with wider directions doesn't need walking again, which keeps maps full of loops
+		// from blowing up. What was walked under another first portal was clipped against a
+		// different portal, so it's forgotten each time the walk leaves the source
+		bool Trace(uint32_t source) {
+			uint32_t sectorCount = (uint32_t)portals.size();
+			MarkVisible(source, source);
+
+			std::vector<uint8_t> onPath(sectorCount, 0);
+			std::vector<Step> path;
+			// Directions each portal has been walked through with under the current first portal
+			std::vector<Arc> explored(portalCount, { 0.0, -1.0 });
+			std::vector<uint8_t> widened(portalCount, 0);
+			// Portals in explored to reset for the next first portal
+			std::vector<uint32_t> touched;
+			size_t steps = 0;
+
+			onPath[source] = 1;
+			path.push_back({ source, 0, { 0.0, PI * 2.0 }, nullptr });
+
+			while (!path.empty()) {
+				Step& step = path.back();
+				const std::vector<Portal>& exits = portals[step.sector];
+				if (step.nextPortal >= exits.size()) {
+					onPath[step.sector] = 0;
+					path.pop_back();
+					continue;
+				}
+
+				const Portal& portal = exits[step.nextPortal++];
+				if (onPath[portal.toSector]) continue;
+				if (++steps > settings->stepBudget || path.size() > settings->maxDepth) return false;
+
+				// Every left corner has to stay on one side of the line and every right corner on the other
+				Arc arc = step.arc;
+				bool open = ClipArc(&arc, portal.leftX - portal.rightX, portal.leftY - portal.rightY);
+				const Portal* first = (path.size() > 1) ? path[1].entry : nullptr;
+				const Portal* others[2] = { step.entry, (first != step.entry) ? first : nullptr };
+				for (const Portal* other : others) {
+					if (!open || !other) continue;
+					open = ClipArc(&arc, portal.leftX - other->rightX, portal.leftY - other->rightY)
+						&& ClipArc(&arc, other->leftX - portal.rightX, other->leftY - portal.rightY);
+				}
+				if (!open) continue;
+				MarkVisible(source, portal.toSector);
+
+				if (path.size() == 1) {
+					for (uint32_t id : touched) {
+						explored[id] = { 0.0, -1.0 };
+						widened[id] = 0;
+					}
+					touched.clear();
+				}
+				Arc& seen = explored[portal.id];
+				if (seen.width >= 0.0) {
+					if (ArcContains(seen, arc)) continue;
+					// Walking on with the hull of both covers everything either would reach,
+					// after a few tries give the portal every direction so it's never walked again
+					arc = (++widened[portal.id] > MAX_WIDEN) ? Arc{ 0.0, PI * 2.0 } : ArcHull(seen, arc);
+				}
+				else touched.push_back(portal.id);
+				seen = arc;
+
+				onPath[portal.toSector] = 1;
+				path.push_back({ portal.toSector, 0, arc, &portal });
+			}
+			return true;
+		}
+
+		void FallBackToArea(uint32_t source) {
+			for (uint32_t sector = 0; sector < area.size(); ++sector) {
+				if (area[sector] == area[source]) MarkVisible(source, sector);
+			}
+		}
+	};
+}
+
+bool LoadReject(const Map* map, RejectTable* table)
+{
+	size_t sectorCount = map->sectors.size();
+	size_t size = (sectorCount * sectorCount + 7) / 8;
+	if (sectorCount == 0 || map->reject.size() < size) return false;
+
+	bool empty = true;
+	for (size_t i = 0; i < size && empty; ++i) empty = (map->reject[i] == 0);
+	if (empty) return false;
+
+	table->sectorCount = (uint32_t)sectorCount;
+	table->bits.assign(map->reject.begin(), map->reject.begin() + size);
+	return true;
+}
+
+void BuildReject(const Map* map, RejectTable* table, const RejectBuildSettings& settings, RejectBuildStats* stats)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	RejectBuilder builder;
+	builder.map = map;
+	builder.settings = &settings;
+	builder.FindPortals();
+
+	uint32_t sectorCount = (uint32_t)map->sectors.size();
+	builder.rowWords = (sectorCount + 63) / 64;
+	builder.visible.assign((size_t)builder.rowWords * sectorCount, 0);
+
+	std::vector<uint8_t> overBudget(sectorCount, 0);
+	auto trace = [&](size_t begin, size_t end) {
+		for (size_t sector = begin; sector < end; ++sector) {
+			if (!builder.Trace((uint32_t)sector)) {
+				overBudget[sector] = 1;
+				builder.FallBackToArea((uint32_t)sector);
+			}
+		}
+	};
+	if (settings.pool) settings.pool->ParallelFor(sectorCount, 1, trace);
+	else trace(0, sectorCount);
+
+	// Seeing is mutual, if either direction found a line the pair is visible
+	table->sectorCount = sectorCount;
+	table->bits.assign(((size_t)sectorCount * sectorCount + 7) / 8, 0);
+	size_t visiblePairs = 0;
+	for (uint32_t from = 0; from < sectorCount; ++from) {
+		for (uint32_t to = 0; to < sectorCount; ++to) {
+			bool forward = builder.visible[from * builder.rowWords + (to >> 6)] & (1ull << (to & 63));
+			bool backward = builder.visible[to * builder.rowWords + (from >> 6)] & (1ull << (from & 63));
+			if (forward || backward) {
+				visiblePairs++;
+				continue;
+			}
+			size_t bit = (size_t)from * sectorCount + to;
+			table->bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+		}
+	}
+
+	if (stats) {
+		stats->sectors = sectorCount;
+		stats->portals = 0;
+		for (auto& exits : builder.portals) stats->portals += exits.size();
+		stats->portals /= 2;
+		stats->visiblePairs = visiblePairs;
+		stats->overBudget = 0;
+		for (uint8_t over : overBudget) stats->overBudget += over;
+		stats->built = true;
+		stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void LoadOrBuildReject(const Map* map, RejectTable* table, const RejectBuildSettings& settings, RejectBuildStats* stats)
+{
+	if (LoadReject(map, table)) {
+		if (stats) {
+			*stats = RejectBuildStats();
+			stats->sectors = table->sectorCount;
+		}
+		return;
+	}
+	BuildReject(map, table, settings, stats);
+}
+
+void EncodeReject(const RejectTable* table, std::vector<uint8_t>* lump)
+{
+	*lump = table->bits;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "Map.h"
+#include "ThreadPool.h"
+
+// Sector to sector visibility in the same layout as the REJECT lump
+// Bit ( from * sectorCount + to ) is set when nothing in sector to can be seen from sector from
+struct RejectTable {
+	uint32_t sectorCount = 0;
+	std::vector<uint8_t> bits;
+
+	bool CanSee(uint32_t from, uint32_t to) const {
+		size_t bit = (size_t)from * sectorCount + to;
+		return !(bits[bit >> 3] & (1u << (bit & 7)));
+	}
+};
+
+struct RejectBuildSettings {
+	// Most portals one line of sight is followed through
+	uint32_t maxDepth = 64;
+	// Most portal steps tried from one sector, past this the whole connected area counts as visible
+	size_t stepBudget = 200000;
+	// Sectors are worked on in parallel on this pool if set
+	ThreadPool* pool = nullptr;
+};
+
+struct RejectBuildStats {
+	size_t sectors = 0;
+	size_t portals = 0;
+	// Ordered pairs that can see each other, including every sector seeing itself
+	size_t visiblePairs = 0;
+	// Sectors that ran out of budget and fell back to their connected area
+	size_t overBudget = 0;
+	bool built = false;
+	double milliseconds = 0.0;
+};
+
+// Uses the map's REJECT lump, fails if it's missing, too small or all zeroes ( the usual placeholder )
+bool LoadReject(const Map* map, RejectTable* table);
+
+// Computes a conservative table, a pair is only rejected if no straight line passes from one
+// sector to the other through the two sided lines between them. Closed doors are treated as open
+void BuildReject(const Map* map, RejectTable* table, const RejectBuildSettings& settings = {}, RejectBuildStats* stats = nullptr);
+
+// LoadReject, falling back to BuildReject when the map's lump can't be used
+void LoadOrBuildReject(const Map* map, RejectTable* table, const RejectBuildSettings& settings = {}, RejectBuildStats* stats = nullptr);
+
+// Lump data ready to be written to a WAD
+void EncodeReject(const RejectTable* table, std::vector<uint8_t>* lump);
@@ -0,0 +1,739 @@
+#include "SoftwareRenderer.h"
+#include <algorithm>
+#include <math.h>
+#include <limits.h>
+
+#define PI             3.14159265358979f
+#define NEAR_PLANE     1.0f
+#define UNUSED_ROW     0xFFFF
+// Sky texture columns across a full turn, the same as Doom's ANGLETOSKYSHIFT
+#define SKY_COLUMNS    1024.0f
+#define SKY_MIDDLE     100.0f
+
+// Line def flags
+#define LINE_UPPER_UNPEGGED 8
+#define LINE_LOWER_UNPEGGED 16
+
+namespace {
+	// Screen columns [ first, last ] that are already covered by solid walls
+	struct ClipRange {
+		int32_t first;
+		int32_t last;
+	};
+
+	// Doom's scalelight, scale is the wall's projection scale at a 320 pixel wide screen
+	int32_t WallShade(int32_t light, float scale)
+	{
+		int32_t start = (LIGHT_LEVELS - 1 - light) * 4;
+		int32_t level = start - (int32_t)(scale * 8.0f);
+		return std::clamp(level, 0, SHADE_LEVELS - 1);
+	}
+	// Doom's zlight, distance is in map units
+	int32_t FlatShade(int32_t light, float distance)
+	{
+		int32_t start = (LIGHT_LEVELS - 1 - light) * 4;
+		int32_t level = start - (int32_t)(80.0f / (distance / 16.0f + 1.0f));
+		return std::clamp(level, 0, SHADE_LEVELS - 1);
+	}
+
+	int32_t Wrap(int32_t value, int32_t size)
+	{
+		value %= size;
+		return value < 0 ? value + size : value;
+	}
+
+	// Adds [ first, last ] to a sorted list of ranges, merging anything it touches
+	void AddSolidRange(std::vector<ClipRange>& solid, int32_t first, int32_t last)
+	{
+		auto begin = std::lower_bound(solid.begin(), solid.end(), first, [](const ClipRange& range, int32_t x) {
+			return range.last + 1 < x;
+		});
+		auto end = begin;
+		while (end != solid.end() && end->first <= last + 1) ++end;
+
+		if (begin == end) {
+			solid.insert(begin, { first, last });
+			return;
+		}
+		begin->first = std::min(begin->first, first);
+		begin->last = std::max((end - 1)->last, last);
+		solid.erase(begin + 1, end);
+	}
+
+	// Calls func( first, last ) for every part of [ first, last ] not covered by the list
+	template<typename Func>
+	void ForEachVisibleRange(const std::vector<ClipRange>& solid, int32_t first, int32_t last, Func&& func)
+	{
+		for (size_t i = 0; i + 1 < solid.size(); ++i) {
+			int32_t gapFirst = std::max(solid[i].last + 1, first);
+			int32_t gapLast = std::min(solid[i + 1].first - 1, last);
+			if (gapFirst <= gapLast) func(gapFirst, gapLast);
+			if (solid[i + 1].first > last) break;
+		}
+	}
+}
+
+struct SoftwareRenderer::Frame {
+	RenderCamera camera;
+	float cosAngle;
+	float sinAngle;
+	float centerX;
+	float centerY;
+	// Distance to the projection plane in pixels, 90 degree field of view
+	float focal;
+	// Converts a projection scale to what it would be on a 320 pixel wide screen
+	float lightScale;
+};
+
+struct SoftwareRenderer::Visplane {
+	int32_t height;
+	int32_t flat;
+	int32_t light;
+	int32_t minX;
+	int32_t maxX;
+	// Indexed by x - strip start + 1, with a spare entry on each side for MakeSpans
+	std::vector<uint16_t> top;
+	std::vector<uint16_t> bottom;
+};
+
+struct SoftwareRenderer::Strip {
+	int32_t x0;
+	int32_t x1;
+	std::vector<ClipRange> solid;
+	// Last row drawn from the top and first row drawn from the bottom, per column
+	std::vector<int16_t> ceilingClip;
+	std::vector<int16_t> floorClip;
+	// Planes are reused between frames, only the first planeCount are in use
+	std::vector<Visplane> planes;
+	size_t planeCount = 0;
+	std::vector<int32_t> spanStart;
+	RenderStats stats;
+};
+
+struct SoftwareRenderer::WallSetup {
+	// Screen x and 1 / depth of both ends after clipping to the near plane
+	float screenX1;
+	float screenX2;
+	float inverseZ1;
+	float inverseZ2;
+	// Texture u divided by depth, interpolating these keeps textures perspective correct
+	float uOverZ1;
+	float uOverZ2;
+
+	float frontFloor;
+	float frontCeiling;
+	float backFloor;
+	float backCeiling;
+	int32_t floorFlat;
+	int32_t ceilingFlat;
+	int32_t sectorLight;
+	// Light with Doom's fake contrast on axis aligned walls
+	int32_t wallLight;
+
+	int32_t upperTexture;
+	int32_t lowerTexture;
+	int32_t middleTexture;
+	// World height of texture row 0 for each part
+	float upperTop;
+	float lowerTop;
+	float middleTop;
+
+	bool solid;
+	bool hasUpper;
+	bool hasLower;
+	bool markFloor;
+	bool markCeiling;
+};
+
+SoftwareRenderer::SoftwareRenderer(WAD* wad, const Map* map, const BSP* bsp, const TextureAtlas* atlas, uint32_t width, uint32_t height)
+	: m_Map(map), m_BSP(bsp), m_Width(width), m_Height(height), m_FlatCache(wad)
+{
+	m_Framebuffer.assign((size_t)width * height, 0);
+	m_Columns.assign((size_t)width * height, 0);
+
+	// Shading tables, falls back to a grey ramp if the WAD has no palette
+	std::vector<Palette> palettes;
+	std::vector<ColorMap> colorMaps;
+	Palette palette;
+	if (LoadPalettes(wad, &palettes)) palette = palettes[0];
+	else for (int i = 0; i < 256; ++i) palette.colors[i][0] = palette.colors[i][1] = palette.colors[i][2] = (uint8_t)i;
+
+	if (LoadColorMaps(wad, &colorMaps) && colorMaps.size() >= SHADE_LEVELS) {
+		BuildShadedLookups(palette, colorMaps, &m_Lookups);
+	}
+	else {
+		m_Lookups.resize(SHADE_LEVELS);
+		for (auto& lookup : m_Lookups) BuildLookup(palette, nullptr, &lookup);
+	}
+
+	// Wall textures are copied out of the atlas column by column
+	m_Textures.resize(atlas->entries.size());
+	for (size_t i = 0; i < atlas->entries.size(); ++i) {
+		const AtlasEntry& entry = atlas->entries[i];
+		m_Textures[i] = { (uint32_t)m_TextureData.size(), entry.width, entry.height };
+		for (uint32_t x = 0; x < entry.width; ++x) {
+			for (uint32_t y = 0; y < entry.height; ++y) {
+				m_TextureData.push_back(atlas->image.pixels[(size_t)(entry.y + y) * atlas->image.width + entry.x + x]);
+			}
+		}
+	}
+	// Empty textures count as missing, DrawColumn wraps by their width and height
+	auto findTexture = [&](uint64_t id) -> int32_t {
+		if (id == 0) return -1;
+		auto it = atlas->lookup.find(id);
+		if (it == atlas->lookup.end()) return -1;
+		const WallTexture& texture = m_Textures[it->second];
+		return (texture.width && texture.height) ? (int32_t)it->second : -1;
+	};
+	m_SkyTexture = findTexture(PackLumpName("SKY1"));
+
+	const SideDefs& sideDefs = map->sideDefs;
+	m_SideTextures.resize(sideDefs.size() * 3);
+	for (size_t i = 0; i < sideDefs.size(); ++i) {
+		m_SideTextures[i * 3 + 0] = findTexture(sideDefs.upperTexture[i]);
+		m_SideTextures[i * 3 + 1] = findTexture(sideDefs.lowerTexture[i]);
+		m_SideTextures[i * 3 + 2] = findTexture(sideDefs.middleTexture[i]);
+	}
+
+	// Flat 0 is a single black pixel used for anything missing
+	static const uint8_t missingFlat = 0;
+	m_Flats.push_back({ &missingFlat, 0, 0 });
+
+	LumpRange flatRange = { 0, (uint32_t)wad->lumps.size() };
+	wad->GetNamespace("F", &flatRange);
+	uint64_t skyID = PackLumpName("F_SKY1");
+	std::unordered_map<int32_t, int32_t> flatIndices;
+	auto findFlat = [&](uint64_t id) -> int32_t {
+		if (id == skyID) return SKY_FLAT;
+		int32_t lump = wad->FindLump(UnpackLumpName(id), flatRange.first, flatRange.last);
+		if (lump < 0) return 0;
+
+		auto it = flatIndices.find(lump);
+		if (it != flatIndices.end()) return it->second;
+
+		const Image* image = m_FlatCache.GetFlat(lump);
+		int32_t index = 0;
+		if (image && (image->width & (image->width - 1)) == 0) {
+			uint32_t shift = 0;
+			while ((1u << shift) < image->width) ++shift;
+			index = (int32_t)m_Flats.size();
+			m_Flats.push_back({ image->pixels.data(), image->width - 1, shift });
+		}
+		else SOFT_ERROR("Flat isn't a power of two square ( " + UnpackLumpName(id) + " )");
+		flatIndices[lump] = index;
+		return index;
+	};
+
+	const Sectors& sectors = map->sectors;
+	m_SectorFlats.resize(sectors.size() * 2);
+	for (size_t i = 0; i < sectors.size(); ++i) {
+		m_SectorFlats[i * 2 + 0] = findFlat(sectors.floorTexture[i]);
+		m_SectorFlats[i * 2 + 1] = findFlat(sectors.ceilingTexture[i]);
+	}
+
+	// A sub sector's sector is the sector of any of its segs
+	const Segments& segments = map->segments;
+	const LineDefs& lineDefs = map->lineDefs;
+	m_SubSectorSectors.assign(map->subSectors.size(), 0);
+	for (size_t i = 0; i < map->subSectors.size(); ++i) {
+		uint32_t segment = map->subSectors.firstSegment[i];
+		if (segment >= segments.size()) continue;
+		uint16_t lineDef = segments.lineDef[segment];
+		if (lineDef >= lineDefs.size()) continue;
+		uint16_t side = segments.direction[segment] ? lineDefs.backSide[lineDef] : lineDefs.frontSide[lineDef];
+		if (side < sideDefs.size()) m_SubSectorSectors[i] = sideDefs.sector[side];
+	}
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+}
+
+float SoftwareRenderer::GetFloorHeight(float x, float y) const
+{
+	if (m_SubSectorSectors.empty()) return 0.0f;
+	uint16_t sector = m_SubSectorSectors[m_BSP->FindSubSector(x, y)];
+	if (sector >= m_Map->sectors.size()) return 0.0f;
+	return m_Map->sectors.floorHeight[sector];
+}
+
+void SoftwareRenderer::Render(const RenderCamera& camera, ThreadPool* pool)
+{
+	Frame frame;
+	frame.camera = camera;
+	frame.cosAngle = cosf(camera.angle);
+	frame.sinAngle = sinf(camera.angle);
+	frame.centerX = m_Width * 0.5f;
+	frame.centerY = m_Height * 0.5f;
+	frame.focal = m_Width * 0.5f;
+	frame.lightScale = 320.0f / m_Width;
+
+	// A couple of strips per thread so one busy strip doesn't hold up the frame
+	size_t stripCount = pool ? pool->GetThreadCount() * 2 : 1;
+	stripCount = std::max<size_t>(1, std::min<size_t>(stripCount, m_Width / 16));
+	if (m_Strips.size() != stripCount) {
+		m_Strips.clear();
+		m_Strips.resize(stripCount);
+		for (size_t i = 0; i < stripCount; ++i) {
+			Strip& strip = m_Strips[i];
+			strip.x0 = (int32_t)(m_Width * i / stripCount);
+			strip.x1 = (int32_t)(m_Width * (i + 1) / stripCount);
+			strip.ceilingClip.resize(strip.x1 - strip.x0);
+			strip.floorClip.resize(strip.x1 - strip.x0);
+			strip.spanStart.resize(m_Height);
+		}
+	}
+
+	auto renderStrips = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) RenderStrip(frame, m_Strips[i]);
+	};
+	if (pool) pool->ParallelFor(stripCount, 1, renderStrips);
+	else renderStrips(0, stripCount);
+
+	// Columns to rows, a band of rows at a time so each band reads every column once
+	auto transpose = [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; ++y) {
+			uint32_t* row = m_Framebuffer.data() + y * m_Width;
+			const uint32_t* column = m_Columns.data() + y;
+			for (uint32_t x = 0; x < m_Width; ++x) row[x] = column[(size_t)x * m_Height];
+		}
+	};
+	if (pool) pool->ParallelFor(m_Height, 16, transpose);
+	else transpose(0, m_Height);
+
+	m_Stats = RenderStats();
+	for (auto& strip : m_Strips) {
+		m_Stats.subSectors += strip.stats.subSectors;
+		m_Stats.segments += strip.stats.segments;
+		m_Stats.wallColumns += strip.stats.wallColumns;
+		m_Stats.visplanes += strip.stats.visplanes;
+		m_Stats.spans += strip.stats.spans;
+	}
+}
+
+void SoftwareRenderer::RenderStrip(const Frame& frame, Strip& strip)
+{
+	strip.stats = RenderStats();
+	strip.planeCount = 0;
+	strip.solid.clear();
+	strip.solid.push_back({ INT_MIN / 2, strip.x0 - 1 });
+	strip.solid.push_back({ strip.x1, INT_MAX / 2 });
+	std::fill(strip.ceilingClip.begin(), strip.ceilingClip.end(), (int16_t)-1);
+	std::fill(strip.floorClip.begin(), strip.floorClip.end(), (int16_t)m_Height);
+
+	// Anything in an unfilled gap would show the last frame, clear it to black
+	for (int32_t x = strip.x0; x < strip.x1; ++x) {
+		uint32_t* column = m_Columns.data() + (size_t)x * m_Height;
+		std::fill(column, column + m_Height, 0xFF000000u);
+	}
+
+	// Only walk the part of the view cone this strip covers
+	float leftAngle = atanf((frame.centerX - strip.x0) / frame.focal);
+	float rightAngle = atanf((frame.centerX - strip.x1) / frame.focal);
+	BSPView view;
+	view.x = frame.camera.x;
+	view.y = frame.camera.y;
+	view.angle = frame.camera.angle + (leftAngle + rightAngle) * 0.5f;
+	view.fov = (leftAngle - rightAngle) + 0.02f;
+
+	const SubSectors& subSectors = m_Map->subSectors;
+	m_BSP->TraverseFrontToBack(view, [&](uint16_t subSector) {
+		if (subSector >= subSectors.size()) return true;
+		strip.stats.subSectors++;
+
+		uint32_t first = subSectors.firstSegment[subSector];
+		uint32_t last = first + subSectors.segmentCount[subSector];
+		for (uint32_t segment = first; segment < last && segment < m_Map->segments.size(); ++segment) {
+			AddSegment(frame, strip, segment);
+		}
+		// Once every column has a solid wall nothing further back can show
+		return strip.solid.size() > 1;
+	});
+
+	DrawPlanes(frame, strip);
+}
+
+void SoftwareRenderer::AddSegment(const Frame& frame, Strip& strip, uint32_t segment)
+{
+	const Segments& segments = m_Map->segments;
+	const Vertices& vertices = m_Map->vertices;
+	const LineDefs& lineDefs = m_Map->lineDefs;
+	const SideDefs& sideDefs = m_Map->sideDefs;
+	const Sectors& sectors = m_Map->sectors;
+
+	uint16_t v1 = segments.startVertex[segment];
+	uint16_t v2 = segments.endVertex[segment];
+	uint16_t lineDef = segments.lineDef[segment];
+	if (v1 >= vertices.size() || v2 >= vertices.size() || lineDef >= lineDefs.size()) return;
+
+	// Into view space, z forward and x to the right
+	float worldX1 = vertices.x[v1], worldY1 = vertices.y[v1];
+	float worldX2 = vertices.x[v2], worldY2 = vertices.y[v2];
+	float dx1 = worldX1 - frame.camera.x, dy1 = worldY1 - frame.camera.y;
+	float dx2 = worldX2 - frame.camera.x, dy2 = worldY2 - frame.camera.y;
+	float z1 = dx1 * frame.cosAngle + dy1 * frame.sinAngle;
+	float z2 = dx2 * frame.cosAngle + dy2 * frame.sinAngle;
+	float x1 = dx1 * frame.sinAngle - dy1 * frame.cosAngle;
+	float x2 = dx2 * frame.sinAngle - dy2 * frame.cosAngle;
+	if (z1 < NEAR_PLANE && z2 < NEAR_PLANE) return;
+
+	uint16_t frontSide = segments.direction[segment] ? lineDefs.backSide[lineDef] : lineDefs.frontSide[lineDef];
+	uint16_t backSide = segments.direction[segment] ? lineDefs.frontSide[lineDef] : lineDefs.backSide[lineDef];
+	if (frontSide >= sideDefs.size()) return;
+	uint16_t frontSector = sideDefs.sector[frontSide];
+	if (frontSector >= sectors.size()) return;
+	uint16_t backSector = (backSide < sideDefs.size()) ? sideDefs.sector[backSide] : NO_SIDEDEF;
+	if (backSector >= sectors.size()) backSector = NO_SIDEDEF;
+
+	float length = sqrtf((worldX2 - worldX1) * (worldX2 - worldX1) + (worldY2 - worldY1) * (worldY2 - worldY1));
+	float u1 = (float)segments.offset[segment] + sideDefs.xOffset[frontSide];
+	float u2 = u1 + length;
+
+	// Clip to the near plane
+	if (z1 < NEAR_PLANE) {
+		float t = (NEAR_PLANE - z1) / (z2 - z1);
+		x1 += (x2 - x1) * t;
+		u1 += (u2 - u1) * t;
+		z1 = NEAR_PLANE;
+	}
+	else if (z2 < NEAR_PLANE) {
+		float t = (NEAR_PLANE - z2) / (z1 - z2);
+		x2 += (x1 - x2) * t;
+		u2 += (u1 - u2) * t;
+		z2 = NEAR_PLANE;
+	}
+
+	WallSetup wall;
+	wall.screenX1 = frame.centerX + x1 * frame.focal / z1;
+	wall.screenX2 = frame.centerX + x2 * frame.focal / z2;
+	// Segs are only seen from their right side, which puts the start on the left
+	if (wall.screenX2 <= wall.screenX1) return;
+
+	int32_t start = std::max((int32_t)ceilf(wall.screenX1 - 0.5f), strip.x0);
+	int32_t stop = std::min((int32_t)ceilf(wall.screenX2 - 0.5f) - 1, strip.x1 - 1);
+	if (start > stop) return;
+
+	wall.inverseZ1 = 1.0f / z1;
+	wall.inverseZ2 = 1.0f / z2;
+	wall.uOverZ1 = u1 / z1;
+	wall.uOverZ2 = u2 / z2;
+
+	wall.frontFloor = sectors.floorHeight[frontSector];
+	wall.frontCeiling = sectors.ceilingHeight[frontSector];
+	wall.floorFlat = m_SectorFlats[frontSector * 2 + 0];
+	wall.ceilingFlat = m_SectorFlats[frontSector * 2 + 1];
+	wall.sectorLight = std::clamp(sectors.lightLevel[frontSector] >> 4, 0, LIGHT_LEVELS - 1);
+	wall.wallLight = wall.sectorLight;
+	if (worldY1 == worldY2) wall.wallLight = std::max(wall.wallLight - 1, 0);
+	else if (worldX1 == worldX2) wall.wallLight = std::min(wall.wallLight + 1, LIGHT_LEVELS - 1);
+
+	wall.upperTexture = m_SideTextures[frontSide * 3 + 0];
+	wall.lowerTexture = m_SideTextures[frontSide * 3 + 1];
+	wall.middleTexture = m_SideTextures[frontSide * 3 + 2];
+
+	uint16_t flags = lineDefs.flags[lineDef];
+	float yOffset = sideDefs.yOffset[frontSide];
+	auto textureHeight = [&](int32_t texture) { return texture < 0 ? 0.0f : (float)m_Textures[texture].height; };
+
+	wall.solid = (backSector == NO_SIDEDEF);
+	if (!wall.solid) {
+		wall.backFloor = sectors.floorHeight[backSector];
+		wall.backCeiling = sectors.ceilingHeight[backSector];
+		int32_t backFloorFlat = m_SectorFlats[backSector * 2 + 0];
+		int32_t backCeilingFlat = m_SectorFlats[backSector * 2 + 1];
+
+		// Closed doors block everything behind them
+		wall.solid = wall.backCeiling <= wall.frontFloor || wall.backFloor >= wall.frontCeiling;
+
+		// The sky hack, two sky ceilings next to each other don't get an upper wall
+		if (wall.ceilingFlat == SKY_FLAT && backCeilingFlat == SKY_FLAT) wall.backCeiling = wall.frontCeiling;
+
+		int16_t backLight = sectors.lightLevel[backSector];
+		bool sameLight = (backLight >> 4) == (sectors.lightLevel[frontSector] >> 4);
+		wall.markFloor = wall.backFloor != wall.frontFloor || backFloorFlat != wall.floorFlat || !sameLight;
+		wall.markCeiling = wall.backCeiling != wall.frontCeiling || backCeilingFlat != wall.ceilingFlat || !sameLight;
+		wall.hasUpper = wall.backCeiling < wall.frontCeiling;
+		wall.hasLower = wall.backFloor > wall.frontFloor;
+
+		// Lines that only exist to trigger things draw nothing
+		if (!wall.solid && !wall.markFloor && !wall.markCeiling && !wall.hasUpper && !wall.hasLower) return;
+
+		wall.upperTop = (flags & LINE_UPPER_UNPEGGED) ? wall.frontCeiling : wall.backCeiling + textureHeight(wall.upperTexture);
+		wall.lowerTop = (flags & LINE_LOWER_UNPEGGED) ? wall.frontCeiling : wall.backFloor;
+		wall.upperTop += yOffset;
+		wall.lowerTop += yOffset;
+	}
+	if (wall.solid) {
+		wall.markFloor = wall.markCeiling = true;
+		wall.hasUpper = wall.hasLower = false;
+	}
+	wall.middleTop = ((flags & LINE_LOWER_UNPEGGED) ? wall.frontFloor + textureHeight(wall.middleTexture) : wall.frontCeiling) + yOffset;
+
+	// Planes that face away from the camera can't be seen
+	if (wall.frontFloor >= frame.camera.z) wall.markFloor = false;
+	if (wall.frontCeiling <= frame.camera.z && wall.ceilingFlat != SKY_FLAT) wall.markCeiling = false;
+
+	strip.stats.segments++;
+	ForEachVisibleRange(strip.solid, start, stop, [&](int32_t first, int32_t last) {
+		StoreWallRange(frame, strip, wall, first, last);
+	});
+	if (wall.solid) AddSolidRange(strip.solid, start, stop);
+}
+
+void SoftwareRenderer::StoreWallRange(const Frame& frame, Strip& strip, const WallSetup& wall, int32_t start, int32_t stop)
+{
+	int32_t floorPlane = -1, ceilingPlane = -1;
+	if (wall.markFloor) {
+		floorPlane = FindPlane(strip, (int32_t)wall.frontFloor, wall.floorFlat, wall.sectorLight);
+		floorPlane = CheckPlane(strip, floorPlane, start, stop);
+	}
+	if (wall.markCeiling) {
+		ceilingPlane = FindPlane(strip, (int32_t)wall.frontCeiling, wall.ceilingFlat, wall.sectorLight);
+		ceilingPlane = CheckPlane(strip, ceilingPlane, start, stop);
+	}
+
+	float viewZ = frame.camera.z;
+	int32_t lastRow = (int32_t)m_Height - 1;
+	float width = wall.screenX2 - wall.screenX1;
+
+	for (int32_t x = start; x <= stop; ++x) {
+		int32_t local = x - strip.x0;
+		float t = (x + 0.5f - wall.screenX1) / width;
+		float inverseZ = wall.inverseZ1 + (wall.inverseZ2 - wall.inverseZ1) * t;
+		float u = (wall.uOverZ1 + (wall.uOverZ2 - wall.uOverZ1) * t) / inverseZ;
+		float scale = frame.focal * inverseZ;
+		float step = 1.0f / scale;
+		const RGBALookup& lookup = m_Lookups[WallShade(wall.wallLight, scale * frame.lightScale)];
+
+		auto toRow = [&](float height) { return (int32_t)ceilf(frame.centerY - (height - viewZ) * scale - 0.5f); };
+		// Texture v of the row drawn first, rows are sampled at their centers
+		auto toV = [&](float textureTop, int32_t row) { return textureTop - viewZ + (row + 0.5f - frame.centerY) * step; };
+
+		int32_t ceilingClip = strip.ceilingClip[local];
+		int32_t floorClip = strip.floorClip[local];
+		int32_t top = std::max(toRow(wall.frontCeiling), ceilingClip + 1);
+		int32_t bottom = std::min(toRow(wall.frontFloor) - 1, floorClip - 1);
+
+		if (ceilingPlane >= 0) {
+			int32_t planeBottom = std::min(top - 1, floorClip - 1);
+			if (ceilingClip + 1 <= planeBottom) {
+				Visplane& plane = strip.planes[ceilingPlane];
+				plane.top[local + 1] = (uint16_t)(ceilingClip + 1);
+				plane.bottom[local + 1] = (uint16_t)planeBottom;
+			}
+		}
+		if (floorPlane >= 0) {
+			int32_t planeTop = std::max(bottom + 1, ceilingClip + 1);
+			if (planeTop <= floorClip - 1) {
+				Visplane& plane = strip.planes[floorPlane];
+				plane.top[local + 1] = (uint16_t)planeTop;
+				plane.bottom[local + 1] = (uint16_t)(floorClip - 1);
+			}
+		}
+
+		strip.stats.wallColumns++;
+		if (wall.solid) {
+			DrawColumn(x, top, bottom, wall.middleTexture, u, toV(wall.middleTop, top), step, lookup);
+			continue;
+		}
+
+		if (wall.hasUpper) {
+			int32_t upperBottom = std::min(toRow(wall.backCeiling) - 1, bottom);
+			DrawColumn(x, top, upperBottom, wall.upperTexture, u, toV(wall.upperTop, top), step, lookup);
+			ceilingClip = std::max(top - 1, upperBottom);
+		}
+		else if (wall.markCeiling) ceilingClip = top - 1;
+
+		if (wall.hasLower) {
+			int32_t lowerTop = std::max(toRow(wall.backFloor), top);
+			DrawColumn(x, lowerTop, bottom, wall.lowerTexture, u, toV(wall.lowerTop, lowerTop), step, lookup);
+			floorClip = std::min(bottom + 1, lowerTop);
+		}
+		else if (wall.markFloor) floorClip = bottom + 1;
+
+		strip.ceilingClip[local] = (int16_t)std::clamp(ceilingClip, -1, lastRow + 1);
+		strip.floorClip[local] = (int16_t)std::clamp(floorClip, 0, lastRow + 1);
+	}
+}
+
+void SoftwareRenderer::DrawColumn(int32_t x, int32_t top, int32_t bottom, int32_t texture, float u, float v, float step, const RGBALookup& lookup)
+{
+	if (texture < 0 || top > bottom) return;
+	const WallTexture& wallTexture = m_Textures[texture];
+	uint32_t height = wallTexture.height;
+	const uint8_t* source = m_TextureData.data() + wallTexture.offset + (size_t)Wrap((int32_t)floorf(u), wallTexture.width) * height;
+	uint32_t* dest = m_Columns.data() + (size_t)x * m_Height + top;
+	int32_t count = bottom - top + 1;
+
+	// 16.16 fixed point like Doom's column drawer
+	uint32_t heightFixed = height << 16;
+	float wrapped = fmodf(v, (float)height);
+	if (wrapped < 0.0f) wrapped += height;
+	uint32_t frac = (uint32_t)(wrapped * 65536.0f) % heightFixed;
+	uint32_t fracStep = (uint32_t)(step * 65536.0f) % heightFixed;
+
+	if ((height & (height - 1)) == 0) {
+		uint32_t mask = height - 1;
+		for (int32_t i = 0; i < count; ++i) {
+			dest[i] = lookup.colors[source[(frac >> 16) & mask]];
+			frac += fracStep;
+		}
+		return;
+	}
+	for (int32_t i = 0; i < count; ++i) {
+		dest[i] = lookup.colors[source[frac >> 16]];
+		frac += fracStep;
+		if (frac >= heightFixed) frac -= heightFixed;
+	}
+}
+
+int32_t SoftwareRenderer::FindPlane(Strip& strip, int32_t height, int32_t flat, int32_t light)
+{
+	// Every sky looks the same no matter the height or light
+	if (flat == SKY_FLAT) height = light = 0;
+
+	for (size_t i = 0; i < strip.planeCount; ++i) {
+		const Visplane& plane = strip.planes[i];
+		if (plane.height == height && plane.flat == flat && plane.light == light) return (int32_t)i;
+	}
+
+	return NewPlane(strip, height, flat, light);
+}
+
+int32_t SoftwareRenderer::NewPlane(Strip& strip, int32_t height, int32_t flat, int32_t light)
+{
+	if (strip.planeCount == strip.planes.size()) {
+		strip.planes.emplace_back();
+		strip.planes.back().top.resize(strip.x1 - strip.x0 + 2);
+		strip.planes.back().bottom.resize(strip.x1 - strip.x0 + 2);
+	}
+	Visplane& plane = strip.planes[strip.planeCount];
+	plane.height = height;
+	plane.flat = flat;
+	plane.light = light;
+	plane.minX = strip.x1;
+	plane.maxX = strip.x0 - 1;
+	std::fill(plane.top.begin(), plane.top.end(), (uint16_t)UNUSED_ROW);
+	return (int32_t)strip.planeCount++;
+}
+
+int32_t SoftwareRenderer::CheckPlane(Strip& strip, int32_t index, int32_t start, int32_t stop)
+{
+	Visplane& plane = strip.planes[index];
+	int32_t intersectFirst = std::max(start, plane.minX);
+	int32_t intersectLast = std::min(stop, plane.maxX);
+
+	int32_t x = intersectFirst;
+	for (; x <= intersectLast; ++x) {
+		if (plane.top[x - strip.x0 + 1] != UNUSED_ROW) break;
+	}
+
+	// The plane is free over the new range, grow it
+	if (x > intersectLast) {
+		plane.minX = std::min(start, plane.minX);
+		plane.maxX = std::max(stop, plane.maxX);
+		return index;
+	}
+
+	// Otherwise the columns overlap and the range needs a plane of its own
+	int32_t added = NewPlane(strip, plane.height, plane.flat, plane.light);
+	strip.planes[added].minX = start;
+	strip.planes[added].maxX = stop;
+	return added;
+}
+
+void SoftwareRenderer::DrawPlanes(const Frame& frame, Strip& strip)
+{
+	strip.stats.visplanes += strip.planeCount;
+
+	for (size_t i = 0; i < strip.planeCount; ++i) {
+		Visplane& plane = strip.planes[i];
+		if (plane.minX > plane.maxX) continue;
+
+		if (plane.flat == SKY_FLAT) {
+			DrawSkyPlane(frame, plane, strip.x0);
+			continue;
+		}
+
+		// Doom's R_MakeSpans, turns the columns of the plane into horizontal spans.
+		// A span starts when a row enters the plane and is drawn when it leaves
+		int32_t first = plane.minX - strip.x0 + 1;
+		int32_t last = plane.maxX - strip.x0 + 1;
+		plane.top[first - 1] = UNUSED_ROW;
+		plane.top[last + 1] = UNUSED_ROW;
+		plane.bottom[first - 1] = 0;
+		plane.bottom[last + 1] = 0;
+
+		for (int32_t index = first; index <= last + 1; ++index) {
+			int32_t x = index - 1 + strip.x0;
+			int32_t t1 = plane.top[index - 1], b1 = plane.bottom[index - 1];
+			int32_t t2 = plane.top[index], b2 = plane.bottom[index];
+
+			while (t1 < t2 && t1 <= b1) {
+				MapPlane(frame, plane, t1, strip.spanStart[t1], x - 1);
+				strip.stats.spans++;
+				t1++;
+			}
+			while (b1 > b2 && b1 >= t1) {
+				MapPlane(frame, plane, b1, strip.spanStart[b1], x - 1);
+				strip.stats.spans++;
+				b1--;
+			}
+			while (t2 < t1 && t2 <= b2) strip.spanStart[t2++] = x;
+			while (b2 > b1 && b2 >= t2) strip.spanStart[b2--] = x;
+		}
+	}
+}
+
+void SoftwareRenderer::MapPlane(const Frame& frame, const Visplane& plane, int32_t y, int32_t x1, int32_t x2)
+{
+	const Flat& flat = m_Flats[plane.flat];
+	float planeZ = fabsf(plane.height - frame.camera.z);
+	float distance = planeZ * frame.focal / fabsf(y + 0.5f - frame.centerY);
+	float pixelSize = distance / frame.focal;
+	const RGBALookup& lookup = m_Lookups[FlatShade(plane.light, distance)];
+
+	// World position under the center of column 0, flats are addressed with y flipped like Doom.
+	// Stepping from column 0 instead of x1 gives the same texels no matter where spans get split
+	float offset = 0.5f - frame.centerX;
+	float worldX = frame.camera.x + distance * frame.cosAngle + offset * pixelSize * frame.sinAngle;
+	float worldY = frame.camera.y + distance * frame.sinAngle - offset * pixelSize * frame.cosAngle;
+
+	uint32_t uStep = (uint32_t)(int64_t)(pixelSize * frame.sinAngle * 65536.0f);
+	uint32_t vStep = (uint32_t)(int64_t)(pixelSize * frame.cosAngle * 65536.0f);
+	uint32_t u = (uint32_t)(int64_t)(worldX * 65536.0f) + uStep * (uint32_t)x1;
+	uint32_t v = (uint32_t)(int64_t)(-worldY * 65536.0f) + vStep * (uint32_t)x1;
+
+	const uint8_t* pixels = flat.pixels;
+	uint32_t mask = flat.sizeMask, shift = flat.shift;
+	uint32_t* dest = m_Columns.data() + (size_t)x1 * m_Height + y;
+	for (int32_t x = x1; x <= x2; ++x) {
+		*dest = lookup.colors[pixels[(((v >> 16) & mask) << shift) | ((u >> 16) & mask)]];
+		dest += m_Height;
+		u += uStep;
+		v += vStep;
+	}
+}
+
+void SoftwareRenderer::DrawSkyPlane(const Frame& frame, const Visplane& plane, int32_t x0)
+{
+	// Sky is drawn at full brightness and doesn't move with the camera's position
+	const RGBALookup& lookup = m_Lookups[0];
+	float step = 320.0f / m_Width;
+
+	for (int32_t x = plane.minX; x <= plane.maxX; ++x) {
+		int32_t top = plane.top[x - x0 + 1];
+		int32_t bottom = plane.bottom[x - x0 + 1];
+		if (top == UNUSED_ROW || top > bottom) continue;
+
+		if (m_SkyTexture < 0) {
+			uint32_t* dest = m_Columns.data() + (size_t)x * m_Height;
+			std::fill(dest + top, dest + bottom + 1, lookup.colors[0]);
+			continue;
+		}
+		float angle = frame.camera.angle + atanf((frame.centerX - x - 0.5f) / frame.focal);
+		float u = angle / (2.0f * PI) * SKY_COLUMNS;
+		float v = SKY_MIDDLE + (top + 0.5f - frame.centerY) * step;
+		DrawColumn(x, top, bottom, m_SkyTexture, u, v, step, lookup);
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "Map.h"
+#include "BSP.h"
+#include "Graphics.h"
+#include "Textures.h"
+#include "ThreadPool.h"
+
+// Light levels like Doom's r_main, COLORMAP 0 - 31 go from full bright to black
+#define LIGHT_LEVELS    16
+#define SHADE_LEVELS    32
+#define PLAYER_HEIGHT   41
+// Sectors with F_SKY1 as their ceiling show the sky instead
+#define SKY_FLAT        -1
+
+struct RenderCamera {
+	float x;
+	float y;
+	// Eye height in map units
+	float z;
+	// Radians, counter clockwise from east
+	float angle;
+};
+
+struct RenderStats {
+	size_t subSectors = 0;
+	size_t segments = 0;
+	size_t wallColumns = 0;
+	size_t visplanes = 0;
+	size_t spans = 0;
+};
+
+// Draws a first person view of a map into an RGBA framebuffer, the way vanilla Doom does
+// BSP walk front to back, walls clipped against a solid seg list, walls drawn as columns
+// and floors / ceilings collected into visplanes that are drawn as spans.
+// The screen is split into column strips that render independently, each strip walks
+// the BSP inside its own part of the view cone so strips never touch the same pixels
+class SoftwareRenderer {
+public:
+	// Everything passed in has to stay alive as long as the renderer
+	SoftwareRenderer(WAD* wad, const Map* map, const BSP* bsp, const TextureAtlas* atlas, uint32_t width, uint32_t height);
+	~SoftwareRenderer();
+
+	// pool can be null to render on the calling thread
+	void Render(const RenderCamera& camera, ThreadPool* pool = nullptr);
+
+	// Floor height of the sector under a point, for placing the camera
+	float GetFloorHeight(float x, float y) const;
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	// Last rendered frame, row by row from the top left
+	const std::vector<uint32_t>& GetFramebuffer() const { return m_Framebuffer; }
+	const RenderStats& GetStats() const { return m_Stats; }
+
+private:
+	struct Visplane;
+	struct Strip;
+	struct Frame;
+	struct WallSetup;
+
+	void RenderStrip(const Frame& frame, Strip& strip);
+	void AddSegment(const Frame& frame, Strip& strip, uint32_t segment);
+	void StoreWallRange(const Frame& frame, Strip& strip, const WallSetup& wall, int32_t start, int32_t stop);
+	void DrawPlanes(const Frame& frame, Strip& strip);
+	void DrawSkyPlane(const Frame& frame, const Visplane& plane, int32_t x0);
+	void MapPlane(const Frame& frame, const Visplane& plane, int32_t y, int32_t x1, int32_t x2);
+	void DrawColumn(int32_t x, int32_t top, int32_t bottom, int32_t texture, float u, float v, float step, const RGBALookup& lookup);
+
+	// Planes are referred to by index since adding one can move the others
+	int32_t FindPlane(Strip& strip, int32_t height, int32_t flat, int32_t light);
+	int32_t CheckPlane(Strip& strip, int32_t plane, int32_t start, int32_t stop);
+	int32_t NewPlane(Strip& strip, int32_t height, int32_t flat, int32_t light);
+
+	// Wall texture as columns so drawing a wall column reads memory in order
+	struct WallTexture {
+		uint32_t offset;
+		uint16_t width;
+		uint16_t height;
+	};
+	// 64 x 64 ( or any power of two square ) flat, row by row
+	struct Flat {
+		const uint8_t* pixels;
+		uint32_t sizeMask;
+		uint32_t shift;
+	};
+
+private:
+	const Map* m_Map;
+	const BSP* m_BSP;
+	uint32_t m_Width;
+	uint32_t m_Height;
+
+	std::vector<uint32_t> m_Framebuffer;
+	// Strips draw into this column by column, it's turned into m_Framebuffer at the end of a frame
+	std::vector<uint32_t> m_Columns;
+
+	std::vector<RGBALookup> m_Lookups;
+	std::vector<uint8_t> m_TextureData;
+	std::vector<WallTexture> m_Textures;
+	ImageCache m_FlatCache;
+	std::vector<Flat> m_Flats;
+	int32_t m_SkyTexture = -1;
+
+	// Per side def: upper, lower and middle texture, -1 for none
+	std::vector<int32_t> m_SideTextures;
+	// Per sector: floor and ceiling index into m_Flats, SKY_FLAT for the sky
+	std::vector<int32_t> m_SectorFlats;
+	// Sector of each sub sector
+	std::vector<uint16_t> m_SubSectorSectors;
+
+	std::vector<Strip> m_Strips;
+	RenderStats m_Stats;
+};
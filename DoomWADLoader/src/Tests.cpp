@@ -0,0 +1,1595 @@
+#include "Tests.h"
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include "Map.h"
+#include "WADWriter.h"
+#include "BSP.h"
+#include "NodeBuilder.h"
+#include "Blockmap.h"
+#include "ThreadPool.h"
+#include "Textures.h"
+#include "WADStack.h"
+#include "Reject.h"
+
+#ifdef PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+// Core.h's ERROR would be replaced by wingdi's
+#define NOGDI
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	struct TestRun {
+		size_t passed = 0;
+		size_t failed = 0;
+	};
+
+	void Check(TestRun* run, bool passed, const std::string& name, const std::string& detail = "") {
+		std::cout << (passed ? "pass " : "FAIL ") << name;
+		if (!passed && !detail.empty()) std::cout << ": " << detail;
+		std::cout << std::endl;
+		if (passed) run->passed++;
+		else run->failed++;
+	}
+
+	std::string TempPath(const std::string& name) {
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	// Little endian lump data written field by field, independent of how the loader reads it
+	struct LumpBuilder {
+		std::vector<uint8_t> bytes;
+
+		void UInt8(uint8_t value) { bytes.push_back(value); }
+		void UInt16(uint16_t value) {
+			bytes.push_back((uint8_t)(value & 0xFF));
+			bytes.push_back((uint8_t)(value >> 8));
+		}
+		void Int16(int16_t value) { UInt16((uint16_t)value); }
+		void UInt32(uint32_t value) {
+			UInt16((uint16_t)(value & 0xFFFF));
+			UInt16((uint16_t)(value >> 16));
+		}
+		void Int32(int32_t value) { UInt32((uint32_t)value); }
+		// Padded with zeroes to 8 characters
+		void Name(const std::string& name) {
+			for (size_t i = 0; i < 8; ++i) bytes.push_back(i < name.size() ? (uint8_t)name[i] : 0);
+		}
+	};
+
+	bool WriteTestWAD(const std::string& path, const std::vector<std::pair<std::string, LumpBuilder>>& lumps) {
+		WADWriter writer;
+		if (!writer.Open(path)) return false;
+		for (auto& [name, lump] : lumps) {
+			if (!writer.AddLump(name, lump.bytes.data(), (uint32_t)lump.bytes.size())) return false;
+		}
+		return writer.Finish();
+	}
+
+	// Lump that views the builder's bytes, the builder has to outlive it
+	Lump ViewLump(const LumpBuilder& builder) {
+		Lump lump;
+		lump.data = builder.bytes.data();
+		lump.size = (uint32_t)builder.bytes.size();
+		return lump;
+	}
+
+	// Generated maps ==================
+
+	#define GRID_CELL_SIZE 128
+
+	// A grid of four sided sectors with the inner corners moved around so lines aren't axis aligned,
+	// some cells are left out as solid walls. Every other cell is its own sector
+	struct GridMap {
+		Map map;
+		int32_t columns = 0;
+		int32_t rows = 0;
+		// Sector of each cell, -1 for solid cells
+		std::vector<int32_t> cellSector;
+		// Corners of the grid, ( columns + 1 ) * ( rows + 1 ) of them
+		std::vector<float> cornerX;
+		std::vector<float> cornerY;
+
+		// A point inside the cell, u and v go from 0 to 1 across it
+		void CellPoint(int32_t column, int32_t row, float u, float v, float* x, float* y) const {
+			int32_t corners[4] = {
+				row * (columns + 1) + column, row * (columns + 1) + column + 1,
+				(row + 1) * (columns + 1) + column, (row + 1) * (columns + 1) + column + 1
+			};
+			float bottomX = cornerX[corners[0]] + (cornerX[corners[1]] - cornerX[corners[0]]) * u;
+			float bottomY = cornerY[corners[0]] + (cornerY[corners[1]] - cornerY[corners[0]]) * u;
+			float topX = cornerX[corners[2]] + (cornerX[corners[3]] - cornerX[corners[2]]) * u;
+			float topY = cornerY[corners[2]] + (cornerY[corners[3]] - cornerY[corners[2]]) * u;
+			*x = bottomX + (topX - bottomX) * v;
+			*y = bottomY + (topY - bottomY) * v;
+		}
+	};
+
+	void MakeGridMap(GridMap* grid, int32_t columns, int32_t rows, float solidChance, uint32_t seed) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		Map& map = grid->map;
+		map = Map();
+		map.name = "MAP01";
+		grid->columns = columns;
+		grid->rows = rows;
+
+		// Corners on the edge of the grid stay put so the outside is a rectangle
+		grid->cornerX.resize((size_t)(columns + 1) * (rows + 1));
+		grid->cornerY.resize(grid->cornerX.size());
+		map.vertices.resize(grid->cornerX.size());
+		for (int32_t y = 0; y <= rows; ++y) {
+			for (int32_t x = 0; x <= columns; ++x) {
+				bool edge = x == 0 || y == 0 || x == columns || y == rows;
+				int32_t jitterX = edge ? 0 : (int32_t)(random() % 65) - 32;
+				int32_t jitterY = edge ? 0 : (int32_t)(random() % 65) - 32;
+				size_t corner = (size_t)y * (columns + 1) + x;
+				map.vertices.x[corner] = (int16_t)(x * GRID_CELL_SIZE + jitterX);
+				map.vertices.y[corner] = (int16_t)(y * GRID_CELL_SIZE + jitterY);
+				grid->cornerX[corner] = map.vertices.x[corner];
+				grid->cornerY[corner] = map.vertices.y[corner];
+			}
+		}
+
+		grid->cellSector.assign((size_t)columns * rows, -1);
+		for (int32_t cell = 0; cell < columns * rows; ++cell) {
+			if (unit(random) < solidChance) continue;
+			grid->cellSector[cell] = (int32_t)map.sectors.size();
+			size_t sector = map.sectors.size();
+			map.sectors.resize(sector + 1);
+			map.sectors.floorHeight[sector] = (int16_t)(random() % 64);
+			map.sectors.ceilingHeight[sector] = (int16_t)(128 + random() % 64);
+			map.sectors.floorTexture[sector] = PackLumpName("FLOOR4_8");
+			map.sectors.ceilingTexture[sector] = PackLumpName("CEIL3_5");
+			map.sectors.lightLevel[sector] = 160;
+		}
+
+		auto sectorAt = [grid](int32_t column, int32_t row) {
+			if (column < 0 || row < 0 || column >= grid->columns || row >= grid->rows) return -1;
+			return grid->cellSector[(size_t)row * grid->columns + column];
+		};
+		auto addSide = [&map](int32_t sector) {
+			size_t side = map.sideDefs.size();
+			map.sideDefs.resize(side + 1);
+			map.sideDefs.middleTexture[side] = PackLumpName("STARTAN3");
+			map.sideDefs.sector[side] = (uint16_t)sector;
+			return (uint16_t)side;
+		};
+		// right is the sector on the right of start -> end
+		auto addLine = [&](uint16_t start, uint16_t end, int32_t right, int32_t left) {
+			if (right < 0 && left < 0) return;
+			if (right < 0) {
+				std::swap(start, end);
+				std::swap(right, left);
+			}
+			size_t line = map.lineDefs.size();
+			map.lineDefs.resize(line + 1);
+			map.lineDefs.startVertex[line] = start;
+			map.lineDefs.endVertex[line] = end;
+			map.lineDefs.flags[line] = (left < 0) ? 1 : 4;
+			map.lineDefs.frontSide[line] = addSide(right);
+			map.lineDefs.backSide[line] = (left < 0) ? NO_SIDEDEF : addSide(left);
+		};
+
+		for (int32_t y = 0; y <= rows; ++y) {
+			for (int32_t x = 0; x <= columns; ++x) {
+				uint16_t corner = (uint16_t)(y * (columns + 1) + x);
+				// Going right the cell below is on the right, going up the cell to the right is
+				if (x < columns) addLine(corner, corner + 1, sectorAt(x, y - 1), sectorAt(x, y));
+				if (y < rows) addLine(corner, (uint16_t)(corner + columns + 1), sectorAt(x, y), sectorAt(x - 1, y));
+			}
+		}
+
+		// A few things in every open cell
+		for (int32_t row = 0; row < rows; ++row) {
+			for (int32_t column = 0; column < columns; ++column) {
+				if (sectorAt(column, row) < 0) continue;
+				for (int i = 0; i < 2; ++i) {
+					float x, y;
+					grid->CellPoint(column, row, 0.1f + unit(random) * 0.8f, 0.1f + unit(random) * 0.8f, &x, &y);
+					size_t thing = map.things.size();
+					map.things.resize(thing + 1);
+					map.things.x[thing] = (int16_t)x;
+					map.things.y[thing] = (int16_t)y;
+					map.things.type[thing] = (thing == 0) ? 1 : 3004;
+					map.things.flags[thing] = 7;
+				}
+			}
+		}
+	}
+
+	// Doom format lumps for the whole map, marker first
+	void AddMapLumps(const Map& map, std::vector<std::pair<std::string, LumpBuilder>>* lumps) {
+		LumpBuilder things, lineDefs, sideDefs, sectors;
+		for (size_t i = 0; i < map.things.size(); ++i) {
+			things.Int16(map.things.x[i]);
+			things.Int16(map.things.y[i]);
+			things.Int16(map.things.angle[i]);
+			things.Int16(map.things.type[i]);
+			things.Int16(map.things.flags[i]);
+		}
+		for (size_t i = 0; i < map.lineDefs.size(); ++i) {
+			lineDefs.UInt16(map.lineDefs.startVertex[i]);
+			lineDefs.UInt16(map.lineDefs.endVertex[i]);
+			lineDefs.UInt16(map.lineDefs.flags[i]);
+			lineDefs.UInt16(map.lineDefs.special[i]);
+			lineDefs.UInt16(map.lineDefs.tag[i]);
+			lineDefs.UInt16(map.lineDefs.frontSide[i]);
+			lineDefs.UInt16(map.lineDefs.backSide[i]);
+		}
+		auto texture = [](uint64_t id) { return id ? UnpackLumpName(id) : std::string("-"); };
+		for (size_t i = 0; i < map.sideDefs.size(); ++i) {
+			sideDefs.Int16(map.sideDefs.xOffset[i]);
+			sideDefs.Int16(map.sideDefs.yOffset[i]);
+			sideDefs.Name(texture(map.sideDefs.upperTexture[i]));
+			sideDefs.Name(texture(map.sideDefs.lowerTexture[i]));
+			sideDefs.Name(texture(map.sideDefs.middleTexture[i]));
+			sideDefs.UInt16(map.sideDefs.sector[i]);
+		}
+		for (size_t i = 0; i < map.sectors.size(); ++i) {
+			sectors.Int16(map.sectors.floorHeight[i]);
+			sectors.Int16(map.sectors.ceilingHeight[i]);
+			sectors.Name(texture(map.sectors.floorTexture[i]));
+			sectors.Name(texture(map.sectors.ceilingTexture[i]));
+			sectors.Int16(map.sectors.lightLevel[i]);
+			sectors.Int16(map.sectors.specialType[i]);
+			sectors.Int16(map.sectors.tagNumber[i]);
+		}
+		NodeLumps nodeLumps;
+		EncodeNodeLumps(&map, &nodeLumps);
+
+		lumps->push_back({ map.name, {} });
+		lumps->push_back({ "THINGS", things });
+		lumps->push_back({ "LINEDEFS", lineDefs });
+		lumps->push_back({ "SIDEDEFS", sideDefs });
+		lumps->push_back({ "VERTEXES", { nodeLumps.vertices } });
+		lumps->push_back({ "SEGS", { nodeLumps.segments } });
+		lumps->push_back({ "SSECTORS", { nodeLumps.subSectors } });
+		lumps->push_back({ "NODES", { nodeLumps.nodes } });
+		lumps->push_back({ "SECTORS", sectors });
+	}
+
+	// Sector a sub sector belongs to, through its first seg
+	int32_t SubSectorSector(const Map* map, uint16_t subSector) {
+		const Segments& segments = map->segments;
+		uint16_t seg = map->subSectors.firstSegment[subSector];
+		uint16_t line = segments.lineDef[seg];
+		uint16_t side = segments.direction[seg] ? map->lineDefs.backSide[line] : map->lineDefs.frontSide[line];
+		return map->sideDefs.sector[side];
+	}
+
+	// Map decode ======================
+
+	// Random records for every map lump, written as raw lumps and read back with LoadMap
+	void TestMapDecode(TestRun* run) {
+		std::mt19937 random(30);
+		auto value = [&]() { return (int16_t)(random() & 0xFFFF); };
+		const std::string textures[] = { "STARTAN3", "-", "comptall", "SKY1", "BIGDOOR2", "F_SKY1" };
+		auto texture = [&]() { return textures[random() % 6]; };
+		// Lowercase names are uppercased and "-" is no texture, same as the loader
+		auto packed = [](const std::string& name) { return name == "-" ? 0 : PackLumpName(name); };
+
+		const size_t count = 257;
+		std::vector<int16_t> fields[16];
+		std::vector<std::string> names[3];
+		auto fill = [&](size_t fieldCount, size_t nameCount) {
+			for (size_t f = 0; f < fieldCount; ++f) {
+				fields[f].resize(count);
+				for (auto& v : fields[f]) v = value();
+			}
+			for (size_t n = 0; n < nameCount; ++n) {
+				names[n].resize(count);
+				for (auto& v : names[n]) v = texture();
+			}
+		};
+
+		std::vector<std::pair<std::string, LumpBuilder>> lumps;
+		lumps.push_back({ "MAP01", {} });
+		Map expected;
+
+		fill(5, 0);
+		LumpBuilder things;
+		expected.things.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t f = 0; f < 5; ++f) things.Int16(fields[f][i]);
+			expected.things.x[i] = fields[0][i];
+			expected.things.y[i] = fields[1][i];
+			expected.things.angle[i] = fields[2][i];
+			expected.things.type[i] = fields[3][i];
+			expected.things.flags[i] = fields[4][i];
+		}
+		lumps.push_back({ "THINGS", things });
+
+		fill(7, 0);
+		LumpBuilder lineDefs;
+		expected.lineDefs.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t f = 0; f < 7; ++f) lineDefs.Int16(fields[f][i]);
+			expected.lineDefs.startVertex[i] = (uint16_t)fields[0][i];
+			expected.lineDefs.endVertex[i] = (uint16_t)fields[1][i];
+			expected.lineDefs.flags[i] = (uint16_t)fields[2][i];
+			expected.lineDefs.special[i] = (uint16_t)fields[3][i];
+			expected.lineDefs.tag[i] = (uint16_t)fields[4][i];
+			expected.lineDefs.frontSide[i] = (uint16_t)fields[5][i];
+			expected.lineDefs.backSide[i] = (uint16_t)fields[6][i];
+		}
+		lumps.push_back({ "LINEDEFS", lineDefs });
+
+		fill(3, 3);
+		LumpBuilder sideDefs;
+		expected.sideDefs.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			sideDefs.Int16(fields[0][i]);
+			sideDefs.Int16(fields[1][i]);
+			for (size_t n = 0; n < 3; ++n) sideDefs.Name(names[n][i]);
+			sideDefs.Int16(fields[2][i]);
+			expected.sideDefs.xOffset[i] = fields[0][i];
+			expected.sideDefs.yOffset[i] = fields[1][i];
+			expected.sideDefs.upperTexture[i] = packed(names[0][i]);
+			expected.sideDefs.lowerTexture[i] = packed(names[1][i]);
+			expected.sideDefs.middleTexture[i] = packed(names[2][i]);
+			expected.sideDefs.sector[i] = (uint16_t)fields[2][i];
+		}
+		lumps.push_back({ "SIDEDEFS", sideDefs });
+
+		fill(2, 0);
+		LumpBuilder vertices;
+		expected.vertices.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			vertices.Int16(fields[0][i]);
+			vertices.Int16(fields[1][i]);
+			expected.vertices.x[i] = fields[0][i];
+			expected.vertices.y[i] = fields[1][i];
+		}
+		lumps.push_back({ "VERTEXES", vertices });
+
+		fill(6, 0);
+		LumpBuilder segments;
+		expected.segments.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t f = 0; f < 6; ++f) segments.Int16(fields[f][i]);
+			expected.segments.startVertex[i] = (uint16_t)fields[0][i];
+			expected.segments.endVertex[i] = (uint16_t)fields[1][i];
+			expected.segments.angle[i] = fields[2][i];
+			expected.segments.lineDef[i] = (uint16_t)fields[3][i];
+			expected.segments.direction[i] = fields[4][i];
+			expected.segments.offset[i] = fields[5][i];
+		}
+		lumps.push_back({ "SEGS", segments });
+
+		fill(2, 0);
+		LumpBuilder subSectors;
+		expected.subSectors.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			subSectors.Int16(fields[0][i]);
+			subSectors.Int16(fields[1][i]);
+			expected.subSectors.segmentCount[i] = (uint16_t)fields[0][i];
+			expected.subSectors.firstSegment[i] = (uint16_t)fields[1][i];
+		}
+		lumps.push_back({ "SSECTORS", subSectors });
+
+		fill(14, 0);
+		LumpBuilder nodes;
+		expected.nodes.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			for (size_t f = 0; f < 14; ++f) nodes.Int16(fields[f][i]);
+			expected.nodes.x[i] = fields[0][i];
+			expected.nodes.y[i] = fields[1][i];
+			expected.nodes.xDelta[i] = fields[2][i];
+			expected.nodes.yDelta[i] = fields[3][i];
+			expected.nodes.rightBox[i] = { fields[4][i], fields[5][i], fields[6][i], fields[7][i] };
+			expected.nodes.leftBox[i] = { fields[8][i], fields[9][i], fields[10][i], fields[11][i] };
+			expected.nodes.rightChild[i] = (uint16_t)fields[12][i];
+			expected.nodes.leftChild[i] = (uint16_t)fields[13][i];
+		}
+		lumps.push_back({ "NODES", nodes });
+
+		fill(5, 2);
+		LumpBuilder sectors;
+		expected.sectors.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			sectors.Int16(fields[0][i]);
+			sectors.Int16(fields[1][i]);
+			sectors.Name(names[0][i]);
+			sectors.Name(names[1][i]);
+			for (size_t f = 2; f < 5; ++f) sectors.Int16(fields[f][i]);
+			expected.sectors.floorHeight[i] = fields[0][i];
+			expected.sectors.ceilingHeight[i] = fields[1][i];
+			expected.sectors.floorTexture[i] = packed(names[0][i]);
+			expected.sectors.ceilingTexture[i] = packed(names[1][i]);
+			expected.sectors.lightLevel[i] = fields[2][i];
+			expected.sectors.specialType[i] = fields[3][i];
+			expected.sectors.tagNumber[i] = fields[4][i];
+		}
+		lumps.push_back({ "SECTORS", sectors });
+
+		LumpBuilder reject;
+		for (size_t i = 0; i < (count * count + 7) / 8; ++i) reject.UInt8((uint8_t)random());
+		expected.reject = reject.bytes;
+		lumps.push_back({ "REJECT", reject });
+
+		LumpBuilder blockMap;
+		blockMap.Int16(-768);
+		blockMap.Int16(1024);
+		blockMap.UInt16(3);
+		blockMap.UInt16(2);
+		for (int i = 0; i < 6; ++i) blockMap.UInt16(10);
+		blockMap.UInt16(0);
+		blockMap.UInt16(0xFFFF);
+		lumps.push_back({ "BLOCKMAP", blockMap });
+
+		std::string path = TempPath("doom_test_map.wad");
+		WAD wad;
+		Map map;
+		map.name = "MAP01";
+		std::string error;
+		bool loaded = WriteTestWAD(path, lumps) && TryLoadWAD(path, &wad, &error);
+		Check(run, loaded, "map decode: write and load test WAD", error);
+		if (!loaded) return;
+		LoadMap(&wad, &map);
+
+		Check(run, map.things.x == expected.things.x && map.things.y == expected.things.y && map.things.angle == expected.things.angle
+			&& map.things.type == expected.things.type && map.things.flags == expected.things.flags, "map decode: THINGS");
+		const LineDefs& a = map.lineDefs;
+		const LineDefs& b = expected.lineDefs;
+		Check(run, a.startVertex == b.startVertex && a.endVertex == b.endVertex && a.flags == b.flags && a.special == b.special
+			&& a.tag == b.tag && a.frontSide == b.frontSide && a.backSide == b.backSide, "map decode: LINEDEFS");
+		Check(run, map.sideDefs.xOffset == expected.sideDefs.xOffset && map.sideDefs.yOffset == expected.sideDefs.yOffset
+			&& map.sideDefs.upperTexture == expected.sideDefs.upperTexture && map.sideDefs.lowerTexture == expected.sideDefs.lowerTexture
+			&& map.sideDefs.middleTexture == expected.sideDefs.middleTexture && map.sideDefs.sector == expected.sideDefs.sector, "map decode: SIDEDEFS");
+		Check(run, map.vertices.x == expected.vertices.x && map.vertices.y == expected.vertices.y, "map decode: VERTEXES");
+		Check(run, map.segments.startVertex == expected.segments.startVertex && map.segments.endVertex == expected.segments.endVertex
+			&& map.segments.angle == expected.segments.angle && map.segments.lineDef == expected.segments.lineDef
+			&& map.segments.direction == expected.segments.direction && map.segments.offset == expected.segments.offset, "map decode: SEGS");
+		Check(run, map.subSectors.segmentCount == expected.subSectors.segmentCount && map.subSectors.firstSegment == expected.subSectors.firstSegment, "map decode: SSECTORS");
+
+		bool sameNodes = map.nodes.x == expected.nodes.x && map.nodes.y == expected.nodes.y && map.nodes.xDelta == expected.nodes.xDelta
+			&& map.nodes.yDelta == expected.nodes.yDelta && map.nodes.rightChild == expected.nodes.rightChild && map.nodes.leftChild == expected.nodes.leftChild
+			&& map.nodes.size() == count;
+		for (size_t i = 0; i < map.nodes.size() && sameNodes; ++i) {
+			const BoundingBox* boxes[4] = { &map.nodes.rightBox[i], &expected.nodes.rightBox[i], &map.nodes.leftBox[i], &expected.nodes.leftBox[i] };
+			for (int side = 0; side < 4; side += 2) {
+				const BoundingBox& x = *boxes[side];
+				const BoundingBox& y = *boxes[side + 1];
+				sameNodes &= x.top == y.top && x.bottom == y.bottom && x.left == y.left && x.right == y.right;
+			}
+		}
+		Check(run, sameNodes, "map decode: NODES");
+
+		Check(run, map.sectors.floorHeight == expected.sectors.floorHeight && map.sectors.ceilingHeight == expected.sectors.ceilingHeight
+			&& map.sectors.floorTexture == expected.sectors.floorTexture && map.sectors.ceilingTexture == expected.sectors.ceilingTexture
+			&& map.sectors.lightLevel == expected.sectors.lightLevel && map.sectors.specialType == expected.sectors.specialType
+			&& map.sectors.tagNumber == expected.sectors.tagNumber, "map decode: SECTORS");
+		Check(run, map.reject == expected.reject, "map decode: REJECT");
+		Check(run, map.blockMap.originX == -768 && map.blockMap.originY == 1024 && map.blockMap.columns == 3 && map.blockMap.rows == 2
+			&& map.blockMap.data.size() == blockMap.bytes.size() / 2 && map.blockMap.data[4] == 10, "map decode: BLOCKMAP header");
+
+		// A lump with a partial record at the end only decodes the whole records
+		lumps.clear();
+		lumps.push_back({ "E1M1", {} });
+		LumpBuilder partial;
+		for (int i = 0; i < 3; ++i) {
+			partial.Int16((int16_t)(i * 64));
+			partial.Int16((int16_t)(-i * 32));
+		}
+		partial.UInt16(7);
+		lumps.push_back({ "THINGS", {} });
+		lumps.push_back({ "VERTEXES", partial });
+		WAD partialWAD;
+		Map partialMap;
+		partialMap.name = "E1M1";
+		loaded = WriteTestWAD(path, lumps) && TryLoadWAD(path, &partialWAD, &error);
+		if (loaded) LoadMap(&partialWAD, &partialMap);
+		Check(run, loaded && partialMap.vertices.size() == 3 && partialMap.vertices.x[2] == 128 && partialMap.vertices.y[2] == -64
+			&& partialMap.lineDefs.size() == 0 && partialMap.sectors.size() == 0, "map decode: partial records and missing lumps");
+	}
+
+	// BSP queries =====================
+
+	// Doom's R_PointInSubsector straight over the map's own nodes, root last
+	uint16_t ReferenceFindSubSector(const Map* map, float x, float y) {
+		const Nodes& nodes = map->nodes;
+		if (nodes.size() == 0) return 0;
+		uint16_t child = (uint16_t)(nodes.size() - 1);
+		while (!(child & SUBSECTOR_FLAG)) {
+			BSPNode node = { nodes.x[child], nodes.y[child], nodes.xDelta[child], nodes.yDelta[child], {}, {}, 0 };
+			child = BSP::PointOnSide(x, y, node) ? nodes.leftChild[child] : nodes.rightChild[child];
+		}
+		return child & ~SUBSECTOR_FLAG;
+	}
+
+	// Doom's R_RenderBSPNode over the map's own nodes, with the front box culled as well
+	void ReferenceFrontToBack(const Map* map, uint16_t child, const BSPView& view, Angle viewAngle, Angle clipAngle, std::vector<uint16_t>* result) {
+		if (child & SUBSECTOR_FLAG) {
+			result->push_back(child & ~SUBSECTOR_FLAG);
+			return;
+		}
+		const Nodes& nodes = map->nodes;
+		BSPNode node = { nodes.x[child], nodes.y[child], nodes.xDelta[child], nodes.yDelta[child], {}, {}, 0 };
+		int side = BSP::PointOnSide(view.x, view.y, node);
+		const BoundingBox& front = side ? nodes.leftBox[child] : nodes.rightBox[child];
+		const BoundingBox& back = side ? nodes.rightBox[child] : nodes.leftBox[child];
+		uint16_t frontChild = side ? nodes.leftChild[child] : nodes.rightChild[child];
+		uint16_t backChild = side ? nodes.rightChild[child] : nodes.leftChild[child];
+
+		if (BSP::BoxInView(front, view, viewAngle, clipAngle)) ReferenceFrontToBack(map, frontChild, view, viewAngle, clipAngle, result);
+		if (BSP::BoxInView(back, view, viewAngle, clipAngle)) ReferenceFrontToBack(map, backChild, view, viewAngle, clipAngle, result);
+	}
+
+	// The reordered BSP has to find the same sub sectors as walking the map's nodes, and the
+	// sub sector has to be the one the point is really in
+	void TestBSPQueries(TestRun* run) {
+		GridMap grid;
+		MakeGridMap(&grid, 24, 24, 0.15f, 31);
+		bool built = BuildNodes(&grid.map);
+		Check(run, built, "bsp: build nodes for a 24x24 grid map");
+		if (!built) return;
+		const Map& map = grid.map;
+
+		BSP bsp;
+		BuildBSP(&map, &bsp);
+		Check(run, bsp.nodes.size() == map.nodes.size() && bsp.subSectorCount == map.subSectors.size(), "bsp: every node and sub sector is kept");
+
+		std::mt19937 random(310);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<float> pointX, pointY;
+		std::vector<int32_t> pointSector;
+		while (pointX.size() < 20000) {
+			int32_t column = random() % grid.columns, row = random() % grid.rows;
+			int32_t sector = grid.cellSector[(size_t)row * grid.columns + column];
+			if (sector < 0) continue;
+			float x, y;
+			grid.CellPoint(column, row, 0.02f + unit(random) * 0.96f, 0.02f + unit(random) * 0.96f, &x, &y);
+			pointX.push_back(x);
+			pointY.push_back(y);
+			pointSector.push_back(sector);
+		}
+
+		std::vector<uint16_t> batched(pointX.size());
+		bsp.FindSubSectors(pointX.data(), pointY.data(), pointX.size(), batched.data());
+		size_t wrongReference = 0, wrongBatch = 0, wrongSector = 0, outsideSegs = 0;
+		for (size_t i = 0; i < pointX.size(); ++i) {
+			uint16_t subSector = bsp.FindSubSector(pointX[i], pointY[i]);
+			if (subSector != ReferenceFindSubSector(&map, pointX[i], pointY[i])) wrongReference++;
+			if (subSector != batched[i]) wrongBatch++;
+			if (SubSectorSector(&map, subSector) != pointSector[i]) wrongSector++;
+
+			// Sub sectors are convex and every seg has its sub sector on the right
+			uint16_t first = map.subSectors.firstSegment[subSector];
+			for (uint16_t seg = first; seg < first + map.subSectors.segmentCount[subSector]; ++seg) {
+				float x1 = map.vertices.x[map.segments.startVertex[seg]], y1 = map.vertices.y[map.segments.startVertex[seg]];
+				float x2 = map.vertices.x[map.segments.endVertex[seg]], y2 = map.vertices.y[map.segments.endVertex[seg]];
+				float side = (y2 - y1) * (pointX[i] - x1) - (x2 - x1) * (pointY[i] - y1);
+				if (side < -0.5f * hypotf(x2 - x1, y2 - y1)) {
+					outsideSegs++;
+					break;
+				}
+			}
+		}
+		std::string points = " ( " + std::to_string(pointX.size()) + " points )";
+		Check(run, wrongReference == 0, "bsp: FindSubSector matches the map's own nodes" + points, std::to_string(wrongReference) + " different");
+		Check(run, wrongBatch == 0, "bsp: FindSubSectors matches FindSubSector" + points, std::to_string(wrongBatch) + " different");
+		Check(run, wrongSector == 0, "bsp: located sub sector is in the point's sector" + points, std::to_string(wrongSector) + " wrong");
+		Check(run, outsideSegs == 0, "bsp: point is behind every seg of its sub sector" + points, std::to_string(outsideSegs) + " outside");
+
+		// Field of views below 180 degrees, BoxInView's clip angle math wraps at 180
+		size_t wrongOrder = 0, badTraversal = 0, views = 0;
+		std::vector<uint16_t> traversed, reference;
+		std::vector<uint8_t> seen(map.subSectors.size());
+		for (size_t i = 0; i < 2000; ++i) {
+			BSPView view = { pointX[i], pointY[i], unit(random) * 6.2831853f, 0.5f + unit(random) * 2.5f };
+			bsp.FrontToBack(view, &traversed);
+			reference.clear();
+			ReferenceFrontToBack(&map, (uint16_t)(map.nodes.size() - 1), view, RadiansToAngle(view.angle), RadiansToAngle(view.fov * 0.5f), &reference);
+			if (traversed != reference) wrongOrder++;
+
+			// Child boxes only cover the segs so the view's own sub sector can be culled, but
+			// nothing should come back twice
+			std::fill(seen.begin(), seen.end(), 0);
+			bool good = true;
+			for (uint16_t subSector : traversed) good &= (seen[subSector]++ == 0);
+			if (!good) badTraversal++;
+			views++;
+		}
+		std::string viewCount = " ( " + std::to_string(views) + " views )";
+		Check(run, wrongOrder == 0, "bsp: FrontToBack matches a recursive walk of the map's nodes" + viewCount, std::to_string(wrongOrder) + " different");
+		Check(run, badTraversal == 0, "bsp: FrontToBack has no repeats" + viewCount, std::to_string(badTraversal) + " bad");
+	}
+
+	// Blockmap queries ================
+
+	// Same tests as the blockmap does, so only which lines get looked at can differ
+	int Orientation(float ax, float ay, float bx, float by, float px, float py) {
+		float value = (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+		return (value > 0.0f) - (value < 0.0f);
+	}
+	bool OnSegment(float ax, float ay, float bx, float by, float px, float py) {
+		return px >= std::min(ax, bx) && px <= std::max(ax, bx) && py >= std::min(ay, by) && py <= std::max(ay, by);
+	}
+	bool SegmentsCross(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy) {
+		int o1 = Orientation(ax, ay, bx, by, cx, cy), o2 = Orientation(ax, ay, bx, by, dx, dy);
+		int o3 = Orientation(cx, cy, dx, dy, ax, ay), o4 = Orientation(cx, cy, dx, dy, bx, by);
+		if (o1 != o2 && o3 != o4) return true;
+		return (o1 == 0 && OnSegment(ax, ay, bx, by, cx, cy)) || (o2 == 0 && OnSegment(ax, ay, bx, by, dx, dy)) ||
+			(o3 == 0 && OnSegment(cx, cy, dx, dy, ax, ay)) || (o4 == 0 && OnSegment(cx, cy, dx, dy, bx, by));
+	}
+	bool SegmentTouchesBox(float x1, float y1, float x2, float y2, float left, float bottom, float right, float top) {
+		if (std::max(x1, x2) < left || std::min(x1, x2) > right) return false;
+		if (std::max(y1, y2) < bottom || std::min(y1, y2) > top) return false;
+		int s0 = Orientation(x1, y1, x2, y2, left, bottom), s1 = Orientation(x1, y1, x2, y2, right, bottom);
+		int s2 = Orientation(x1, y1, x2, y2, right, top), s3 = Orientation(x1, y1, x2, y2, left, top);
+		return !(s0 > 0 && s1 > 0 && s2 > 0 && s3 > 0) && !(s0 < 0 && s1 < 0 && s2 < 0 && s3 < 0);
+	}
+
+	// Every query is a box, a segment and a thing search, with their brute force answers
+	struct BlockmapQuery {
+		float left, bottom, right, top;
+		float x1, y1, x2, y2;
+		float x, y, radius;
+		std::vector<uint16_t> boxLines, segmentLines, things;
+	};
+
+	void MakeBlockmapQueries(const Map* map, const Blockmap* blockmap, size_t count, uint32_t seed, std::vector<BlockmapQuery>* queries) {
+		std::mt19937 random(seed);
+		// Reaches past the grid on every side
+		int32_t minX = blockmap->originX - 256, minY = blockmap->originY - 256;
+		int32_t spanX = blockmap->columns * BLOCK_SIZE + 512, spanY = blockmap->rows * BLOCK_SIZE + 512;
+		auto randomX = [&]() { return (float)(minX + (int32_t)(random() % spanX)); };
+		auto randomY = [&]() { return (float)(minY + (int32_t)(random() % spanY)); };
+
+		queries->resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			BlockmapQuery& query = (*queries)[i];
+			query.left = randomX();
+			query.bottom = randomY();
+			query.right = query.left + (float)(random() % 400);
+			query.top = query.bottom + (float)(random() % 400);
+
+			query.x1 = randomX();
+			query.y1 = randomY();
+			switch (i % 4) {
+			// Across the whole map, nearly diagonal and off the integer grid so steps almost tie
+			case 0: {
+				float length = (float)(random() % 3000);
+				query.x1 += (float)(random() % 1000) / 1000.0f;
+				query.x2 = query.x1 + ((random() % 2) ? length : -length) + (float)(random() % 1000) / 1000.0f;
+				query.y2 = query.y1 + ((random() % 2) ? length : -length) + (float)(random() % 1000) / 1000.0f;
+				break;
+			}
+			// Short
+			case 1: query.x2 = query.x1 + (float)(random() % 257) - 128; query.y2 = query.y1 + (float)(random() % 257) - 128; break;
+			// Straight up or across, along block edges every so often
+			case 2:
+				if (random() % 2) query.x1 = (float)(blockmap->originX + (int32_t)(random() % blockmap->columns) * BLOCK_SIZE);
+				query.x2 = (random() % 2) ? query.x1 : randomX();
+				query.y2 = (query.x2 == query.x1) ? randomY() : query.y1;
+				break;
+			// Diagonal from a block corner, through the corners of every block it passes
+			default: {
+				query.x1 = (float)(blockmap->originX + (int32_t)(random() % blockmap->columns) * BLOCK_SIZE);
+				query.y1 = (float)(blockmap->originY + (int32_t)(random() % blockmap->rows) * BLOCK_SIZE);
+				float length = (float)((random() % 8 + 1) * BLOCK_SIZE);
+				query.x2 = query.x1 + ((random() % 2) ? length : -length);
+				query.y2 = query.y1 + ((random() % 2) ? length : -length);
+				break;
+			}
+			}
+
+			query.x = randomX();
+			query.y = randomY();
+			query.radius = (float)(random() % 300);
+
+			query.boxLines.clear();
+			query.segmentLines.clear();
+			for (uint16_t line = 0; line < map->lineDefs.size(); ++line) {
+				uint16_t v1 = map->lineDefs.startVertex[line], v2 = map->lineDefs.endVertex[line];
+				if (v1 >= map->vertices.size() || v2 >= map->vertices.size()) continue;
+				float lx1 = map->vertices.x[v1], ly1 = map->vertices.y[v1];
+				float lx2 = map->vertices.x[v2], ly2 = map->vertices.y[v2];
+				if (SegmentTouchesBox(lx1, ly1, lx2, ly2, query.left, query.bottom, query.right, query.top)) query.boxLines.push_back(line);
+				if (SegmentsCross(query.x1, query.y1, query.x2, query.y2, lx1, ly1, lx2, ly2)) query.segmentLines.push_back(line);
+			}
+			query.things.clear();
+			for (uint16_t thing = 0; thing < map->things.size(); ++thing) {
+				float dx = map->things.x[thing] - query.x, dy = map->things.y[thing] - query.y;
+				if (dx * dx + dy * dy <= query.radius * query.radius) query.things.push_back(thing);
+			}
+		}
+	}
+
+	// Number of queries the blockmap got a different answer for, results are sorted since only
+	// the segment query has an order. A repeated line is a wrong answer too
+	size_t CheckBlockmapQueries(const Blockmap* blockmap, const std::vector<BlockmapQuery>& queries, size_t begin, size_t end, BlockmapScratch* scratch) {
+		size_t wrong = 0;
+		std::vector<uint16_t> result;
+		for (size_t i = begin; i < end; ++i) {
+			const BlockmapQuery& query = queries[i];
+			bool same = true;
+			if (scratch) blockmap->LinesInBox(query.left, query.bottom, query.right, query.top, &result, scratch);
+			else blockmap->LinesInBox(query.left, query.bottom, query.right, query.top, &result);
+			std::sort(result.begin(), result.end());
+			same &= result == query.boxLines;
+
+			if (scratch) blockmap->LinesAlongSegment(query.x1, query.y1, query.x2, query.y2, &result, scratch);
+			else blockmap->LinesAlongSegment(query.x1, query.y1, query.x2, query.y2, &result);
+			std::sort(result.begin(), result.end());
+			same &= result == query.segmentLines;
+
+			blockmap->ThingsNearPoint(query.x, query.y, query.radius, &result);
+			std::sort(result.begin(), result.end());
+			same &= result == query.things;
+			if (!same) wrong++;
+		}
+		return wrong;
+	}
+
+	// Built and loaded blockmaps against checking every line and thing, from one thread and from many
+	void TestBlockmap(TestRun* run) {
+		GridMap grid;
+		MakeGridMap(&grid, 32, 32, 0.2f, 33);
+		Map& map = grid.map;
+
+		Blockmap built;
+		BuildBlockmap(&map, &built);
+		std::vector<uint8_t> lump;
+		Check(run, EncodeBlockmap(&built, &lump), "blockmap: encode");
+
+		map.blockMap.data.resize(lump.size() / 2);
+		for (size_t i = 0; i < map.blockMap.data.size(); ++i) map.blockMap.data[i] = (uint16_t)(lump[i * 2] | (lump[i * 2 + 1] << 8));
+		map.blockMap.originX = (int16_t)map.blockMap.data[0];
+		map.blockMap.originY = (int16_t)map.blockMap.data[1];
+		map.blockMap.columns = map.blockMap.data[2];
+		map.blockMap.rows = map.blockMap.data[3];
+		Blockmap loaded;
+		Check(run, LoadBlockmap(&map, &loaded) && loaded.lines == built.lines && loaded.lineOffsets == built.lineOffsets,
+			"blockmap: load what was encoded");
+
+		std::vector<BlockmapQuery> queries;
+		MakeBlockmapQueries(&map, &built, 4000, 330, &queries);
+		std::string count = " ( " + std::to_string(queries.size()) + " queries )";
+		size_t wrong = CheckBlockmapQueries(&built, queries, 0, queries.size(), nullptr);
+		Check(run, wrong == 0, "blockmap: built blockmap matches brute force" + count, std::to_string(wrong) + " wrong");
+		wrong = CheckBlockmapQueries(&loaded, queries, 0, queries.size(), nullptr);
+		Check(run, wrong == 0, "blockmap: loaded blockmap matches brute force" + count, std::to_string(wrong) + " wrong");
+
+		ThreadPool pool(4);
+		std::atomic<size_t> threadedWrong = 0;
+		pool.ParallelFor(queries.size(), 100, [&](size_t begin, size_t end) {
+			BlockmapScratch scratch;
+			threadedWrong += CheckBlockmapQueries(&built, queries, begin, end, &scratch);
+		});
+		Check(run, threadedWrong == 0, "blockmap: queries from " + std::to_string(pool.GetThreadCount()) + " threads with their own scratch" + count,
+			std::to_string(threadedWrong) + " wrong");
+
+		// Line defs pointing at vertices that don't exist are left out instead of read past the end
+		map.lineDefs.startVertex[0] = 60000;
+		map.lineDefs.endVertex[1] = (uint16_t)map.vertices.size();
+		Blockmap broken;
+		BuildBlockmap(&map, &broken);
+		MakeBlockmapQueries(&map, &broken, 500, 331, &queries);
+		wrong = CheckBlockmapQueries(&broken, queries, 0, queries.size(), nullptr);
+		wrong += CheckBlockmapQueries(&loaded, queries, 0, queries.size(), nullptr);
+		Check(run, wrong == 0, "blockmap: line defs with missing vertices are skipped", std::to_string(wrong) + " wrong");
+	}
+
+	// Pictures ========================
+
+	struct Post {
+		uint8_t delta;
+		std::vector<uint8_t> pixels;
+	};
+
+	// Patch lump with every column's posts written in order
+	LumpBuilder BuildPatch(uint16_t width, uint16_t height, int16_t left, int16_t top, const std::vector<std::vector<Post>>& columns) {
+		LumpBuilder lump;
+		lump.UInt16(width);
+		lump.UInt16(height);
+		lump.Int16(left);
+		lump.Int16(top);
+		uint32_t offset = 8 + (uint32_t)columns.size() * 4;
+		for (auto& column : columns) {
+			lump.UInt32(offset);
+			for (auto& post : column) offset += 4 + (uint32_t)post.pixels.size();
+			offset++;
+		}
+		for (auto& column : columns) {
+			for (auto& post : column) {
+				lump.UInt8(post.delta);
+				lump.UInt8((uint8_t)post.pixels.size());
+				lump.UInt8(0);
+				for (uint8_t pixel : post.pixels) lump.UInt8(pixel);
+				lump.UInt8(0);
+			}
+			lump.UInt8(0xFF);
+		}
+		return lump;
+	}
+
+	// Flats, patches and the RGBA expansion against pictures worked out by hand
+	void TestPictures(TestRun* run) {
+		LumpBuilder flat;
+		for (uint32_t i = 0; i < 64 * 64; ++i) flat.UInt8((uint8_t)((i % 64) * 3 + (i / 64) * 7));
+		Image image;
+		bool decoded = DecodeFlat(ViewLump(flat), &image);
+		bool same = decoded && image.width == 64 && image.height == 64 && image.pixels == flat.bytes &&
+			image.mask == std::vector<uint8_t>(64 * 64, 1);
+		Check(run, same, "pictures: 64x64 flat");
+		// Some WADs have flats with a few extra bytes on the end
+		for (int i = 0; i < 64; ++i) flat.UInt8(0xEE);
+		decoded = DecodeFlat(ViewLump(flat), &image);
+		Check(run, decoded && image.width == 64 && image.pixels.size() == 64 * 64 && image.pixels.back() == flat.bytes[64 * 64 - 1], "pictures: flat with extra bytes");
+		Check(run, !DecodeFlat(ViewLump(LumpBuilder()), &image), "pictures: empty flat is rejected");
+
+		// 4x5, the last column's post runs off the bottom
+		LumpBuilder patch = BuildPatch(4, 5, -3, 7, {
+			{ { 0, { 10, 11 } }, { 3, { 12 } } },
+			{ },
+			{ { 1, { 20, 21, 22, 23 } } },
+			{ { 4, { 30, 31, 32 } } },
+		});
+		const std::vector<uint8_t> expectedPixels = {
+			10, 0,  0,  0,
+			11, 0, 20,  0,
+			 0, 0, 21,  0,
+			12, 0, 22,  0,
+			 0, 0, 23, 30,
+		};
+		const std::vector<uint8_t> expectedMask = {
+			1, 0, 0, 0,
+			1, 0, 1, 0,
+			0, 0, 1, 0,
+			1, 0, 1, 0,
+			0, 0, 1, 1,
+		};
+		decoded = DecodePatch(ViewLump(patch), &image);
+		Check(run, decoded && image.width == 4 && image.height == 5 && image.leftOffset == -3 && image.topOffset == 7 &&
+			image.pixels == expectedPixels && image.mask == expectedMask, "pictures: 4x5 patch");
+
+		// Past row 254 a delta that doesn't go down the column is added to the last post's top
+		patch = BuildPatch(1, 400, 0, 0, {
+			{ { 10, std::vector<uint8_t>(5, 1) }, { 254, std::vector<uint8_t>(10, 2) }, { 46, std::vector<uint8_t>(20, 3) }, { 100, std::vector<uint8_t>(8, 4) } },
+		});
+		std::vector<uint8_t> tallPixels(400, 0);
+		for (int y = 10; y < 15; ++y) tallPixels[y] = 1;
+		for (int y = 254; y < 264; ++y) tallPixels[y] = 2;
+		for (int y = 300; y < 320; ++y) tallPixels[y] = 3;
+		std::vector<uint8_t> tallMask(400, 0);
+		for (int y = 0; y < 400; ++y) tallMask[y] = tallPixels[y] != 0;
+		decoded = DecodePatch(ViewLump(patch), &image);
+		Check(run, decoded && image.height == 400 && image.pixels == tallPixels && image.mask == tallMask, "pictures: tall patch with relative post offsets");
+
+		patch = BuildPatch(4, 5, 0, 0, { { }, { }, { }, { { 0, { 1, 2, 3 } } } });
+		LumpBuilder truncated = patch;
+		truncated.bytes.resize(8 + 4 * 3);
+		Check(run, !DecodePatch(ViewLump(truncated), &image), "pictures: patch without every column offset is rejected");
+		truncated = patch;
+		truncated.bytes.resize(truncated.bytes.size() - 3);
+		Check(run, !DecodePatch(ViewLump(truncated), &image), "pictures: post running past the lump is rejected");
+
+		Palette palette;
+		for (int i = 0; i < 256; ++i) {
+			palette.colors[i][0] = (uint8_t)i;
+			palette.colors[i][1] = (uint8_t)(255 - i);
+			palette.colors[i][2] = (uint8_t)(i * 3);
+		}
+		RGBALookup lookup;
+		BuildLookup(palette, nullptr, &lookup);
+		const uint8_t pixels[] = { 0, 1, 255, 128 };
+		const uint8_t mask[] = { 1, 0, 1, 1 };
+		uint32_t rgba[4];
+		ExpandToRGBA(pixels, mask, 4, lookup, rgba);
+		Check(run, rgba[0] == 0xFF00FF00u && rgba[1] == 0 && rgba[2] == 0xFFFD00FFu && rgba[3] == 0xFF807F80u, "pictures: RGBA expansion");
+
+		// Every length and start alignment so the SIMD loop and its tail both get checked
+		std::mt19937 random(34);
+		std::vector<uint8_t> randomPixels(256 + 8), randomMask(randomPixels.size());
+		for (size_t i = 0; i < randomPixels.size(); ++i) {
+			randomPixels[i] = (uint8_t)random();
+			randomMask[i] = (random() % 3) ? (uint8_t)(random() % 4) : 0;
+		}
+		std::vector<uint32_t> fast(randomPixels.size()), scalar(randomPixels.size());
+		size_t wrong = 0;
+		for (size_t start = 0; start < 8; ++start) {
+			for (size_t count = 0; count <= 256; ++count) {
+				for (int masked = 0; masked < 2; ++masked) {
+					const uint8_t* maskStart = masked ? randomMask.data() + start : nullptr;
+					ExpandToRGBA(randomPixels.data() + start, maskStart, count, lookup, fast.data());
+					ExpandToRGBAScalar(randomPixels.data() + start, maskStart, count, lookup, scalar.data());
+					if (!std::equal(fast.begin(), fast.begin() + count, scalar.begin())) wrong++;
+				}
+			}
+		}
+#ifdef __AVX2__
+		std::string path = "AVX2";
+#else
+		std::string path = "scalar";
+#endif
+		Check(run, wrong == 0, "pictures: " + path + " RGBA expansion matches scalar", std::to_string(wrong) + " different");
+	}
+
+	// Textures ========================
+
+	// Patches hanging off every side of a texture are clipped, later patches draw over earlier ones
+	void TestTextureCompose(TestRun* run) {
+		LumpBuilder pnames;
+		pnames.Int32(1);
+		pnames.Name("TESTPAT");
+
+		// 3x2 patch, every pixel solid
+		LumpBuilder patch = BuildPatch(3, 2, 0, 0, { { { 0, { 1, 4 } } }, { { 0, { 2, 5 } } }, { { 0, { 3, 6 } } } });
+
+		struct Use { int16_t x, y; };
+		struct Texture { std::string name; uint16_t width, height; std::vector<Use> uses; };
+		const std::vector<Texture> textures = {
+			{ "CLIPPED", 6, 3, { { -2, -1 }, { 5, 2 }, { -1, 1 } } },
+			{ "OUTSIDE", 4, 4, { { -10, 0 }, { 0, -10 }, { 4, 0 }, { 0, 4 } } },
+		};
+		LumpBuilder texture1;
+		texture1.Int32((int32_t)textures.size());
+		uint32_t offset = 4 + (uint32_t)textures.size() * 4;
+		for (auto& texture : textures) {
+			texture1.UInt32(offset);
+			offset += (uint32_t)(MAPTEXTURE_SIZE + texture.uses.size() * MAPPATCH_SIZE);
+		}
+		for (auto& texture : textures) {
+			texture1.Name(texture.name);
+			texture1.Int32(0);
+			texture1.UInt16(texture.width);
+			texture1.UInt16(texture.height);
+			texture1.Int32(0);
+			texture1.UInt16((uint16_t)texture.uses.size());
+			for (auto& use : texture.uses) {
+				texture1.Int16(use.x);
+				texture1.Int16(use.y);
+				texture1.UInt16(0);
+				texture1.Int16(1);
+				texture1.Int16(0);
+			}
+		}
+
+		std::string path = TempPath("compose_test.wad");
+		bool written = WriteTestWAD(path, { { "PNAMES", pnames }, { "TEXTURE1", texture1 }, { "P_START", {} }, { "TESTPAT", patch }, { "P_END", {} } });
+		WAD wad;
+		std::string error;
+		TextureAtlas atlas;
+		bool built = written && TryLoadWAD(path, &wad, &error) && BuildTextureAtlas(&wad, nullptr, &atlas);
+		Check(run, built, "textures: build atlas from test WAD", error);
+		if (!built) return;
+
+		auto region = [&atlas](const std::string& name, std::vector<uint8_t>* pixels, std::vector<uint8_t>* mask) {
+			const AtlasEntry* entry = atlas.Find(name);
+			pixels->clear();
+			mask->clear();
+			if (!entry) return;
+			for (uint32_t y = 0; y < entry->height; ++y) {
+				size_t row = (size_t)(entry->y + y) * atlas.image.width + entry->x;
+				pixels->insert(pixels->end(), atlas.image.pixels.begin() + row, atlas.image.pixels.begin() + row + entry->width);
+				mask->insert(mask->end(), atlas.image.mask.begin() + row, atlas.image.mask.begin() + row + entry->width);
+			}
+		};
+		std::vector<uint8_t> pixels, mask;
+		region("CLIPPED", &pixels, &mask);
+		const std::vector<uint8_t> expectedPixels = {
+			6, 0, 0, 0, 0, 0,
+			2, 3, 0, 0, 0, 0,
+			5, 6, 0, 0, 0, 1,
+		};
+		std::vector<uint8_t> expectedMask(expectedPixels.size());
+		for (size_t i = 0; i < expectedPixels.size(); ++i) expectedMask[i] = expectedPixels[i] != 0;
+		Check(run, pixels == expectedPixels && mask == expectedMask, "textures: patches clipped on every side");
+
+		region("OUTSIDE", &pixels, &mask);
+		Check(run, mask == std::vector<uint8_t>(16, 0), "textures: patches entirely outside draw nothing");
+	}
+
+	// Reject ==========================
+
+	// Any straight line between two sectors that doesn't touch a one sided line means they can
+	// see each other, so the built table can't reject them
+	void TestReject(TestRun* run) {
+		size_t falseRejects = 0, pairs = 0;
+		bool built = true;
+		for (uint32_t seed = 0; seed < 6; ++seed) {
+			GridMap grid;
+			MakeGridMap(&grid, 16, 16, 0.35f, 400 + seed);
+			const Map& map = grid.map;
+			RejectTable table;
+			RejectBuildStats stats;
+			BuildReject(&map, &table, {}, &stats);
+			built &= stats.built && stats.overBudget == 0;
+
+			std::vector<uint16_t> solidLines;
+			for (uint16_t line = 0; line < map.lineDefs.size(); ++line) {
+				if (map.lineDefs.backSide[line] == NO_SIDEDEF) solidLines.push_back(line);
+			}
+
+			std::mt19937 random(40 + seed);
+			std::uniform_real_distribution<float> unit(0.02f, 0.98f);
+			std::vector<uint8_t> checked(table.sectorCount * table.sectorCount, 0);
+			for (size_t i = 0; i < 200000; ++i) {
+				int32_t column1 = random() % grid.columns, row1 = random() % grid.rows;
+				int32_t column2 = random() % grid.columns, row2 = random() % grid.rows;
+				int32_t from = grid.cellSector[(size_t)row1 * grid.columns + column1];
+				int32_t to = grid.cellSector[(size_t)row2 * grid.columns + column2];
+				if (from < 0 || to < 0) continue;
+				if (checked[from * table.sectorCount + to]) continue;
+
+				float x1, y1, x2, y2;
+				grid.CellPoint(column1, row1, unit(random), unit(random), &x1, &y1);
+				grid.CellPoint(column2, row2, unit(random), unit(random), &x2, &y2);
+				bool blocked = false;
+				for (uint16_t line : solidLines) {
+					uint16_t v1 = map.lineDefs.startVertex[line], v2 = map.lineDefs.endVertex[line];
+					if (SegmentsCross(x1, y1, x2, y2, map.vertices.x[v1], map.vertices.y[v1], map.vertices.x[v2], map.vertices.y[v2])) {
+						blocked = true;
+						break;
+					}
+				}
+				if (blocked) continue;
+				checked[from * table.sectorCount + to] = 1;
+				pairs++;
+				if (!table.CanSee(from, to)) falseRejects++;
+			}
+		}
+		Check(run, built, "reject: built every source within budget");
+		Check(run, falseRejects == 0, "reject: no pair with a clear line between them is rejected ( " + std::to_string(pairs) + " pairs )",
+			std::to_string(falseRejects) + " rejected");
+	}
+
+	// WAD stacks ======================
+
+	LumpBuilder TextLump(const std::string& text) {
+		LumpBuilder lump;
+		for (char c : text) lump.UInt8((uint8_t)c);
+		return lump;
+	}
+	bool LumpIs(const Lump* lump, const std::string& text) {
+		return lump && lump->size == text.size() && memcmp(lump->data, text.data(), text.size()) == 0;
+	}
+	LumpBuilder ThingsLump(size_t count) {
+		LumpBuilder lump;
+		for (size_t i = 0; i < count * 5; ++i) lump.Int16((int16_t)i);
+		return lump;
+	}
+
+	// A PWAD replaces lumps by name, single entries of a namespace and whole maps
+	void TestWADStack(TestRun* run) {
+		std::string iwadPath = TempPath("stack_iwad.wad");
+		std::string pwadPath = TempPath("stack_pwad1.wad");
+		std::string pwad2Path = TempPath("stack_pwad2.wad");
+		LumpBuilder lineDefs;
+		for (int i = 0; i < 7; ++i) lineDefs.Int16(0);
+		bool written = WriteTestWAD(iwadPath, {
+			{ "DEMO1", TextLump("iwad demo") }, { "DUPE", TextLump("first") }, { "DUPE", TextLump("second") },
+			{ "F_START", {} }, { "FLOOR1", TextLump("iwad floor1") }, { "FLOOR2", TextLump("iwad floor2") }, { "FLOOR3", TextLump("iwad floor3") }, { "F_END", {} },
+			{ "MAP01", {} }, { "THINGS", ThingsLump(3) }, { "LINEDEFS", lineDefs },
+		});
+		// Doubled namespace prefixes are the same namespace, and this MAP01 has no line defs of its own
+		written &= WriteTestWAD(pwadPath, {
+			{ "DEMO1", TextLump("pwad demo") },
+			{ "FF_START", {} }, { "FLOOR2", TextLump("pwad floor2") }, { "FLOOR4", TextLump("pwad floor4") }, { "FF_END", {} },
+			{ "MAP01", {} }, { "THINGS", ThingsLump(2) },
+		});
+		written &= WriteTestWAD(pwad2Path, {
+			{ "S_START", {} }, { "TROOA1", TextLump("imp") }, { "S_END", {} },
+			{ "MAP02", {} }, { "THINGS", ThingsLump(1) },
+		});
+		Check(run, written, "wad stack: write test WADs");
+		if (!written) return;
+
+		GameConfig config;
+		config.iwad = "stack_iwad.wad";
+		config.pwads = { "stack_pwad1.wad", "stack_pwad2.wad" };
+		WADStack stack;
+		std::string error;
+		bool mounted = MountGameConfig(config, std::filesystem::temp_directory_path().string(), &stack, &error);
+		Check(run, mounted && stack.wads.size() == 3, "wad stack: mount IWAD and two PWADs", error);
+		if (!mounted) return;
+
+		Check(run, LumpIs(stack.FindLump("DEMO1"), "pwad demo"), "wad stack: PWAD lump replaces the IWAD's");
+		Check(run, LumpIs(stack.FindLump("DUPE"), "second"), "wad stack: later lump wins inside one WAD");
+		Check(run, stack.FindLump("NOTHERE") == nullptr, "wad stack: missing lump is null");
+
+		const StackNamespace* flats = stack.GetNamespace("F");
+		std::vector<std::string> flatNames;
+		std::vector<uint32_t> flatWADs;
+		if (flats) {
+			for (const LumpRef& ref : flats->lumps) {
+				flatNames.push_back(stack.GetLump(ref).name);
+				flatWADs.push_back(ref.wad);
+			}
+		}
+		Check(run, flatNames == std::vector<std::string>{ "FLOOR1", "FLOOR2", "FLOOR3", "FLOOR4" } && flatWADs == std::vector<uint32_t>{ 0, 1, 0, 1 },
+			"wad stack: flats keep their order with one replaced and one added");
+		Check(run, LumpIs(stack.FindInNamespace("F", "FLOOR2"), "pwad floor2") && LumpIs(stack.FindInNamespace("F", "FLOOR1"), "iwad floor1"),
+			"wad stack: namespace lookups find the winning flat");
+		Check(run, LumpIs(stack.FindInNamespace("S", "TROOA1"), "imp") && stack.FindInNamespace("S", "FLOOR1") == nullptr,
+			"wad stack: namespaces stay separate");
+
+		Map map;
+		map.name = "MAP01";
+		WAD* mapWAD = stack.GetMapWAD("MAP01");
+		if (mapWAD) LoadMap(mapWAD, &map);
+		Check(run, mapWAD == stack.wads[1].get() && map.things.size() == 2 && map.lineDefs.size() == 0,
+			"wad stack: PWAD map replaces the whole IWAD map");
+		Check(run, stack.GetMapWAD("MAP02") == stack.wads[2].get() && stack.GetMapWAD("MAP03") == nullptr, "wad stack: maps only in a PWAD are found");
+
+		// A PWAD that isn't there undoes the whole config, on an empty stack and on one that already has a WAD
+		config.pwads = { "stack_pwad1.wad", "stack_missing.wad" };
+		WADStack failed;
+		mounted = MountGameConfig(config, std::filesystem::temp_directory_path().string(), &failed, &error);
+		Check(run, !mounted && failed.wads.empty() && failed.lumpIndex.empty() && failed.namespaces.empty() && failed.mapBlocks.empty(),
+			"wad stack: failed config leaves an empty stack empty");
+		failed = WADStack();
+		mounted = MountWAD(iwadPath, &failed, &error);
+		size_t lumps = failed.lumpIndex.size();
+		mounted &= !MountGameConfig(config, std::filesystem::temp_directory_path().string(), &failed, &error);
+		const StackNamespace* failedFlats = failed.GetNamespace("F");
+		Check(run, mounted && failed.wads.size() == 1 && failed.lumpIndex.size() == lumps && LumpIs(failed.FindLump("DEMO1"), "iwad demo") &&
+			failedFlats && failedFlats->lumps.size() == 3 && failed.GetMapWAD("MAP01") == failed.wads[0].get(),
+			"wad stack: failed config leaves earlier WADs as they were");
+	}
+
+	// Benchmarks ======================
+
+	double SecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+	double ToMB(uint64_t bytes) {
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	// Memory the process has resident right now, 0 if the platform doesn't say
+	uint64_t ResidentBytes() {
+#ifdef PLATFORM_WINDOWS
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.WorkingSetSize;
+#else
+		FILE* file = fopen("/proc/self/statm", "r");
+		if (!file) return 0;
+		unsigned long long pages = 0, resident = 0;
+		int read = fscanf(file, "%llu %llu", &pages, &resident);
+		fclose(file);
+		return (read == 2) ? resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+	}
+
+	// lumpCount lumps of lumpSize random bytes, every payload is different so the writer can't
+	// share any of them. Lumps are called L and their index in hex
+	bool WriteSyntheticWAD(const std::string& path, uint32_t lumpCount, uint32_t lumpSize, uint32_t seed) {
+		std::mt19937 random(seed);
+		WADWriter writer;
+		if (!writer.Open(path)) return false;
+		std::vector<uint32_t> payload((lumpSize + 3) / 4);
+		char name[16];
+		for (uint32_t i = 0; i < lumpCount; ++i) {
+			for (uint32_t& word : payload) word = random();
+			snprintf(name, sizeof(name), "L%X", i);
+			if (!writer.AddLump(name, (const uint8_t*)payload.data(), lumpSize)) return false;
+		}
+		return writer.Finish();
+	}
+
+	// A few hundred MB WAD, loading only reads the directory so it shouldn't cost anywhere near
+	// the file's size in time or memory until the lumps are read
+	bool BenchLoad() {
+		const uint32_t lumpCount = 6144, lumpSize = 64 * 1024;
+		std::string path = TempPath("bench_load.wad");
+		auto writeStart = std::chrono::steady_clock::now();
+		if (!WriteSyntheticWAD(path, lumpCount, lumpSize, 28)) {
+			std::cout << "Failed to write ( " << path << " )" << std::endl;
+			return false;
+		}
+		double writeSeconds = SecondsSince(writeStart);
+
+		uint64_t residentBefore = ResidentBytes(), residentLoaded, residentRead;
+		double loadSeconds, readSeconds;
+		uint64_t checksum = 0;
+		{
+			WAD wad;
+			std::string error;
+			auto loadStart = std::chrono::steady_clock::now();
+			bool loaded = TryLoadWAD(path, &wad, &error);
+			loadSeconds = SecondsSince(loadStart);
+			if (!loaded || wad.lumps.size() != lumpCount) {
+				std::cout << "Failed to load ( " << path << " ) " << error << std::endl;
+				return false;
+			}
+			residentLoaded = ResidentBytes();
+
+			auto readStart = std::chrono::steady_clock::now();
+			for (const Lump& lump : wad.lumps) {
+				for (uint32_t i = 0; i < lump.size; i += 64) checksum += lump.data[i];
+			}
+			readSeconds = SecondsSince(readStart);
+			residentRead = ResidentBytes();
+		}
+		std::filesystem::remove(path);
+
+		uint64_t bytes = (uint64_t)lumpCount * lumpSize;
+		std::cout << "Load =========================" << std::endl;
+		std::cout << "WAD: " << lumpCount << " lumps, " << ToMB(bytes) << " MB ( written in " << writeSeconds * 1000.0 << "ms )" << std::endl;
+		std::cout << "Load: " << loadSeconds * 1000.0 << "ms ( " << lumpCount / loadSeconds << " lumps/sec )" << std::endl;
+		std::cout << "Read Every Lump: " << readSeconds * 1000.0 << "ms ( " << ToMB(bytes) / readSeconds << " MB/sec, checksum " << checksum << " )" << std::endl;
+		std::cout << "Resident: " << ToMB(residentBefore) << " MB before, " << ToMB(residentLoaded) << " MB loaded, "
+			<< ToMB(residentRead) << " MB after reading" << std::endl;
+		return true;
+	}
+
+	// Name lookups in a WAD with as many lumps as the biggest megawads, against going through the
+	// directory comparing names
+	bool BenchLookup() {
+		const uint32_t lumpCount = 50000;
+		std::string path = TempPath("bench_lookup.wad");
+		if (!WriteSyntheticWAD(path, lumpCount, 16, 29)) {
+			std::cout << "Failed to write ( " << path << " )" << std::endl;
+			return false;
+		}
+		WAD wad;
+		std::string error;
+		if (!TryLoadWAD(path, &wad, &error)) {
+			std::cout << error << std::endl;
+			return false;
+		}
+
+		std::mt19937 random(290);
+		const size_t lookupCount = 1000000;
+		std::vector<std::string> hits(lookupCount), misses(lookupCount);
+		char name[16];
+		for (size_t i = 0; i < lookupCount; ++i) {
+			snprintf(name, sizeof(name), "L%X", (uint32_t)(random() % lumpCount));
+			hits[i] = name;
+			snprintf(name, sizeof(name), "M%X", (uint32_t)(random() % lumpCount));
+			misses[i] = name;
+		}
+
+		size_t found = 0;
+		auto time = [&](const std::vector<std::string>& names, size_t count, auto&& lookup) {
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < count; ++i) found += lookup(names[i]);
+			return count / SecondsSince(start);
+		};
+		double hitRate = time(hits, lookupCount, [&](const std::string& name) { return wad.GetLump(name) != nullptr; });
+		double missRate = time(misses, lookupCount, [&](const std::string& name) { return wad.GetLump(name) != nullptr; });
+		// Last match wins like Doom's W_CheckNumForName, so the whole directory is gone through
+		double scanRate = time(hits, 2000, [&](const std::string& name) {
+			uint64_t id = PackLumpName(name);
+			int32_t match = -1;
+			for (uint32_t i = 0; i < wad.lumps.size(); ++i) if (wad.lumps[i].id == id) match = (int32_t)i;
+			return match >= 0;
+		});
+		std::filesystem::remove(path);
+
+		std::cout << "Lookup =======================" << std::endl;
+		std::cout << "WAD: " << lumpCount << " lumps ( " << found << " found )" << std::endl;
+		std::cout << "Hit: " << hitRate << " lookups/sec" << std::endl;
+		std::cout << "Miss: " << missRate << " lookups/sec" << std::endl;
+		std::cout << "Directory Scan: " << scanRate << " lookups/sec" << std::endl;
+		return true;
+	}
+
+	// Full decodes of generated maps with built nodes, every map is different so the writer keeps
+	// all of them
+	bool BenchMaps() {
+		const int mapCount = 16, passes = 20;
+		std::vector<std::pair<std::string, LumpBuilder>> lumps;
+		size_t lines = 0;
+		for (int i = 0; i < mapCount; ++i) {
+			GridMap grid;
+			MakeGridMap(&grid, 40, 40, 0.2f, 3000 + i);
+			char name[16];
+			snprintf(name, sizeof(name), "MAP%02d", i + 1);
+			grid.map.name = name;
+			if (!BuildNodes(&grid.map)) {
+				std::cout << "Failed to build nodes for " << name << std::endl;
+				return false;
+			}
+			lines += grid.map.lineDefs.size();
+			AddMapLumps(grid.map, &lumps);
+		}
+		std::string path = TempPath("bench_maps.wad");
+		WAD wad;
+		std::string error;
+		if (!WriteTestWAD(path, lumps) || !TryLoadWAD(path, &wad, &error)) {
+			std::cout << "Failed to write or load ( " << path << " ) " << error << std::endl;
+			return false;
+		}
+
+		size_t records = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; ++pass) {
+			for (int i = 0; i < mapCount; ++i) {
+				Map map;
+				map.name = lumps[(size_t)i * 9].first;
+				LoadMap(&wad, &map);
+				records += map.things.size() + map.lineDefs.size() + map.sideDefs.size() + map.vertices.size() +
+					map.segments.size() + map.subSectors.size() + map.nodes.size() + map.sectors.size();
+			}
+		}
+		double seconds = SecondsSince(start);
+		std::filesystem::remove(path);
+
+		double maps = (double)mapCount * passes;
+		std::cout << "Maps =========================" << std::endl;
+		std::cout << "WAD: " << mapCount << " maps, " << lines / mapCount << " lines and " << records / maps << " records per map" << std::endl;
+		std::cout << "Decode: " << maps / seconds << " maps/sec ( " << records / seconds / 1000000.0 << " M records/sec )" << std::endl;
+		return true;
+	}
+
+	// Point lookups and front to back walks over a generated map the size of a big PWAD level,
+	// against walking the map's own nodes
+	bool BenchBSP() {
+		GridMap grid;
+		MakeGridMap(&grid, 64, 64, 0.15f, 3100);
+		if (!BuildNodes(&grid.map)) {
+			std::cout << "Failed to build nodes" << std::endl;
+			return false;
+		}
+		const Map& map = grid.map;
+		BSP bsp;
+		BuildBSP(&map, &bsp);
+
+		std::mt19937 random(311);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const size_t pointCount = 1000000;
+		std::vector<float> pointX(pointCount), pointY(pointCount);
+		for (size_t i = 0; i < pointCount; ++i) {
+			pointX[i] = unit(random) * grid.columns * GRID_CELL_SIZE;
+			pointY[i] = unit(random) * grid.rows * GRID_CELL_SIZE;
+		}
+
+		uint64_t sum = 0;
+		auto time = [&](size_t count, auto&& func) {
+			auto start = std::chrono::steady_clock::now();
+			func();
+			return count / SecondsSince(start);
+		};
+		double singleRate = time(pointCount, [&]() {
+			for (size_t i = 0; i < pointCount; ++i) sum += bsp.FindSubSector(pointX[i], pointY[i]);
+		});
+		std::vector<uint16_t> batched(pointCount);
+		double batchRate = time(pointCount, [&]() {
+			bsp.FindSubSectors(pointX.data(), pointY.data(), pointCount, batched.data());
+			sum += batched[pointCount - 1];
+		});
+		double referenceRate = time(pointCount, [&]() {
+			for (size_t i = 0; i < pointCount; ++i) sum += ReferenceFindSubSector(&map, pointX[i], pointY[i]);
+		});
+
+		// Both walks get the same views
+		const size_t viewCount = 20000;
+		std::vector<float> viewAngle(viewCount);
+		for (float& angle : viewAngle) angle = unit(random) * 6.2831853f;
+		std::vector<uint16_t> traversed;
+		size_t visited = 0;
+		double viewRate = time(viewCount, [&]() {
+			for (size_t i = 0; i < viewCount; ++i) {
+				BSPView view = { pointX[i], pointY[i], viewAngle[i], 1.5707963f };
+				bsp.FrontToBack(view, &traversed);
+				visited += traversed.size();
+			}
+		});
+		double referenceViewRate = time(viewCount, [&]() {
+			for (size_t i = 0; i < viewCount; ++i) {
+				BSPView view = { pointX[i], pointY[i], viewAngle[i], 1.5707963f };
+				traversed.clear();
+				ReferenceFrontToBack(&map, (uint16_t)(map.nodes.size() - 1), view, RadiansToAngle(view.angle), RadiansToAngle(view.fov * 0.5f), &traversed);
+				sum += traversed.size();
+			}
+		});
+
+		std::cout << "BSP ==========================" << std::endl;
+		std::cout << "Map: " << map.lineDefs.size() << " lines, " << map.nodes.size() << " nodes, " << map.subSectors.size() << " sub sectors ( checksum " << sum << " )" << std::endl;
+		std::cout << "FindSubSector: " << singleRate << " queries/sec" << std::endl;
+		std::cout << "FindSubSectors: " << batchRate << " queries/sec" << std::endl;
+		std::cout << "Map Nodes: " << referenceRate << " queries/sec" << std::endl;
+		std::cout << "FrontToBack: " << viewRate << " views/sec ( " << visited / (double)viewCount << " sub sectors per view )" << std::endl;
+		std::cout << "Map Nodes Walk: " << referenceViewRate << " views/sec" << std::endl;
+		return true;
+	}
+
+	// Nodes for a generated map near the format's limits, on one thread and on a pool, each
+	// result checked with ValidateBSP
+	bool BenchNodes() {
+		GridMap grid;
+		MakeGridMap(&grid, 96, 96, 0.15f, 3200);
+		ThreadPool pool;
+		auto build = [&](ThreadPool* buildPool, NodeBuilderStats* stats, double* validateSeconds, std::string* error) {
+			Map map = grid.map;
+			NodeBuilderSettings settings;
+			settings.pool = buildPool;
+			if (!BuildNodes(&map, settings, stats)) {
+				*error = "map is too big for the lump format";
+				return false;
+			}
+			auto start = std::chrono::steady_clock::now();
+			bool valid = ValidateBSP(&map, error);
+			*validateSeconds = SecondsSince(start);
+			return valid;
+		};
+		NodeBuilderStats single, parallel;
+		double singleValidate, parallelValidate;
+		std::string error;
+		if (!build(nullptr, &single, &singleValidate, &error) || !build(&pool, &parallel, &parallelValidate, &error)) {
+			std::cout << "Failed to build nodes: " << error << std::endl;
+			return false;
+		}
+
+		std::cout << "Nodes ========================" << std::endl;
+		std::cout << "Map: " << grid.map.lineDefs.size() << " lines, " << parallel.segments << " segs ( " << parallel.splits << " splits ), "
+			<< parallel.nodes << " nodes, " << parallel.subSectors << " sub sectors" << std::endl;
+		std::cout << "Build: " << single.milliseconds << "ms on 1 thread, " << parallel.milliseconds << "ms on " << pool.GetThreadCount() << " threads" << std::endl;
+		std::cout << "Validate: " << parallelValidate * 1000.0 << "ms ( " << singleValidate * 1000.0 << "ms for the single thread build )" << std::endl;
+		return true;
+	}
+
+	// Mounting an IWAD the size of Doom 2's with 20 PWADs on top, each replacing lumps, flats,
+	// sprites and a map and adding some of its own
+	bool BenchMount() {
+		const int pwadCount = 20, passes = 20;
+		std::mt19937 random(380);
+		// Payloads only need to differ, the writer would share identical ones
+		auto payload = [&]() {
+			LumpBuilder lump;
+			for (int i = 0; i < 16; ++i) lump.UInt32(random());
+			return lump;
+		};
+		// Doubled prefixes ( FF_START ) are the same namespace and the same lump names
+		auto addNamespace = [&](std::vector<std::pair<std::string, LumpBuilder>>* lumps, const std::string& prefix, int first, int count) {
+			lumps->push_back({ prefix + "_START", {} });
+			for (int i = first; i < first + count; ++i) lumps->push_back({ prefix.substr(0, 1) + "LMP" + std::to_string(i), payload() });
+			lumps->push_back({ prefix + "_END", {} });
+		};
+		auto addMaps = [&](std::vector<std::pair<std::string, LumpBuilder>>* lumps, int first, int count) {
+			for (int i = first; i < first + count; ++i) {
+				lumps->push_back({ "MAP" + std::string(i < 10 ? "0" : "") + std::to_string(i), {} });
+				for (const char* name : { "THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS", "SSECTORS", "NODES", "SECTORS", "REJECT", "BLOCKMAP" }) {
+					lumps->push_back({ name, payload() });
+				}
+			}
+		};
+
+		GameConfig config;
+		config.iwad = "bench_iwad.wad";
+		std::vector<std::pair<std::string, LumpBuilder>> lumps;
+		for (int i = 0; i < 1000; ++i) lumps.push_back({ "LUMP" + std::to_string(i), payload() });
+		addNamespace(&lumps, "F", 0, 150);
+		addNamespace(&lumps, "S", 0, 1400);
+		addNamespace(&lumps, "P", 0, 450);
+		addMaps(&lumps, 1, 32);
+		size_t lumpCount = lumps.size();
+		bool written = WriteTestWAD(TempPath(config.iwad), lumps);
+		for (int pwad = 0; pwad < pwadCount && written; ++pwad) {
+			lumps.clear();
+			for (int i = 0; i < 100; ++i) lumps.push_back({ "LUMP" + std::to_string((pwad * 37 + i) % 1100), payload() });
+			addNamespace(&lumps, "FF", pwad * 10, 20);
+			addNamespace(&lumps, "SS", pwad * 50, 100);
+			addMaps(&lumps, pwad % 32 + 1, 1);
+			lumpCount += lumps.size();
+			config.pwads.push_back("bench_pwad" + std::to_string(pwad) + ".wad");
+			written &= WriteTestWAD(TempPath(config.pwads.back()), lumps);
+		}
+		if (!written) {
+			std::cout << "Failed to write test WADs" << std::endl;
+			return false;
+		}
+
+		std::string directory = std::filesystem::temp_directory_path().string();
+		std::string error;
+		size_t lumpNames = 0, flats = 0, sprites = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; ++pass) {
+			WADStack stack;
+			if (!MountGameConfig(config, directory, &stack, &error)) {
+				std::cout << "Failed to mount: " << error << std::endl;
+				return false;
+			}
+			lumpNames = stack.lumpIndex.size();
+			flats = stack.GetNamespace("F") ? stack.GetNamespace("F")->lumps.size() : 0;
+			sprites = stack.GetNamespace("S") ? stack.GetNamespace("S")->lumps.size() : 0;
+		}
+		double seconds = SecondsSince(start) / passes;
+		std::filesystem::remove(TempPath(config.iwad));
+		for (auto& pwad : config.pwads) std::filesystem::remove(TempPath(pwad));
+
+		std::cout << "Mount ========================" << std::endl;
+		std::cout << "Stack: IWAD and " << pwadCount << " PWADs, " << lumpCount << " lumps" << std::endl;
+		std::cout << "Resolved: " << lumpNames << " names, " << flats << " flats, " << sprites << " sprites" << std::endl;
+		std::cout << "Mount: " << seconds * 1000.0 << "ms ( " << lumpCount / seconds << " lumps/sec )" << std::endl;
+		return true;
+	}
+
+	// Reject tables for generated maps from a few dozen sectors up to a few thousand
+	bool BenchReject() {
+		ThreadPool pool;
+		RejectBuildSettings settings;
+		settings.pool = &pool;
+		std::cout << "Reject =======================" << std::endl;
+		std::cout << "Threads: " << pool.GetThreadCount() << std::endl;
+		for (int32_t size : { 8, 16, 32, 48, 64 }) {
+			GridMap grid;
+			MakeGridMap(&grid, size, size, 0.35f, 4000 + size);
+			RejectTable table;
+			RejectBuildStats stats;
+			BuildReject(&grid.map, &table, settings, &stats);
+			if (!stats.built) {
+				std::cout << "Failed to build the table for a " << size << "x" << size << " grid" << std::endl;
+				return false;
+			}
+			double pairs = (double)stats.sectors * stats.sectors;
+			std::cout << "Sectors " << stats.sectors << ": " << stats.milliseconds << "ms ( " << stats.portals << " portals, "
+				<< (int)(stats.visiblePairs * 100.0 / pairs) << "% of pairs visible, " << stats.overBudget << " over budget )" << std::endl;
+		}
+		return true;
+	}
+}
+
+int TestCommand(int argc, char** argv)
+{
+	const std::pair<std::string, void(*)(TestRun*)> tests[] = {
+		{ "map", TestMapDecode },
+		{ "bsp", TestBSPQueries },
+		{ "blockmap", TestBlockmap },
+		{ "pictures", TestPictures },
+		{ "textures", TestTextureCompose },
+		{ "stack", TestWADStack },
+		{ "reject", TestReject },
+	};
+	std::string only = (argc > 2) ? argv[2] : "";
+	TestRun run;
+	bool ran = false;
+	for (auto& [name, test] : tests) {
+		if (!only.empty() && only != name) continue;
+		test(&run);
+		ran = true;
+	}
+	if (!ran) {
+		std::cout << "Usage: test [ name ], names are";
+		for (auto& test : tests) std::cout << " " << test.first;
+		std::cout << std::endl;
+		return 1;
+	}
+
+	std::cout << "Tests ========================" << std::endl;
+	std::cout << "Passed: " << run.passed << std::endl;
+	std::cout << "Failed: " << run.failed << std::endl;
+	return run.failed ? 2 : 0;
+}
+
+int BenchCommand(int argc, char** argv)
+{
+	const std::pair<std::string, bool(*)()> benchmarks[] = {
+		{ "load", BenchLoad },
+		{ "lookup", BenchLookup },
+		{ "maps", BenchMaps },
+		{ "bsp", BenchBSP },
+		{ "nodes", BenchNodes },
+		{ "mount", BenchMount },
+		{ "reject", BenchReject },
+	};
+	std::string only = (argc > 2) ? argv[2] : "";
+	bool ran = false, failed = false;
+	for (auto& [name, bench] : benchmarks) {
+		if (!only.empty() && only != name) continue;
+		failed |= !bench();
+		ran = true;
+	}
+	if (!ran) {
+		std::cout << "Usage: bench [ name ], names are";
+		for (auto& benchmark : benchmarks) std::cout << " " << benchmark.first;
+		std::cout << std::endl;
+		return 1;
+	}
+	return failed ? 2 : 0;
+}
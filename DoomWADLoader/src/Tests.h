@@ -0,0 +1,12 @@
+#pragma once
+
+// test [ name ]
+// Headless checks for everything that doesn't need a window. Test data is generated, so no WAD has
+// to be provided. Runs every group of checks, or only the one called name. Prints every result and
+// returns 2 if any check failed
+int TestCommand(int argc, char** argv);
+
+// bench [ name ]
+// Timings on generated data, so like test no WAD has to be provided. Runs every benchmark, or only
+// the one called name
+int BenchCommand(int argc, char** argv);
@@ -0,0 +1,446 @@
+#include "Textures.h"
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <math.h>
+
+#define ATLAS_MAGIC   0x41545744 // "DWTA"
+#define ATLAS_VERSION 1
+
+namespace {
+
+	void RunParallel(ThreadPool* pool, size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func) {
+		if (pool) pool->ParallelFor(count, batchSize, func);
+		else func(0, count);
+	}
+
+	// Bottom left skyline packer, the atlas is a fixed width and grows downwards
+	class SkylinePacker {
+	public:
+		SkylinePacker(uint32_t width)
+			: m_Width(width) {
+			m_Skyline.push_back({ 0, 0, width });
+		}
+
+		bool Insert(uint32_t width, uint32_t height, uint32_t* x, uint32_t* y) {
+			size_t bestIndex = SIZE_MAX;
+			uint32_t bestTop = UINT32_MAX;
+			uint32_t bestY = 0;
+
+			for (size_t i = 0; i < m_Skyline.size(); ++i) {
+				uint32_t fitY;
+				if (!Fits(i, width, &fitY)) continue;
+				if (fitY + height < bestTop) {
+					bestTop = fitY + height;
+					bestIndex = i;
+					bestY = fitY;
+				}
+			}
+			if (bestIndex == SIZE_MAX) return false;
+
+			*x = m_Skyline[bestIndex].x;
+			*y = bestY;
+			AddLevel(bestIndex, *x, bestY + height, width);
+			if (bestY + height > m_Height) m_Height = bestY + height;
+			return true;
+		}
+
+		uint32_t GetHeight() const { return m_Height; }
+
+	private:
+		// Height a rect starting at segment index would rest at
+		bool Fits(size_t index, uint32_t width, uint32_t* y) const {
+			uint32_t x = m_Skyline[index].x;
+			if (x + width > m_Width) return false;
+
+			uint32_t top = 0;
+			uint32_t remaining = width;
+			for (size_t i = index; remaining > 0; ++i) {
+				if (i >= m_Skyline.size()) return false;
+				top = std::max(top, m_Skyline[i].y);
+				remaining = (m_Skyline[i].width >= remaining) ? 0 : remaining - m_Skyline[i].width;
+			}
+			*y = top;
+			return true;
+		}
+
+		void AddLevel(size_t index, uint32_t x, uint32_t y, uint32_t width) {
+			m_Skyline.insert(m_Skyline.begin() + index, { x, y, width });
+
+			// Trim or remove the segments the new one covers
+			for (size_t i = index + 1; i < m_Skyline.size();) {
+				Segment& previous = m_Skyline[i - 1];
+				Segment& current = m_Skyline[i];
+				uint32_t previousEnd = previous.x + previous.width;
+				if (current.x >= previousEnd) break;
+
+				uint32_t shrink = previousEnd - current.x;
+				if (current.width <= shrink) {
+					m_Skyline.erase(m_Skyline.begin() + i);
+					continue;
+				}
+				current.x += shrink;
+				current.width -= shrink;
+				break;
+			}
+
+			// Merge neighbours at the same height
+			for (size_t i = 0; i + 1 < m_Skyline.size();) {
+				if (m_Skyline[i].y == m_Skyline[i + 1].y) {
+					m_Skyline[i].width += m_Skyline[i + 1].width;
+					m_Skyline.erase(m_Skyline.begin() + i + 1);
+				}
+				else ++i;
+			}
+		}
+
+	private:
+		struct Segment {
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+
+		uint32_t m_Width;
+		uint32_t m_Height = 0;
+		std::vector<Segment> m_Skyline;
+	};
+
+	uint64_t HashBytes(uint64_t hash, const uint8_t* data, size_t size) {
+		// FNV-1a
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= data[i];
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+	uint64_t HashLump(uint64_t hash, WAD* wad, int32_t id) {
+		if (id < 0) return HashBytes(hash, (const uint8_t*)"-", 1);
+		const Lump& lump = wad->lumps[id];
+		return HashBytes(hash, lump.data, lump.size);
+	}
+
+	bool ReadTextureLump(const Lump& lump, size_t patchCount, std::vector<TextureDef>* textures) {
+		const uint8_t* data = lump.data;
+		if (lump.size < 4) return false;
+
+		int32_t count = ReadInt32(data);
+		if (count < 0 || 4 + (size_t)count * 4 > lump.size) return false;
+
+		for (int32_t i = 0; i < count; ++i) {
+			uint32_t offset = ReadUInt32(data + 4 + i * 4);
+			if ((size_t)offset + MAPTEXTURE_SIZE > lump.size) return false;
+
+			const uint8_t* record = data + offset;
+			TextureDef texture;
+			texture.id = PackLumpName((const char*)record, 8);
+			texture.name = UnpackLumpName(texture.id);
+			texture.width = ReadUInt16(record + 12);
+			texture.height = ReadUInt16(record + 14);
+
+			uint16_t patchUses = ReadUInt16(record + 20);
+			if ((size_t)offset + MAPTEXTURE_SIZE + patchUses * MAPPATCH_SIZE > lump.size) return false;
+
+			texture.patches.resize(patchUses);
+			for (uint16_t p = 0; p < patchUses; ++p) {
+				const uint8_t* patch = record + MAPTEXTURE_SIZE + p * MAPPATCH_SIZE;
+				texture.patches[p].originX = ReadInt16(patch);
+				texture.patches[p].originY = ReadInt16(patch + 2);
+				texture.patches[p].patch = ReadUInt16(patch + 4);
+				if (texture.patches[p].patch >= patchCount) {
+					SOFT_ERROR("Texture uses a patch that isn't in PNAMES ( " + texture.name + " )");
+					texture.patches[p].patch = 0xFFFF;
+				}
+			}
+			textures->push_back(texture);
+		}
+		return true;
+	}
+
+	void ComposeTexture(const TextureDef& texture, const std::vector<int32_t>& patchSlots, const std::vector<Image>& patches, Image* image) {
+		uint32_t width = texture.width;
+		uint32_t height = texture.height;
+		image->width = width;
+		image->height = height;
+		image->pixels.assign(width * height, 0);
+		image->mask.assign(width * height, 0);
+
+		for (const TexturePatch& use : texture.patches) {
+			if (use.patch == 0xFFFF || patchSlots[use.patch] < 0) continue;
+			const Image& patch = patches[patchSlots[use.patch]];
+
+			// Clip the patch against the texture
+			int32_t firstX = std::max(0, -(int32_t)use.originX);
+			int32_t firstY = std::max(0, -(int32_t)use.originY);
+			int32_t lastX = std::min((int32_t)patch.width, (int32_t)width - use.originX);
+			int32_t lastY = std::min((int32_t)patch.height, (int32_t)height - use.originY);
+
+			// Rows are indexed with the clipped column, a pointer to the patch's origin could be before the row
+			for (int32_t y = firstY; y < lastY; ++y) {
+				const uint8_t* source = &patch.pixels[y * patch.width];
+				const uint8_t* sourceMask = &patch.mask[y * patch.width];
+				size_t row = (size_t)(y + use.originY) * width;
+				for (int32_t x = firstX; x < lastX; ++x) {
+					if (!sourceMask[x]) continue;
+					image->pixels[row + use.originX + x] = source[x];
+					image->mask[row + use.originX + x] = 1;
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	void WriteValue(std::ofstream& file, const T& value) {
+		file.write((const char*)&value, sizeof(T));
+	}
+	template<typename T>
+	bool ReadValue(std::ifstream& file, T* value) {
+		file.read((char*)value, sizeof(T));
+		return (bool)file;
+	}
+}
+
+bool LoadTextureDefs(WAD* wad, std::vector<TextureDef>* textures, std::vector<int32_t>* patchLumps)
+{
+	textures->clear();
+	patchLumps->clear();
+
+	int32_t pnamesID = wad->FindLump("PNAMES");
+	if (pnamesID < 0) return false;
+	const Lump& pnames = wad->lumps[pnamesID];
+	if (pnames.size < 4) return false;
+
+	int32_t count = ReadInt32(pnames.data);
+	if (count < 0 || 4 + (size_t)count * 8 > pnames.size) {
+		SOFT_ERROR("PNAMES is too small for its patch count");
+		return false;
+	}
+
+	// Patches between P_START and P_END win over lumps with the same name elsewhere
+	LumpRange patchRange;
+	bool hasPatchRange = wad->GetNamespace("P", &patchRange);
+	patchLumps->resize(count);
+	for (int32_t i = 0; i < count; ++i) {
+		std::string name = UnpackLumpName(PackLumpName((const char*)pnames.data + 4 + i * 8, 8));
+		int32_t id = -1;
+		if (hasPatchRange) id = wad->FindLump(name, patchRange.first, patchRange.last);
+		if (id < 0) id = wad->FindLump(name);
+		(*patchLumps)[i] = id;
+	}
+
+	bool found = false;
+	const char* lumpNames[] = { "TEXTURE1", "TEXTURE2" };
+	for (const char* lumpName : lumpNames) {
+		int32_t id = wad->FindLump(lumpName);
+		if (id < 0) continue;
+		found = true;
+		if (!ReadTextureLump(wad->lumps[id], count, textures)) {
+			SOFT_ERROR(std::string("Texture lump is broken ( ") + lumpName + " )");
+			return false;
+		}
+	}
+	return found;
+}
+
+const AtlasEntry* TextureAtlas::Find(uint64_t id) const
+{
+	auto it = lookup.find(id);
+	if (it == lookup.end()) return nullptr;
+	return &entries[it->second];
+}
+
+uint64_t TextureChecksum(WAD* wad)
+{
+	std::vector<TextureDef> textures;
+	std::vector<int32_t> patchLumps;
+	LoadTextureDefs(wad, &textures, &patchLumps);
+
+	uint64_t hash = 0xCBF29CE484222325ull;
+	hash = HashLump(hash, wad, wad->FindLump("PNAMES"));
+	hash = HashLump(hash, wad, wad->FindLump("TEXTURE1"));
+	hash = HashLump(hash, wad, wad->FindLump("TEXTURE2"));
+	for (int32_t id : patchLumps) hash = HashLump(hash, wad, id);
+	return hash;
+}
+
+bool BuildTextureAtlas(WAD* wad, ThreadPool* pool, TextureAtlas* atlas, TextureAtlasStats* stats, const std::string& cachePath)
+{
+	TextureAtlasStats localStats;
+	if (!stats) stats = &localStats;
+	*stats = TextureAtlasStats();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<TextureDef> textures;
+	std::vector<int32_t> patchLumps;
+	if (!LoadTextureDefs(wad, &textures, &patchLumps)) return false;
+	stats->textures = textures.size();
+
+	uint64_t checksum = TextureChecksum(wad);
+	if (!cachePath.empty() && LoadTextureAtlas(cachePath, checksum, atlas)) {
+		auto end = std::chrono::high_resolution_clock::now();
+		stats->fromCache = true;
+		stats->composeMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+		stats->occupancy = 0.0;
+		for (auto& entry : atlas->entries) stats->occupancy += (double)entry.width * entry.height;
+		if (atlas->image.width && atlas->image.height) stats->occupancy /= (double)atlas->image.width * atlas->image.height;
+		return true;
+	}
+
+	// Decode every patch once no matter how many textures use it
+	std::vector<int32_t> patchSlots(patchLumps.size(), -1);
+	std::vector<int32_t> uniqueLumps;
+	for (auto& texture : textures) {
+		for (auto& use : texture.patches) {
+			if (use.patch == 0xFFFF) continue;
+			++stats->patchUses;
+			if (patchSlots[use.patch] >= 0 || patchLumps[use.patch] < 0) continue;
+			patchSlots[use.patch] = (int32_t)uniqueLumps.size();
+			uniqueLumps.push_back(patchLumps[use.patch]);
+		}
+	}
+	stats->uniquePatches = uniqueLumps.size();
+
+	std::vector<Image> patches(uniqueLumps.size());
+	RunParallel(pool, uniqueLumps.size(), 8, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			if (!DecodePatch(wad->lumps[uniqueLumps[i]], &patches[i])) {
+				SOFT_ERROR("Failed to decode patch ( " + wad->lumps[uniqueLumps[i]].name + " )");
+				patches[i] = Image();
+			}
+		}
+	});
+
+	std::vector<Image> composed(textures.size());
+	RunParallel(pool, textures.size(), 4, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) ComposeTexture(textures[i], patchSlots, patches, &composed[i]);
+	});
+
+	auto composeEnd = std::chrono::high_resolution_clock::now();
+	stats->composeMilliseconds = std::chrono::duration<double, std::milli>(composeEnd - start).count();
+
+	// Tallest first packs tighter on a skyline
+	std::vector<uint32_t> order(textures.size());
+	uint64_t area = 0;
+	uint32_t widest = 1;
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+		area += (uint64_t)textures[i].width * textures[i].height;
+		widest = std::max<uint32_t>(widest, textures[i].width);
+	}
+	std::sort(order.begin(), order.end(), [&textures](uint32_t a, uint32_t b) {
+		if (textures[a].height != textures[b].height) return textures[a].height > textures[b].height;
+		if (textures[a].width != textures[b].width) return textures[a].width > textures[b].width;
+		return a < b;
+	});
+
+	uint32_t atlasWidth = 64;
+	while ((uint64_t)atlasWidth * atlasWidth < area) atlasWidth *= 2;
+	atlasWidth = std::max(atlasWidth, widest);
+
+	SkylinePacker packer(atlasWidth);
+	atlas->entries.assign(textures.size(), AtlasEntry());
+	atlas->lookup.clear();
+	for (uint32_t i : order) {
+		uint32_t x = 0, y = 0;
+		if (textures[i].width && textures[i].height) packer.Insert(textures[i].width, textures[i].height, &x, &y);
+		atlas->entries[i] = { textures[i].id, (uint16_t)x, (uint16_t)y, textures[i].width, textures[i].height };
+	}
+	if (packer.GetHeight() > 0xFFFF) {
+		SOFT_ERROR("Texture atlas is too tall");
+		return false;
+	}
+	for (uint32_t i = 0; i < textures.size(); ++i) {
+		// First definition of a name wins like Doom's texture lookup
+		atlas->lookup.insert({ textures[i].id, i });
+	}
+
+	Image& image = atlas->image;
+	image.width = atlasWidth;
+	image.height = std::max<uint32_t>(packer.GetHeight(), 1);
+	image.pixels.assign((size_t)image.width * image.height, 0);
+	image.mask.assign((size_t)image.width * image.height, 0);
+
+	// Textures don't overlap so copying them in can be done in parallel
+	RunParallel(pool, textures.size(), 16, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			const AtlasEntry& entry = atlas->entries[i];
+			const Image& texture = composed[i];
+			for (uint32_t y = 0; y < entry.height; ++y) {
+				size_t destination = (size_t)(entry.y + y) * image.width + entry.x;
+				memcpy(&image.pixels[destination], &texture.pixels[y * texture.width], entry.width);
+				memcpy(&image.mask[destination], &texture.mask[y * texture.width], entry.width);
+			}
+		}
+	});
+	atlas->checksum = checksum;
+
+	auto packEnd = std::chrono::high_resolution_clock::now();
+	stats->packMilliseconds = std::chrono::duration<double, std::milli>(packEnd - composeEnd).count();
+	stats->occupancy = (double)area / ((double)image.width * image.height);
+
+	if (!cachePath.empty() && !SaveTextureAtlas(cachePath, atlas)) {
+		SOFT_ERROR("Failed to write texture atlas cache ( " + cachePath + " )");
+	}
+	return true;
+}
+
+bool SaveTextureAtlas(const std::string& path, const TextureAtlas* atlas)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	WriteValue(file, (uint32_t)ATLAS_MAGIC);
+	WriteValue(file, (uint32_t)ATLAS_VERSION);
+	WriteValue(file, atlas->checksum);
+	WriteValue(file, atlas->image.width);
+	WriteValue(file, atlas->image.height);
+	WriteValue(file, (uint32_t)atlas->entries.size());
+	for (const AtlasEntry& entry : atlas->entries) {
+		WriteValue(file, entry.id);
+		WriteValue(file, entry.x);
+		WriteValue(file, entry.y);
+		WriteValue(file, entry.width);
+		WriteValue(file, entry.height);
+	}
+	file.write((const char*)atlas->image.pixels.data(), atlas->image.pixels.size());
+	file.write((const char*)atlas->image.mask.data(), atlas->image.mask.size());
+	return (bool)file;
+}
+
+bool LoadTextureAtlas(const std::string& path, uint64_t checksum, TextureAtlas* atlas)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	uint32_t magic, version, width, height, entryCount;
+	uint64_t fileChecksum;
+	if (!ReadValue(file, &magic) || magic != ATLAS_MAGIC) return false;
+	if (!ReadValue(file, &version) || version != ATLAS_VERSION) return false;
+	if (!ReadValue(file, &fileChecksum) || fileChecksum != checksum) return false;
+	if (!ReadValue(file, &width) || !ReadValue(file, &height) || !ReadValue(file, &entryCount)) return false;
+	if (width > 0xFFFF || height > 0xFFFF || entryCount > 0xFFFF) return false;
+
+	std::vector<AtlasEntry> entries(entryCount);
+	for (AtlasEntry& entry : entries) {
+		if (!ReadValue(file, &entry.id) || !ReadValue(file, &entry.x) || !ReadValue(file, &entry.y) ||
+			!ReadValue(file, &entry.width) || !ReadValue(file, &entry.height)) return false;
+		if ((uint32_t)entry.x + entry.width > width || (uint32_t)entry.y + entry.height > height) return false;
+	}
+
+	Image image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height);
+	image.mask.resize((size_t)width * height);
+	file.read((char*)image.pixels.data(), image.pixels.size());
+	file.read((char*)image.mask.data(), image.mask.size());
+	if (!file) return false;
+
+	atlas->image = std::move(image);
+	atlas->entries = std::move(entries);
+	atlas->checksum = checksum;
+	atlas->lookup.clear();
+	for (uint32_t i = 0; i < atlas->entries.size(); ++i) atlas->lookup.insert({ atlas->entries[i].id, i });
+	return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include "WAD.h"
+#include "Graphics.h"
+#include "ThreadPool.h"
+
+#define MAPTEXTURE_SIZE (sizeof(char) * 22)
+#define MAPPATCH_SIZE   (sizeof(char) * 10)
+
+struct TexturePatch {
+	int16_t originX;
+	int16_t originY;
+	// Index into PNAMES
+	uint16_t patch;
+};
+// Wall texture from TEXTURE1 / TEXTURE2, made by drawing patches on top of each other
+struct TextureDef {
+	std::string name;
+	uint64_t id;
+	uint16_t width;
+	uint16_t height;
+	std::vector<TexturePatch> patches;
+};
+
+// Reads PNAMES and TEXTURE1 / TEXTURE2, patchLumps maps PNAMES entries to lump indices ( -1 if missing )
+bool LoadTextureDefs(WAD* wad, std::vector<TextureDef>* textures, std::vector<int32_t>* patchLumps);
+
+struct AtlasEntry {
+	uint64_t id;
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+};
+// Every composed wall texture packed into one image
+struct TextureAtlas {
+	Image image;
+	std::vector<AtlasEntry> entries;
+	// Packed texture name to index in entries
+	std::unordered_map<uint64_t, uint32_t> lookup;
+	// Hash of the lumps the atlas was built from, a cache file only gets used if this matches
+	uint64_t checksum = 0;
+
+	const AtlasEntry* Find(uint64_t id) const;
+	const AtlasEntry* Find(const std::string& name) const { return Find(PackLumpName(name)); }
+};
+
+struct TextureAtlasStats {
+	size_t textures = 0;
+	size_t uniquePatches = 0;
+	// Patch uses across all textures, compared to uniquePatches this is how much decoding dedup saved
+	size_t patchUses = 0;
+	bool fromCache = false;
+	double composeMilliseconds = 0.0;
+	double packMilliseconds = 0.0;
+	// Fraction of the atlas covered by textures
+	double occupancy = 0.0;
+};
+
+// Composes every texture and packs them into an atlas
+// If cachePath is set an up to date cache file is loaded instead, and a new one is written after building
+bool BuildTextureAtlas(WAD* wad, ThreadPool* pool, TextureAtlas* atlas, TextureAtlasStats* stats = nullptr, const std::string& cachePath = "");
+
+uint64_t TextureChecksum(WAD* wad);
+bool SaveTextureAtlas(const std::string& path, const TextureAtlas* atlas);
+// Fails if the file is missing, broken or was built from different lumps
+bool LoadTextureAtlas(const std::string& path, uint64_t checksum, TextureAtlas* atlas);
@@ -0,0 +1,100 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0) threadCount = 1;
+
+	for (size_t i = 1; i < threadCount; ++i) {
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_TaskReady.notify_all();
+	for (auto& worker : m_Workers) worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> func)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push(std::move(func));
+	}
+	m_TaskReady.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_TaskReady.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+			if (m_Stopping && m_Tasks.empty()) return;
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop();
+		}
+		task();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func)
+{
+	if (count == 0) return;
+	if (batchSize == 0) batchSize = 1;
+	size_t batchCount = (count + batchSize - 1) / batchSize;
+
+	if (batchCount == 1 || m_Workers.empty()) {
+		func(0, count);
+		return;
+	}
+
+	// Helpers may start after the loop is already done so they share ownership of the job
+	struct Job {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> finished{ 0 };
+		size_t count;
+		size_t batchSize;
+		size_t batchCount;
+		const std::function<void(size_t, size_t)>* func;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	auto job = std::make_shared<Job>();
+	job->count = count;
+	job->batchSize = batchSize;
+	job->batchCount = batchCount;
+	job->func = &func;
+
+	// Returns once there are no batches left to take
+	auto work = [](Job& job) {
+		while (true) {
+			size_t batch = job.next.fetch_add(1);
+			if (batch >= job.batchCount) return;
+
+			size_t begin = batch * job.batchSize;
+			size_t end = (begin + job.batchSize < job.count) ? begin + job.batchSize : job.count;
+			(*job.func)(begin, end);
+
+			if (job.finished.fetch_add(1) + 1 == job.batchCount) {
+				std::lock_guard<std::mutex> lock(job.mutex);
+				job.done.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = (batchCount - 1 < m_Workers.size()) ? batchCount - 1 : m_Workers.size();
+	for (size_t i = 0; i < helpers; ++i) {
+		Submit([job, work]() { work(*job); });
+	}
+
+	// The caller only waits on batches, not on helpers, so a busy pool can't deadlock it
+	work(*job);
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->done.wait(lock, [&job]() { return job->finished.load() == job->batchCount; });
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+// Fixed set of worker threads for splitting loops across cores
+class ThreadPool {
+public:
+	// 0 uses one thread per core, the calling thread counts as one of them
+	ThreadPool(size_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Total threads that work on a ParallelFor, including the caller
+	size_t GetThreadCount() const { return m_Workers.size() + 1; }
+
+	// Calls func( begin, end ) over [ 0, count ) in batches of batchSize and waits for all of them
+	// The calling thread works on batches too, so calling ParallelFor from inside a batch is fine
+	void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func);
+
+	// Runs func on a worker without waiting for it
+	void Submit(std::function<void()> func);
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> m_Workers;
+	std::queue<std::function<void()>> m_Tasks;
+	std::mutex m_Mutex;
+	std::condition_variable m_TaskReady;
+	bool m_Stopping = false;
+};
@@ -3,27 +3,51 @@
 #include <iomanip>
 #include <sstream>
 #include "JSON.h"
+#include "Map.h"
+#include <algorithm>
+#include <ctype.h>
 
-void read(uint8_t& value, uint8_t* data, uint32_t& offset) {
+void read(uint8_t& value, const uint8_t* data, uint32_t& offset) {
 	value = data[offset];
 	offset += sizeof(uint8_t);
 }
-void read(uint16_t& value, uint8_t* data, uint32_t& offset) {
+void read(uint16_t& value, const uint8_t* data, uint32_t& offset) {
 	value = (data[offset + 1] << 8) + data[offset];
 	offset += sizeof(uint16_t);
 }
-void read(uint32_t& value, uint8_t* data, uint32_t& offset) {
+void read(uint32_t& value, const uint8_t* data, uint32_t& offset) {
 	value = (((uint32_t)data[offset + 3]) << 24) | (((uint32_t)data[offset + 2]) << 16) | (((uint32_t)data[offset + 1]) << 8) | (uint32_t)data[offset];
 	offset += sizeof(uint32_t);
 }
-void read(std::string& value, uint32_t size, uint8_t* data, uint32_t& offset) {
+void read(std::string& value, uint32_t size, const uint8_t* data, uint32_t& offset) {
 	for (int i = 0; i < size; ++i) {
 		value.push_back(data[offset + i]);
 	}
 	offset += sizeof(uint8_t) * value.size();
 }
 
-void LoadHeader(uint8_t* data, WAD* wad) {
+uint64_t PackLumpName(const char* name, size_t length)
+{
+	uint64_t id = 0;
+	for (size_t i = 0; i < length && i < 8; ++i) {
+		if (name[i] == '\0') break;
+		id |= (uint64_t)(uint8_t)toupper((uint8_t)name[i]) << (i * 8);
+	}
+	return id;
+}
+
+std::string UnpackLumpName(uint64_t id)
+{
+	std::string name;
+	for (int i = 0; i < 8; ++i) {
+		char c = (char)((id >> (i * 8)) & 0xFF);
+		if (c == '\0') break;
+		name.push_back(c);
+	}
+	return name;
+}
+
+void LoadHeader(const uint8_t* data, WAD* wad) {
 
 	uint32_t offset = 0;
 
@@ -32,13 +56,14 @@ void LoadHeader(uint8_t* data, WAD* wad) {
 	read(wad->directoryPointer, data, offset);
 }
 
-void LoadLump(uint8_t* data, uint32_t& offset, WAD* wad) {
+bool LoadLump(const uint8_t* data, uint32_t& offset, WAD* wad) {
 
 	Lump lump;
 
 	read(lump.pointer, data, offset);
 	read(lump.size, data, offset);
 
+	lump.id = PackLumpName((const char*)data + offset, 8);
 	uint8_t c = NULL;
 	for (int i = 0; i < 8; ++i) {
 		read(c, data, offset);
@@ -48,95 +73,126 @@ void LoadLump(uint8_t* data, uint32_t& offset, WAD* wad) {
 		//	break;
 	}
 
+	bool valid = true;
 	if (lump.size != 0) {
-		lump.data = (uint8_t*)malloc(lump.size * sizeof(uint8_t));
-		memcpy(lump.data, data + lump.pointer, lump.size * sizeof(uint8_t));
-	}
-	else {
-		wad->markers.insert({ lump.name, wad->lumps.size() });
+		if ((uint64_t)lump.pointer + lump.size > wad->file.Size()) {
+			valid = false;
+			lump.size = 0;
+		}
+		else lump.data = data + lump.pointer;
 	}
+	if (lump.size == 0) lump.data = nullptr;
 
+	wad->lumpIndex[lump.id].push_back((uint32_t)wad->lumps.size());
 	wad->lumps.push_back(lump);
+	return valid;
 }
 
-void LoadWAD(const std::string& path, WAD* wad)
-{
-	std::ifstream file;
-	file.open(path, std::ios::binary);
-	if (!file.is_open()) { FATAL_ERROR("Failed to load WAD file ( " + path + " )") }
-
-	file.seekg(0, std::ios::end);
-	uint32_t size = file.tellg();
-	file.seekg(0, std::ios::beg);
+bool IsMapLump(uint64_t id) {
+	static const uint64_t mapLumps[] = {
+		PackLumpName("THINGS"),  PackLumpName("LINEDEFS"), PackLumpName("SIDEDEFS"), PackLumpName("VERTEXES"),
+		PackLumpName("SEGS"),    PackLumpName("SSECTORS"), PackLumpName("NODES"),    PackLumpName("SECTORS"),
+		PackLumpName("REJECT"),  PackLumpName("BLOCKMAP"), PackLumpName("BEHAVIOR"), PackLumpName("SCRIPTS")
+	};
+	for (uint64_t mapLump : mapLumps) {
+		if (id == mapLump) return true;
+	}
+	return false;
+}
 
-	uint8_t* data = (uint8_t*)malloc(size);
-	if (!data) { FATAL_ERROR("Failed to allocate memory for WAD data") }
-	file.read(reinterpret_cast<char*>(data), size);
+// Finds namespace markers ( S_START/S_END, FF_START/FF_END, ... ) and map blocks
+void IndexLumpRanges(WAD* wad) {
+	const uint64_t things = PackLumpName("THINGS");
+	std::unordered_map<uint64_t, uint32_t> openNamespaces;
+
+	for (uint32_t i = 0; i < wad->lumps.size(); ++i) {
+		Lump& lump = wad->lumps[i];
+		if (lump.size != 0) continue;
+
+		// Map marker, the map's lumps follow it until a lump that isn't part of a map
+		if (i + 1 < wad->lumps.size() && wad->lumps[i + 1].id == things) {
+			uint32_t last = i + 1;
+			while (last < wad->lumps.size() && IsMapLump(wad->lumps[last].id)) ++last;
+			wad->mapBlocks.insert({ lump.id, { i + 1, last } });
+			continue;
+		}
 
-	LoadHeader(data, wad);
+		// Namespace markers, doubled prefixes ( SS_START ) are the same namespace as single ones
+		size_t split = lump.name.find('_');
+		if (split == std::string::npos || split == 0 || split > 2) continue;
+		std::string prefix = lump.name.substr(0, split);
+		std::string suffix = lump.name.substr(split + 1);
+		if (prefix.size() == 2 && prefix[0] == prefix[1]) prefix.pop_back();
+		uint64_t prefixID = PackLumpName(prefix);
 
-	for (int i = 0; i < wad->lumpCount; ++i) {
-		uint32_t offset = wad->directoryPointer + (i * LUMP_SIZE);
-		LoadLump(data, offset, wad);
+		if (suffix == "START") {
+			if (!openNamespaces.count(prefixID)) openNamespaces.insert({ prefixID, i + 1 });
+		}
+		else if (suffix == "END") {
+			auto start = openNamespaces.find(prefixID);
+			if (start == openNamespaces.end()) continue;
+			if (!wad->namespaces.count(prefixID)) wad->namespaces.insert({ prefixID, { start->second, i } });
+			openNamespaces.erase(start);
+		}
 	}
-
-	file.close();
 }
 
-void LoadMap(WAD* wad, Map* map)
+bool TryLoadWAD(const std::string& path, WAD* wad, std::string* error)
 {
-	uint32_t mapMarker = wad->GetMarker(map->name);
-	Lump& lineDefsLump = wad->GetLump("LINEDEFS", mapMarker);
-	Lump& sideDefsLump = wad->GetLump("SIDEDEFS", mapMarker);
-	Lump& vertexLump   = wad->GetLump("VERTEXES", mapMarker);
-	Lump& segsLump     = wad->GetLump("SEGS",     mapMarker);
-	Lump& sSectorsLump = wad->GetLump("SSECTORS", mapMarker);
-	Lump& nodesLump    = wad->GetLump("NODES",    mapMarker);
-	Lump& sectorsLump  = wad->GetLump("SECTORS",  mapMarker);
-
-	// Line Defs
-	{
-		uint32_t count = lineDefsLump.size / LINEDEF_SIZE;
-
-		for (int i = 0; i < count; ++i) {
-			LineDef lineDef;
-
-			uint32_t loc = lineDefsLump.pointer + (i * LINEDEF_SIZE);
-			read(lineDef.startVertex, lineDefsLump.data, loc);
-			read(lineDef.endVertex,   lineDefsLump.data, loc);
-			read(lineDef.flags,       lineDefsLump.data, loc);
-			read(lineDef.special,     lineDefsLump.data, loc);
-			read(lineDef.tag,         lineDefsLump.data, loc);
-			read(lineDef.frontSide,   lineDefsLump.data, loc);
-			read(lineDef.backSide,    lineDefsLump.data, loc);
-
-			map->lineDefs.push_back(lineDef);
-		}
+	if (!wad->file.Open(path)) {
+		*error = "Failed to load WAD file ( " + path + " )";
+		return false;
 	}
+	const uint8_t* data = wad->file.Data();
+	size_t size = wad->file.Size();
 
-	// Vertices
-	{
-		uint32_t count = vertexLump.size / VERTEX_SIZE;
-
-		for (int i = 0; i < count; ++i) {
-			Vertex vertex;
+	if (size < HEADER_SIZE) {
+		*error = "WAD file is too small ( " + path + " )";
+		return false;
+	}
+	LoadHeader(data, wad);
 
-			uint32_t loc = lineDefsLump.pointer + (i * VERTEX_SIZE);
-			read(vertex.x, lineDefsLump.data, loc);
-			read(vertex.y, lineDefsLump.data, loc);
+	if (wad->signature != "IWAD" && wad->signature != "PWAD") {
+		*error = "File isn't a WAD ( " + path + " )";
+		return false;
+	}
+	if ((uint64_t)wad->directoryPointer + (uint64_t)wad->lumpCount * LUMP_SIZE > size) {
+		*error = "WAD directory points outside of the file ( " + path + " )";
+		return false;
+	}
 
-			map->vertices.push_back(vertex);
+	// Broken lumps are kept as empty lumps so the rest of the WAD is still usable
+	bool valid = true;
+	wad->lumps.reserve(wad->lumpCount);
+	for (int i = 0; i < wad->lumpCount; ++i) {
+		uint32_t offset = wad->directoryPointer + (i * LUMP_SIZE);
+		if (!LoadLump(data, offset, wad) && valid) {
+			*error = "Lump points outside of the WAD file ( " + wad->lumps.back().name + " )";
+			valid = false;
 		}
 	}
+
+	IndexLumpRanges(wad);
+	return valid;
+}
+
+void LoadWAD(const std::string& path, WAD* wad)
+{
+	std::string error;
+	if (!TryLoadWAD(path, wad, &error)) {
+		FATAL_ERROR(error);
+	}
 }
 
 void LoadGameConfig(WAD* wad, GameConfig* config)
 {
 	if (!wad->lumpExists("GAMECONF")) return;
-	Lump& gameConfigLump = wad->GetLump("GAMECONF");
+	const Lump* gameConfigLump = wad->GetLump("GAMECONF");
+	if (!gameConfigLump) return;
 
+	// Lumps aren't null terminated so only the lump's own bytes go into the stream
 	std::stringstream buffer;
-	buffer << (char*)gameConfigLump.data;
+	buffer << std::string((const char*)gameConfigLump->data, gameConfigLump->size);
 
 	std::string JSONSource;
 
@@ -144,7 +200,7 @@ void LoadGameConfig(WAD* wad, GameConfig* config)
 	char c;
 	buffer >> std::noskipws;
 	buffer >> c;
-	while (c) {
+	while (c && buffer) {
 		JSONSource.push_back(c);
 		buffer >> c;
 		if (c == '{') bracketCount += 1;
@@ -169,6 +225,18 @@ void LoadGameConfig(WAD* wad, GameConfig* config)
 	config->executable = data["executable"].ReadString();
 	config->mode = data["mode"].ReadString();
 	config->options = data["options"].ReadString();
+
+	// Optional lists, read straight from children so a missing key isn't reported
+	auto readList = [&](const std::string& key, std::vector<std::string>* list) {
+		list->clear();
+		auto it = data.children.find(key);
+		if (it == data.children.end() || it->second.type != JSON::DataType::Array) return;
+		for (auto& element : it->second.elements) {
+			if (element.type == JSON::DataType::String) list->push_back(element.value);
+		}
+	};
+	readList("pwadfiles", &config->pwads);
+	readList("playertranslations", &config->playerTranslations);
 }
 
 std::string GenerateConsoleText(WAD* wad, Map* map, GameConfig* config)
@@ -188,6 +256,17 @@ std::string GenerateConsoleText(WAD* wad, Map* map, GameConfig* config)
 	desc << "Lump Count: " << wad->lumpCount << std::endl;
 	desc << "Directory Pointer: " << wad->directoryPointer << std::endl;
 	desc << std::endl;
+
+	desc << "Map data =====================" << std::endl;
+	desc << "Things: "      << map->things.size() << std::endl;
+	desc << "Vertices: "    << map->vertices.size() << std::endl;
+	desc << "Line Defs: "   << map->lineDefs.size() << std::endl;
+	desc << "Side Defs: "   << map->sideDefs.size() << std::endl;
+	desc << "Segments: "    << map->segments.size() << std::endl;
+	desc << "Sub Sectors: " << map->subSectors.size() << std::endl;
+	desc << "Nodes: "       << map->nodes.size() << std::endl;
+	desc << "Sectors: "     << map->sectors.size() << std::endl;
+	desc << std::endl;
 	for (int i = wad->GetMarker(map->name) + 1; i < wad->lumpCount; ++i) {
 		if (wad->lumps[i].size == 0) break;
 		desc << std::left << std::setw(30) << std::setfill('=') << (wad->lumps[i].name + " ") << std::endl;
@@ -200,25 +279,70 @@ std::string GenerateConsoleText(WAD* wad, Map* map, GameConfig* config)
 	return desc.str();
 }
 
-Lump& WAD::GetLump(const std::string& name, uint32_t startID)
+uint8_t* Lump::GetMutableData()
 {
-	for (int i = startID; i < lumps.size(); ++i) {
-		if (lumps[i].name == name) return lumps[i];
+	if (mutableData.size() != size) {
+		mutableData.assign(data, data + size);
+		data = mutableData.data();
 	}
-	FATAL_ERROR("Lump doesn't exist ( " + name + " )")
+	return mutableData.data();
+}
+Lump& Lump::operator=(const Lump& other)
+{
+	if (this == &other) return *this;
+	pointer = other.pointer;
+	size = other.size;
+	name = other.name;
+	id = other.id;
+	mutableData = other.mutableData;
+	bool copied = !other.mutableData.empty() && other.data == other.mutableData.data();
+	data = copied ? mutableData.data() : other.data;
+	return *this;
+}
+
+int32_t WAD::FindLump(const std::string& name, uint32_t startID, uint32_t endID) const
+{
+	auto it = lumpIndex.find(PackLumpName(name));
+	if (it == lumpIndex.end()) return -1;
+
+	// Occurrences are in directory order
+	const std::vector<uint32_t>& occurrences = it->second;
+	auto next = std::lower_bound(occurrences.begin(), occurrences.end(), startID);
+	if (next == occurrences.end() || *next >= endID) return -1;
+	return (int32_t)*next;
+}
+Lump* WAD::GetLump(const std::string& name, uint32_t startID)
+{
+	int32_t id = FindLump(name, startID);
+	return (id >= 0) ? &lumps[id] : nullptr;
 }
 bool WAD::lumpExists(const std::string& name, uint32_t startID)
 {
-	for (int i = startID; i < lumps.size(); ++i) {
-		if (lumps[i].name == name) return true;
-	}
-	return false;
+	return FindLump(name, startID) >= 0;
 }
 uint32_t WAD::GetMarker(const std::string& name)
 {
-	if (!markers.count(name)) {
-		SOFT_ERROR("Marker doesn't exist ( " + name + " )");
-		return 0;
+	auto it = lumpIndex.find(PackLumpName(name));
+	if (it != lumpIndex.end()) {
+		for (uint32_t id : it->second) {
+			if (lumps[id].size == 0) return id;
+		}
 	}
-	return markers[name];
+	SOFT_ERROR("Marker doesn't exist ( " + name + " )");
+	return 0;
+}
+
+bool WAD::GetNamespace(const std::string& prefix, LumpRange* range) const
+{
+	auto it = namespaces.find(PackLumpName(prefix));
+	if (it == namespaces.end()) return false;
+	*range = it->second;
+	return true;
+}
+bool WAD::GetMapLumps(const std::string& map, LumpRange* range) const
+{
+	auto it = mapBlocks.find(PackLumpName(map));
+	if (it == mapBlocks.end()) return false;
+	*range = it->second;
+	return true;
 }
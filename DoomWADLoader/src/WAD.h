@@ -1,29 +1,60 @@
 #pragma once
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <stdio.h>
+#include <string.h>
 #include "Core.h"
+#include "MappedFile.h"
 
 #define HEADER_SIZE  (sizeof(char) * 12)
 #define LUMP_SIZE    (sizeof(char) * 16)
 
-#define LINEDEF_SIZE (sizeof(char) * 14)
-#define SIDEDEF_SIZE (sizeof(char) * 30)
-#define VERTEX_SIZE  (sizeof(char) * 4)
-#define SEG_SIZE     (sizeof(char) * 12)
-#define SSECTOR_SIZE (sizeof(char) * 4)
-#define NODE_SIZE    (sizeof(char) * 28)
-#define SECTOR_SIZE  (sizeof(char) * 26)
+// Packs an up to 8 character lump name into an int so names can be compared and hashed
+// in one go. Names are uppercased like Doom does when it looks up lumps
+uint64_t PackLumpName(const char* name, size_t length);
+inline uint64_t PackLumpName(const std::string& name) { return PackLumpName(name.c_str(), name.size()); }
+std::string UnpackLumpName(uint64_t id);
+
+// Lump data is little endian and not aligned, every platform we build for is little endian
+inline int16_t  ReadInt16(const uint8_t* data)  { int16_t value;  memcpy(&value, data, sizeof(value)); return value; }
+inline uint16_t ReadUInt16(const uint8_t* data) { uint16_t value; memcpy(&value, data, sizeof(value)); return value; }
+inline int32_t  ReadInt32(const uint8_t* data)  { int32_t value;  memcpy(&value, data, sizeof(value)); return value; }
+inline uint32_t ReadUInt32(const uint8_t* data) { uint32_t value; memcpy(&value, data, sizeof(value)); return value; }
 
 struct Lump {
-	uint32_t pointer;
-	uint32_t size;
+	uint32_t pointer = 0;
+	uint32_t size = 0;
 	std::string name;
+	uint64_t id = 0;
 	
-	uint8_t* data;
+	// View into the mapped WAD file, only valid while the WAD is loaded
+	// After GetMutableData it points at the copy instead, so writes are seen through it
+	const uint8_t* data = nullptr;
+
+	// Copies the lump out of the mapping the first time it's called
+	uint8_t* GetMutableData();
+
+	std::vector<uint8_t> mutableData;
+
+	Lump() = default;
+	// Copies point data at their own mutableData
+	Lump(const Lump& other) { *this = other; }
+	Lump& operator=(const Lump& other);
+	// Moving a vector keeps its buffer, so data stays valid
+	Lump(Lump&&) = default;
+	Lump& operator=(Lump&&) = default;
+};
+// Lumps [ first, last )
+struct LumpRange {
+	uint32_t first;
+	uint32_t last;
 };
+
 struct WAD {
+	MappedFile file;
+
 	// Header Data
 	std::string signature;
 	uint32_t lumpCount;
@@ -31,12 +62,24 @@ struct WAD {
 
 	// Everything else
 	std::vector<Lump> lumps;
-	std::map<std::string, uint32_t> markers;
+
+	// Lump indices for every name, in directory order
+	std::unordered_map<uint64_t, std::vector<uint32_t>> lumpIndex;
+	// Lumps between X_START and X_END markers, keyed by the packed prefix ( S, F, P, ... )
+	std::unordered_map<uint64_t, LumpRange> namespaces;
+	// Lumps that belong to a map, keyed by the packed map marker name
+	std::unordered_map<uint64_t, LumpRange> mapBlocks;
 
 	// Functions
-	Lump& GetLump(const std::string& name, uint32_t startID = 0);
+	// Returns the index of the first lump called name in [ startID, endID ) or -1
+	int32_t FindLump(const std::string& name, uint32_t startID = 0, uint32_t endID = UINT32_MAX) const;
+	// nullptr if there's no lump called name
+	Lump* GetLump(const std::string& name, uint32_t startID = 0);
 	bool lumpExists(const std::string& name, uint32_t startID = 0);
 	uint32_t GetMarker(const std::string& name);
+
+	bool GetNamespace(const std::string& prefix, LumpRange* range) const;
+	bool GetMapLumps(const std::string& map, LumpRange* range) const;
 };
 
 struct GameConfig {
@@ -52,81 +95,11 @@ struct GameConfig {
 	std::string options;
 };
 
-struct Vertex {
-	uint16_t x;
-	uint16_t y;
-};
-struct LineDef {
-	uint16_t startVertex;
-	uint16_t endVertex;
-	uint16_t flags;
-	uint16_t special;
-	uint16_t tag;
-	uint16_t frontSide;
-	uint16_t backSide;
-};
-struct SideDef {
-	uint16_t xOffset;
-	uint16_t yOffset;
-	std::string upperTexture;
-	std::string middleTexture;
-	std::string lowerTexture;
-	uint16_t faceSector;
-};
-struct Segment {
-	int16_t startVertex;
-	int16_t endVertex;
-	int16_t angle;
-	int16_t lineDef;
-	int16_t direction;
-	int16_t offset;
-};
-struct SubSector {
-	uint16_t segmentCount;
-	uint16_t firstSegment;
-};
-struct Sector {
-	uint16_t floorHeight;
-	uint16_t ceilingHeight;
-	std::string floorTexture;
-	std::string ceilingTexture;
-	uint16_t lightLevel;
-	uint16_t specialType;
-	uint16_t tagNumber;
-};
-
-struct BoundingBox {
-	uint16_t top;
-	uint16_t bottom;
-	uint16_t left;
-	uint16_t right;
-};
-struct Node {
-	uint16_t x;
-	uint16_t y;
-	uint16_t xDelta;
-	uint16_t yDelta;
-	BoundingBox rightBox;
-	BoundingBox leftBox;
-	uint16_t rightChild;
-	uint16_t leftChild;
-};
-
-struct Map {
-	std::string name;
-
-	std::vector<Vertex> vertices;
-	std::vector<LineDef> lineDefs;
-	std::vector<SideDef> sideDefs;
-	std::vector<Segment> segments;
-	std::vector<SubSector> subSectors;
-	std::vector<SubSector> sectors;
-
-	std::vector<Node> nodes;
-};
+struct Map;
 
 void LoadWAD(const std::string& path, WAD* wad);
-void LoadMap(WAD* wad, Map* map);
+// Same as LoadWAD but problems are returned instead of being fatal, for tools that go through many files
+bool TryLoadWAD(const std::string& path, WAD* wad, std::string* error);
 void LoadGameConfig(WAD* wad, GameConfig* config);
 
 std::string GenerateConsoleText(WAD* wad, Map* map, GameConfig* config);
\ No newline at end of file
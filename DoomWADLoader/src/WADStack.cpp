@@ -0,0 +1,108 @@
+#include "WADStack.h"
+#include <filesystem>
+
+const Lump* WADStack::FindLump(const std::string& name) const
+{
+	return FindLump(PackLumpName(name));
+}
+const Lump* WADStack::FindLump(uint64_t id) const
+{
+	LumpRef ref;
+	if (!FindLump(id, &ref)) return nullptr;
+	return &GetLump(ref);
+}
+bool WADStack::FindLump(uint64_t id, LumpRef* ref) const
+{
+	auto it = lumpIndex.find(id);
+	if (it == lumpIndex.end()) return false;
+	*ref = it->second;
+	return true;
+}
+
+const Lump* WADStack::FindInNamespace(const std::string& prefix, const std::string& name) const
+{
+	const StackNamespace* space = GetNamespace(prefix);
+	if (!space) return nullptr;
+	auto it = space->lookup.find(PackLumpName(name));
+	if (it == space->lookup.end()) return nullptr;
+	return &GetLump(space->lumps[it->second]);
+}
+const StackNamespace* WADStack::GetNamespace(const std::string& prefix) const
+{
+	auto it = namespaces.find(PackLumpName(prefix));
+	return it == namespaces.end() ? nullptr : &it->second;
+}
+
+WAD* WADStack::GetMapWAD(const std::string& map) const
+{
+	auto it = mapBlocks.find(PackLumpName(map));
+	if (it == mapBlocks.end()) return nullptr;
+	return wads[it->second.first].get();
+}
+
+bool MountWAD(const std::string& path, WADStack* stack, std::string* error)
+{
+	std::unique_ptr<WAD> wad = std::make_unique<WAD>();
+	if (!TryLoadWAD(path, wad.get(), error)) return false;
+
+	uint32_t wadIndex = (uint32_t)stack->wads.size();
+
+	// Later lumps win, inside one WAD too, so a plain walk in directory order does it
+	for (uint32_t i = 0; i < wad->lumps.size(); ++i) {
+		stack->lumpIndex[wad->lumps[i].id] = { wadIndex, i };
+	}
+
+	for (auto& [prefix, range] : wad->namespaces) {
+		StackNamespace& space = stack->namespaces[prefix];
+		for (uint32_t i = range.first; i < range.last; ++i) {
+			const Lump& lump = wad->lumps[i];
+			// Nested markers ( F1_START ) are just there for old tools
+			if (lump.size == 0) continue;
+
+			auto existing = space.lookup.find(lump.id);
+			if (existing != space.lookup.end()) {
+				space.lumps[existing->second] = { wadIndex, i };
+				continue;
+			}
+			space.lookup.insert({ lump.id, (uint32_t)space.lumps.size() });
+			space.lumps.push_back({ wadIndex, i });
+		}
+	}
+
+	for (auto& [map, range] : wad->mapBlocks) {
+		stack->mapBlocks[map] = { wadIndex, range };
+	}
+
+	stack->wads.push_back(std::move(wad));
+	stack->paths.push_back(path);
+	return true;
+}
+
+bool MountGameConfig(const GameConfig& config, const std::string& directory, WADStack* stack, std::string* error)
+{
+	if (config.iwad.empty()) {
+		*error = "Game config has no IWAD";
+		return false;
+	}
+
+	// The indices are copied so a WAD that fails to load part way through can be undone
+	size_t wadCount = stack->wads.size();
+	auto lumpIndex = stack->lumpIndex;
+	auto namespaces = stack->namespaces;
+	auto mapBlocks = stack->mapBlocks;
+	auto rollback = [&]() {
+		stack->wads.resize(wadCount);
+		stack->paths.resize(wadCount);
+		stack->lumpIndex = std::move(lumpIndex);
+		stack->namespaces = std::move(namespaces);
+		stack->mapBlocks = std::move(mapBlocks);
+		return false;
+	};
+
+	std::filesystem::path root(directory);
+	if (!MountWAD((root / config.iwad).string(), stack, error)) return rollback();
+	for (auto& pwad : config.pwads) {
+		if (!MountWAD((root / pwad).string(), stack, error)) return rollback();
+	}
+	return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+#include "WAD.h"
+
+// Lump somewhere in a stack, wad indexes WADStack::wads and lump indexes that WAD's lumps
+struct LumpRef {
+	uint32_t wad;
+	uint32_t lump;
+};
+
+// Every lump between X_START and X_END markers across the whole stack, in mount order
+// A lump with the same name as one already in the namespace takes its place, so animation
+// ranges ( NUKAGE1 - NUKAGE3 ) keep their order when a PWAD replaces part of them
+struct StackNamespace {
+	std::vector<LumpRef> lumps;
+	std::unordered_map<uint64_t, uint32_t> lookup;
+};
+
+// The IWAD and any PWADs mounted on top of it, resolved the way Boom does it:
+//  - Lumps are found by name, the last WAD mounted wins
+//  - Namespaces ( sprites, flats, patches ) are merged across every WAD instead of only
+//    the last WAD's markers counting, so a PWAD can replace a single flat
+//  - A map in a PWAD replaces the whole map, lumps are never mixed between WADs
+// Nothing is copied, lumps are views into each WAD's mapping
+struct WADStack {
+	// Pointers so lump views and WAD* handed out stay put as more WADs are mounted
+	std::vector<std::unique_ptr<WAD>> wads;
+	std::vector<std::string> paths;
+
+	std::unordered_map<uint64_t, LumpRef> lumpIndex;
+	std::unordered_map<uint64_t, StackNamespace> namespaces;
+	// Map marker name to the WAD the map comes from and its lumps in that WAD
+	std::unordered_map<uint64_t, std::pair<uint32_t, LumpRange>> mapBlocks;
+
+	const Lump& GetLump(LumpRef ref) const { return wads[ref.wad]->lumps[ref.lump]; }
+
+	// Null if no WAD has the lump
+	const Lump* FindLump(const std::string& name) const;
+	const Lump* FindLump(uint64_t id) const;
+	bool FindLump(uint64_t id, LumpRef* ref) const;
+	// Looks in a merged namespace ( "S", "F", "P" ), null if it's not there
+	const Lump* FindInNamespace(const std::string& prefix, const std::string& name) const;
+	const StackNamespace* GetNamespace(const std::string& prefix) const;
+
+	// The WAD holding the winning copy of a map, ready for LoadMap. Null if no WAD has it
+	WAD* GetMapWAD(const std::string& map) const;
+};
+
+// Loads a WAD and puts it on top of the stack, the first one mounted should be the IWAD
+bool MountWAD(const std::string& path, WADStack* stack, std::string* error);
+// Mounts the config's IWAD and then its PWADs in order, paths are relative to directory
+// If any of them fails to load the stack is left how it was before the call
+bool MountGameConfig(const GameConfig& config, const std::string& directory, WADStack* stack, std::string* error);
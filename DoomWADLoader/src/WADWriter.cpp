@@ -0,0 +1,192 @@
+#include "WADWriter.h"
+#include <filesystem>
+#include <string.h>
+
+static uint64_t HashPayload(const uint8_t* data, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= data[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+template<typename T>
+static void WriteValue(std::fstream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(T));
+}
+
+WADWriter::~WADWriter()
+{
+	if (m_File.is_open()) {
+		SOFT_ERROR("WAD writer destroyed before Finish, the file is incomplete ( " + m_Path + " )");
+	}
+}
+
+bool WADWriter::Open(const std::string& path, const std::string& signature, uint32_t alignment)
+{
+	if (signature.size() != 4) {
+		SOFT_ERROR("WAD signature has to be 4 characters ( " + signature + " )");
+		return false;
+	}
+	m_File.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	if (!m_File.is_open()) {
+		SOFT_ERROR("Failed to open WAD for writing ( " + path + " )");
+		return false;
+	}
+
+	m_Path = path;
+	m_Alignment = alignment ? alignment : 1;
+	m_Directory.clear();
+	m_Payloads.clear();
+	m_Stats = WADWriterStats();
+
+	// Count and directory pointer are filled in by Finish
+	m_File.write(signature.c_str(), 4);
+	WriteValue(m_File, (uint32_t)0);
+	WriteValue(m_File, (uint32_t)0);
+	m_Offset = HEADER_SIZE;
+	return (bool)m_File;
+}
+
+bool WADWriter::SamePayload(uint64_t offset, const uint8_t* data, uint32_t size)
+{
+	m_CompareBuffer.resize(size);
+	m_File.seekg(offset);
+	m_File.read(m_CompareBuffer.data(), size);
+	bool same = m_File && memcmp(m_CompareBuffer.data(), data, size) == 0;
+	m_File.clear();
+	m_File.seekp(m_Offset);
+	return same;
+}
+
+bool WADWriter::AddLump(const std::string& name, const uint8_t* data, uint32_t size)
+{
+	if (!m_File.is_open()) return false;
+
+	DirectoryEntry entry = { 0, size, { 0 } };
+	memcpy(entry.name, name.c_str(), name.size() < 8 ? name.size() : 8);
+	m_Stats.lumps++;
+
+	if (size == 0) {
+		m_Directory.push_back(entry);
+		return true;
+	}
+
+	uint64_t hash = HashPayload(data, size);
+	auto [first, last] = m_Payloads.equal_range(hash);
+	for (auto it = first; it != last; ++it) {
+		if (it->second.size != size || !SamePayload(it->second.offset, data, size)) continue;
+		entry.pointer = (uint32_t)it->second.offset;
+		m_Directory.push_back(entry);
+		m_Stats.bytesShared += size;
+		return true;
+	}
+
+	uint64_t padding = (m_Alignment - m_Offset % m_Alignment) % m_Alignment;
+	if (m_Offset + padding + size > UINT32_MAX) {
+		SOFT_ERROR("WAD is too big for 32 bit lump offsets ( " + m_Path + " )");
+		return false;
+	}
+	static const char zeros[64] = { 0 };
+	for (uint64_t left = padding; left > 0; ) {
+		uint64_t count = left < sizeof(zeros) ? left : sizeof(zeros);
+		m_File.write(zeros, count);
+		left -= count;
+	}
+	m_Offset += padding;
+	m_Stats.paddingBytes += padding;
+
+	m_File.write((const char*)data, size);
+	entry.pointer = (uint32_t)m_Offset;
+	m_Payloads.insert({ hash, { m_Offset, size } });
+	m_Directory.push_back(entry);
+	m_Offset += size;
+	m_Stats.uniquePayloads++;
+	return (bool)m_File;
+}
+
+bool WADWriter::Finish()
+{
+	if (!m_File.is_open()) return false;
+
+	// Directory entries are 16 bytes, keep them aligned too
+	uint64_t padding = (4 - m_Offset % 4) % 4;
+	for (uint64_t i = 0; i < padding; ++i) m_File.put(0);
+	m_Offset += padding;
+	m_Stats.paddingBytes += padding;
+
+	uint32_t directoryPointer = (uint32_t)m_Offset;
+	for (const DirectoryEntry& entry : m_Directory) {
+		WriteValue(m_File, entry.pointer);
+		WriteValue(m_File, entry.size);
+		m_File.write(entry.name, 8);
+	}
+	m_Offset += m_Directory.size() * LUMP_SIZE;
+
+	m_File.seekp(4);
+	WriteValue(m_File, (uint32_t)m_Directory.size());
+	WriteValue(m_File, directoryPointer);
+
+	bool good = (bool)m_File;
+	m_File.close();
+	m_Stats.bytesWritten = m_Offset;
+	if (!good) SOFT_ERROR("Failed to write WAD ( " + m_Path + " )");
+	return good;
+}
+
+bool RepackWAD(const std::string& inPath, const std::string& outPath, uint32_t alignment, WADWriterStats* stats, std::string* error)
+{
+	std::error_code sameError;
+	if (std::filesystem::equivalent(inPath, outPath, sameError)) {
+		*error = "Can't repack a WAD onto itself ( " + inPath + " )";
+		return false;
+	}
+
+	WAD wad;
+	if (!TryLoadWAD(inPath, &wad, error)) return false;
+
+	WADWriter writer;
+	if (!writer.Open(outPath, wad.signature, alignment)) {
+		*error = "Failed to open WAD for writing ( " + outPath + " )";
+		return false;
+	}
+	for (const Lump& lump : wad.lumps) {
+		if (!writer.AddLump(lump.name, lump.data, lump.size)) {
+			*error = "Failed to write lump ( " + lump.name + " )";
+			writer.Finish();
+			return false;
+		}
+	}
+	if (!writer.Finish()) {
+		*error = "Failed to write WAD ( " + outPath + " )";
+		return false;
+	}
+	if (stats) *stats = writer.GetStats();
+	return true;
+}
+
+bool CompareWADs(const WAD* a, const WAD* b, std::string* difference)
+{
+	if (a->signature != b->signature) {
+		*difference = "Signatures differ ( " + a->signature + " / " + b->signature + " )";
+		return false;
+	}
+	if (a->lumps.size() != b->lumps.size()) {
+		*difference = "Lump counts differ ( " + std::to_string(a->lumps.size()) + " / " + std::to_string(b->lumps.size()) + " )";
+		return false;
+	}
+	for (size_t i = 0; i < a->lumps.size(); ++i) {
+		const Lump& lumpA = a->lumps[i];
+		const Lump& lumpB = b->lumps[i];
+		if (lumpA.name != lumpB.name || lumpA.size != lumpB.size ||
+			(lumpA.size && memcmp(lumpA.data, lumpB.data, lumpA.size) != 0)) {
+			*difference = "Lump " + std::to_string(i) + " differs ( " + lumpA.name + " )";
+			return false;
+		}
+	}
+	return true;
+}
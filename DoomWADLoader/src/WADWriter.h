@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <stdint.h>
+#include "WAD.h"
+
+struct WADWriterStats {
+	size_t lumps = 0;
+	// Payloads actually written, lumps with the same bytes share one
+	size_t uniquePayloads = 0;
+	uint64_t bytesWritten = 0;
+	// Bytes that didn't have to be written because an identical payload already was
+	uint64_t bytesShared = 0;
+	uint64_t paddingBytes = 0;
+};
+
+// Writes a WAD front to back: header, lump data as it's added, then the directory once at the end
+// Lumps with the same contents are only written once and share an offset in the directory.
+// Payloads are matched by hash and size and then compared with what's already on disk, so
+// the caller's data only has to live until AddLump returns
+class WADWriter {
+public:
+	WADWriter() { }
+	~WADWriter();
+
+	WADWriter(const WADWriter&) = delete;
+	WADWriter& operator=(const WADWriter&) = delete;
+
+	// alignment pads each payload to start on a multiple of it, 1 for no padding
+	bool Open(const std::string& path, const std::string& signature = "PWAD", uint32_t alignment = 4);
+	// name is written as is, up to 8 characters
+	bool AddLump(const std::string& name, const uint8_t* data, uint32_t size);
+	bool AddMarker(const std::string& name) { return AddLump(name, nullptr, 0); }
+	// Writes the directory and fixes up the header, nothing can be added after this
+	bool Finish();
+
+	const WADWriterStats& GetStats() const { return m_Stats; }
+
+private:
+	bool SamePayload(uint64_t offset, const uint8_t* data, uint32_t size);
+
+	struct DirectoryEntry {
+		uint32_t pointer;
+		uint32_t size;
+		char name[8];
+	};
+	struct Payload {
+		uint64_t offset;
+		uint32_t size;
+	};
+
+private:
+	std::fstream m_File;
+	std::string m_Path;
+	uint32_t m_Alignment = 4;
+	uint64_t m_Offset = 0;
+	std::vector<DirectoryEntry> m_Directory;
+	// Payload hash to everything written with that hash
+	std::unordered_multimap<uint64_t, Payload> m_Payloads;
+	std::vector<char> m_CompareBuffer;
+	WADWriterStats m_Stats;
+};
+
+// Rewrites a WAD with aligned, deduplicated lumps. Names, order and contents stay the same
+bool RepackWAD(const std::string& inPath, const std::string& outPath, uint32_t alignment, WADWriterStats* stats, std::string* error);
+// Checks two WADs have the same signature and the same lumps in the same order, difference describes the first mismatch
+bool CompareWADs(const WAD* a, const WAD* b, std::string* difference);
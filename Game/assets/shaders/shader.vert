@@ -1,18 +1,27 @@
 #version 460 core
+// Unit quad
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in vec2 aTexID;
-layout (location = 3) in vec4 aTint;
+// One sprite per instance
+layout (location = 2) in vec2 aPosition;
+layout (location = 3) in vec2 aScale;
+layout (location = 4) in float aRotation;
+layout (location = 5) in vec4 aUV;
+layout (location = 6) in vec4 aTint;
 
 uniform mat4 ViewProjection;
 
 out vec2 TexCoord;
-out vec2 TexID;
 out vec4 Tint;
 
 void main() {
-	TexCoord = aTexCoord;
-	TexID = aTexID;
+	vec2 corner = aPos * 0.5f * aScale;
+	float s = sin(aRotation);
+	float c = cos(aRotation);
+	corner = vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+
+	// aUV is the corner and size of the sprite's part of the texture
+	TexCoord = aUV.xy + aTexCoord * aUV.zw;
 	Tint = aTint;
-	gl_Position = ViewProjection * vec4(aPos.x, aPos.y, -1, 1.0);
-}
\ No newline at end of file
+	gl_Position = ViewProjection * vec4(aPosition + corner, -1, 1.0);
+}
@@ -1,4 +1,3 @@
-#include "..\..\..\VoxelGame\src\Core\Application.h"
 #include "Application.h"
 #include <iostream>
 #include "Renderer/Renderer.h"
@@ -72,13 +71,10 @@ void Application::OnResize(WindowResizeEvent& e)
 	Renderer::OnResize(e.GetWidth(), e.GetHeight());
 }
 
-void Application::EventCallback(Event::Event& e)
-{
-}
-
 void Application::Run()
 {
 	m_LastFrameTime = System::GetTime();
+	m_TickAccumulator = 0.0f;
 
 	m_Game->StartUp();
 
@@ -91,11 +87,20 @@ void Application::Run()
 		m_DiagnosticInfo.fps = 1 / deltaTime;
 
 		time = System::GetTime();
-		m_Game->Update(deltaTime);
+		m_TickAccumulator += deltaTime;
+		if (m_TickAccumulator > SIMULATION_TICK * SIMULATION_MAX_TICKS) m_TickAccumulator = SIMULATION_TICK * SIMULATION_MAX_TICKS;
+		m_DiagnosticInfo.tickCount = 0;
+		while (m_TickAccumulator >= SIMULATION_TICK) {
+			m_Game->Update(SIMULATION_TICK);
+			m_TickAccumulator -= SIMULATION_TICK;
+			m_DiagnosticInfo.tickCount += 1;
+		}
 		m_DiagnosticInfo.updateMS = (System::GetTime() - time) * 1000.0f;
 
+		// What's left over is how far into the next tick this frame is
 		time = System::GetTime();
-		m_Game->Render();
+		m_DiagnosticInfo.tickAlpha = m_TickAccumulator / SIMULATION_TICK;
+		m_Game->Render(m_DiagnosticInfo.tickAlpha);
 		m_DiagnosticInfo.renderMS = (System::GetTime() - time) * 1000.0f;
 
 		time = System::GetTime();
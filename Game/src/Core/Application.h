@@ -4,6 +4,11 @@
 #include "Core/Event/WindowEvent.h"
 #include "Game/Game.h"
 
+// The game is updated in steps of this many seconds however long frames take
+#define SIMULATION_TICK (1.0f / 60.0f)
+// Most ticks run in one frame, after a long stall the game slows down instead of trying to catch up
+#define SIMULATION_MAX_TICKS 8
+
 struct DiagnosticInfo
 {
 	float fps;
@@ -11,6 +16,8 @@ struct DiagnosticInfo
 	float updateMS;
 	float renderMS;
 	float imguiMS;
+	int tickCount;
+	float tickAlpha;
 };
 
 class Application
@@ -36,6 +43,8 @@ private:
 	Window* m_Window;
 	bool m_IsRunning;
 	float m_LastFrameTime;
+	// Time that hasn't been simulated yet, always less than a tick after the ticks for a frame have run
+	float m_TickAccumulator;
 
 	Game* m_Game;
 
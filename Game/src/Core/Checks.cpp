@@ -0,0 +1,464 @@
+#include "Checks.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+// The implementation is in Texture.cpp, premake defines STB_IMAGE_IMPLEMENTATION for the whole project
+#undef STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+#include "Core/Random.h"
+#include "Renderer/SpriteTransform.h"
+#include "Game/EnemyAI.h"
+#include "Game/SpatialHash.h"
+#include "Game/Game.h"
+#include "Game/Partical.h"
+#include "Renderer/AtlasPacker.h"
+#include "Renderer/SpriteBatch.h"
+#include "Renderer/RenderQueue.h"
+
+namespace {
+	int s_Failed;
+
+	void Check(bool passed, const std::string& name) {
+		std::cout << (passed ? "pass " : "FAIL ") << name << std::endl;
+		if (!passed) s_Failed += 1;
+	}
+
+	// [-1, 1)
+	float NextSigned(Random& random) {
+		return random.NextFloat() * 2.0f - 1.0f;
+	}
+
+	// The kernels only differ from the reference by how they get sin and cos, so corners can be off by a few ulp of the position
+	bool Close(float a, float b) {
+		return std::fabs(a - b) <= 1e-4f * (1.0f + std::fabs(b));
+	}
+
+	// Corners and Bounds against the std::sin / std::cos reference. Counts that aren't a multiple of the SIMD
+	// width go through the tail, and every tenth sprite is turned thousands of radians to test range reduction
+	void CheckSpriteTransform() {
+		Random random(45);
+		for (uint32_t count : { 1u, 3u, 7u, 8u, 9u, 15u, 17u, 1001u }) {
+			std::vector<float> positionX(count), positionY(count), scaleX(count), scaleY(count), rotation(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				positionX[i] = NextSigned(random) * 100.0f;
+				positionY[i] = NextSigned(random) * 100.0f;
+				scaleX[i] = 0.1f + random.NextFloat() * 4.0f;
+				scaleY[i] = 0.1f + random.NextFloat() * 4.0f;
+				rotation[i] = NextSigned(random) * (i % 10 == 0 ? 3000.0f : 7.0f);
+			}
+			SpriteTransforms sprites = { positionX.data(), positionY.data(), scaleX.data(), scaleY.data(), rotation.data() };
+
+			std::vector<glm::vec2> corners(count * 4), expectedCorners(count * 4);
+			SpriteTransform::Corners(sprites, count, corners.data());
+			SpriteTransform::CornersScalar(sprites, count, expectedCorners.data());
+			bool cornersMatch = true;
+			for (uint32_t i = 0; i < count * 4; ++i) {
+				if (!Close(corners[i].x, expectedCorners[i].x) || !Close(corners[i].y, expectedCorners[i].y)) cornersMatch = false;
+			}
+
+			std::vector<float> minX(count), minY(count), maxX(count), maxY(count);
+			std::vector<float> expectedMinX(count), expectedMinY(count), expectedMaxX(count), expectedMaxY(count);
+			SpriteTransform::Bounds(sprites, count, minX.data(), minY.data(), maxX.data(), maxY.data());
+			SpriteTransform::BoundsScalar(sprites, count, expectedMinX.data(), expectedMinY.data(), expectedMaxX.data(), expectedMaxY.data());
+			bool boundsMatch = true;
+			for (uint32_t i = 0; i < count; ++i) {
+				if (!Close(minX[i], expectedMinX[i]) || !Close(minY[i], expectedMinY[i]) ||
+					!Close(maxX[i], expectedMaxX[i]) || !Close(maxY[i], expectedMaxY[i])) boundsMatch = false;
+			}
+
+			std::string suffix = std::string(" ( ") + SpriteTransform::GetKernelName() + ", " + std::to_string(count) + " sprites )";
+			Check(cornersMatch, "SpriteTransform::Corners matches CornersScalar" + suffix);
+			Check(boundsMatch, "SpriteTransform::Bounds matches BoundsScalar" + suffix);
+		}
+	}
+	// Everything EnemyAI::Update reads and writes, so two copies can be run side by side
+	struct EnemyArrays {
+		std::vector<float> PositionX, PositionY, DirectionX, DirectionY, Rotation, Time, TintTime, Speed, TurnSpeed, FireTime;
+		std::vector<uint32_t> Random;
+		std::vector<uint8_t> Shoot;
+
+		EnemyAIState GetState() {
+			return {
+				PositionX.data(), PositionY.data(), DirectionX.data(), DirectionY.data(), Rotation.data(),
+				Time.data(), TintTime.data(), Speed.data(), TurnSpeed.data(), FireTime.data(), Random.data()
+			};
+		}
+	};
+
+	EnemyArrays MakeEnemies(uint32_t count, uint32_t seed) {
+		Random random(seed);
+		EnemyArrays enemies;
+		for (uint32_t i = 0; i < count; ++i) {
+			float angle = random.NextFloat() * 6.2831853f;
+			// Some start on the target and some facing straight away from it, the two special cases in the kernel
+			float x = i % 7 == 0 ? 0.0f : NextSigned(random) * 5.0f;
+			float y = i % 7 == 0 ? 0.0f : NextSigned(random) * 5.0f;
+			float length = std::sqrt(x * x + y * y);
+			enemies.PositionX.push_back(x);
+			enemies.PositionY.push_back(y);
+			enemies.DirectionX.push_back(i % 5 == 0 && length > 0.0f ? x / length : std::cos(angle));
+			enemies.DirectionY.push_back(i % 5 == 0 && length > 0.0f ? y / length : std::sin(angle));
+			enemies.Rotation.push_back(0.0f);
+			enemies.Time.push_back(random.NextFloat() * 2.0f);
+			enemies.TintTime.push_back(random.NextFloat());
+			enemies.Speed.push_back(1.0f + random.Next(50) / 25.0f);
+			enemies.TurnSpeed.push_back(2.0f + random.Next(50) / 50.0f);
+			enemies.FireTime.push_back(0.5f + random.Next(6) / 2.0f);
+			enemies.Random.push_back(EnemyAI::SeedRandom(random.Next()));
+			enemies.Shoot.push_back(0);
+		}
+		return enemies;
+	}
+
+	// Update against UpdateScalar over seeded runs. Everything but rotation has to match exactly since
+	// replays depend on it, rotation is only drawn so it gets the SSE atan2's error
+	void CheckEnemyAI() {
+		const float tick = 1.0f / 60.0f;
+		const float fireRange = 1.5f;
+		for (uint32_t seed = 1; seed <= 4; ++seed) {
+			uint32_t count = 64 * seed + seed;
+			EnemyArrays kernel = MakeEnemies(count, seed);
+			EnemyArrays reference = kernel;
+			EnemyAIState kernelState = kernel.GetState();
+			EnemyAIState referenceState = reference.GetState();
+
+			bool stateMatches = true;
+			bool rotationMatches = true;
+			for (uint32_t step = 0; step < 600 && stateMatches; ++step) {
+				// Circles the origin so enemies keep turning, and now and then lands right on some of them
+				glm::vec2 target = step % 100 == 0 ? glm::vec2(0.0f, 0.0f) : glm::vec2(std::cos(step * 0.02f) * 3.0f, std::sin(step * 0.03f) * 3.0f);
+				EnemyAI::Update(kernelState, count, tick, target, fireRange, kernel.Shoot.data());
+				EnemyAI::UpdateScalar(referenceState, count, tick, target, fireRange, reference.Shoot.data());
+
+				stateMatches = kernel.PositionX == reference.PositionX && kernel.PositionY == reference.PositionY &&
+					kernel.DirectionX == reference.DirectionX && kernel.DirectionY == reference.DirectionY &&
+					kernel.Time == reference.Time && kernel.TintTime == reference.TintTime &&
+					kernel.Random == reference.Random && kernel.Shoot == reference.Shoot;
+				for (uint32_t i = 0; i < count; ++i) {
+					if (std::fabs(kernel.Rotation[i] - reference.Rotation[i]) > 1e-5f) rotationMatches = false;
+				}
+			}
+
+			std::string suffix = std::string(" ( ") + EnemyAI::GetKernelName() + ", seed " + std::to_string(seed) + ", " + std::to_string(count) + " enemies )";
+			Check(stateMatches, "EnemyAI::Update matches UpdateScalar" + suffix);
+			Check(rotationMatches, "EnemyAI::Update rotation is within 1e-5 of std::atan2" + suffix);
+		}
+	}
+	uint32_t BruteForceFirst(const std::vector<glm::vec2>& points, const glm::vec2& position, float radius) {
+		for (uint32_t i = 0; i < points.size(); ++i) {
+			glm::vec2 offset = points[i] - position;
+			if (offset.x * offset.x + offset.y * offset.y <= radius * radius) return i;
+		}
+		return SPATIAL_HASH_NONE;
+	}
+
+	// QueryFirst against checking every point. One hash is rebuilt for every case, so going from many
+	// points to few also checks that nothing is left over from the last build
+	void CheckSpatialHash() {
+		Random random(49);
+		SpatialHash hash(0.5f);
+		struct Case { uint32_t count; float spread; float radius; };
+		// Clustered points share cells and slots, radii around the cell size cover one cell up to many
+		const Case cases[] = {
+			{ 0, 10.0f, 0.5f }, { 1, 1.0f, 0.5f }, { 200, 10.0f, 0.1f }, { 5000, 20.0f, 0.5f },
+			{ 5000, 2.0f, 0.25f }, { 3, 100.0f, 2.0f }, { 1000, 10.0f, 1.7f }
+		};
+		for (const Case& test : cases) {
+			std::vector<glm::vec2> points;
+			for (uint32_t i = 0; i < test.count; ++i) {
+				// Every fourth point sits right on a cell corner, and some repeat an earlier point
+				if (i % 4 == 0) points.push_back({ (float)((int32_t)random.Next(40) - 20) * 0.5f, (float)((int32_t)random.Next(40) - 20) * 0.5f });
+				else if (i % 9 == 0) points.push_back(points[random.Next(i)]);
+				else points.push_back({ NextSigned(random) * test.spread, NextSigned(random) * test.spread });
+			}
+			hash.Build(points.data(), test.count);
+
+			std::vector<glm::vec2> queries;
+			for (uint32_t i = 0; i < 2000; ++i) {
+				if (test.count > 0 && i % 3 == 0) queries.push_back(points[random.Next(test.count)] + glm::vec2(NextSigned(random) * test.radius, 0.0f));
+				else queries.push_back({ NextSigned(random) * test.spread, NextSigned(random) * test.spread });
+			}
+			std::vector<uint32_t> results(queries.size());
+			hash.QueryFirst(queries.data(), (uint32_t)queries.size(), test.radius, results.data());
+
+			bool matches = true;
+			for (uint32_t i = 0; i < queries.size(); ++i) {
+				if (results[i] != BruteForceFirst(points, queries[i], test.radius)) matches = false;
+			}
+			char name[128];
+			snprintf(name, sizeof(name), "SpatialHash::QueryFirst matches brute force ( %u points, radius %g )", test.count, test.radius);
+			Check(matches, name);
+		}
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Every packed rectangle has to be on its page with the padding around it, and no two padded
+	// rectangles on a page can overlap. Sets bigger than a page have to spill onto more pages
+	void CheckAtlasPacker() {
+		Random random(44);
+		struct Case { uint32_t count; uint32_t maxSize; uint32_t pageSize; uint32_t padding; };
+		const Case cases[] = {
+			{ 50, 32, 1024, 2 }, { 300, 64, 256, 1 }, { 500, 16, 128, 0 }, { 1, 254, 256, 1 }, { 40, 200, 512, 3 }
+		};
+		for (const Case& test : cases) {
+			std::vector<AtlasRect> rects(test.count);
+			uint64_t area = 0;
+			for (AtlasRect& rect : rects) {
+				rect = { 1 + random.Next(test.maxSize), 1 + random.Next(test.maxSize), 0, 0, 0 };
+				if (test.count == 1) rect.Width = rect.Height = test.maxSize;
+				area += (uint64_t)(rect.Width + test.padding * 2) * (rect.Height + test.padding * 2);
+			}
+			AtlasPacker packer(test.pageSize, test.pageSize, test.padding);
+			bool packed = packer.Pack(rects);
+
+			bool inside = true;
+			bool separate = true;
+			uint32_t padding = test.padding;
+			for (size_t i = 0; i < rects.size(); ++i) {
+				const AtlasRect& a = rects[i];
+				if (a.Page >= packer.GetPageCount() || a.X < padding || a.Y < padding ||
+					a.X + a.Width + padding > test.pageSize || a.Y + a.Height + padding > test.pageSize) inside = false;
+				for (size_t j = i + 1; j < rects.size(); ++j) {
+					const AtlasRect& b = rects[j];
+					if (a.Page != b.Page) continue;
+					bool apart = a.X + a.Width + padding * 2 <= b.X || b.X + b.Width + padding * 2 <= a.X ||
+						a.Y + a.Height + padding * 2 <= b.Y || b.Y + b.Height + padding * 2 <= a.Y;
+					if (!apart) separate = false;
+				}
+			}
+			uint64_t pageArea = (uint64_t)test.pageSize * test.pageSize;
+			bool pages = area <= pageArea || packer.GetPageCount() > 1;
+
+			char suffix[96];
+			snprintf(suffix, sizeof(suffix), " ( %u rects up to %u on %ux%u pages, padding %u )", test.count, test.maxSize, test.pageSize, test.pageSize, test.padding);
+			Check(packed && inside, std::string("AtlasPacker places every rect inside its page and padding") + suffix);
+			Check(separate, std::string("AtlasPacker keeps padded rects apart") + suffix);
+			Check(pages && packer.GetOccupancy() <= 1.0f, std::string("AtlasPacker starts new pages when one is full ( ") + std::to_string(packer.GetPageCount()) + " pages )" + suffix);
+		}
+
+		std::vector<AtlasRect> tooBig = { { 16, 16, 0, 0, 0 }, { 256, 8, 0, 0, 0 } };
+		AtlasPacker packer(256, 256, 1);
+		bool packed = packer.Pack(tooBig);
+		Check(!packed && tooBig[0].Page == 0 && tooBig[1].Page == UINT32_MAX, "AtlasPacker leaves a rect that can't fit on an empty page unpacked");
+	}
+
+	// Packs the game's own textures by size the way StartUp does, one draw call per texture becomes one per page
+	void TimeAtlasPack() {
+		// TextureAtlas's default page size and padding
+		const uint32_t pageSize = 2048, padding = 1;
+		const std::vector<Game::AtlasImage>& images = Game::GetAtlasImages();
+		std::vector<AtlasRect> rects;
+		for (const Game::AtlasImage& image : images) {
+			int width, height, channels;
+			if (!stbi_info(image.Path.c_str(), &width, &height, &channels)) {
+				std::cout << "time atlas pack skipped, can't read ( " << image.Path << " ), run from the Game directory" << std::endl;
+				return;
+			}
+			rects.push_back({ (uint32_t)width, (uint32_t)height, 0, 0, 0 });
+		}
+		auto start = std::chrono::steady_clock::now();
+		AtlasPacker packer(pageSize, pageSize, padding);
+		packer.Pack(rects);
+		double packMS = MillisecondsSince(start);
+		uint32_t unpacked = 0;
+		for (const AtlasRect& rect : rects) if (rect.Page == UINT32_MAX) unpacked += 1;
+
+		// A few thousand sprite sized images, to see how packing grows
+		Random random(440);
+		std::vector<AtlasRect> many(5000);
+		for (AtlasRect& rect : many) rect = { 4 + random.Next(60), 4 + random.Next(60), 0, 0, 0 };
+		start = std::chrono::steady_clock::now();
+		AtlasPacker manyPacker(pageSize, pageSize, padding);
+		manyPacker.Pack(many);
+		double manyMS = MillisecondsSince(start);
+
+		printf("time atlas pack: %u game textures on %u pages ( %.0f%% full ) in %.3f ms, a frame using all of them goes from %u to %u draw calls\n",
+			(uint32_t)rects.size(), packer.GetPageCount(), packer.GetOccupancy() * 100.0f, packMS, (uint32_t)rects.size(), packer.GetPageCount() + unpacked);
+		printf("time atlas pack: %u generated images on %u pages ( %.0f%% full ) in %.3f ms\n",
+			(uint32_t)many.size(), manyPacker.GetPageCount(), manyPacker.GetOccupancy() * 100.0f, manyMS);
+	}
+
+	// 100k sprites a frame through SpriteBatch::Add, the way the renderer fills a frame's instances
+	void TimeSpriteBatch() {
+		const uint32_t count = 100000, frames = 20;
+		Random random(41);
+		std::vector<glm::vec2> positions(count), scales(count);
+		std::vector<float> rotations(count);
+		std::vector<glm::vec4> tints(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			positions[i] = { NextSigned(random) * 50.0f, NextSigned(random) * 50.0f };
+			scales[i] = { 0.1f + random.NextFloat(), 0.1f + random.NextFloat() };
+			rotations[i] = NextSigned(random) * 3.1415927f;
+			tints[i] = { random.NextFloat(), random.NextFloat(), random.NextFloat(), 1.0f };
+		}
+
+		SpriteBatch batch;
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			batch.Clear();
+			for (uint32_t i = 0; i < count; ++i) batch.Add(positions[i], scales[i], rotations[i], { 0.25f, 0.5f }, { 0.125f, 0.25f }, tints[i]);
+		}
+		double frameMS = MillisecondsSince(start) / frames;
+
+		// Before instancing every quad was four vertices of position, uv, texture id and tint
+		const uint32_t vertexPathBytes = 4 * (2 + 2 + 2 + 4) * sizeof(float);
+		printf("time sprite batch: %u quads in %.3f ms a frame ( %.1f M quads/sec ), %u bytes per quad ( %u before instancing ), %.1f MB a frame\n",
+			count, frameMS, count / frameMS / 1000.0, (uint32_t)sizeof(SpriteInstance), vertexPathBytes, batch.GetSizeInBytes() / (1024.0 * 1024.0));
+	}
+
+	// Submit and Sort for a frame of 100k sprites spread over more and more textures. Two cameras
+	// like the game and menu, and a tenth of the sprites transparent so they keep their order
+	void TimeRenderQueue() {
+		const uint32_t count = 100000, frames = 20;
+		for (uint32_t textures : { 1u, 16u, 256u }) {
+			Random random(42);
+			std::vector<uint32_t> texture(count), camera(count);
+			std::vector<uint8_t> transparent(count);
+			std::vector<glm::vec2> positions(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				texture[i] = random.Next(textures);
+				camera[i] = random.Next(8) == 0 ? 1 : 0;
+				transparent[i] = random.Next(10) == 0;
+				positions[i] = { NextSigned(random) * 50.0f, NextSigned(random) * 50.0f };
+			}
+
+			RenderQueue queue;
+			double submitMS = 0.0, sortMS = 0.0;
+			for (uint32_t frame = 0; frame < frames; ++frame) {
+				queue.Clear();
+				auto start = std::chrono::steady_clock::now();
+				for (uint32_t i = 0; i < count; ++i) {
+					queue.Submit(camera[i], transparent[i], texture[i], positions[i], { 0.5f, 0.5f }, 0.0f, { 0.0f, 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+				}
+				submitMS += MillisecondsSince(start);
+				start = std::chrono::steady_clock::now();
+				queue.Sort();
+				sortMS += MillisecondsSince(start);
+			}
+			submitMS /= frames;
+			sortMS /= frames;
+			uint32_t opaqueRuns = 0;
+			for (const RenderRun& run : queue.GetRuns()) if (!run.Transparent) opaqueRuns += 1;
+			printf("time render queue: %u sprites, %u textures, submit %.3f ms, sort %.3f ms ( %.1f M sprites/sec ), %u opaque runs, %u transparent runs\n",
+				count, textures, submitMS, sortMS, count / (submitMS + sortMS) / 1000.0, opaqueRuns, (uint32_t)queue.GetRuns().size() - opaqueRuns);
+		}
+	}
+
+	// What the renderer did per quad before the kernels, a model matrix and four mat4 * vec4
+	void CornersMatrix(const SpriteTransforms& sprites, uint32_t count, glm::vec2* corners) {
+		const glm::vec4 quad[4] = { { 1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, -1.0f, 0.0f, 1.0f }, { -1.0f, -1.0f, 0.0f, 1.0f }, { -1.0f, 1.0f, 0.0f, 1.0f } };
+		for (uint32_t i = 0; i < count; ++i) {
+			glm::mat4 model(1.0f);
+			model = glm::translate(model, { sprites.PositionX[i], sprites.PositionY[i], -1.0f });
+			model = glm::rotate(model, sprites.Rotation[i], { 0, 0, 1 });
+			model = glm::scale(model, { sprites.ScaleX[i], sprites.ScaleY[i], 1 });
+			for (uint32_t corner = 0; corner < 4; ++corner) corners[i * 4 + corner] = glm::vec2(model * quad[corner]);
+		}
+	}
+
+	// Corners through the SIMD kernel, the scalar reference and the old matrix path from 10k to 1M sprites
+	void TimeSpriteTransform() {
+		const uint32_t maxCount = 1000000;
+		Random random(45);
+		std::vector<float> positionX(maxCount), positionY(maxCount), scaleX(maxCount), scaleY(maxCount), rotation(maxCount);
+		for (uint32_t i = 0; i < maxCount; ++i) {
+			positionX[i] = NextSigned(random) * 100.0f;
+			positionY[i] = NextSigned(random) * 100.0f;
+			scaleX[i] = 0.1f + random.NextFloat();
+			scaleY[i] = 0.1f + random.NextFloat();
+			rotation[i] = NextSigned(random) * 7.0f;
+		}
+		SpriteTransforms sprites = { positionX.data(), positionY.data(), scaleX.data(), scaleY.data(), rotation.data() };
+		std::vector<glm::vec2> corners((size_t)maxCount * 4);
+
+		for (uint32_t count : { 10000u, 100000u, 1000000u }) {
+			// Same number of sprites in total for every size
+			uint32_t passes = 3000000 / count;
+			auto rate = [&](void (*corner)(const SpriteTransforms&, uint32_t, glm::vec2*)) {
+				auto start = std::chrono::steady_clock::now();
+				for (uint32_t pass = 0; pass < passes; ++pass) corner(sprites, count, corners.data());
+				return (double)count * passes / MillisecondsSince(start) / 1000.0;
+			};
+			double matrix = rate(CornersMatrix);
+			double scalar = rate(SpriteTransform::CornersScalar);
+			double kernel = rate(SpriteTransform::Corners);
+			printf("time sprite transform: %u quads, %s %.1f M quads/sec, scalar %.1f M quads/sec, mat4 %.1f M quads/sec\n",
+				count, SpriteTransform::GetKernelName(), kernel, scalar, matrix);
+		}
+	}
+
+	// Enemies a second through both paths, each gets its own copy of the same enemies
+	void TimeEnemyAI() {
+		const uint32_t count = 100000, ticks = 100;
+		const float tick = 1.0f / 60.0f;
+		EnemyArrays kernel = MakeEnemies(count, 49);
+		EnemyArrays reference = kernel;
+		EnemyAIState kernelState = kernel.GetState();
+		EnemyAIState referenceState = reference.GetState();
+
+		auto rate = [&](void (*update)(const EnemyAIState&, uint32_t, float, const glm::vec2&, float, uint8_t*), EnemyAIState& state, EnemyArrays& enemies) {
+			auto start = std::chrono::steady_clock::now();
+			for (uint32_t step = 0; step < ticks; ++step) {
+				glm::vec2 target = { std::cos(step * 0.02f) * 3.0f, std::sin(step * 0.03f) * 3.0f };
+				update(state, count, tick, target, 1.5f, enemies.Shoot.data());
+			}
+			return (double)count * ticks / MillisecondsSince(start) / 1000.0;
+		};
+		double kernelRate = rate(EnemyAI::Update, kernelState, kernel);
+		double scalarRate = rate(EnemyAI::UpdateScalar, referenceState, reference);
+		printf("time enemy ai: %u enemies, %s %.1f M enemies/sec, scalar %.1f M enemies/sec\n", count, EnemyAI::GetKernelName(), kernelRate, scalarRate);
+	}
+
+	// A million pieces of debris updated and batched every frame, far past MAX_DEBRIS_PARTICALS to see how it scales
+	void TimeDebrisPool() {
+		const uint32_t count = 1000000, frames = 20;
+		const float tick = 1.0f / 60.0f;
+		Random random(46);
+		DebrisPool debris(count, nullptr);
+		for (uint32_t i = 0; i < count; ++i) {
+			float angle = random.NextFloat() * 6.2831853f;
+			glm::vec2 texID = { (float)random.Next(3), (float)random.Next(4) };
+			debris.Spawn({ NextSigned(random) * 50.0f, NextSigned(random) * 50.0f }, { std::cos(angle), std::sin(angle) }, texID);
+		}
+
+		SpriteBatch batch;
+		double updateMS = 0.0, submitMS = 0.0;
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			auto start = std::chrono::steady_clock::now();
+			debris.OnUpdate(tick);
+			updateMS += MillisecondsSince(start);
+			start = std::chrono::steady_clock::now();
+			batch.Clear();
+			debris.Render(batch);
+			submitMS += MillisecondsSince(start);
+		}
+		updateMS /= frames;
+		submitMS /= frames;
+		printf("time debris pool: %u particles, update %.3f ms, batch %.3f ms a frame ( %.1f M particles/sec )\n",
+			debris.GetCount(), updateMS, submitMS, debris.GetCount() / (updateMS + submitMS) / 1000.0);
+	}
+}
+
+int RunChecks() {
+	s_Failed = 0;
+	CheckSpriteTransform();
+	CheckEnemyAI();
+	CheckSpatialHash();
+	CheckAtlasPacker();
+	TimeAtlasPack();
+	TimeSpriteBatch();
+	TimeRenderQueue();
+	TimeSpriteTransform();
+	TimeDebrisPool();
+	TimeEnemyAI();
+	Game::TimeSimulation();
+	std::cout << (s_Failed ? std::to_string(s_Failed) + " checks failed" : "All checks passed") << std::endl;
+	return s_Failed;
+}
@@ -1,6 +1,17 @@
 #include "Application.h"
+#include "Checks.h"
+#include <string>
+
+int main(int argc, char** argv) {
+	// --check runs the headless self checks without opening a window
+	if (argc >= 2 && std::string(argv[1]) == "--check") {
+		return RunChecks();
+	}
+	// --replay <file> plays a recorded game as fast as possible without a window
+	if (argc >= 3 && std::string(argv[1]) == "--replay") {
+		return Game::Replay(argv[2]);
+	}
 
-int main() {
 	Application* app = new Application();
 	app->Run();
 	delete(app);
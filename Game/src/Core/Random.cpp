@@ -0,0 +1,20 @@
+#include "Random.h"
+
+Random::Random(uint64_t seed, uint64_t stream)
+{
+	// The increment has to be odd
+	m_State = 0;
+	m_Increment = (stream << 1) | 1;
+	Next();
+	m_State += seed;
+	Next();
+}
+
+uint32_t Random::Next()
+{
+	uint64_t state = m_State;
+	m_State = state * 6364136223846793005ull + m_Increment;
+	uint32_t shifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+	uint32_t rotation = (uint32_t)(state >> 59);
+	return (shifted >> rotation) | (shifted << ((0u - rotation) & 31));
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+
+// PCG32 random number generator. The same seed and stream always give the same numbers, different
+// streams with the same seed don't overlap, so every system can have its own stream from one game seed
+class Random {
+public:
+	Random(uint64_t seed = 0, uint64_t stream = 0);
+
+	uint32_t Next();
+	// [0, bound)
+	uint32_t Next(uint32_t bound) { return Next() % bound; }
+	// [0, 1)
+	float NextFloat() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+	uint64_t m_State;
+	uint64_t m_Increment;
+};
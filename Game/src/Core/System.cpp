@@ -1,6 +1,11 @@
 #include "System.h"
-#include <GLFW/glfw3.h>
+#include <chrono>
+
+namespace {
+	const auto s_StartTime = std::chrono::steady_clock::now();
+}
 
 float System::GetTime() {
-	return glfwGetTime();
-}
\ No newline at end of file
+	// Doesn't need GLFW, so timing works without a window
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - s_StartTime).count();
+}
@@ -1,14 +1,10 @@
 #include "Background.h"
 #include "Renderer/Renderer.h"
 
-Background::Background(const std::string& texture, float paralaxStrength, Camera* camera) {
+Background::Background(Texture* texture, float paralaxStrength, Camera* camera) {
 	m_Camera = camera;
 	m_ParalaxStrength = paralaxStrength;
-
-	TextureConfig config;
-	config.MinFilter = TexFilterMode::Nearest;
-	config.MagFilter = TexFilterMode::Nearest;
-	m_Texture = new Texture(texture, config);
+	m_Texture = texture;
 
 	m_TileSize = 10;
 }
@@ -6,7 +6,7 @@
 
 class Background {
 public:
-	Background(const std::string& texture, float paralaxStrength, Camera* camera);
+	Background(Texture* texture, float paralaxStrength, Camera* camera);
 
 	void Render(const glm::vec2& position);
 
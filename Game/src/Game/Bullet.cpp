@@ -1,27 +1,93 @@
 #include "Bullet.h"
+#include <cmath>
 #include "Renderer/Renderer.h"
 
-Bullet::Bullet(const glm::vec2& position, const glm::vec2& direction, const glm::vec2& texID, Texture* atlas) {
-	m_Position = position;
-	m_Direction = { direction.x, -direction.y };
+BulletStore::BulletStore(Texture* atlas, const glm::vec2& texID)
+{
 	m_Atlas = atlas;
 	m_TexID = texID;
+}
 
-	m_Speed = 5.0f;
-	m_LifeSpan = 5.0f;
-	m_Time = 0.0f;
+EntityHandle BulletStore::Spawn(const glm::vec2& position, const glm::vec2& direction)
+{
+	m_PositionX.push_back(position.x);
+	m_PositionY.push_back(position.y);
+	m_PreviousX.push_back(position.x);
+	m_PreviousY.push_back(position.y);
+	m_DirectionX.push_back(direction.x);
+	m_DirectionY.push_back(-direction.y);
+	m_Time.push_back(0.0f);
+	return m_Entities.Create();
 }
 
-void Bullet::OnUpdate(float deltaTime) {
-	m_Time += deltaTime;
-	m_Position += m_Direction * (deltaTime * m_Speed);
+void BulletStore::Remove(uint32_t index)
+{
+	m_Entities.Remove(index);
+	m_PositionX[index] = m_PositionX.back();
+	m_PositionY[index] = m_PositionY.back();
+	m_PreviousX[index] = m_PreviousX.back();
+	m_PreviousY[index] = m_PreviousY.back();
+	m_DirectionX[index] = m_DirectionX.back();
+	m_DirectionY[index] = m_DirectionY.back();
+	m_Time[index] = m_Time.back();
+	m_PositionX.pop_back();
+	m_PositionY.pop_back();
+	m_PreviousX.pop_back();
+	m_PreviousY.pop_back();
+	m_DirectionX.pop_back();
+	m_DirectionY.pop_back();
+	m_Time.pop_back();
 }
-bool Bullet::ShouldKill()
+
+void BulletStore::Clear()
 {
-	return (m_Time >= m_LifeSpan);
+	m_Entities.Clear();
+	m_PositionX.clear();
+	m_PositionY.clear();
+	m_PreviousX.clear();
+	m_PreviousY.clear();
+	m_DirectionX.clear();
+	m_DirectionY.clear();
+	m_Time.clear();
 }
 
-void Bullet::Render() {
-	float rotation = atan2(m_Direction.x, -m_Direction.y);
-	Renderer::DrawQuadAtlas(m_Position, { 0.125, 0.125 }, rotation, m_Atlas, { 3,2 }, m_TexID);
-}
\ No newline at end of file
+void BulletStore::OnUpdate(float deltaTime)
+{
+	for (uint32_t i = 0; i < GetCount();) {
+		if (m_Time[i] >= BULLET_LIFE_SPAN) Remove(i);
+		else ++i;
+	}
+
+	m_PreviousX = m_PositionX;
+	m_PreviousY = m_PositionY;
+
+	float* positionX = m_PositionX.data();
+	float* positionY = m_PositionY.data();
+	const float* directionX = m_DirectionX.data();
+	const float* directionY = m_DirectionY.data();
+	float* time = m_Time.data();
+	float distance = deltaTime * BULLET_SPEED;
+	uint32_t count = GetCount();
+	for (uint32_t i = 0; i < count; ++i) {
+		positionX[i] += directionX[i] * distance;
+		positionY[i] += directionY[i] * distance;
+		time[i] += deltaTime;
+	}
+}
+
+void BulletStore::Render(float alpha)
+{
+	uint32_t count = GetCount();
+	for (uint32_t i = 0; i < count; ++i) {
+		float rotation = atan2(m_DirectionX[i], -m_DirectionY[i]);
+		Renderer::DrawQuadAtlas(GetPosition(i, alpha), { 0.125, 0.125 }, rotation, m_Atlas, { 3,2 }, m_TexID);
+	}
+}
+
+glm::vec2 BulletStore::GetPosition(uint32_t index, float alpha) const
+{
+	return {
+		m_PreviousX[index] + (m_PositionX[index] - m_PreviousX[index]) * alpha,
+		m_PreviousY[index] + (m_PositionY[index] - m_PreviousY[index]) * alpha
+	};
+}
@@ -1,25 +1,47 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
 #include "Renderer/Texture.h"
+#include "EntityStore.h"
 
-class Bullet {
+// Same for every bullet
+#define BULLET_SPEED     5.0f
+#define BULLET_LIFE_SPAN 5.0f
+
+// Every bullet fired by one side, they all use the same texture. Fields are their own arrays and
+// removing swaps in the last bullet, handles from Spawn stay valid until the bullet is removed
+class BulletStore {
 public:
-	Bullet(const glm::vec2& position, const glm::vec2& direction, const glm::vec2& texID, Texture* atlas);
+	BulletStore(Texture* atlas, const glm::vec2& texID);
+
+	EntityHandle Spawn(const glm::vec2& position, const glm::vec2& direction);
+	void Remove(uint32_t index);
+	void Clear();
 
+	// Removes bullets that have run out of time then moves the rest
 	void OnUpdate(float deltaTime);
-	bool ShouldKill();
-	void Render();
+	// alpha is how far between the last two ticks to draw them
+	void Render(float alpha);
 
-	const glm::vec2& GetPosition() { return m_Position; }
+	uint32_t GetCount() const { return m_Entities.GetCount(); }
+	const EntityStore& GetEntities() const { return m_Entities; }
+	glm::vec2 GetPosition(uint32_t index) const { return { m_PositionX[index], m_PositionY[index] }; }
+	glm::vec2 GetPosition(uint32_t index, float alpha) const;
+	const float* GetPositionX() const { return m_PositionX.data(); }
+	const float* GetPositionY() const { return m_PositionY.data(); }
 
 private:
 	Texture* m_Atlas;
 	glm::vec2 m_TexID;
 
-	glm::vec2 m_Position;
-	glm::vec2 m_Direction;
-
-	float m_Speed;
-	float m_LifeSpan;
-	float m_Time;
-};
\ No newline at end of file
+	EntityStore m_Entities;
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	// Where each bullet was before the last tick
+	std::vector<float> m_PreviousX;
+	std::vector<float> m_PreviousY;
+	std::vector<float> m_DirectionX;
+	std::vector<float> m_DirectionY;
+	std::vector<float> m_Time;
+};
@@ -1,100 +1,156 @@
 #include "Enemy.h"
+#include "EnemyAI.h"
 #include "Renderer/Renderer.h"
-#include <random>
 
-Enemy::Enemy(const glm::vec2& pos, const glm::vec2& dir, Player* player, Texture* atlas)
-{
-	m_Player = player;
-
-	m_Position = pos;
-	m_Direction = dir;
-	m_Atlas = atlas;
-
-	m_Rotation = atan2(dir.x, dir.y);
-
-	glm::vec2 TextureIDS[] = {
+namespace {
+	// Column and row in the ship atlas for each type
+	const glm::vec2 TextureIDS[] = {
 		{0,0},
 		{0,1},
 		{2,0},
 		{3,1}
 	};
+}
 
-	m_Type = rand() % 4;
-	m_TexID = TextureIDS[m_Type];
-	m_Speed = 1.0f + (rand() % 50) / 25;
-	m_TurnSpeed = 2.0f + (rand() % 50) / 50;
-	m_FireTime = 0.5f + (rand() % 6) / 2;
-	m_Health = 1 + (rand() % 2);
-
+EnemyStore::EnemyStore(Texture* atlas, uint32_t seed)
+{
+	m_Atlas = atlas;
+	m_Scale = { 0.25f, 0.25f };
 	m_FireRange = glm::radians(20.0f);
-	m_Time = 6.0f;
+	SetSeed(seed);
+}
 
-	m_TintTime = 0.0f;
+void EnemyStore::SetSeed(uint32_t seed)
+{
+	m_Seed = seed;
+	m_SpawnCount = 0;
 }
 
-bool Enemy::OnUpdate(float deltaTime)
+EntityHandle EnemyStore::Spawn(const glm::vec2& position, const glm::vec2& direction)
 {
-	m_TintTime -= 5.0f * deltaTime;
-	if (m_TintTime < 0.0f) m_TintTime = 0.0f;
-
-	glm::vec2 directionToPlayer = m_Player->GetPosition() - m_Position;
-	if (glm::length(directionToPlayer) == 0) directionToPlayer = { 1, 0 };
-	else directionToPlayer = glm::normalize(directionToPlayer);
-
-	bool shoot = (glm::length(directionToPlayer + m_Direction) >= m_FireRange);
-	if (shoot) {
-		if (m_Time <= 0.0f) {
-			m_Time = m_FireTime;
-		}
-		else shoot = false;
-	}
-	m_Time -= deltaTime;
-	if (m_Time < 0) m_Time = 0;
+	m_PositionX.push_back(position.x);
+	m_PositionY.push_back(position.y);
+	m_PreviousX.push_back(position.x);
+	m_PreviousY.push_back(position.y);
+	m_DirectionX.push_back(direction.x);
+	m_DirectionY.push_back(direction.y);
+	m_Rotation.push_back(atan2(direction.x, direction.y));
+
+	uint32_t random = EnemyAI::SeedRandom(m_Seed ^ EnemyAI::SeedRandom(m_SpawnCount++));
+	m_Type.push_back((uint8_t)(EnemyAI::NextRandom(random) % 4));
+	m_Speed.push_back(1.0f + (EnemyAI::NextRandom(random) % 50) / 25);
+	m_TurnSpeed.push_back(2.0f + (EnemyAI::NextRandom(random) % 50) / 50);
+	m_FireTime.push_back(0.5f + (EnemyAI::NextRandom(random) % 6) / 2);
+	m_Health.push_back(1.0f + (EnemyAI::NextRandom(random) % 2));
+	m_Random.push_back(random);
+
+	m_Time.push_back(6.0f);
+	m_TintTime.push_back(0.0f);
+	return m_Entities.Create();
+}
 
-	glm::vec2 newDirection = {};
-	if (glm::length(directionToPlayer + m_Direction) <= 0.2) {
-		if (rand() % 2) newDirection = glm::vec2(directionToPlayer.y, -directionToPlayer.x);
-		else  newDirection = glm::vec2(directionToPlayer.y, directionToPlayer.x);
-	}
-	else {
-		newDirection = deltaTime * m_TurnSpeed * directionToPlayer + m_Direction;
-	}
+void EnemyStore::Remove(uint32_t index)
+{
+	m_Entities.Remove(index);
+	m_PositionX[index] = m_PositionX.back();
+	m_PositionY[index] = m_PositionY.back();
+	m_PreviousX[index] = m_PreviousX.back();
+	m_PreviousY[index] = m_PreviousY.back();
+	m_DirectionX[index] = m_DirectionX.back();
+	m_DirectionY[index] = m_DirectionY.back();
+	m_Rotation[index] = m_Rotation.back();
+	m_Health[index] = m_Health.back();
+	m_Speed[index] = m_Speed.back();
+	m_TurnSpeed[index] = m_TurnSpeed.back();
+	m_FireTime[index] = m_FireTime.back();
+	m_Time[index] = m_Time.back();
+	m_TintTime[index] = m_TintTime.back();
+	m_Type[index] = m_Type.back();
+	m_Random[index] = m_Random.back();
+	m_PositionX.pop_back();
+	m_PositionY.pop_back();
+	m_PreviousX.pop_back();
+	m_PreviousY.pop_back();
+	m_DirectionX.pop_back();
+	m_DirectionY.pop_back();
+	m_Rotation.pop_back();
+	m_Health.pop_back();
+	m_Speed.pop_back();
+	m_TurnSpeed.pop_back();
+	m_FireTime.pop_back();
+	m_Time.pop_back();
+	m_TintTime.pop_back();
+	m_Type.pop_back();
+	m_Random.pop_back();
+}
 
-	float length = glm::length(newDirection);
-	m_Direction = glm::normalize(newDirection);
-	m_Rotation = atan2(m_Direction.x, -m_Direction.y);
+void EnemyStore::Clear()
+{
+	m_Entities.Clear();
+	m_PositionX.clear();
+	m_PositionY.clear();
+	m_PreviousX.clear();
+	m_PreviousY.clear();
+	m_DirectionX.clear();
+	m_DirectionY.clear();
+	m_Rotation.clear();
+	m_Health.clear();
+	m_Speed.clear();
+	m_TurnSpeed.clear();
+	m_FireTime.clear();
+	m_Time.clear();
+	m_TintTime.clear();
+	m_Type.clear();
+	m_Random.clear();
+}
 
-	length = glm::clamp(length, 0.1f, 3.0f);
+void EnemyStore::OnUpdate(float deltaTime, const glm::vec2& target, std::vector<uint32_t>& shooters)
+{
+	m_PreviousX = m_PositionX;
+	m_PreviousY = m_PositionY;
+
+	uint32_t count = GetCount();
+	m_Shoot.resize(count);
+	EnemyAIState state = {
+		m_PositionX.data(), m_PositionY.data(), m_DirectionX.data(), m_DirectionY.data(), m_Rotation.data(),
+		m_Time.data(), m_TintTime.data(), m_Speed.data(), m_TurnSpeed.data(), m_FireTime.data(), m_Random.data()
+	};
+	EnemyAI::Update(state, count, deltaTime, target, m_FireRange, m_Shoot.data());
 
-	m_Position += m_Direction * deltaTime * m_Speed * length;
-	return shoot;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (m_Shoot[i]) shooters.push_back(i);
+	}
 }
 
-void Enemy::Render()
+void EnemyStore::Render(float alpha)
 {
-	glm::vec4 tint = { 1.0f, 1.0f - (m_TintTime / 2.0f), 1.0f - (m_TintTime / 2.0f), 1.0f };
-	Renderer::DrawQuadAtlas(m_Position, { 0.25f, 0.25f }, m_Rotation, m_Atlas, { 5,2 }, m_TexID, false, tint);
+	uint32_t count = GetCount();
+	for (uint32_t i = 0; i < count; ++i) {
+		float fade = 1.0f - (m_TintTime[i] / 2.0f);
+		glm::vec4 tint = { 1.0f, fade, fade, 1.0f };
+		Renderer::DrawQuadAtlas(GetPosition(i, alpha), m_Scale, m_Rotation[i], m_Atlas, { 5,2 }, TextureIDS[m_Type[i]], false, tint);
+	}
 }
 
-void Enemy::Damage(int damage)
+glm::vec2 EnemyStore::GetPosition(uint32_t index, float alpha) const
 {
-	m_TintTime = 2.0f;
-	m_Health -= damage;
+	return {
+		m_PreviousX[index] + (m_PositionX[index] - m_PreviousX[index]) * alpha,
+		m_PreviousY[index] + (m_PositionY[index] - m_PreviousY[index]) * alpha
+	};
 }
 
-bool Enemy::ShouldKill()
+void EnemyStore::Damage(uint32_t index, int damage)
 {
-	//if (glm::distance(m_Position, m_Player->GetPosition()) >= 12) return true;
-	if (m_Health <= 0.0f) return true;
-
-	return false;
+	m_TintTime[index] = 2.0f;
+	m_Health[index] -= damage;
 }
 
-EnemySpawner::EnemySpawner(Player* player, Texture* atlas, std::vector<Enemy>* enemies)
+EnemySpawner::EnemySpawner(Player* player, EnemyStore* enemies, const Random& random)
 {
 	m_Player = player;
 	m_Enemies = enemies;
-	m_Atlas = atlas;
+	m_Random = random;
 
 	m_SpawnRadius = 3.0f;
 	m_SpawnRate = 3.0f;
@@ -109,19 +165,12 @@ void EnemySpawner::OnUpdate(float deltaTime)
 {
 	if (m_Time <= 0.0f && m_KillCount < m_WaveCount) {
 		glm::vec2 dir = {
-			(rand() % 1000) / 1000.0f,
-			(rand() % 1000) / 1000.0f,
+			m_Random.Next(1000) / 1000.0f,
+			m_Random.Next(1000) / 1000.0f,
 		};
 		dir = glm::normalize(dir);
 
-		Enemy e(
-			m_Player->GetPosition() + (dir * m_SpawnRadius),
-			-dir,
-			m_Player,
-			m_Atlas
-		);
-
-		m_Enemies->push_back(e);
+		m_Enemies->Spawn(m_Player->GetPosition() + (dir * m_SpawnRadius), -dir);
 
 		m_Time = m_SpawnRate;
 	}
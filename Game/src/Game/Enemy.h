@@ -1,46 +1,76 @@
 #pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+#include "Core/Random.h"
 #include "Renderer/Texture.h"
+#include "EntityStore.h"
 #include "Player.h"
 
-class Enemy
-{
+// Every enemy ship, each field is its own array. Removing swaps in the last enemy, so indices are
+// only good until the next removal and handles from Spawn should be kept instead.
+// Every enemy has its own random stream seeded from the store's seed and how many were spawned before it
+class EnemyStore {
 public:
-	Enemy(const glm::vec2& pos, const glm::vec2& dir, Player* player, Texture* atlas);
-
-	bool OnUpdate(float deltaTime);
-	void Render();
-
-	void Damage(int damage);
-	bool ShouldKill();
-
-	const glm::vec2& GetPosition() { return m_Position; }
-	const glm::vec2& GetDirection() { return m_Direction; }
-
-	int GetType() { return m_Type; }
+	EnemyStore(Texture* atlas, uint32_t seed = 0);
+
+	// Type, speed, turn speed, fire time and health are picked from the new enemy's random stream
+	EntityHandle Spawn(const glm::vec2& position, const glm::vec2& direction);
+	void Remove(uint32_t index);
+	void Clear();
+	// Enemies spawned after this get streams from the new seed
+	void SetSeed(uint32_t seed);
+
+	// Turns every enemy towards target and moves it with EnemyAI, the index of every enemy that fires is added to shooters
+	void OnUpdate(float deltaTime, const glm::vec2& target, std::vector<uint32_t>& shooters);
+	// alpha is how far between the last two ticks to draw them
+	void Render(float alpha);
+
+	void Damage(uint32_t index, int damage);
+	bool ShouldKill(uint32_t index) const { return m_Health[index] <= 0.0f; }
+
+	uint32_t GetCount() const { return m_Entities.GetCount(); }
+	const EntityStore& GetEntities() const { return m_Entities; }
+	glm::vec2 GetPosition(uint32_t index) const { return { m_PositionX[index], m_PositionY[index] }; }
+	glm::vec2 GetPosition(uint32_t index, float alpha) const;
+	const float* GetPositionX() const { return m_PositionX.data(); }
+	const float* GetPositionY() const { return m_PositionY.data(); }
+	int GetType(uint32_t index) const { return m_Type[index]; }
 
 private:
 	Texture* m_Atlas;
-	glm::vec2 m_TexID;
-
-	Player* m_Player;
-
-	glm::vec2 m_Position;
-	glm::vec2 m_Direction;
-	float m_Rotation;
-
-	float m_Health;
-	float m_Speed;
-	float m_TurnSpeed;
+	// Same for every enemy
+	glm::vec2 m_Scale;
 	float m_FireRange;
-	float m_FireTime;
-	float m_Time;
-	float m_TintTime;
-	int m_Type;
+
+	EntityStore m_Entities;
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	// Where each enemy was before the last tick
+	std::vector<float> m_PreviousX;
+	std::vector<float> m_PreviousY;
+	std::vector<float> m_DirectionX;
+	std::vector<float> m_DirectionY;
+	std::vector<float> m_Rotation;
+	std::vector<float> m_Health;
+	std::vector<float> m_Speed;
+	std::vector<float> m_TurnSpeed;
+	std::vector<float> m_FireTime;
+	std::vector<float> m_Time;
+	std::vector<float> m_TintTime;
+	std::vector<uint8_t> m_Type;
+	std::vector<uint32_t> m_Random;
+
+	uint32_t m_Seed;
+	uint32_t m_SpawnCount;
+	// Fire flags from EnemyAI, kept so updating every frame doesn't allocate
+	std::vector<uint8_t> m_Shoot;
 };
 
 class EnemySpawner {
 public:
-	EnemySpawner(Player* player, Texture* atlas, std::vector<Enemy>* enemies);
+	// Where enemies spawn comes from random, the same stream gives the same waves
+	EnemySpawner(Player* player, EnemyStore* enemies, const Random& random);
 
 	void OnUpdate(float deltaTime);
 
@@ -50,9 +80,8 @@ public:
 
 private:
 	Player* m_Player;
-	std::vector<Enemy>* m_Enemies;
-
-	Texture* m_Atlas;
+	EnemyStore* m_Enemies;
+	Random m_Random;
 
 	int m_Wave;
 	int m_WaveCount;
@@ -62,4 +91,4 @@ private:
 	float m_SpawnRate;
 	float m_Time;
 	float m_BreakTime;
-};
\ No newline at end of file
+};
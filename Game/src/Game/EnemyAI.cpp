@@ -0,0 +1,213 @@
+#include "EnemyAI.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define ENEMY_AI_SSE
+#endif
+
+namespace {
+	// Past this the enemy is facing away from the target and turns sideways instead
+	const float TurnAroundLength = 0.2f;
+	const float MinStep = 0.1f;
+	const float MaxStep = 3.0f;
+
+#if defined(ENEMY_AI_SSE)
+	__m128 Select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	__m128i Select(__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+	__m128i NextRandomLanes(__m128i x) {
+		x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+		x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+		return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	}
+
+	// atan2 to about 1e-7. The ratio of the smaller side to the bigger one is brought under tan(pi / 8)
+	// around 0 or pi / 4, then the polynomial, then the quadrant is put back from the signs
+	__m128 Atan2(__m128 y, __m128 x) {
+		__m128 sign = _mm_set1_ps(-0.0f);
+		__m128 ax = _mm_andnot_ps(sign, x);
+		__m128 ay = _mm_andnot_ps(sign, y);
+		__m128 swap = _mm_cmpgt_ps(ay, ax);
+		__m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(ax, ay));
+
+		__m128 reduce = _mm_cmpgt_ps(a, _mm_set1_ps(0.4142135623f));
+		__m128 t = Select(reduce, _mm_div_ps(_mm_sub_ps(a, _mm_set1_ps(1.0f)), _mm_add_ps(a, _mm_set1_ps(1.0f))), a);
+		__m128 z = _mm_mul_ps(t, t);
+		__m128 p = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(8.05374449538e-2f), z), _mm_set1_ps(1.38776856032e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.99777106478e-1f));
+		p = _mm_sub_ps(_mm_mul_ps(p, z), _mm_set1_ps(3.33329491539e-1f));
+		__m128 r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), t), t);
+		r = _mm_add_ps(r, _mm_and_ps(reduce, _mm_set1_ps(0.78539816340f)));
+
+		r = Select(swap, _mm_sub_ps(_mm_set1_ps(1.57079632679f), r), r);
+		r = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265359f), r), r);
+		return _mm_or_ps(r, _mm_and_ps(y, sign));
+	}
+#endif
+}
+
+void EnemyAI::Update(const EnemyAIState& enemies, uint32_t count, float deltaTime, const glm::vec2& target, float fireRange, uint8_t* shoot)
+{
+	uint32_t i = 0;
+#if defined(ENEMY_AI_SSE)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 targetX = _mm_set1_ps(target.x);
+	const __m128 targetY = _mm_set1_ps(target.y);
+	for (; i + 4 <= count; i += 4) {
+		__m128 positionX = _mm_loadu_ps(enemies.PositionX + i);
+		__m128 positionY = _mm_loadu_ps(enemies.PositionY + i);
+		__m128 directionX = _mm_loadu_ps(enemies.DirectionX + i);
+		__m128 directionY = _mm_loadu_ps(enemies.DirectionY + i);
+
+		__m128 tint = _mm_sub_ps(_mm_loadu_ps(enemies.TintTime + i), _mm_mul_ps(_mm_set1_ps(5.0f), dt));
+		_mm_storeu_ps(enemies.TintTime + i, _mm_max_ps(tint, zero));
+
+		// Towards the target, or along x when already on it
+		__m128 toX = _mm_sub_ps(targetX, positionX);
+		__m128 toY = _mm_sub_ps(targetY, positionY);
+		__m128 toLength = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)));
+		__m128 onTarget = _mm_cmpeq_ps(toLength, zero);
+		__m128 inverse = _mm_div_ps(one, toLength);
+		toX = Select(onTarget, one, _mm_mul_ps(toX, inverse));
+		toY = Select(onTarget, zero, _mm_mul_ps(toY, inverse));
+
+		__m128 sumX = _mm_add_ps(toX, directionX);
+		__m128 sumY = _mm_add_ps(toY, directionY);
+		__m128 sumLength = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(sumX, sumX), _mm_mul_ps(sumY, sumY)));
+
+		// Fires when in range and the timer has run out, which restarts it
+		__m128 time = _mm_loadu_ps(enemies.Time + i);
+		__m128 fire = _mm_and_ps(_mm_cmpge_ps(sumLength, _mm_set1_ps(fireRange)), _mm_cmple_ps(time, zero));
+		time = Select(fire, _mm_loadu_ps(enemies.FireTime + i), time);
+		time = _mm_max_ps(_mm_sub_ps(time, dt), zero);
+		_mm_storeu_ps(enemies.Time + i, time);
+		int fireBits = _mm_movemask_ps(fire);
+		for (int lane = 0; lane < 4; ++lane) shoot[i + lane] = (uint8_t)((fireBits >> lane) & 1);
+
+		// Facing away turns sideways one way or the other, only those draw a random number
+		__m128 turnAround = _mm_cmple_ps(sumLength, _mm_set1_ps(TurnAroundLength));
+		__m128i turnAroundBits = _mm_castps_si128(turnAround);
+		__m128i random = _mm_loadu_si128((const __m128i*)(enemies.Random + i));
+		__m128i nextRandom = NextRandomLanes(random);
+		_mm_storeu_si128((__m128i*)(enemies.Random + i), Select(turnAroundBits, nextRandom, random));
+		__m128 odd = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(nextRandom, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		__m128 sideX = toY;
+		__m128 sideY = Select(odd, _mm_sub_ps(zero, toX), toX);
+
+		__m128 turn = _mm_mul_ps(dt, _mm_loadu_ps(enemies.TurnSpeed + i));
+		__m128 blendX = _mm_add_ps(_mm_mul_ps(turn, toX), directionX);
+		__m128 blendY = _mm_add_ps(_mm_mul_ps(turn, toY), directionY);
+		__m128 newX = Select(turnAround, sideX, blendX);
+		__m128 newY = Select(turnAround, sideY, blendY);
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(newX, newX), _mm_mul_ps(newY, newY)));
+		inverse = _mm_div_ps(one, length);
+		directionX = _mm_mul_ps(newX, inverse);
+		directionY = _mm_mul_ps(newY, inverse);
+		_mm_storeu_ps(enemies.DirectionX + i, directionX);
+		_mm_storeu_ps(enemies.DirectionY + i, directionY);
+		_mm_storeu_ps(enemies.Rotation + i, Atan2(directionX, _mm_sub_ps(zero, directionY)));
+
+		length = _mm_min_ps(_mm_max_ps(length, _mm_set1_ps(MinStep)), _mm_set1_ps(MaxStep));
+		__m128 speed = _mm_loadu_ps(enemies.Speed + i);
+		positionX = _mm_add_ps(positionX, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(directionX, dt), speed), length));
+		positionY = _mm_add_ps(positionY, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(directionY, dt), speed), length));
+		_mm_storeu_ps(enemies.PositionX + i, positionX);
+		_mm_storeu_ps(enemies.PositionY + i, positionY);
+	}
+#endif
+	// Whatever doesn't fill a whole register
+	EnemyAIState rest = {
+		enemies.PositionX + i, enemies.PositionY + i, enemies.DirectionX + i, enemies.DirectionY + i, enemies.Rotation + i,
+		enemies.Time + i, enemies.TintTime + i, enemies.Speed + i, enemies.TurnSpeed + i, enemies.FireTime + i, enemies.Random + i
+	};
+	UpdateScalar(rest, count - i, deltaTime, target, fireRange, shoot + i);
+}
+
+void EnemyAI::UpdateScalar(const EnemyAIState& enemies, uint32_t count, float deltaTime, const glm::vec2& target, float fireRange, uint8_t* shoot)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		float tint = enemies.TintTime[i] - 5.0f * deltaTime;
+		enemies.TintTime[i] = tint < 0.0f ? 0.0f : tint;
+
+		float toX = target.x - enemies.PositionX[i];
+		float toY = target.y - enemies.PositionY[i];
+		float toLength = std::sqrt(toX * toX + toY * toY);
+		if (toLength == 0.0f) {
+			toX = 1.0f;
+			toY = 0.0f;
+		}
+		else {
+			float inverse = 1.0f / toLength;
+			toX = toX * inverse;
+			toY = toY * inverse;
+		}
+
+		float directionX = enemies.DirectionX[i];
+		float directionY = enemies.DirectionY[i];
+		float sumX = toX + directionX;
+		float sumY = toY + directionY;
+		float sumLength = std::sqrt(sumX * sumX + sumY * sumY);
+
+		float time = enemies.Time[i];
+		bool fire = sumLength >= fireRange && time <= 0.0f;
+		if (fire) time = enemies.FireTime[i];
+		time -= deltaTime;
+		enemies.Time[i] = time < 0.0f ? 0.0f : time;
+		shoot[i] = fire ? 1 : 0;
+
+		float newX, newY;
+		if (sumLength <= TurnAroundLength) {
+			newX = toY;
+			newY = (NextRandom(enemies.Random[i]) & 1) ? -toX : toX;
+		}
+		else {
+			float turn = deltaTime * enemies.TurnSpeed[i];
+			newX = turn * toX + directionX;
+			newY = turn * toY + directionY;
+		}
+
+		float length = std::sqrt(newX * newX + newY * newY);
+		float inverse = 1.0f / length;
+		directionX = newX * inverse;
+		directionY = newY * inverse;
+		enemies.DirectionX[i] = directionX;
+		enemies.DirectionY[i] = directionY;
+		enemies.Rotation[i] = std::atan2(directionX, -directionY);
+
+		length = length < MinStep ? MinStep : (length > MaxStep ? MaxStep : length);
+		enemies.PositionX[i] += directionX * deltaTime * enemies.Speed[i] * length;
+		enemies.PositionY[i] += directionY * deltaTime * enemies.Speed[i] * length;
+	}
+}
+
+uint32_t EnemyAI::NextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+uint32_t EnemyAI::SeedRandom(uint32_t seed)
+{
+	// Mixed so seeds next to each other start far apart
+	seed ^= seed >> 16;
+	seed *= 0x7FEB352Du;
+	seed ^= seed >> 15;
+	seed *= 0x846CA68Bu;
+	seed ^= seed >> 16;
+	return seed ? seed : 0x9E3779B9u;
+}
+
+const char* EnemyAI::GetKernelName()
+{
+#if defined(ENEMY_AI_SSE)
+	return "SSE";
+#else
+	return "Scalar";
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// Enemies as separate arrays, the way the kernels read them
+struct EnemyAIState {
+	float* PositionX;
+	float* PositionY;
+	float* DirectionX;
+	float* DirectionY;
+	float* Rotation;
+	float* Time;
+	float* TintTime;
+	const float* Speed;
+	const float* TurnSpeed;
+	const float* FireTime;
+	// xorshift state for each enemy, never 0
+	uint32_t* Random;
+};
+
+// Steers every enemy towards a target, four at a time with SSE when the compiler has it. Each enemy
+// draws from its own random stream, so a run only depends on the seeds it was given. Besides rotation,
+// which is only drawn, the SSE kernel gives exactly what the scalar one does as long as the compiler
+// doesn't fuse multiplies and adds. Doesn't touch OpenGL so it can run without a window
+class EnemyAI {
+public:
+	// shoot is set to 1 for every enemy that fires this update and 0 for the rest
+	static void Update(const EnemyAIState& enemies, uint32_t count, float deltaTime, const glm::vec2& target, float fireRange, uint8_t* shoot);
+	// One enemy at a time with std::atan2, what the SSE kernel is checked against
+	static void UpdateScalar(const EnemyAIState& enemies, uint32_t count, float deltaTime, const glm::vec2& target, float fireRange, uint8_t* shoot);
+
+	// Next number in an xorshift stream, state can't be 0
+	static uint32_t NextRandom(uint32_t& state);
+	// Turns any number into a usable starting state
+	static uint32_t SeedRandom(uint32_t seed);
+
+	// "SSE" or "Scalar"
+	static const char* GetKernelName();
+};
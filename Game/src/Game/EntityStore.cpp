@@ -0,0 +1,55 @@
+#include "EntityStore.h"
+
+EntityHandle EntityStore::Create()
+{
+	uint32_t slot;
+	if (!m_FreeSlots.empty()) {
+		slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else {
+		slot = (uint32_t)m_SlotIndex.size();
+		m_SlotIndex.push_back(0);
+		m_SlotGeneration.push_back(0);
+	}
+
+	m_SlotIndex[slot] = (uint32_t)m_IndexSlot.size();
+	m_IndexSlot.push_back(slot);
+	return { slot, m_SlotGeneration[slot] };
+}
+
+void EntityStore::Remove(uint32_t index)
+{
+	uint32_t slot = m_IndexSlot[index];
+	uint32_t lastSlot = m_IndexSlot.back();
+	m_IndexSlot[index] = lastSlot;
+	m_SlotIndex[lastSlot] = index;
+	m_IndexSlot.pop_back();
+
+	m_SlotGeneration[slot] += 1;
+	m_SlotIndex[slot] = ENTITY_SLOT_NONE;
+	m_FreeSlots.push_back(slot);
+}
+
+void EntityStore::Clear()
+{
+	// Every live slot moves on a generation so old handles stay invalid
+	for (uint32_t slot : m_IndexSlot) {
+		m_SlotGeneration[slot] += 1;
+		m_SlotIndex[slot] = ENTITY_SLOT_NONE;
+		m_FreeSlots.push_back(slot);
+	}
+	m_IndexSlot.clear();
+}
+
+bool EntityStore::IsAlive(EntityHandle handle) const
+{
+	if (handle.Slot >= m_SlotGeneration.size()) return false;
+	return m_SlotGeneration[handle.Slot] == handle.Generation;
+}
+
+EntityHandle EntityStore::GetHandle(uint32_t index) const
+{
+	uint32_t slot = m_IndexSlot[index];
+	return { slot, m_SlotGeneration[slot] };
+}
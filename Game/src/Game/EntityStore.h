@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+#define ENTITY_SLOT_NONE UINT32_MAX
+
+// Refers to one entity for as long as it's alive, other entities being added or removed doesn't change it.
+// Once the entity is removed its slot's generation moves on and the handle stops being valid
+struct EntityHandle {
+	uint32_t Slot = ENTITY_SLOT_NONE;
+	uint32_t Generation = 0;
+};
+
+// Keeps the entities of a store packed at the front of its component arrays. Handles go through a slot
+// table to find where their entity is now, removing moves the last entity into the gap and points its
+// slot at the new index, so removing is O(1) and the arrays never have holes. The store that owns it
+// does the same move on its own arrays
+class EntityStore {
+public:
+	// The new entity is at index GetCount() - 1, its components go on the end of each array
+	EntityHandle Create();
+	// Removes the entity at index, the last entity takes its place
+	void Remove(uint32_t index);
+	void Clear();
+
+	bool IsAlive(EntityHandle handle) const;
+	// Where a live entity's components are
+	uint32_t GetIndex(EntityHandle handle) const { return m_SlotIndex[handle.Slot]; }
+	EntityHandle GetHandle(uint32_t index) const;
+
+	uint32_t GetCount() const { return (uint32_t)m_IndexSlot.size(); }
+
+private:
+	// Per slot, the index of the entity using it and how many times it's been reused
+	std::vector<uint32_t> m_SlotIndex;
+	std::vector<uint32_t> m_SlotGeneration;
+	std::vector<uint32_t> m_FreeSlots;
+	// Per index, the slot of the entity there
+	std::vector<uint32_t> m_IndexSlot;
+};
@@ -3,14 +3,9 @@
 #include "Core/Application.h"
 #include "Renderer/Renderer.h"
 
-void FontRenderer::Init() {
+void FontRenderer::Init(Texture* fontAtlas) {
 	s_Data = new FontRendererData();
-
-	TextureConfig config;
-	config.MinFilter = TexFilterMode::Nearest;
-	config.MagFilter = TexFilterMode::Nearest;
-	config.FlipY = true;
-	s_Data->FontAtlas = new Texture("assets/textures/CommodorePixeled.png", config);
+	s_Data->FontAtlas = fontAtlas;
 
 	s_Data->PaddingX = 0.0f;
 	s_Data->PaddingY = 0.1f;
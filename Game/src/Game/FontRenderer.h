@@ -6,7 +6,8 @@
 
 class FontRenderer {
 public:
-	static void Init();
+	// fontAtlas is the 32 by 32 cell character sheet
+	static void Init(Texture* fontAtlas);
 	static void SetCamera(Camera* camera);
 
 	static float GetTextWidth(float charWidth, const std::string& text);
@@ -1,17 +1,26 @@
 #include "Game.h"
 #include <iostream>
+#include <iomanip>
 #include <map>
+#include <chrono>
+#include <random>
 #include <imgui.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Core/Application.h"
+#include "Core/System.h"
+#include "Core/Random.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/TextureAtlas.h"
 #include "FontRenderer.h"
 #include "Core/Input.h"
 #include "Player.h"
 #include "Background.h"
 #include "Bullet.h"
 #include "Enemy.h"
+#include "EnemyAI.h"
 #include "Partical.h"
+#include "SpatialHash.h"
+#include "InputRecording.h"
 
 namespace {
 	enum class GameState
@@ -70,6 +79,23 @@ namespace {
 	Button s_OptionsButton;
 	Button s_ExitButton;
 
+	// Every texture the game uses is part of one of its pages
+	TextureAtlas* s_TextureAtlas;
+	const std::vector<Game::AtlasImage> s_AtlasImages = {
+		{ "assets/textures/CommodorePixeled.png", true },
+		{ "assets/textures/spaceships.png", true },
+		{ "assets/textures/projectiles.png", true },
+		{ "assets/textures/ShipDebris.png", true },
+		{ "assets/textures/ExplosionSpritesheet.png", true },
+		{ "assets/textures/menu_button.png", false },
+		{ "assets/textures/Title.png", false },
+		{ "assets/textures/Arrow.png", false },
+		{ "assets/textures/SpaceBackgroundDust.png", false },
+		{ "assets/textures/SpaceBackgroundNebulae.png", false },
+		{ "assets/textures/SpaceBackgroundStars.png", false },
+		{ "assets/textures/SpaceBackgroundPlanets.png", false },
+	};
+
 	Texture* s_ShipAtlas;
 	Texture* s_ProjectileAtlas;
 	Texture* s_ButtonAtlas;
@@ -82,146 +108,232 @@ namespace {
 	Camera* s_MainCamera;
 	Camera* s_MenuCamera;
 
-	struct EnemyArrow {
-		glm::vec2 direction;
-
-		void Render() {
-			float rot = atan2(-direction.x, direction.y);
-			glm::vec2 position = s_Player->GetPosition() + (direction * 0.16f);
-			Renderer::DrawQuad(position, { 0.25f,0.25f }, rot, s_ArrowTexture);
-		}
-	};
-	std::vector<EnemyArrow> s_EnemyArrows;
-
-	std::vector<Partical*> s_Particals;
+	ParticalSystem* s_Particals;
 
 	Background* s_BackgroundDust;
 	Background* s_BackgroundNebulae;
 	Background* s_BackgroundPlanets;
 	Background* s_BackgroundStars;
 
-	std::vector<Bullet> s_EnemyBullets;
-	std::vector<Bullet> s_PlayerBullets;
-	std::vector<Enemy> s_Enemies;
+	BulletStore* s_EnemyBullets;
+	BulletStore* s_PlayerBullets;
+	EnemyStore* s_Enemies;
+	std::vector<uint32_t> s_EnemyShooters;
+	float s_EnemyAIMS;
 
 	EnemySpawner* s_EnemySpawner;
 	bool s_EnableEnemySpawner;
 	int s_KillCount;
 
-	void StartGame() {
-		s_EnemyBullets.clear();
-		s_PlayerBullets.clear();
-		s_Enemies.clear();
-		s_EnemyArrows.clear();
-		s_Particals.clear();
+	// Ships are 0.25 across, bullets are treated as points
+	const float s_HitRadius = 0.25f / 2.0f;
+	SpatialHash s_EnemyGrid;
+	std::vector<glm::vec2> s_CollisionPoints;
+	std::vector<uint32_t> s_CollisionHits;
+	float s_CollisionMS;
+
+	// Every system that needs random numbers gets its own stream from the game's seed
+	enum RandomStream : uint64_t {
+		SpawnerStream = 1,
+		EnemyStream,
+		DebrisStream
+	};
+
+	// Input of the current game, saved when the player dies
+	InputRecording s_Recording;
+	const char* s_RecordingPath = "last_game.rec";
+	// Counted as they come in and handed to the next tick
+	uint8_t s_FirePresses;
+	// Where the main camera was before the last tick, it's drawn part way to where it is now
+	glm::vec2 s_PreviousCameraPosition;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+	// FNV-1a of everything in the game that decides how it plays out, two runs of the same recording give the same hash
+	uint64_t HashGameState() {
+		uint64_t hash = 14695981039346656037ull;
+		glm::vec2 playerPosition = s_Player->GetPosition();
+		int playerHealth = s_Player->GetHealth();
+		int wave = s_EnemySpawner->GetWave();
+		uint32_t particalCount = s_Particals->GetCount();
+		hash = HashBytes(hash, &playerPosition, sizeof(playerPosition));
+		hash = HashBytes(hash, &playerHealth, sizeof(playerHealth));
+		hash = HashBytes(hash, &s_KillCount, sizeof(s_KillCount));
+		hash = HashBytes(hash, &wave, sizeof(wave));
+		hash = HashBytes(hash, &particalCount, sizeof(particalCount));
+
+		uint32_t count = s_Enemies->GetCount();
+		hash = HashBytes(hash, &count, sizeof(count));
+		hash = HashBytes(hash, s_Enemies->GetPositionX(), count * sizeof(float));
+		hash = HashBytes(hash, s_Enemies->GetPositionY(), count * sizeof(float));
+		for (BulletStore* bullets : { s_PlayerBullets, s_EnemyBullets }) {
+			count = bullets->GetCount();
+			hash = HashBytes(hash, &count, sizeof(count));
+			hash = HashBytes(hash, bullets->GetPositionX(), count * sizeof(float));
+			hash = HashBytes(hash, bullets->GetPositionY(), count * sizeof(float));
+		}
+		return hash;
+	}
+
+	// Every hit is found first and applied after, bullets that hit something are removed in one pass at the end
+	void UpdateCollisions() {
+		float startTime = System::GetTime();
+
+		// Player bullets against enemies, the lowest index enemy in range takes the hit
+		s_CollisionPoints.clear();
+		for (uint32_t i = 0; i < s_Enemies->GetCount(); ++i) s_CollisionPoints.push_back(s_Enemies->GetPosition(i));
+		s_EnemyGrid.Build(s_CollisionPoints.data(), (uint32_t)s_CollisionPoints.size());
+
+		s_CollisionPoints.clear();
+		for (uint32_t i = 0; i < s_PlayerBullets->GetCount(); ++i) s_CollisionPoints.push_back(s_PlayerBullets->GetPosition(i));
+		s_CollisionHits.resize(s_CollisionPoints.size());
+		s_EnemyGrid.QueryFirst(s_CollisionPoints.data(), (uint32_t)s_CollisionPoints.size(), s_HitRadius, s_CollisionHits.data());
+
+		// Backwards so the bullet swapped into a removed one's place has already been checked
+		for (uint32_t i = s_PlayerBullets->GetCount(); i-- > 0;) {
+			if (s_CollisionHits[i] == SPATIAL_HASH_NONE) continue;
+			s_Enemies->Damage(s_CollisionHits[i], 1);
+			s_PlayerBullets->Remove(i);
+		}
+
+		// Enemy bullets against the player, one point so a straight pass is all it needs
+		glm::vec2 playerPosition = s_Player->GetPosition();
+		float radiusSquared = s_HitRadius * s_HitRadius;
+		for (uint32_t i = s_EnemyBullets->GetCount(); i-- > 0;) {
+			glm::vec2 offset = s_EnemyBullets->GetPosition(i) - playerPosition;
+			if (offset.x * offset.x + offset.y * offset.y > radiusSquared) continue;
+			s_Player->Damage(1);
+			s_EnemyBullets->Remove(i);
+		}
+
+		s_CollisionMS = (System::GetTime() - startTime) * 1000.0f;
+	}
+
+	// Everything random in the game comes from seed, the same seed and input play out the same way
+	void StartGame(uint32_t seed) {
+		s_EnemyBullets->Clear();
+		s_PlayerBullets->Clear();
+		s_Enemies->Clear();
+		s_Particals->Clear();
 
 		s_KillCount = 0;
 		s_EnableEnemySpawner = true;
+		s_FirePresses = 0;
+
+		s_Enemies->SetSeed(Random(seed, EnemyStream).Next());
+		s_Particals->SetRandom(Random(seed, DebrisStream));
 
 		//s_MainCamera->SetPosition({ 0,0 });
 		s_MainCamera->SetRotation(0);
 		s_Player = new Player(s_ShipAtlas, s_MainCamera);
-		s_EnemySpawner = new EnemySpawner(s_Player, s_ShipAtlas, &s_Enemies);
+		s_EnemySpawner = new EnemySpawner(s_Player, s_Enemies, Random(seed, SpawnerStream));
+
+		s_Recording.Begin(seed, SIMULATION_TICK);
 	}
-	void UpdateGame(float deltaTime) {
-		s_Player->OnUpdate(&s_EnemyBullets, deltaTime);
-		if (s_Player->GetHealth() <= 0) s_CurrentGameState = GameState::Death;
+	// The game without a window for Replay and TimeSimulation. Nothing is drawn so nothing needs a texture,
+	// the camera is only there for the player to move
+	void StartHeadless(uint32_t seed) {
+		ViewFrustum frustum = { -1.0f, 1.0f, 1.0f, -1.0f };
+		s_MainCamera = new Camera(frustum, { 0,0 }, 1.5f);
+		s_Particals = new ParticalSystem(nullptr, nullptr);
+		s_EnemyBullets = new BulletStore(nullptr, { 0,0 });
+		s_PlayerBullets = new BulletStore(nullptr, { 0,1 });
+		s_Enemies = new EnemyStore(nullptr);
+		StartGame(seed);
+	}
+	// Reads the keyboard and mouse into what one tick of the game sees
+	InputFrame SampleInput() {
+		InputFrame input;
+		if (Input::IsKeyPressed(KEY_W)) input.Keys |= INPUT_FRAME_UP;
+		if (Input::IsKeyPressed(KEY_S)) input.Keys |= INPUT_FRAME_DOWN;
+		if (Input::IsKeyPressed(KEY_A)) input.Keys |= INPUT_FRAME_LEFT;
+		if (Input::IsKeyPressed(KEY_D)) input.Keys |= INPUT_FRAME_RIGHT;
+
+		input.FireCount = s_FirePresses;
+		s_FirePresses = 0;
+
+		glm::vec2 cursor = { Input::GetMouseX(), Input::GetMouseY() };
+		glm::vec2 aim = cursor - s_MainCamera->ScreenSpacePos(s_Player->GetPosition());
+		input.AimX = (int16_t)glm::clamp(std::round(aim.x), -32768.0f, 32767.0f);
+		input.AimY = (int16_t)glm::clamp(std::round(aim.y), -32768.0f, 32767.0f);
+		return input;
+	}
+	// One tick of the game, only reads input so it can run from a recording
+	void SimulateGame(float deltaTime, const InputFrame& input) {
+		s_Player->OnUpdate(deltaTime, input);
+		for (int i = 0; i < input.FireCount; ++i) {
+			s_PlayerBullets->Spawn(s_Player->GetPosition(), s_Player->GetDirection());
+		}
 
 		if(s_EnableEnemySpawner) s_EnemySpawner->OnUpdate(deltaTime);
 
-		for (int i = 0; i < s_EnemyBullets.size(); ++i) {
-			if (s_EnemyBullets[i].ShouldKill()) {
-				s_EnemyBullets.erase(s_EnemyBullets.begin() + i);
-				i -= 1;
-				continue;
-			}
-			s_EnemyBullets[i].OnUpdate(deltaTime);
-		}
-		for (int i = 0; i < s_PlayerBullets.size(); ++i) {
-			if (s_PlayerBullets[i].ShouldKill()) {
-				s_PlayerBullets.erase(s_PlayerBullets.begin() + i);
-				i -= 1;
-				continue;
-			}
-			s_PlayerBullets[i].OnUpdate(deltaTime);
-		}
+		s_EnemyBullets->OnUpdate(deltaTime);
+		s_PlayerBullets->OnUpdate(deltaTime);
 		
-		for (int i = 0; i < s_Particals.size(); ++i) {
-			if (s_Particals[i]->OnUpdate(deltaTime)) {
-				s_Particals.erase(s_Particals.begin() + i);
-				i -= 1;
-			}
-		}
+		s_Particals->OnUpdate(deltaTime);
 
-		if (s_EnemyArrows.size() != s_Enemies.size()) {
-			s_EnemyArrows.resize(s_Enemies.size());
-		}
-		for (int i = 0; i < s_Enemies.size(); ++i) {
-			Enemy& e = s_Enemies[i];
-
-			s_EnemyArrows[i].direction = glm::normalize(e.GetPosition() - s_Player->GetPosition());
+		UpdateCollisions();
+		if (s_Player->GetHealth() <= 0) s_CurrentGameState = GameState::Death;
 
-			for (int j = 0; j < s_PlayerBullets.size(); ++j) {
-				Bullet& b = s_PlayerBullets[j];
-				if (glm::distance(b.GetPosition(), e.GetPosition()) <= (0.25f / 2.0f)) {
-					s_PlayerBullets.erase(s_PlayerBullets.begin() + j);
-					j -= 1;
-					e.Damage(1.0f);
-				}
-			}
-			
-			if (e.ShouldKill()) {
-				Explosion* explosion = new Explosion(e.GetPosition(), e.GetType(), s_ExplosionAnimation, s_ShipDebrisAtlas, &s_Particals);
-				s_Particals.push_back(explosion);
-
-				s_Enemies.erase(s_Enemies.begin() + i);
-				s_EnemyArrows.erase(s_EnemyArrows.begin() + i);
-				i -= 1;
-				s_KillCount += 1;
-				s_EnemySpawner->GetKillCount() += 1;
+		for (uint32_t i = 0; i < s_Enemies->GetCount();) {
+			if (!s_Enemies->ShouldKill(i)) {
+				++i;
 				continue;
 			}
-			if (e.OnUpdate(deltaTime)) {
-				glm::vec2 dir = glm::normalize(s_Player->GetPosition() - e.GetPosition());
-				dir = { dir.x, -dir.y };
-				Bullet b(
-					e.GetPosition(),
-					dir,
-					{ 0,0 },
-					s_ProjectileAtlas
-				);
-				s_EnemyBullets.push_back(b);
-			}
+			s_Particals->Explosions.Spawn(s_Enemies->GetPosition(i), s_Enemies->GetType(i));
+			s_Enemies->Remove(i);
+			s_KillCount += 1;
+			s_EnemySpawner->GetKillCount() += 1;
 		}
-	}
-	void RenderGame() {
-		if (!s_EnemySpawner) return;
-
-		s_BackgroundDust->Render(s_Player->GetPosition());
-		s_BackgroundNebulae->Render(s_Player->GetPosition());
-		s_BackgroundStars->Render(s_Player->GetPosition());
-		s_BackgroundPlanets->Render(s_Player->GetPosition());
 
-		for (auto& b : s_EnemyBullets) {
-			b.Render();
+		float startTime = System::GetTime();
+		s_EnemyShooters.clear();
+		s_Enemies->OnUpdate(deltaTime, s_Player->GetPosition(), s_EnemyShooters);
+		s_EnemyAIMS = (System::GetTime() - startTime) * 1000.0f;
+		for (uint32_t i : s_EnemyShooters) {
+			glm::vec2 position = s_Enemies->GetPosition(i);
+			glm::vec2 dir = glm::normalize(s_Player->GetPosition() - position);
+			s_EnemyBullets->Spawn(position, { dir.x, -dir.y });
 		}
-		for (auto& b : s_PlayerBullets) {
-			b.Render();
+	}
+	void UpdateGame(float deltaTime) {
+		InputFrame input = SampleInput();
+		s_Recording.Add(input);
+		SimulateGame(deltaTime, input);
+	}
+	// Points from the player towards every enemy
+	void RenderEnemyArrows(float alpha) {
+		glm::vec2 playerPosition = s_Player->GetInterpolatedPosition(alpha);
+		for (uint32_t i = 0; i < s_Enemies->GetCount(); ++i) {
+			glm::vec2 direction = glm::normalize(s_Enemies->GetPosition(i, alpha) - playerPosition);
+			float rot = atan2(-direction.x, direction.y);
+			Renderer::DrawQuad(playerPosition + (direction * 0.16f), { 0.25f,0.25f }, rot, s_ArrowTexture);
 		}
+	}
+	void RenderGame(float alpha) {
+		if (!s_EnemySpawner) return;
 
-		for (auto& p : s_Particals) {
-			p->Render();
-		}
+		glm::vec2 playerPosition = s_Player->GetInterpolatedPosition(alpha);
+		s_BackgroundDust->Render(playerPosition);
+		s_BackgroundNebulae->Render(playerPosition);
+		s_BackgroundStars->Render(playerPosition);
+		s_BackgroundPlanets->Render(playerPosition);
 
-		for (auto& e : s_Enemies) {
-			e.Render();
-		}
+		s_EnemyBullets->Render(alpha);
+		s_PlayerBullets->Render(alpha);
 
-		for (auto& a : s_EnemyArrows) {
-			a.Render();
-		}
+		s_Particals->Render();
+
+		s_Enemies->Render(alpha);
+		RenderEnemyArrows(alpha);
 
-		s_Player->Render();
+		s_Player->Render(alpha);
 
 		Renderer::ChangeCamera(s_MenuCamera);
 
@@ -314,7 +426,8 @@ namespace {
 	}
 
 	void StartDeath() {
-
+		s_Recording.SetFinalHash(HashGameState());
+		if (!s_Recording.Save(s_RecordingPath)) std::cout << "Failed to save recording to " << s_RecordingPath << std::endl;
 	}
 	void UpdateDeath(float deltaTime) {
 		exit(-1);
@@ -324,9 +437,9 @@ namespace {
 	}
 
 	void Reset() {
-		s_EnemyBullets.clear();
-		s_PlayerBullets.clear();
-		s_Enemies.clear();
+		s_EnemyBullets->Clear();
+		s_PlayerBullets->Clear();
+		s_Enemies->Clear();
 
 		s_MainCamera->SetPosition({ 0,0 });
 		s_MainCamera->SetRotation(0);
@@ -347,13 +460,8 @@ void Game::OnMouseButton(MouseButtonEvent& e)
 	if (s_CurrentGameState != GameState::Game) return;
 	if (e.GetButton() != MOUSE_BUTTON_LEFT || e.GetAction() != PRESS) return;
 
-	Bullet bullet(
-		s_Player->GetPosition(),
-		s_Player->GetDirection(),
-		{ 0,1 },
-		s_ProjectileAtlas
-	);
-	s_PlayerBullets.push_back(bullet);
+	// Bullets are fired on the next tick so they can be recorded
+	if (s_FirePresses < UINT8_MAX) s_FirePresses += 1;
 }
 
 void Game::OnResize(WindowResizeEvent& e)
@@ -379,28 +487,39 @@ void Game::StartUp() {
 	s_MainCamera = new Camera(frustum, {0,0}, 1.5f);
 	s_MenuCamera = new Camera(frustum);
 
-	FontRenderer::Init();
+	// Packed together so sprites with different textures can be drawn in one draw call
+	s_TextureAtlas = new TextureAtlas();
+	for (const AtlasImage& image : s_AtlasImages) s_TextureAtlas->Add(image.Path, image.FlipY);
 
 	TextureConfig config;
 	config.MinFilter = TexFilterMode::Nearest;
 	config.MagFilter = TexFilterMode::Nearest;
-	config.FlipY = true;
-	s_ShipAtlas = new Texture("assets/textures/spaceships.png", config);
-	s_ProjectileAtlas = new Texture("assets/textures/projectiles.png", config);
-	s_ShipDebrisAtlas = new Texture("assets/textures/ShipDebris.png", config);
-	s_ExplosionAnimation = new Texture("assets/textures/ExplosionSpritesheet.png", config);
-
-	config.FlipY = false;
-	s_ButtonAtlas = new Texture("assets/textures/menu_button.png", config);
-	s_TitleTexture = new Texture("assets/textures/Title.png", config);
-	s_ArrowTexture = new Texture("assets/textures/Arrow.png", config);
-
-	s_BackgroundDust =    new Background("assets/textures/SpaceBackgroundDust.png", 0, s_MainCamera);
-	s_BackgroundNebulae = new Background("assets/textures/SpaceBackgroundNebulae.png", 0.03, s_MainCamera);
-	s_BackgroundStars =   new Background("assets/textures/SpaceBackgroundStars.png", 0.05, s_MainCamera);
-	s_BackgroundPlanets = new Background("assets/textures/SpaceBackgroundPlanets.png", 0.07, s_MainCamera);
+	config.SWrapMode = TexWrapMode::ClampToEdge;
+	config.TWrapMode = TexWrapMode::ClampToEdge;
+	s_TextureAtlas->Build(config);
+
+	FontRenderer::Init(s_TextureAtlas->Get("assets/textures/CommodorePixeled.png"));
+
+	s_ShipAtlas = s_TextureAtlas->Get("assets/textures/spaceships.png");
+	s_ProjectileAtlas = s_TextureAtlas->Get("assets/textures/projectiles.png");
+	s_ShipDebrisAtlas = s_TextureAtlas->Get("assets/textures/ShipDebris.png");
+	s_ExplosionAnimation = s_TextureAtlas->Get("assets/textures/ExplosionSpritesheet.png");
+	s_Particals = new ParticalSystem(s_ShipDebrisAtlas, s_ExplosionAnimation);
+	s_EnemyBullets = new BulletStore(s_ProjectileAtlas, { 0,0 });
+	s_PlayerBullets = new BulletStore(s_ProjectileAtlas, { 0,1 });
+	s_Enemies = new EnemyStore(s_ShipAtlas);
+
+	s_ButtonAtlas = s_TextureAtlas->Get("assets/textures/menu_button.png");
+	s_TitleTexture = s_TextureAtlas->Get("assets/textures/Title.png");
+	s_ArrowTexture = s_TextureAtlas->Get("assets/textures/Arrow.png");
+
+	s_BackgroundDust =    new Background(s_TextureAtlas->Get("assets/textures/SpaceBackgroundDust.png"), 0, s_MainCamera);
+	s_BackgroundNebulae = new Background(s_TextureAtlas->Get("assets/textures/SpaceBackgroundNebulae.png"), 0.03, s_MainCamera);
+	s_BackgroundStars =   new Background(s_TextureAtlas->Get("assets/textures/SpaceBackgroundStars.png"), 0.05, s_MainCamera);
+	s_BackgroundPlanets = new Background(s_TextureAtlas->Get("assets/textures/SpaceBackgroundPlanets.png"), 0.07, s_MainCamera);
 
 	s_Player = new Player(s_ShipAtlas, s_MainCamera);
+	s_PreviousCameraPosition = s_MainCamera->GetPosition();
 
 	s_LastGameState = GameState::None;
 	s_CurrentGameState = GameState::MainMenu;
@@ -410,8 +529,10 @@ void Game::Shutdown() {
 }
 
 void Game::Update(float deltaTime) {
+	s_PreviousCameraPosition = s_MainCamera->GetPosition();
+
 	if (s_LastGameState != s_CurrentGameState) {
-		if (s_CurrentGameState == GameState::Game) StartGame();
+		if (s_CurrentGameState == GameState::Game) StartGame(std::random_device()());
 		else if (s_CurrentGameState == GameState::Death) StartDeath();
 		else if (s_CurrentGameState == GameState::MainMenu) StartMainMenu();
 	}
@@ -422,15 +543,100 @@ void Game::Update(float deltaTime) {
 	else if (s_CurrentGameState == GameState::MainMenu) UpdateMainMenu(deltaTime);
 }
 
-void Game::Render() {
+void Game::Render(float alpha) {
+	glm::vec2 cameraPosition = s_MainCamera->GetPosition();
+	s_MainCamera->SetPosition(s_PreviousCameraPosition + (cameraPosition - s_PreviousCameraPosition) * alpha);
+
 	Renderer::StartFrame(s_MainCamera);
 	Renderer::ClearColor({ 0.0f, 0.0f, 0.0f });
 
-	if (s_CurrentGameState == GameState::Game) RenderGame();
+	if (s_CurrentGameState == GameState::Game) RenderGame(alpha);
 	else if (s_CurrentGameState == GameState::Death) RenderDeath();
 	else if (s_CurrentGameState == GameState::MainMenu) RenderMainMenu();
 
 	Renderer::EndFrame();
+
+	s_MainCamera->SetPosition(cameraPosition);
+}
+
+const std::vector<Game::AtlasImage>& Game::GetAtlasImages()
+{
+	return s_AtlasImages;
+}
+
+int Game::Replay(const std::string& path)
+{
+	InputRecording recording;
+	if (!recording.Load(path)) {
+		std::cout << "Failed to load recording " << path << std::endl;
+		return -1;
+	}
+
+	StartHeadless(recording.GetSeed());
+
+	float tickLength = recording.GetTickLength();
+	uint32_t tickCount = recording.GetTickCount();
+	float startTime = System::GetTime();
+	for (uint32_t i = 0; i < tickCount; ++i) SimulateGame(tickLength, recording.GetFrame(i));
+	float seconds = System::GetTime() - startTime;
+
+	uint64_t hash = HashGameState();
+	bool match = hash == recording.GetFinalHash();
+	std::cout << "Replayed " << tickCount << " ticks in " << seconds << " s ( " << (uint64_t)(tickCount / seconds) << " ticks/sec )" << std::endl;
+	std::cout << std::hex << std::setfill('0');
+	std::cout << "State hash: " << std::setw(16) << hash << " ( recorded " << std::setw(16) << recording.GetFinalHash() << ", " << (match ? "match" : "MISMATCH") << " )" << std::endl;
+	return match ? 0 : 1;
+}
+
+void Game::TimeSimulation()
+{
+	const uint32_t enemyCount = 10000, bulletCount = 100000, ticks = 10;
+	StartHeadless(47);
+
+	// Spread over a 100x100 area, so about one enemy per square unit and a few percent of bullets hit
+	Random random(47);
+	auto randomPosition = [&random]() { return glm::vec2(random.NextFloat() * 100.0f - 50.0f, random.NextFloat() * 100.0f - 50.0f); };
+	double collisionMS = 0.0;
+	uint32_t hits = 0;
+	for (uint32_t tick = 0; tick < ticks; ++tick) {
+		s_Enemies->Clear();
+		s_PlayerBullets->Clear();
+		for (uint32_t i = 0; i < enemyCount; ++i) s_Enemies->Spawn(randomPosition(), { 0, 1 });
+		for (uint32_t i = 0; i < bulletCount; ++i) s_PlayerBullets->Spawn(randomPosition(), { 0, 1 });
+
+		auto start = std::chrono::steady_clock::now();
+		UpdateCollisions();
+		collisionMS += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		hits += bulletCount - s_PlayerBullets->GetCount();
+	}
+	std::cout << "time collisions: " << enemyCount << " enemies, " << bulletCount << " bullets, " << hits / ticks << " hits, "
+		<< collisionMS / ticks << " ms a tick" << std::endl;
+
+	// A whole wave played out: 10k enemies closing in from a ring around the player, shooting back as the
+	// player turns and fires every tick, with the spawner still adding to it
+	const uint32_t waveTicks = 600;
+	StartGame(48);
+	for (uint32_t i = 0; i < enemyCount; ++i) {
+		float angle = random.NextFloat() * 6.2831853f;
+		float distance = 20.0f + random.NextFloat() * 40.0f;
+		glm::vec2 direction = { std::cos(angle), std::sin(angle) };
+		s_Enemies->Spawn(direction * distance, -direction);
+	}
+	uint32_t peakEntities = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint32_t tick = 0; tick < waveTicks; ++tick) {
+		InputFrame input;
+		input.FireCount = 1;
+		input.AimX = (int16_t)(std::cos(tick * 0.05f) * 100.0f);
+		input.AimY = (int16_t)(std::sin(tick * 0.05f) * 100.0f);
+		SimulateGame(SIMULATION_TICK, input);
+		uint32_t entities = s_Enemies->GetCount() + s_EnemyBullets->GetCount() + s_PlayerBullets->GetCount() + s_Particals->GetCount();
+		if (entities > peakEntities) peakEntities = entities;
+	}
+	double waveMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "time wave: " << waveTicks << " ticks, " << peakEntities << " entities at most ( " << s_Enemies->GetCount() << " enemies, "
+		<< s_EnemyBullets->GetCount() << " enemy bullets at the end ), " << waveMS / waveTicks << " ms a tick ( "
+		<< (uint64_t)(waveTicks / (waveMS / 1000.0)) << " ticks/sec )" << std::endl;
 }
 
 void Game::OnImGui() {
@@ -444,6 +650,7 @@ void Game::OnImGui() {
 	ImGui::Text("Game Update: %f ~ (%i%%)", app_info.updateMS, (int)((app_info.updateMS / app_info.frameTimeMS) * 100));
 	ImGui::Text("Render Update: %f ~ (%i%%)", app_info.renderMS, (int)((app_info.renderMS / app_info.frameTimeMS) * 100));
 	ImGui::Text("ImGui Update: %f ~ (%i%%)", app_info.imguiMS, (int)((app_info.imguiMS / app_info.frameTimeMS) * 100));
+	ImGui::Text("Ticks This Frame: %i ( alpha %.2f )", app_info.tickCount, app_info.tickAlpha);
 	
 	ImGui::SeparatorText("Renderer Diagnostic");
 	ImGui::Text("Render MS: %f", app_info.renderMS);
@@ -451,7 +658,12 @@ void Game::OnImGui() {
 	ImGui::Text("Batching MS: %f", render_info.BatchMS);
 	ImGui::Text("Draw Call Count: %i", render_info.DrawCallCount);
 	ImGui::Text("Render Group Count: %i", render_info.RenderGroupCount);
-	ImGui::Text("Quad Count: %i", render_info.QuadCount);
+	ImGui::Text("Quad Count: %i ( %i culled )", render_info.QuadCount, render_info.CulledQuadCount);
+	ImGui::Text("Bytes Per Quad: %i", render_info.BytesPerQuad);
+	ImGui::Text("Quads/sec: %.0f", render_info.QuadsPerSecond);
+	ImGui::Text("Upload Stalls: %i ( %.3f ms )", render_info.UploadStallCount, render_info.UploadStallMS);
+	ImGui::Text("Atlas: %i textures on %i pages ( %.0f%% full )", s_TextureAtlas->GetImageCount(), s_TextureAtlas->GetPageCount(), s_TextureAtlas->GetOccupancy() * 100.0f);
+	ImGui::Text("Atlas Pack MS: %f ( Build MS: %f )", s_TextureAtlas->GetPackMS(), s_TextureAtlas->GetBuildMS());
 
 	ImGui::SeparatorText("Game Info");
 	std::map<GameState, std::string> StateToStr = {
@@ -460,9 +672,12 @@ void Game::OnImGui() {
 		{ GameState::Death, "Death" },
 	};
 
-	ImGui::Text("Bullet Count: %i", s_PlayerBullets.size() + s_EnemyBullets.size());
-	ImGui::Text("Enemy Count: %i", s_Enemies.size());
-	ImGui::Text("Partical Count: %i", s_Particals.size());
+	ImGui::Text("Bullet Count: %i", s_PlayerBullets->GetCount() + s_EnemyBullets->GetCount());
+	ImGui::Text("Enemy Count: %i", s_Enemies->GetCount());
+	ImGui::Text("Partical Count: %i", s_Particals->GetCount());
+	ImGui::Text("Collision MS: %f", s_CollisionMS);
+	float enemiesPerSecond = s_EnemyAIMS > 0.0f ? s_Enemies->GetCount() / (s_EnemyAIMS / 1000.0f) : 0.0f;
+	ImGui::Text("Enemy AI MS: %f ( %s, %.2f M enemies/s )", s_EnemyAIMS, EnemyAI::GetKernelName(), enemiesPerSecond / 1000000.0f);
 	ImGui::Text(std::string("Current Game State ( " + StateToStr[s_CurrentGameState] + " )").c_str());
 	
 	const char* items[] = { "Main Menu", "Game", "Death" };
@@ -491,22 +706,23 @@ void Game::OnImGui() {
 		Reset();
 	}
 
+	// Debug changes aren't recorded, a game that used them won't replay the same
 	static int count;
 	if (ImGui::Button("Spawn Enemy")) {
 		for (int i = 0; i < count; ++i) {
-			Enemy e(
-				s_Player->GetPosition(),
-				s_Player->GetDirection(),
-				s_Player,
-				s_ShipAtlas
-			);
-			s_Enemies.push_back(e);
+			s_Enemies->Spawn(s_Player->GetPosition(), s_Player->GetDirection());
 		}
 	}
 	ImGui::SameLine();
 	ImGui::InputInt("Count", &count);
 	ImGui::Checkbox("Enable Enemy Spawner", &s_EnableEnemySpawner);
 
+	ImGui::Text("Recording: %i ticks ( seed %u )", s_Recording.GetTickCount(), s_Recording.GetSeed());
+	if (s_CurrentGameState == GameState::Game && ImGui::Button("Save Recording")) {
+		s_Recording.SetFinalHash(HashGameState());
+		if (!s_Recording.Save(s_RecordingPath)) std::cout << "Failed to save recording to " << s_RecordingPath << std::endl;
+	}
+
 	auto window = Application::Get()->GetWindow();
 	bool temp = window->GetVSync();
 	ImGui::Checkbox("VSync", &temp);
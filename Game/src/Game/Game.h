@@ -1,5 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <string>
+#include <vector>
 #include "Renderer/Texture.h"
 #include "Renderer/Camera.h"
 #include "Core/Event/Event.h"
@@ -17,10 +19,25 @@ public:
 	void StartUp();
 	void Shutdown();
 
+	// Called once per simulation tick, deltaTime is always the tick length
 	void Update(float deltaTime);
-	void Render();
+	// alpha is how far the frame is between the last tick and the next one
+	void Render(float alpha);
 	void OnImGui();
 
+	// Runs a recorded game headless and prints ticks/sec and a hash of the final state.
+	// Returns non zero if the recording couldn't be loaded or the hash doesn't match the one it was saved with
+	static int Replay(const std::string& path);
+	// Fills a game without a window with far more than a wave spawns and prints how long it takes, run by --check
+	static void TimeSimulation();
+
+	// Every image packed into the texture atlas at start up
+	struct AtlasImage {
+		std::string Path;
+		bool FlipY;
+	};
+	static const std::vector<AtlasImage>& GetAtlasImages();
+
 private:
 	
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "InputRecording.h"
+#include <fstream>
+
+namespace {
+	const char Magic[4] = { 'I', 'N', 'P', 'T' };
+	const uint32_t Version = 1;
+	// Keys, FireCount, AimX and AimY
+	const uint64_t FrameSize = sizeof(uint8_t) * 2 + sizeof(int16_t) * 2;
+
+	template<typename T>
+	void Write(std::ofstream& file, const T& value) {
+		file.write((const char*)&value, sizeof(T));
+	}
+	template<typename T>
+	bool Read(std::ifstream& file, T& value) {
+		return (bool)file.read((char*)&value, sizeof(T));
+	}
+}
+
+void InputRecording::Begin(uint32_t seed, float tickLength)
+{
+	m_Seed = seed;
+	m_TickLength = tickLength;
+	m_FinalHash = 0;
+	m_Frames.clear();
+}
+
+bool InputRecording::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	file.write(Magic, sizeof(Magic));
+	Write(file, Version);
+	Write(file, m_Seed);
+	Write(file, m_TickLength);
+	Write(file, m_FinalHash);
+	Write(file, GetTickCount());
+
+	// Field by field so padding never ends up in the file
+	for (const InputFrame& frame : m_Frames) {
+		Write(file, frame.Keys);
+		Write(file, frame.FireCount);
+		Write(file, frame.AimX);
+		Write(file, frame.AimY);
+	}
+	return (bool)file;
+}
+
+bool InputRecording::Load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	char magic[4];
+	uint32_t version, tickCount;
+	if (!file.read(magic, sizeof(magic)) || std::string(magic, 4) != std::string(Magic, 4)) return false;
+	if (!Read(file, version) || version != Version) return false;
+	if (!Read(file, m_Seed) || !Read(file, m_TickLength) || !Read(file, m_FinalHash) || !Read(file, tickCount)) return false;
+
+	// The count comes from the file, a broken one shouldn't get to allocate more frames than the file has
+	std::streampos framesStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streampos end = file.tellg();
+	if (framesStart < 0 || end < framesStart || (uint64_t)(end - framesStart) < tickCount * FrameSize) return false;
+	file.seekg(framesStart);
+
+	m_Frames.resize(tickCount);
+	for (InputFrame& frame : m_Frames) {
+		if (!Read(file, frame.Keys) || !Read(file, frame.FireCount) || !Read(file, frame.AimX) || !Read(file, frame.AimY)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+// Bits of InputFrame::Keys
+#define INPUT_FRAME_UP    (1 << 0)
+#define INPUT_FRAME_DOWN  (1 << 1)
+#define INPUT_FRAME_LEFT  (1 << 2)
+#define INPUT_FRAME_RIGHT (1 << 3)
+
+// Everything the game simulation reads from the player in one tick. Sampled once before each tick
+// so a run can be played back from the frames alone
+struct InputFrame {
+	uint8_t Keys = 0;
+	// Times fire was pressed since the last tick
+	uint8_t FireCount = 0;
+	// Mouse relative to the player on screen in whole pixels, y down
+	int16_t AimX = 0;
+	int16_t AimY = 0;
+
+	bool IsKeyDown(uint8_t key) const { return (Keys & key) != 0; }
+	glm::vec2 GetAim() const { return { (float)AimX, (float)AimY }; }
+};
+
+// The input of one game, tick by tick, along with what's needed to run it again: the seed it started
+// with, the tick length and the hash of the game state after the last tick.
+// Saved as a small header followed by 6 bytes a tick
+class InputRecording {
+public:
+	void Begin(uint32_t seed, float tickLength);
+	void Add(const InputFrame& frame) { m_Frames.push_back(frame); }
+	void SetFinalHash(uint64_t hash) { m_FinalHash = hash; }
+
+	// Both return false if the file couldn't be opened or isn't a recording
+	bool Save(const std::string& path) const;
+	bool Load(const std::string& path);
+
+	uint32_t GetSeed() const { return m_Seed; }
+	float GetTickLength() const { return m_TickLength; }
+	uint64_t GetFinalHash() const { return m_FinalHash; }
+	uint32_t GetTickCount() const { return (uint32_t)m_Frames.size(); }
+	const InputFrame& GetFrame(uint32_t tick) const { return m_Frames[tick]; }
+
+private:
+	uint32_t m_Seed = 0;
+	float m_TickLength = 0.0f;
+	uint64_t m_FinalHash = 0;
+	std::vector<InputFrame> m_Frames;
+};
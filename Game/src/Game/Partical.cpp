@@ -1,131 +1,216 @@
 #include "Partical.h"
+#include <cmath>
 #include "Renderer/Renderer.h"
 
-Partical::Partical(const glm::vec2& position, const glm::vec2& scale,
-	const glm::vec2& direction, float rotation,
-	Texture* atlas, const glm::vec2& atlasSize, const glm::vec2& texID,
-	std::vector<Partical*>* particals)
+DebrisPool::DebrisPool(uint32_t capacity, Texture* atlas)
 {
-	m_Position = position;
-	m_Scale = scale;
-	m_Direction = direction;
-	m_Rotation = rotation;
-
 	m_Atlas = atlas;
-	m_TextureID = texID;
-	m_AtlasSize = atlasSize;
-
-	m_Particals = particals;
-}
+	m_Count = 0;
+	m_Capacity = capacity;
 
-Debris::Debris(const glm::vec2& position, const glm::vec2& direction, 
-			   Texture* atlas, const glm::vec2& atlasSize, const glm::vec2& texID,
-			   std::vector<Partical*>* particals)
-	:Partical(position, {0.25f, 0.25f}, direction, 0.0f, atlas, atlasSize, texID, particals)
-{
-	m_Rotation = atan2(-m_Direction.x, m_Direction.y);
-
-	m_Speed = 1.0f;
+	m_Scale = { 0.25f, 0.25f };
 	m_LeadOut = 0.0f;
-	m_LifeSpan = 25.0f;
-}
-bool Debris::OnUpdate(float deltaTime)
-{
-	if (m_LifeSpan <= 0.0f) return true;
-	m_LifeSpan -= deltaTime;
-
-	m_Position += m_Direction * (m_Speed * deltaTime);
-	m_Speed -= m_LeadOut * deltaTime;
-	if (m_Speed < 0.0f) m_Speed = 0.0f;
 
-	return false;
+	m_PositionX.resize(capacity);
+	m_PositionY.resize(capacity);
+	m_DirectionX.resize(capacity);
+	m_DirectionY.resize(capacity);
+	m_Speed.resize(capacity);
+	m_LifeSpan.resize(capacity);
+	m_Rotation.resize(capacity);
+	m_TextureX.resize(capacity);
+	m_TextureY.resize(capacity);
 }
-void Debris::Render()
+
+bool DebrisPool::Spawn(const glm::vec2& position, const glm::vec2& direction, const glm::vec2& texID)
 {
-	Renderer::DrawQuadAtlas(m_Position, m_Scale, m_Rotation, m_Atlas, m_AtlasSize, m_TextureID);
+	if (m_Count == m_Capacity) return false;
+
+	uint32_t i = m_Count++;
+	m_PositionX[i] = position.x;
+	m_PositionY[i] = position.y;
+	m_DirectionX[i] = direction.x;
+	m_DirectionY[i] = direction.y;
+	m_Speed[i] = 1.0f;
+	m_LifeSpan[i] = 25.0f;
+	m_Rotation[i] = atan2(-direction.x, direction.y);
+	m_TextureX[i] = (uint8_t)texID.x;
+	m_TextureY[i] = (uint8_t)texID.y;
+	return true;
 }
 
-void Debris::SpawnShipDebris(int type, int count, glm::vec2 position, Texture* atlas, std::vector<Partical*>* particals)
+void DebrisPool::SpawnShipDebris(int type, int count, const glm::vec2& position)
 {
 	for (int i = 0; i < count; ++i) {
-		float r = (rand() % (int)(1000 / (i + 1)));
+		float r = (float)m_Random.Next(1000 / (i + 1));
 		glm::vec2 dir = { cos(r), sin(r) };
 		dir = glm::normalize(dir);
 
 		glm::vec2 texID = { 0,0 };
 		if (type < 4) {
 			texID = {
-				(rand() % 3),
+				(float)m_Random.Next(3),
 				type
 			};
 		}
 		else if (type == 5) {
 			texID = {
 				5,
-				(rand() % 4)
+				(float)m_Random.Next(4)
 			};
 		}
 
-		Debris* debris = new Debris(position, dir, atlas, { 4,4 }, texID, particals);
-		particals->push_back(debris);
+		if (!Spawn(position, dir, texID)) return;
 	}
 }
 
-AnimatedPartical::AnimatedPartical(const glm::vec2& position, const glm::vec2& scale,
-				 const glm::vec2& direction, float rotation,
-				 int frameCount, float frameDuration,
-				 Texture* atlas, const glm::vec2& atlasSize,
-				 std::vector<Partical*>* particals)
-	: Partical(position, scale, direction, rotation, atlas, atlasSize, { 0, 0 }, particals)
+void DebrisPool::OnUpdate(float deltaTime)
 {
-	m_CurrentFrame = 0;
-	m_FrameCount = frameCount;
-	m_FrameDuration = frameDuration;
-	m_Time = m_FrameDuration;
-}
-bool AnimatedPartical::OnUpdate(float deltaTime) {
-	UpdateAnimation(deltaTime);
-	return false;
+	// No branches so the compiler can do several at once
+	float* positionX = m_PositionX.data();
+	float* positionY = m_PositionY.data();
+	const float* directionX = m_DirectionX.data();
+	const float* directionY = m_DirectionY.data();
+	float* speed = m_Speed.data();
+	float* lifeSpan = m_LifeSpan.data();
+	float leadOut = m_LeadOut * deltaTime;
+	for (uint32_t i = 0; i < m_Count; ++i) {
+		float distance = speed[i] * deltaTime;
+		positionX[i] += directionX[i] * distance;
+		positionY[i] += directionY[i] * distance;
+		float newSpeed = speed[i] - leadOut;
+		speed[i] = newSpeed < 0.0f ? 0.0f : newSpeed;
+		lifeSpan[i] -= deltaTime;
+	}
+
+	for (uint32_t i = 0; i < m_Count;) {
+		if (lifeSpan[i] <= 0.0f) Remove(i);
+		else ++i;
+	}
 }
-void AnimatedPartical::Render() {
-	RenderAnimation();
+
+void DebrisPool::Render()
+{
+	for (uint32_t i = 0; i < m_Count; ++i) {
+		Renderer::DrawQuadAtlas({ m_PositionX[i], m_PositionY[i] }, m_Scale, m_Rotation[i], m_Atlas, { 4,4 }, { (float)m_TextureX[i], (float)m_TextureY[i] });
+	}
 }
-void AnimatedPartical::UpdateAnimation(float deltaTime)
+
+void DebrisPool::Render(SpriteBatch& batch)
 {
-	if (m_CurrentFrame == m_FrameCount) m_CurrentFrame = 0;
-	if (m_Time <= 0.0f) {
-		m_CurrentFrame += 1;
-		m_Time = m_FrameDuration;
+	// Works out the cell the way the renderer does, without an atlas the whole texture is the 4x4 grid
+	glm::vec2 uvMin = m_Atlas ? m_Atlas->GetUVMin() : glm::vec2(0.0f, 0.0f);
+	glm::vec2 cellSize = (m_Atlas ? m_Atlas->GetUVSize() : glm::vec2(1.0f, 1.0f)) / 4.0f;
+	for (uint32_t i = 0; i < m_Count; ++i) {
+		glm::vec2 cell = uvMin + glm::vec2((float)m_TextureX[i], (float)m_TextureY[i]) * cellSize;
+		batch.Add({ m_PositionX[i], m_PositionY[i] }, m_Scale, m_Rotation[i], cell, cellSize, { 1, 1, 1, 1 });
 	}
-	m_Time -= deltaTime;
 }
-void AnimatedPartical::RenderAnimation()
+
+// The last one takes its place, draw order doesn't matter for debris
+void DebrisPool::Remove(uint32_t index)
+{
+	uint32_t last = --m_Count;
+	m_PositionX[index] = m_PositionX[last];
+	m_PositionY[index] = m_PositionY[last];
+	m_DirectionX[index] = m_DirectionX[last];
+	m_DirectionY[index] = m_DirectionY[last];
+	m_Speed[index] = m_Speed[last];
+	m_LifeSpan[index] = m_LifeSpan[last];
+	m_Rotation[index] = m_Rotation[last];
+	m_TextureX[index] = m_TextureX[last];
+	m_TextureY[index] = m_TextureY[last];
+}
+
+ExplosionPool::ExplosionPool(uint32_t capacity, Texture* atlas, DebrisPool* debris)
 {
-	Renderer::DrawQuadAtlas(m_Position, m_Scale, m_Rotation, m_Atlas, m_AtlasSize, FindFramePosition(m_CurrentFrame));
+	m_Atlas = atlas;
+	m_Debris = debris;
+	m_Count = 0;
+	m_Capacity = capacity;
+
+	m_Scale = { 0.5f, 0.5f };
+	m_AtlasSize = { 3, 4 };
+	m_FrameCount = 10;
+	m_FrameDuration = 0.05f;
+	m_DebrisFrame = m_FrameCount - 5;
+
+	m_PositionX.resize(capacity);
+	m_PositionY.resize(capacity);
+	m_Time.resize(capacity);
+	m_ShipType.resize(capacity);
+	m_SpawnedDebris.resize(capacity);
 }
-glm::vec2 AnimatedPartical::FindFramePosition(int frame)
+
+bool ExplosionPool::Spawn(const glm::vec2& position, int shipType)
 {
-	glm::vec2 texID = { 0,0 };
-	texID.x = m_CurrentFrame % (int)m_AtlasSize.x;
-	texID.y = floor(m_CurrentFrame / m_AtlasSize.x);
-	return texID;
+	if (m_Count == m_Capacity) return false;
+
+	uint32_t i = m_Count++;
+	m_PositionX[i] = position.x;
+	m_PositionY[i] = position.y;
+	m_Time[i] = 0.0f;
+	m_ShipType[i] = shipType;
+	m_SpawnedDebris[i] = 0;
+	return true;
 }
 
-Explosion::Explosion(const glm::vec2& position, 
-					 int shipType, Texture* atlas, Texture* debrisAtlas,
-					 std::vector<Partical*>* particals)
-	: AnimatedPartical(position, { 0.5f, 0.5f }, { 0.0f, 1.0f, }, 0.0f, 10, 0.05f, atlas, { 3,4 }, particals)
+void ExplosionPool::OnUpdate(float deltaTime)
 {
-	m_DebrisAtlas = debrisAtlas;
-	m_ShipType = shipType;
-	m_SpawnedDebris = false;
+	float* time = m_Time.data();
+	for (uint32_t i = 0; i < m_Count; ++i) time[i] += deltaTime;
+
+	for (uint32_t i = 0; i < m_Count;) {
+		int frame = (int)(time[i] / m_FrameDuration);
+		if (frame >= m_DebrisFrame && !m_SpawnedDebris[i]) {
+			m_Debris->SpawnShipDebris(m_ShipType[i], 3, { m_PositionX[i], m_PositionY[i] });
+			m_SpawnedDebris[i] = 1;
+		}
+		if (frame >= m_FrameCount) Remove(i);
+		else ++i;
+	}
 }
-bool Explosion::OnUpdate(float deltaTime) {
-	UpdateAnimation(deltaTime);
-	if (m_CurrentFrame == (m_FrameCount - 5) && m_SpawnedDebris == false) {
-		Debris::SpawnShipDebris(m_ShipType, 3, m_Position, m_DebrisAtlas, m_Particals);
-		m_SpawnedDebris = true;
+
+void ExplosionPool::Render()
+{
+	int across = (int)m_AtlasSize.x;
+	for (uint32_t i = 0; i < m_Count; ++i) {
+		int frame = (int)(m_Time[i] / m_FrameDuration);
+		glm::vec2 texID = { (float)(frame % across), (float)(frame / across) };
+		Renderer::DrawQuadAtlas({ m_PositionX[i], m_PositionY[i] }, m_Scale, 0.0f, m_Atlas, m_AtlasSize, texID);
 	}
-	if (m_CurrentFrame == m_FrameCount) return true;
-	return false;
-}
\ No newline at end of file
+}
+
+void ExplosionPool::Remove(uint32_t index)
+{
+	uint32_t last = --m_Count;
+	m_PositionX[index] = m_PositionX[last];
+	m_PositionY[index] = m_PositionY[last];
+	m_Time[index] = m_Time[last];
+	m_ShipType[index] = m_ShipType[last];
+	m_SpawnedDebris[index] = m_SpawnedDebris[last];
+}
+
+ParticalSystem::ParticalSystem(Texture* debrisAtlas, Texture* explosionAtlas)
+	: Debris(MAX_DEBRIS_PARTICALS, debrisAtlas), Explosions(MAX_EXPLOSION_PARTICALS, explosionAtlas, &Debris)
+{
+}
+
+void ParticalSystem::OnUpdate(float deltaTime)
+{
+	// Explosions first so the debris they throw out moves this frame too
+	Explosions.OnUpdate(deltaTime);
+	Debris.OnUpdate(deltaTime);
+}
+
+void ParticalSystem::Render()
+{
+	Debris.Render();
+	Explosions.Render();
+}
+
+void ParticalSystem::Clear()
+{
+	Debris.Clear();
+	Explosions.Clear();
+}
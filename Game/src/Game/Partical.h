@@ -1,84 +1,114 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+#include "Core/Random.h"
 #include "Renderer/Texture.h"
+#include "Renderer/SpriteBatch.h"
 
-class Partical {
+// Most particals of each kind alive at once, spawning more than this does nothing
+#define MAX_DEBRIS_PARTICALS    4096
+#define MAX_EXPLOSION_PARTICALS 512
+
+// Pieces of a destroyed ship, they fly off in a straight line until their life span runs out.
+// Every field is its own array so updating them is a few straight loops, dead debris is swapped with the last one
+class DebrisPool {
 public:
-	Partical(const glm::vec2& position, const glm::vec2& scale, 
-			 const glm::vec2& direction, float rotation,
-			 Texture* atlas, const glm::vec2& atlasSize, const glm::vec2& texID,
-			 std::vector<Partical*>* particals);
+	DebrisPool(uint32_t capacity, Texture* atlas);
 
-	// Return true to destroy partical
-	virtual bool OnUpdate(float deltaTime) = 0;
-	virtual void Render() = 0;
+	// Returns false if the pool is full
+	bool Spawn(const glm::vec2& position, const glm::vec2& direction, const glm::vec2& texID);
+	// Emitter for when a ship is destroyed, count pieces in random directions using the ship type's row of the atlas
+	void SpawnShipDebris(int type, int count, const glm::vec2& position);
+	// Stream the emitter picks directions and pieces from
+	void SetRandom(const Random& random) { m_Random = random; }
 
-protected:
-	glm::vec2 m_Position;
-	glm::vec2 m_Scale;
-	glm::vec2 m_Direction;
-	float m_Rotation;
+	void OnUpdate(float deltaTime);
+	void Render();
+	// The same sprites Render draws added to batch instead, doesn't touch OpenGL so it can run without a window
+	void Render(SpriteBatch& batch);
+	void Clear() { m_Count = 0; }
 
-	Texture* m_Atlas;
-	glm::vec2 m_AtlasSize;
-	glm::vec2 m_TextureID;
+	uint32_t GetCount() { return m_Count; }
+	uint32_t GetCapacity() { return m_Capacity; }
 
-	std::vector<Partical*>* m_Particals;
-};
-
-class Debris : public Partical {
-public:
-	Debris(const glm::vec2& position, const glm::vec2& direction, 
-		   Texture* atlas, const glm::vec2& atlasSize, const glm::vec2& texID,
-		   std::vector<Partical*>* particals);
-
-	virtual bool OnUpdate(float deltaTime) override;
-	virtual void Render() override;
-
-	static void SpawnShipDebris(int type, int count, glm::vec2 position, Texture* atlas, std::vector<Partical*>* particals);
+private:
+	void Remove(uint32_t index);
 
 private:
-	float m_Speed;
+	Texture* m_Atlas;
+	uint32_t m_Count;
+	uint32_t m_Capacity;
+	Random m_Random;
+
+	// Same for every piece of debris
+	glm::vec2 m_Scale;
 	float m_LeadOut;
-	float m_LifeSpan;
+
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	std::vector<float> m_DirectionX;
+	std::vector<float> m_DirectionY;
+	std::vector<float> m_Speed;
+	std::vector<float> m_LifeSpan;
+	std::vector<float> m_Rotation;
+	std::vector<uint8_t> m_TextureX;
+	std::vector<uint8_t> m_TextureY;
 };
 
-class AnimatedPartical : public Partical {
+// Explosion animations, debris is thrown out part way through
+class ExplosionPool {
 public:
-	AnimatedPartical(const glm::vec2& position, const glm::vec2& scale,
-					 const glm::vec2& direction, float rotation,
-					 int frameCount, float frameDuration,
-					 Texture* atlas, const glm::vec2& atlasSize,
-					 std::vector<Partical*>* particals);
+	ExplosionPool(uint32_t capacity, Texture* atlas, DebrisPool* debris);
 
-	virtual bool OnUpdate(float deltaTime) override;
-	virtual void Render() override;
+	// Returns false if the pool is full
+	bool Spawn(const glm::vec2& position, int shipType);
 
-protected:
-	void UpdateAnimation(float deltaTime);
-	void RenderAnimation();
+	void OnUpdate(float deltaTime);
+	void Render();
+	// The same sprites Render draws added to batch instead, doesn't touch OpenGL so it can run without a window
+	void Render(SpriteBatch& batch);
+	void Clear() { m_Count = 0; }
 
-	glm::vec2 FindFramePosition(int frame);
+	uint32_t GetCount() { return m_Count; }
+	uint32_t GetCapacity() { return m_Capacity; }
 
-protected:
-	int m_CurrentFrame;
-	int m_FrameCount;
+private:
+	void Remove(uint32_t index);
 
+private:
+	Texture* m_Atlas;
+	DebrisPool* m_Debris;
+	uint32_t m_Count;
+	uint32_t m_Capacity;
+
+	// Same for every explosion
+	glm::vec2 m_Scale;
+	glm::vec2 m_AtlasSize;
+	int m_FrameCount;
 	float m_FrameDuration;
-	float m_Time;
+	int m_DebrisFrame;
+
+	std::vector<float> m_PositionX;
+	std::vector<float> m_PositionY;
+	std::vector<float> m_Time;
+	std::vector<int> m_ShipType;
+	std::vector<uint8_t> m_SpawnedDebris;
 };
 
-class Explosion : public AnimatedPartical {
+// Every partical pool the game uses
+class ParticalSystem {
 public:
-	Explosion(const glm::vec2& position, 
-		      int shipType, Texture* atlas, Texture* debrisAtlas,
-		      std::vector<Partical*>* particals);
+	ParticalSystem(Texture* debrisAtlas, Texture* explosionAtlas);
 
-	virtual bool OnUpdate(float deltaTime) override;
+	void OnUpdate(float deltaTime);
+	void Render();
+	void Clear();
+	void SetRandom(const Random& random) { Debris.SetRandom(random); }
 
-private:
-	Texture* m_DebrisAtlas;
+	uint32_t GetCount() { return Debris.GetCount() + Explosions.GetCount(); }
 
-	int m_ShipType;
-	bool m_SpawnedDebris;
-};
\ No newline at end of file
+public:
+	DebrisPool Debris;
+	ExplosionPool Explosions;
+};
@@ -1,13 +1,13 @@
 #include "Player.h"
 #include <imgui.h>
-#include "Core/Application.h"
-#include "Core/Input.h"
 #include "Renderer/Renderer.h"
 
 Player::Player(Texture* atlas, Camera* camera) {
 	m_Atlas = atlas;
 	m_Camera = camera;
 	m_Position = { 0,0 };
+	m_PreviousPosition = m_Position;
+	m_Direction = { 1, 0 };
 	m_Rotation = 0;
 	m_IsMoving = false;
 
@@ -18,16 +18,9 @@ Player::Player(Texture* atlas, Camera* camera) {
 	m_Health = 10;
 }
 
-void Player::OnUpdate(std::vector<Bullet>* enemyBullets, float deltaTime) {
-	for (int i = 0; i < enemyBullets->size(); ++i) {
-		Bullet& b = enemyBullets->at(i);
-		if (glm::distance(m_Position, b.GetPosition()) <= (0.25f / 2.0f)) {
-			enemyBullets->erase(enemyBullets->begin() + i);
-			i -= 1;
-			Damage(1);
-		}
-	}
-	
+void Player::OnUpdate(float deltaTime, const InputFrame& input) {
+	m_PreviousPosition = m_Position;
+
 	// Camera
 	glm::vec2 cameraPos = m_Camera->GetPosition();
 	float dist = glm::distance(m_Position, cameraPos);
@@ -46,10 +39,10 @@ void Player::OnUpdate(std::vector<Bullet>* enemyBullets, float deltaTime) {
 
 	// Player
 	glm::vec2 move = { 0, 0 };
-	if (Input::IsKeyPressed(KEY_W)) move.y = 1;
-	if (Input::IsKeyPressed(KEY_S)) move.y = -1;
-	if (Input::IsKeyPressed(KEY_A)) move.x = -1;
-	if (Input::IsKeyPressed(KEY_D)) move.x = 1;
+	if (input.IsKeyDown(INPUT_FRAME_UP)) move.y = 1;
+	if (input.IsKeyDown(INPUT_FRAME_DOWN)) move.y = -1;
+	if (input.IsKeyDown(INPUT_FRAME_LEFT)) move.x = -1;
+	if (input.IsKeyDown(INPUT_FRAME_RIGHT)) move.x = 1;
 
 	if (move.x != 0 || move.y != 0) {
 		move = glm::normalize(move);
@@ -60,20 +53,15 @@ void Player::OnUpdate(std::vector<Bullet>* enemyBullets, float deltaTime) {
 	else m_IsMoving = false;
 
 	// Player rotation
-	glm::vec2 mousePos = {
-		Input::GetMouseX(),
-		Input::GetMouseY()
-	};
-	glm::vec2 playerScreenPos = m_Camera->ScreenSpacePos(m_Position);
-	glm::vec2 mouseDir = mousePos - playerScreenPos;
+	glm::vec2 mouseDir = input.GetAim();
 	if (glm::length(mouseDir) == 0.0f) mouseDir = { 1, 0 };
 	else mouseDir = glm::normalize(mouseDir);
 	m_Direction = mouseDir;
 	m_Rotation = atan2(mouseDir.x, mouseDir.y);
 }
 
-void Player::Render() {
-	Renderer::DrawQuadAtlas(m_Position, { 0.25f,0.25f }, m_Rotation, m_Atlas, { 5, 2 }, { 1, 1 });
+void Player::Render(float alpha) {
+	Renderer::DrawQuadAtlas(GetInterpolatedPosition(alpha), { 0.25f,0.25f }, m_Rotation, m_Atlas, { 5, 2 }, { 1, 1 });
 }
 
 void Player::OnImGui()
@@ -2,19 +2,21 @@
 #include <glm/glm.hpp>
 #include "Renderer/Texture.h"
 #include "Renderer/Camera.h"
-#include "Bullet.h"
+#include "InputRecording.h"
 
 class Player {
 public:
 	Player(Texture* atlas, Camera* camera);
 
-	void OnUpdate(std::vector<Bullet>* enemyBullets, float deltaTime);
+	void OnUpdate(float deltaTime, const InputFrame& input);
 
-	void Render();
+	// alpha is how far between the last two ticks to draw the player
+	void Render(float alpha);
 	void OnImGui();
 
 	void SetPosition(const glm::vec2& pos) { m_Position = pos; }
 	const glm::vec2& GetPosition() { return m_Position; }
+	glm::vec2 GetInterpolatedPosition(float alpha) { return m_PreviousPosition + (m_Position - m_PreviousPosition) * alpha; }
 	const glm::vec2& GetDirection() { return m_Direction; }
 	float GetRotation() { return m_Rotation; }
 	bool IsMoving() { return m_IsMoving; }
@@ -26,6 +28,7 @@ private:
 	Texture* m_Atlas;
 	Camera* m_Camera;
 	glm::vec2 m_Position;
+	glm::vec2 m_PreviousPosition;
 	glm::vec2 m_Direction;
 	float m_Rotation;
 	bool m_IsMoving;
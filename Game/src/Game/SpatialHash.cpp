@@ -0,0 +1,103 @@
+#include "SpatialHash.h"
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize)
+{
+	m_CellSize = cellSize;
+	m_InverseCellSize = 1.0f / cellSize;
+	m_TableMask = 0;
+}
+
+int32_t SpatialHash::CellCoord(float value) const
+{
+	return (int32_t)std::floor(value * m_InverseCellSize);
+}
+
+uint32_t SpatialHash::Hash(int32_t x, int32_t y) const
+{
+	return (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & m_TableMask;
+}
+
+void SpatialHash::Build(const glm::vec2* points, uint32_t count)
+{
+	// About two slots a point keeps shared slots rare, a power of two so the hash is a mask
+	uint32_t tableSize = 64;
+	while (tableSize < count * 2) tableSize *= 2;
+	m_TableMask = tableSize - 1;
+
+	m_SlotStart.assign(tableSize + 1, 0);
+	m_PointSlots.resize(count);
+	m_PointCellX.resize(count);
+	m_PointCellY.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		m_PointCellX[i] = CellCoord(points[i].x);
+		m_PointCellY[i] = CellCoord(points[i].y);
+		uint32_t slot = Hash(m_PointCellX[i], m_PointCellY[i]);
+		m_PointSlots[i] = slot;
+		m_SlotStart[slot + 1] += 1;
+	}
+	for (uint32_t slot = 0; slot < tableSize; ++slot) m_SlotStart[slot + 1] += m_SlotStart[slot];
+
+	m_Points.resize(count);
+	m_Indices.resize(count);
+	m_CellX.resize(count);
+	m_CellY.resize(count);
+	// Points go in the order they were given so each slot stays sorted by index
+	m_SlotNext.assign(m_SlotStart.begin(), m_SlotStart.end() - 1);
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t at = m_SlotNext[m_PointSlots[i]]++;
+		m_Points[at] = points[i];
+		m_Indices[at] = i;
+		m_CellX[at] = m_PointCellX[i];
+		m_CellY[at] = m_PointCellY[i];
+	}
+}
+
+void SpatialHash::QueryFirst(const glm::vec2* queries, uint32_t count, float radius, uint32_t* results) const
+{
+	float radiusSquared = radius * radius;
+	for (uint32_t q = 0; q < count; ++q) {
+		const glm::vec2& position = queries[q];
+		uint32_t best = SPATIAL_HASH_NONE;
+		if (!m_Points.empty()) {
+			int32_t minX = CellCoord(position.x - radius), maxX = CellCoord(position.x + radius);
+			int32_t minY = CellCoord(position.y - radius), maxY = CellCoord(position.y + radius);
+			for (int32_t y = minY; y <= maxY; ++y) {
+				for (int32_t x = minX; x <= maxX; ++x) {
+					uint32_t slot = Hash(x, y);
+					for (uint32_t i = m_SlotStart[slot]; i < m_SlotStart[slot + 1]; ++i) {
+						// Slot is sorted by index, nothing further on can beat what's already been found
+						if (m_Indices[i] >= best) break;
+						if (m_CellX[i] != x || m_CellY[i] != y) continue;
+						glm::vec2 offset = m_Points[i] - position;
+						if (offset.x * offset.x + offset.y * offset.y <= radiusSquared) {
+							best = m_Indices[i];
+							break;
+						}
+					}
+				}
+			}
+		}
+		results[q] = best;
+	}
+}
+
+void SpatialHash::Query(const glm::vec2& position, float radius, std::vector<uint32_t>& results) const
+{
+	if (m_Points.empty()) return;
+
+	float radiusSquared = radius * radius;
+	int32_t minX = CellCoord(position.x - radius), maxX = CellCoord(position.x + radius);
+	int32_t minY = CellCoord(position.y - radius), maxY = CellCoord(position.y + radius);
+	for (int32_t y = minY; y <= maxY; ++y) {
+		for (int32_t x = minX; x <= maxX; ++x) {
+			uint32_t slot = Hash(x, y);
+			for (uint32_t i = m_SlotStart[slot]; i < m_SlotStart[slot + 1]; ++i) {
+				// Another cell that landed in the same slot
+				if (m_CellX[i] != x || m_CellY[i] != y) continue;
+				glm::vec2 offset = m_Points[i] - position;
+				if (offset.x * offset.x + offset.y * offset.y <= radiusSquared) results.push_back(m_Indices[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+
+#define SPATIAL_HASH_NONE UINT32_MAX
+
+// Uniform grid over a set of points, rebuilt every frame. Cells are hashed into a table and the points are
+// counting sorted by cell, so every cell's points sit next to each other. Queries check the cells a circle
+// covers and nothing else. Doesn't touch OpenGL so it can run without a window
+class SpatialHash {
+public:
+	// cellSize should be about the size of the things being tested, queries with a much bigger radius check a lot of cells
+	SpatialHash(float cellSize = 0.5f);
+
+	void Build(const glm::vec2* points, uint32_t count);
+
+	// For every query point, the lowest index point within radius of it or SPATIAL_HASH_NONE
+	void QueryFirst(const glm::vec2* queries, uint32_t count, float radius, uint32_t* results) const;
+	// Appends every point within radius of position
+	void Query(const glm::vec2& position, float radius, std::vector<uint32_t>& results) const;
+
+	uint32_t GetCount() const { return (uint32_t)m_Points.size(); }
+	float GetCellSize() const { return m_CellSize; }
+
+private:
+	int32_t CellCoord(float value) const;
+	uint32_t Hash(int32_t x, int32_t y) const;
+
+private:
+	float m_CellSize;
+	float m_InverseCellSize;
+	uint32_t m_TableMask;
+
+	// Start of each table slot in the sorted arrays, one more than the table size
+	std::vector<uint32_t> m_SlotStart;
+	// Sorted by table slot
+	std::vector<glm::vec2> m_Points;
+	std::vector<uint32_t> m_Indices;
+	// Cell each sorted point is in, slots can be shared by more than one cell
+	std::vector<int32_t> m_CellX;
+	std::vector<int32_t> m_CellY;
+
+	// Scratch for Build, kept so rebuilding every frame doesn't allocate
+	std::vector<uint32_t> m_PointSlots;
+	std::vector<int32_t> m_PointCellX;
+	std::vector<int32_t> m_PointCellY;
+	std::vector<uint32_t> m_SlotNext;
+};
@@ -0,0 +1,123 @@
+#include "AtlasPacker.h"
+#include <algorithm>
+
+AtlasPacker::AtlasPacker(uint32_t pageWidth, uint32_t pageHeight, uint32_t padding)
+{
+	m_PageWidth = pageWidth;
+	m_PageHeight = pageHeight;
+	m_Padding = padding;
+	m_UsedArea = 0;
+}
+
+bool AtlasPacker::Pack(std::vector<AtlasRect>& rects)
+{
+	// Tall rectangles first leave a flatter skyline for the short ones
+	std::vector<uint32_t> order(rects.size());
+	for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (rects[a].Height != rects[b].Height) return rects[a].Height > rects[b].Height;
+		return rects[a].Width > rects[b].Width;
+	});
+
+	bool packed = true;
+	for (uint32_t i : order) {
+		AtlasRect& rect = rects[i];
+		uint32_t width = rect.Width + m_Padding * 2;
+		uint32_t height = rect.Height + m_Padding * 2;
+		rect.Page = UINT32_MAX;
+
+		if (width > m_PageWidth || height > m_PageHeight) {
+			packed = false;
+			continue;
+		}
+
+		size_t index = 0;
+		uint32_t y = 0;
+		uint32_t page = 0;
+		for (; page < m_Pages.size(); ++page) {
+			if (FindPosition(m_Pages[page], width, height, &index, &y)) break;
+		}
+		if (page == m_Pages.size()) {
+			m_Pages.push_back({ { 0, 0, m_PageWidth } });
+			index = 0;
+			y = 0;
+		}
+
+		rect.Page = page;
+		rect.X = m_Pages[page][index].X + m_Padding;
+		rect.Y = y + m_Padding;
+		Place(m_Pages[page], index, y, width, height);
+		m_UsedArea += (uint64_t)rect.Width * rect.Height;
+	}
+	return packed;
+}
+
+float AtlasPacker::GetOccupancy() const
+{
+	if (m_Pages.empty()) return 0.0f;
+	return (float)((double)m_UsedArea / ((double)m_PageWidth * m_PageHeight * m_Pages.size()));
+}
+
+// Where the rectangle would sit if its left edge was at the start of segment index
+bool AtlasPacker::Fit(const Skyline& skyline, size_t index, uint32_t width, uint32_t height, uint32_t* y) const
+{
+	uint32_t x = skyline[index].X;
+	if (x + width > m_PageWidth) return false;
+
+	uint32_t top = 0;
+	uint32_t covered = 0;
+	for (size_t i = index; covered < width; ++i) {
+		top = std::max(top, skyline[i].Y);
+		covered += skyline[i].Width;
+	}
+	if (top + height > m_PageHeight) return false;
+
+	*y = top;
+	return true;
+}
+
+// Lowest top edge wins, then the leftmost
+bool AtlasPacker::FindPosition(const Skyline& skyline, uint32_t width, uint32_t height, size_t* index, uint32_t* y) const
+{
+	bool found = false;
+	uint32_t bestTop = UINT32_MAX;
+	for (size_t i = 0; i < skyline.size(); ++i) {
+		uint32_t fitY;
+		if (!Fit(skyline, i, width, height, &fitY)) continue;
+		if (fitY + height < bestTop) {
+			bestTop = fitY + height;
+			*index = i;
+			*y = fitY;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void AtlasPacker::Place(Skyline& skyline, size_t index, uint32_t y, uint32_t width, uint32_t height)
+{
+	uint32_t x = skyline[index].X;
+	skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+	// Cut the segments the rectangle now covers
+	size_t i = index + 1;
+	while (i < skyline.size() && skyline[i].X < x + width) {
+		uint32_t overlap = x + width - skyline[i].X;
+		if (overlap >= skyline[i].Width) {
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+		skyline[i].X += overlap;
+		skyline[i].Width -= overlap;
+		break;
+	}
+
+	// Neighbours at the same height are one segment
+	for (size_t j = 0; j + 1 < skyline.size();) {
+		if (skyline[j].Y == skyline[j + 1].Y) {
+			skyline[j].Width += skyline[j + 1].Width;
+			skyline.erase(skyline.begin() + j + 1);
+		}
+		else ++j;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// A rectangle to pack, Width and Height go in and X, Y and Page come out
+struct AtlasRect {
+	uint32_t Width;
+	uint32_t Height;
+
+	uint32_t X;
+	uint32_t Y;
+	uint32_t Page;
+};
+
+// Skyline packer, every rectangle goes on the lowest part of the skyline it fits on, tallest first.
+// Another page is started when none of the others have room. Doesn't touch OpenGL so it can run without a window
+class AtlasPacker {
+public:
+	// padding is left empty on every side of a rectangle so filtering doesn't pick up its neighbours
+	AtlasPacker(uint32_t pageWidth, uint32_t pageHeight, uint32_t padding = 1);
+
+	// Returns false if a rectangle doesn't fit on an empty page, it's left with Page set to UINT32_MAX
+	bool Pack(std::vector<AtlasRect>& rects);
+
+	uint32_t GetPageCount() const { return (uint32_t)m_Pages.size(); }
+	uint32_t GetPageWidth() const { return m_PageWidth; }
+	uint32_t GetPageHeight() const { return m_PageHeight; }
+	// How much of the pages are covered by rectangles, padding not included
+	float GetOccupancy() const;
+
+private:
+	// Top edge of the packed area from X to X + Width
+	struct Segment {
+		uint32_t X;
+		uint32_t Y;
+		uint32_t Width;
+	};
+	typedef std::vector<Segment> Skyline;
+
+	bool Fit(const Skyline& skyline, size_t index, uint32_t width, uint32_t height, uint32_t* y) const;
+	bool FindPosition(const Skyline& skyline, uint32_t width, uint32_t height, size_t* index, uint32_t* y) const;
+	void Place(Skyline& skyline, size_t index, uint32_t y, uint32_t width, uint32_t height);
+
+private:
+	uint32_t m_PageWidth;
+	uint32_t m_PageHeight;
+	uint32_t m_Padding;
+
+	std::vector<Skyline> m_Pages;
+	uint64_t m_UsedArea;
+};
@@ -20,7 +20,7 @@ void Camera::CalculateView() {
 	m_View = glm::rotate(m_View, m_Rotation, { 0,0,1 });
 	m_View = glm::translate(m_View, { -m_Position, 0 });
 
-	m_ViewProjection = m_Projection * m_View;
+	CalculateViewProjection();
 }
 
 void Camera::CalculateProjection()
@@ -39,7 +39,24 @@ void Camera::CalculateProjection()
 		m_ZoomFrustum.far
 	);
 
+	CalculateViewProjection();
+}
+
+void Camera::CalculateViewProjection()
+{
 	m_ViewProjection = m_Projection * m_View;
+	// Screen to world conversions happen a lot more often than the camera moves
+	m_InverseViewProjection = glm::inverse(m_ViewProjection);
+
+	glm::vec2 corners[] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+	for (int i = 0; i < 4; ++i) {
+		glm::vec4 world = m_InverseViewProjection * glm::vec4(corners[i], 0.0f, 1.0f);
+		if (i == 0) m_WorldBounds = { world.x, world.y, world.x, world.y };
+		m_WorldBounds.x = glm::min(m_WorldBounds.x, world.x);
+		m_WorldBounds.y = glm::min(m_WorldBounds.y, world.y);
+		m_WorldBounds.z = glm::max(m_WorldBounds.z, world.x);
+		m_WorldBounds.w = glm::max(m_WorldBounds.w, world.y);
+	}
 }
 
 void Camera::SetViewFrustum(const ViewFrustum& frustum)
@@ -75,7 +92,7 @@ glm::vec2 Camera::ScreenToWorld(const glm::vec2& v)
 	glm::vec2 projView;
 	projView.x = (v.x * 2) / window->GetWidth() - 1.0f;
 	projView.y = ((window->GetHeight() - v.y) * 2) / window->GetHeight() - 1.0f;
-	return glm::inverse(m_ViewProjection) * glm::vec4(projView, 0.0f, 1.0f);
+	return m_InverseViewProjection * glm::vec4(projView, 0.0f, 1.0f);
 }
 
 ViewFrustum ViewFrustum::CalculateScreenFrustum() 
@@ -24,6 +24,9 @@ public:
 	const glm::mat4& GetView() { return m_View; }
 	const glm::mat4& GetProjection() { return m_Projection; }
 	const glm::mat4& GetViewProjection() { return m_ViewProjection; }
+	const glm::mat4& GetInverseViewProjection() { return m_InverseViewProjection; }
+	// Smallest box around what the camera sees in world space, min x, min y, max x, max y
+	const glm::vec4& GetWorldBounds() { return m_WorldBounds; }
 
 	const ViewFrustum& GetViewFrustum() { return m_Frustum; }
 	const ViewFrustum& GetZoomFrustum() { return m_ZoomFrustum; }
@@ -40,6 +43,10 @@ public:
 	glm::vec2 ScreenSpacePos(const glm::vec2& v);
 	glm::vec2 ScreenToWorld(const glm::vec2& v);
 
+private:
+	// Called whenever the view or projection changes
+	void CalculateViewProjection();
+
 private:
 	glm::vec2 m_Position;
 	float m_Rotation;
@@ -51,4 +58,6 @@ private:
 	glm::mat4 m_Projection;
 	glm::mat4 m_View;
 	glm::mat4 m_ViewProjection;
+	glm::mat4 m_InverseViewProjection;
+	glm::vec4 m_WorldBounds;
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "RenderQueue.h"
+#include <utility>
+#include <algorithm>
+#include "SpriteTransform.h"
+
+namespace {
+	const uint64_t TransparentBit = 1ull << 55;
+
+	uint32_t KeyCamera(uint64_t key) { return (uint32_t)(key >> 56); }
+	bool KeyTransparent(uint64_t key) { return (key & TransparentBit) != 0; }
+	uint32_t KeyTexture(uint64_t key) {
+		return KeyTransparent(key) ? (uint32_t)(key & 0xFFFF) : (uint32_t)((key >> 32) & 0xFFFF);
+	}
+	uint32_t KeySequence(uint64_t key) {
+		return KeyTransparent(key) ? (uint32_t)(key >> 16) : (uint32_t)key;
+	}
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t camera, bool transparent, uint32_t texture, uint32_t sequence)
+{
+	uint64_t key = ((uint64_t)(camera & 0xFF) << 56);
+	texture &= 0xFFFF;
+	if (transparent) return key | TransparentBit | ((uint64_t)sequence << 16) | texture;
+	return key | ((uint64_t)texture << 32) | sequence;
+}
+
+void RenderQueue::Submit(uint32_t camera, bool transparent, uint32_t texture,
+	const glm::vec2& position, const glm::vec2& scale, float rotation, const glm::vec2& uvMin, const glm::vec2& uvSize, const glm::vec4& tint)
+{
+	m_Keys.push_back(MakeKey(camera, transparent, texture, (uint32_t)m_Keys.size()));
+	m_Batch.Add(position, scale, rotation, uvMin, uvSize, tint);
+}
+
+uint32_t RenderQueue::Cull(const glm::vec4* cameraBounds, uint32_t cameraCount)
+{
+	// Sprites are split into separate arrays a block at a time so the bounds can be worked out together
+	const uint32_t blockSize = 64;
+	float positionX[blockSize], positionY[blockSize], scaleX[blockSize], scaleY[blockSize], rotation[blockSize];
+	float minX[blockSize], minY[blockSize], maxX[blockSize], maxY[blockSize];
+	SpriteTransforms block = { positionX, positionY, scaleX, scaleY, rotation };
+
+	// Keys are still in the order they were submitted, so key i is sprite i
+	const SpriteInstance* instances = m_Batch.GetData();
+	uint32_t count = (uint32_t)m_Keys.size();
+	uint32_t kept = 0;
+	for (uint32_t first = 0; first < count; first += blockSize) {
+		uint32_t size = std::min(blockSize, count - first);
+		for (uint32_t i = 0; i < size; ++i) {
+			const SpriteInstance& instance = instances[first + i];
+			positionX[i] = instance.Position.x;
+			positionY[i] = instance.Position.y;
+			scaleX[i] = instance.Scale.x;
+			scaleY[i] = instance.Scale.y;
+			rotation[i] = instance.Rotation;
+		}
+		SpriteTransform::Bounds(block, size, minX, minY, maxX, maxY);
+
+		for (uint32_t i = 0; i < size; ++i) {
+			uint64_t key = m_Keys[first + i];
+			uint32_t camera = KeyCamera(key);
+			if (camera < cameraCount) {
+				const glm::vec4& view = cameraBounds[camera];
+				if (maxX[i] < view.x || minX[i] > view.z || maxY[i] < view.y || minY[i] > view.w) continue;
+			}
+			m_Keys[kept++] = key;
+		}
+	}
+
+	uint32_t culled = count - kept;
+	m_Keys.resize(kept);
+	return culled;
+}
+
+void RenderQueue::Sort()
+{
+	size_t count = m_Keys.size();
+	m_Runs.clear();
+	m_Sorted.resize(count);
+	if (count == 0) return;
+
+	// Least significant byte first, every histogram is counted in one pass and
+	// bytes that are the same in every key are skipped
+	uint32_t histograms[8][256] = {};
+	for (uint64_t key : m_Keys) {
+		for (int pass = 0; pass < 8; ++pass) histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	m_Scratch.resize(count);
+	uint64_t* source = m_Keys.data();
+	uint64_t* destination = m_Scratch.data();
+	for (int pass = 0; pass < 8; ++pass) {
+		uint32_t* histogram = histograms[pass];
+		uint32_t shift = pass * 8;
+		if (histogram[(source[0] >> shift) & 0xFF] == count) continue;
+
+		uint32_t offset = 0;
+		for (int bucket = 0; bucket < 256; ++bucket) {
+			uint32_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (size_t i = 0; i < count; ++i) {
+			uint64_t key = source[i];
+			destination[histogram[(key >> shift) & 0xFF]++] = key;
+		}
+		std::swap(source, destination);
+	}
+	if (source != m_Keys.data()) m_Keys.swap(m_Scratch);
+
+	// The sequence in each key is where its sprite was submitted
+	const SpriteInstance* instances = m_Batch.GetData();
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t key = m_Keys[i];
+		m_Sorted[i] = instances[KeySequence(key)];
+
+		uint32_t camera = KeyCamera(key), texture = KeyTexture(key);
+		bool transparent = KeyTransparent(key);
+		if (!m_Runs.empty()) {
+			RenderRun& run = m_Runs.back();
+			if (run.Camera == camera && run.Texture == texture && run.Transparent == transparent) {
+				run.Count += 1;
+				continue;
+			}
+		}
+		m_Runs.push_back({ camera, texture, transparent, (uint32_t)i, 1 });
+	}
+}
+
+void RenderQueue::Clear()
+{
+	m_Keys.clear();
+	m_Batch.Clear();
+}
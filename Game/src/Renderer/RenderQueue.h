@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "SpriteBatch.h"
+
+// Key bits from the top down
+//   camera ( 8 ) | transparent ( 1 ) | opaque: texture ( 16 ) sequence ( 32 )
+//                                      transparent: sequence ( 32 ) texture ( 16 )
+// Opaque sprites group by texture, transparent ones keep the order they were drawn in
+#define RENDER_KEY_MAX_CAMERAS  256
+#define RENDER_KEY_MAX_TEXTURES 65536
+
+// Sprites next to each other after sorting that can go in one draw call
+struct RenderRun {
+	uint32_t Camera;
+	uint32_t Texture;
+	bool Transparent;
+	uint32_t First;
+	uint32_t Count;
+};
+
+// Every sprite drawn in a frame goes in one list with a sort key, one radix sort at the end of the
+// frame puts sprites that share state together. Doesn't touch OpenGL so it can run without a window
+class RenderQueue {
+public:
+	void Submit(uint32_t camera, bool transparent, uint32_t texture,
+		const glm::vec2& position, const glm::vec2& scale, float rotation, const glm::vec2& uvMin, const glm::vec2& uvSize, const glm::vec4& tint);
+
+	// Drops sprites that are completely outside their camera, cameraBounds is min x, min y, max x, max y
+	// for each camera id. Call before Sort, returns how many were dropped
+	uint32_t Cull(const glm::vec4* cameraBounds, uint32_t cameraCount);
+	// Sorts everything submitted and works out the runs
+	void Sort();
+	void Clear();
+
+	uint32_t GetCount() const { return (uint32_t)m_Keys.size(); }
+	// Valid after Sort
+	const std::vector<SpriteInstance>& GetSorted() const { return m_Sorted; }
+	const std::vector<RenderRun>& GetRuns() const { return m_Runs; }
+
+	static uint64_t MakeKey(uint32_t camera, bool transparent, uint32_t texture, uint32_t sequence);
+
+private:
+	SpriteBatch m_Batch;
+	std::vector<uint64_t> m_Keys;
+	std::vector<uint64_t> m_Scratch;
+	std::vector<SpriteInstance> m_Sorted;
+	std::vector<RenderRun> m_Runs;
+};
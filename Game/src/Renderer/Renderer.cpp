@@ -5,6 +5,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <fstream>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 #include "Core/Application.h"
 #include "Core/System.h"
 
@@ -123,6 +126,9 @@ void Renderer::Init(std::function<void(Event&)> callback) {
 		glDeleteShader(VertexShader);
 		glDeleteShader(FragmentShader);
 		glDeleteShader(AtlasShader);
+
+		s_Data.ViewProjectionLocation = glGetUniformLocation(s_Data.MainShader, "ViewProjection");
+		s_Data.TextureLocation = glGetUniformLocation(s_Data.MainShader, "Texture");
 	}
 
 	// Load Post Proc Shader 
@@ -267,9 +273,8 @@ void Renderer::Init(std::function<void(Event&)> callback) {
 	glGenVertexArrays(1, &s_Data.Quad);
 	glBindVertexArray(s_Data.Quad);
 	
-	unsigned int VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glGenBuffers(1, &s_Data.QuadVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, s_Data.QuadVBO);
 	glBufferData(GL_ARRAY_BUFFER, s_Data.QuadVertices.size() * sizeof(s_Data.QuadVertices[0]), &s_Data.QuadVertices[0], GL_STATIC_DRAW);
 
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
@@ -277,13 +282,36 @@ void Renderer::Init(std::function<void(Event&)> callback) {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	unsigned int EBO;
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glGenBuffers(1, &s_Data.QuadEBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Data.QuadEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, s_Data.QuadIndices.size() * sizeof(uint32_t), &s_Data.QuadIndices[0], GL_STATIC_DRAW);
 
 	glBindVertexArray(0);
 
+	// Sprite VAO, lives as long as the renderer
+	{
+		glGenVertexArrays(1, &s_Data.SpriteVAO);
+		glBindVertexArray(s_Data.SpriteVAO);
+
+		// Corners of the unit quad, once per vertex
+		glBindBuffer(GL_ARRAY_BUFFER, s_Data.QuadVBO);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_Data.QuadEBO);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// Sprites, once per instance
+		s_Data.Instances = new RingBuffer(1024 * sizeof(SpriteInstance));
+		SetInstanceAttributes();
+	}
+
+	s_Data.LastTexture = nullptr;
+	s_Data.LastTextureID = 0;
+
 	// Create blank texture
 	TextureConfig config;
 	config.Width = 1;
@@ -295,13 +323,43 @@ void Renderer::Init(std::function<void(Event&)> callback) {
 	s_Data.DiagnosticInfo.BatchMS = 0;
 	s_Data.DiagnosticInfo.DrawMS = 0;
 	s_Data.DiagnosticInfo.DrawCallCount = 0;
+	s_Data.DiagnosticInfo.BytesPerQuad = sizeof(SpriteInstance);
+	s_Data.DiagnosticInfo.QuadsPerSecond = 0;
+	s_Data.DiagnosticInfo.UploadStallCount = 0;
+	s_Data.DiagnosticInfo.UploadStallMS = 0;
+}
+void Renderer::SetInstanceAttributes()
+{
+	glBindVertexArray(s_Data.SpriteVAO);
+	s_Data.Instances->Bind();
+
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Position));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Scale));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Rotation));
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(5, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, UV));
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, Tint));
+	glEnableVertexAttribArray(6);
+	for (unsigned int attribute = 2; attribute <= 6; ++attribute) glVertexAttribDivisor(attribute, 1);
+
+	glBindVertexArray(0);
+	s_Data.Instances->Unbind();
 }
 
 void Renderer::StartFrame(Camera* camera) {
-	s_Data.CurrentCamera = camera;
+	s_Data.FrameCameras.clear();
+	ChangeCamera(camera);
 	s_Data.DiagnosticInfo.DrawCallCount = 0;
 	s_Data.DiagnosticInfo.RenderGroupCount = 0;
 	s_Data.DiagnosticInfo.QuadCount = 0;
+	s_Data.DiagnosticInfo.CulledQuadCount = 0;
+
+	s_Data.Instances->BeginFrame();
+	s_Data.DiagnosticInfo.UploadStallCount = s_Data.Instances->GetStallCount();
+	s_Data.DiagnosticInfo.UploadStallMS = s_Data.Instances->GetStallMS();
 
 	glClear(GL_COLOR_BUFFER_BIT);
 
@@ -316,105 +374,86 @@ void Renderer::StartFrame(Camera* camera) {
 void Renderer::ChangeCamera(Camera* camera)
 {
 	s_Data.CurrentCamera = camera;
+
+	// Only a couple of cameras are used a frame
+	auto it = std::find(s_Data.FrameCameras.begin(), s_Data.FrameCameras.end(), camera);
+	if (it != s_Data.FrameCameras.end()) {
+		s_Data.CurrentCameraID = (uint32_t)(it - s_Data.FrameCameras.begin());
+		return;
+	}
+	if (s_Data.FrameCameras.size() == RENDER_KEY_MAX_CAMERAS) {
+		ErrorEvent err("Too many cameras in one frame ( " + std::to_string(RENDER_KEY_MAX_CAMERAS) + " max )");
+		s_Data.callback(err);
+		return;
+	}
+	s_Data.CurrentCameraID = (uint32_t)s_Data.FrameCameras.size();
+	s_Data.FrameCameras.push_back(camera);
 }
 void Renderer::EndFrame() {
-	std::vector<int> validRenderGroups;
-	s_Data.DiagnosticInfo.RenderGroupCount = s_Data.RenderGroups.size();
-
-	for (int i = 0; i < s_Data.RenderGroups.size(); ++i) {
-		RenderGroup* rg = s_Data.RenderGroups[i];
-		if (rg->Vertices.size() == 0) { 
-
-			rg->Vertices.clear();
-			rg->Vertices.resize(0);
-			rg->Vertices = std::vector<BatchVertex>();
-
-			rg->Indices.clear();
-			rg->Indices.resize(0);
-			rg->Indices = std::vector<uint32_t>();
-
-			glDeleteBuffers(1, &rg->VBO);
-			glDeleteBuffers(1, &rg->EBO);
-			glDeleteVertexArrays(1, &rg->VAO);
-
-			delete rg;
-			s_Data.RenderGroups.erase(s_Data.RenderGroups.begin() + i);
-			i -= 1;
-			continue; 
-		}
-		
-		if (rg->VAO == (unsigned int)(-1)) {
-			glGenVertexArrays(1, &rg->VAO);
-			glBindVertexArray(rg->VAO);
-
-			glGenBuffers(1, &rg->VBO);
-			glBindBuffer(GL_ARRAY_BUFFER, rg->VBO);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(rg->Vertices[0]) * rg->Vertices.size(), &rg->Vertices[0], GL_DYNAMIC_DRAW);
-
-			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)0);
-			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)(2 * sizeof(float)));
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)(4 * sizeof(float)));
-			glEnableVertexAttribArray(2);
-			glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)(6 * sizeof(float)));
-			glEnableVertexAttribArray(3);
-
-			glGenBuffers(1, &rg->EBO);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rg->EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * rg->Indices.size(), &rg->Indices[0], GL_DYNAMIC_DRAW);
-		
-			glBindVertexArray(0);
-		}
-		else if(rg->Vertices.size() == rg->LastVertexCount) {
-			glBindVertexArray(rg->VAO);
-
-			glBindBuffer(GL_ARRAY_BUFFER, rg->VBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, rg->Vertices.size() * sizeof(BatchVertex), &rg->Vertices[0]);
-			
-			glBindVertexArray(0);
-		}
-		else {
-			glBindVertexArray(rg->VAO);
-
-			glBindBuffer(GL_ARRAY_BUFFER, rg->VBO);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(rg->Vertices[0]) * rg->Vertices.size(), &rg->Vertices[0], GL_DYNAMIC_DRAW);
-			
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rg->EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * rg->Indices.size(), &rg->Indices[0], GL_DYNAMIC_DRAW);
-		
-			glBindVertexArray(0);
-		}
-		
-		rg->LastVertexCount = rg->Vertices.size();
-		validRenderGroups.push_back(i);
+	s_Data.FrameCameraBounds.clear();
+	for (Camera* camera : s_Data.FrameCameras) s_Data.FrameCameraBounds.push_back(camera->GetWorldBounds());
+	s_Data.DiagnosticInfo.CulledQuadCount = s_Data.Queue.Cull(s_Data.FrameCameraBounds.data(), (uint32_t)s_Data.FrameCameraBounds.size());
+
+	s_Data.Queue.Sort();
+	const std::vector<RenderRun>& runs = s_Data.Queue.GetRuns();
+	const std::vector<SpriteInstance>& instances = s_Data.Queue.GetSorted();
+	s_Data.DiagnosticInfo.RenderGroupCount = runs.size();
+
+	// Written straight into this frame's part of the ring, the runs are drawn from where it landed
+	uint32_t firstInstance = 0;
+	if (!instances.empty()) {
+		uint32_t bytes = (uint32_t)(instances.size() * sizeof(SpriteInstance));
+		// At least doubles so the buffer settles after a few frames
+		if (s_Data.Instances->Reserve(bytes)) SetInstanceAttributes();
+
+		uint32_t offset;
+		void* destination = s_Data.Instances->Allocate(bytes, sizeof(SpriteInstance), &offset);
+		std::memcpy(destination, instances.data(), bytes);
+		s_Data.Instances->Flush();
+		firstInstance = offset / sizeof(SpriteInstance);
 	}
 
 	s_Data.DiagnosticInfo.BatchMS = (System::GetTime() - s_Data.DiagnosticInfo.StartBatchMS) * 1000.0f;
+	if (s_Data.DiagnosticInfo.BatchMS > 0.0f) {
+		s_Data.DiagnosticInfo.QuadsPerSecond = s_Data.DiagnosticInfo.QuadCount / (s_Data.DiagnosticInfo.BatchMS / 1000.0f);
+	}
 
 	float startMS = System::GetTime();
 
 	glUseProgram(s_Data.MainShader);
+	glUniform1i(s_Data.TextureLocation, 0);
+	glBindVertexArray(s_Data.SpriteVAO);
+	glActiveTexture(GL_TEXTURE0);
 
-	for (int& id : validRenderGroups) {
-		RenderGroup* rg = s_Data.RenderGroups[id];
-		
-		unsigned int viewproj_loc = glGetUniformLocation(s_Data.MainShader, "ViewProjection");
-		unsigned int AtlasSize_loc = glGetUniformLocation(s_Data.MainShader, "AtlasSize");
-		unsigned int texture_loc = glGetUniformLocation(s_Data.MainShader, "Texture");
-		glm::mat4 viewproj = rg->Camera->GetViewProjection();
-		glUniformMatrix4fv(viewproj_loc, 1, GL_FALSE, glm::value_ptr(viewproj));
-		glUniform2f(AtlasSize_loc, rg->AtlasSize.x, rg->AtlasSize.y);
-		glUniform1i(texture_loc, 0);
-
-		glBindVertexArray(rg->VAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, rg->Texture->GetHandle());
-		glDrawElements(GL_TRIANGLES, rg->Indices.size(), GL_UNSIGNED_INT, 0);
-		s_Data.DiagnosticInfo.DrawCallCount += 1;
+	// Only change what's different from the last run
+	uint32_t camera = UINT32_MAX;
+	uint32_t texture = UINT32_MAX;
+	bool blending = false;
+	for (const RenderRun& run : runs) {
+		if (run.Camera != camera) {
+			camera = run.Camera;
+			glm::mat4 viewproj = s_Data.FrameCameras[camera]->GetViewProjection();
+			glUniformMatrix4fv(s_Data.ViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewproj));
+		}
+		if (run.Texture != texture) {
+			texture = run.Texture;
+			glBindTexture(GL_TEXTURE_2D, s_Data.Textures[texture]->GetHandle());
+		}
+		if (run.Transparent != blending) {
+			blending = run.Transparent;
+			if (blending) {
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			}
+			else glDisable(GL_BLEND);
+		}
 
-		glBindVertexArray(0);
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, run.Count, firstInstance + run.First);
+		s_Data.DiagnosticInfo.DrawCallCount += 1;
 	}
+	if (blending) glDisable(GL_BLEND);
+	glBindVertexArray(0);
+	s_Data.Instances->EndFrame();
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
@@ -441,15 +480,9 @@ void Renderer::EndFrame() {
 
 	s_Data.DiagnosticInfo.DrawMS = (System::GetTime() - startMS) * 1000.0f;
 	
-	// Clear vertices and indices in all render groups to prevent memory leaks
+	// Sprites are submitted again every frame, the queue keeps its memory
 	startMS = System::GetTime();
-	for (RenderGroup* rg : s_Data.RenderGroups) {
-		rg->Vertices.clear();
-		rg->Vertices.resize(0);
-
-		rg->Indices.clear();
-		rg->Indices.resize(0);
-	}
+	s_Data.Queue.Clear();
 	s_Data.DiagnosticInfo.BatchMS += (System::GetTime() - startMS) * 1000.0f;
 }
 
@@ -480,185 +513,113 @@ void Renderer::ClearColor(const glm::vec3& color)
 
 void Renderer::DrawQuad(const glm::vec2& pos, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	Submit(model, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, { 1,1 }, 0.0f, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
 }
 void Renderer::DrawQuad(const glm::vec2& pos, const glm::vec2& scale, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, 0.0f, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
 }
 void Renderer::DrawQuad(const glm::vec2& pos, const glm::vec2& scale, float rot, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, rot, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
 }
 
 void Renderer::DrawScreenSpaceQuad(const glm::vec2& pos, const glm::vec2& scale, float rot, bool transparent, const glm::vec4& tint)
 {
-	glm::vec2 wPos = s_Data.CurrentCamera->ScreenToWorld(pos);
-	glm::vec2 wScale = s_Data.CurrentCamera->ScreenToWorld(scale);
-
-	glm::vec2 position = {
-		(wPos.x + wScale.x) / 2,
-		(wPos.y + wScale.y) / 2
-	};
-
-	wScale = {
-		abs(wScale.x - wPos.x),
-		abs(wScale.y - wPos.y)
-	};
-
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { position, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { wScale, 1 });
-	Submit(model, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	glm::vec2 position, wScale;
+	ScreenToWorldQuad(pos, scale, &position, &wScale);
+	Submit(position, wScale, rot, { 1,1 }, { 0,0 }, tint, s_Data.BlankTexture, transparent);
 }
 
 void Renderer::DrawQuad(glm::vec2 pos, Texture* texture, bool transparent, glm::vec4 tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	Submit(model, { 1,1 }, { 0,0 }, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, { 1,1 }, 0.0f, { 1,1 }, { 0,0 }, tint, texture, transparent);
 }
 void Renderer::DrawQuad(const glm::vec2& pos, const glm::vec2& scale, Texture* texture, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, { 1,1 }, { 0,0 }, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, 0.0f, { 1,1 }, { 0,0 }, tint, texture, transparent);
 }
 void Renderer::DrawQuad(const glm::vec2& pos, const glm::vec2& scale, float rot, Texture* texture, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, { 1,1 }, { 0,0 }, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, rot, { 1,1 }, { 0,0 }, tint, texture, transparent);
 }
 
 void Renderer::DrawQuadAtlas(glm::vec2 pos, Texture* texture, const glm::vec2& size, const glm::vec2& texid, bool transparent, glm::vec4 tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	Submit(model, size, texid, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, { 1,1 }, 0.0f, size, texid, tint, texture, transparent);
 }
 void Renderer::DrawQuadAtlas(const glm::vec2& pos, const glm::vec2& scale, Texture* texture, const glm::vec2& size, const glm::vec2& texid, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, size, texid, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, 0.0f, size, texid, tint, texture, transparent);
 }
 void Renderer::DrawQuadAtlas(const glm::vec2& pos, const glm::vec2& scale, float rot, Texture* texture, const glm::vec2& size, const glm::vec2& texid, bool transparent, const glm::vec4& tint)
 {
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { pos, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { scale, 1 });
-	Submit(model, size, texid, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	Submit(pos, scale, rot, size, texid, tint, texture, transparent);
 }
 
 void Renderer::DrawScreenSpaceQuad(const glm::vec2& pos, const glm::vec2& scale, float rot, Texture* texture, bool transparent, const glm::vec4& tint)
 {
-	glm::vec2 wPos = s_Data.CurrentCamera->ScreenToWorld(pos);
-	glm::vec2 wScale = s_Data.CurrentCamera->ScreenToWorld(scale);
-
-	glm::vec2 position = {
-		(wPos.x + wScale.x) / 2,
-		(wPos.y + wScale.y) / 2
-	};
-
-	wScale = {
-		abs(wScale.x - wPos.x),
-		abs(wScale.y - wPos.y)
-	};
-
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { position, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { wScale, 1 });
-	Submit(model, { 1, 1 }, { 0, 0 }, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
+	glm::vec2 position, wScale;
+	ScreenToWorldQuad(pos, scale, &position, &wScale);
+	Submit(position, wScale, rot, { 1, 1 }, { 0, 0 }, tint, texture, transparent);
 }
 void Renderer::DrawScreenSpaceQuadAtlas(const glm::vec2& pos, const glm::vec2& scale, float rot, Texture* texture, const glm::vec2& size, const glm::vec2& texid, bool transparent, const glm::vec4& tint)
+{
+	glm::vec2 position, wScale;
+	ScreenToWorldQuad(pos, scale, &position, &wScale);
+	Submit(position, wScale, rot, size, texid, tint, texture, transparent);
+}
+
+// pos and scale are opposite screen space corners, gives back the world space center and size
+void Renderer::ScreenToWorldQuad(const glm::vec2& pos, const glm::vec2& scale, glm::vec2* worldPos, glm::vec2* worldScale)
 {
 	glm::vec2 wPos = s_Data.CurrentCamera->ScreenToWorld(pos);
 	glm::vec2 wScale = s_Data.CurrentCamera->ScreenToWorld(scale);
 
-	glm::vec2 position = {
+	*worldPos = {
 		(wPos.x + wScale.x) / 2,
 		(wPos.y + wScale.y) / 2
 	};
 
-	wScale = {
+	*worldScale = {
 		abs(wScale.x - wPos.x),
 		abs(wScale.y - wPos.y)
 	};
-
-	glm::mat4 model = glm::mat4(1);
-	model = glm::translate(model, { position, -1.0f });
-	model = glm::rotate(model, rot, { 0, 0, 1 });
-	model = glm::scale(model, { wScale, 1 });
-
-	Submit(model, size, texid, tint, texture, transparent);
-	s_Data.DiagnosticInfo.QuadCount += 1;
 }
 
-int Renderer::FindGroup(Texture* texture, Camera* camera, bool transparent)
+uint32_t Renderer::FindTexture(Texture* texture)
 {
-	for (int i = 0; i < s_Data.RenderGroups.size(); ++i) {
-		auto& rg = s_Data.RenderGroups[i];
-		if (rg->Camera == camera && rg->Texture == texture) return i;
+	// Sprites tend to come in a row with the same texture
+	if (texture == s_Data.LastTexture) return s_Data.LastTextureID;
+
+	uint32_t id;
+	auto it = s_Data.TextureIDs.find(texture);
+	if (it != s_Data.TextureIDs.end()) id = it->second;
+	else {
+		id = (uint32_t)s_Data.Textures.size();
+		if (id == RENDER_KEY_MAX_TEXTURES) {
+			ErrorEvent err("Too many textures ( " + std::to_string(RENDER_KEY_MAX_TEXTURES) + " max )");
+			s_Data.callback(err);
+			return 0;
+		}
+		s_Data.TextureIDs.insert({ texture, id });
+		s_Data.Textures.push_back(texture);
 	}
-	return -1;
+
+	s_Data.LastTexture = texture;
+	s_Data.LastTextureID = id;
+	return id;
 }
 
-void Renderer::Submit(const glm::mat4& transform, const glm::vec2& size, const glm::vec2& texid, const glm::vec4& tint, Texture* texture, bool transparent)
+void Renderer::Submit(const glm::vec2& position, const glm::vec2& scale, float rot, const glm::vec2& size, const glm::vec2& texid, const glm::vec4& tint, Texture* texture, bool transparent)
 {
-	int groupID = FindGroup(texture, s_Data.CurrentCamera, transparent);
-	
-	if (groupID == -1) {
-		groupID = s_Data.RenderGroups.size();
-		RenderGroup* rg = new RenderGroup();
-		rg->VAO = -1;
-		rg->Texture = texture;
-		rg->AtlasSize = size;
-		rg->Transparent = transparent;
-		rg->Camera = s_Data.CurrentCamera;
-		rg->LastVertexCount = 0;
-		s_Data.RenderGroups.push_back(rg);
-	}
-
-	RenderGroup* rg = s_Data.RenderGroups[groupID];
-	int quadCount = rg->Vertices.size() / 4;
-	for (int i = 0; i < s_Data.QuadVertices.size(); ++i) {
-		BatchVertex vert = {
-			transform * glm::vec4(s_Data.QuadVertices[i].position / 2.0f, 0, 1),
-			s_Data.QuadVertices[i].texCoord,
-			texid,
-			tint
-		};
-		rg->Vertices.push_back(vert);
-	}
-	for (int i = 0; i < s_Data.QuadIndices.size(); ++i) {
-		rg->Indices.push_back(s_Data.QuadIndices[i] + (quadCount * 4));
-	}
+	// Sprites on the same atlas page share a texture, the cell is found inside the texture's part of the page
+	// A zero sized atlas is treated as one cell
+	glm::vec2 cells = { size.x > 0.0f ? size.x : 1.0f, size.y > 0.0f ? size.y : 1.0f };
+	glm::vec2 cellSize = texture->GetUVSize() / cells;
+	glm::vec2 uvMin = texture->GetUVMin() + texid * cellSize;
+
+	// The quad itself is built in the vertex shader
+	s_Data.Queue.Submit(s_Data.CurrentCameraID, transparent, FindTexture(texture->GetPage()), position, scale, rot, uvMin, cellSize, tint);
+	s_Data.DiagnosticInfo.QuadCount += 1;
 }
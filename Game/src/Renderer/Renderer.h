@@ -1,19 +1,33 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <map>
+#include <unordered_map>
 #include "Core/Event/Event.h"
 #include "Texture.h"
 #include "Camera.h"
+#include "RenderQueue.h"
+#include "RingBuffer.h"
 
 struct RenderDiagnosticInfo
 {
 	int DrawCallCount;
+	// Runs of sprites sharing a camera, blend mode and texture after sorting
 	int RenderGroupCount;
 	int QuadCount;
+	// Quads outside their camera that were never uploaded
+	int CulledQuadCount;
 	float DrawMS;
 
 	float StartBatchMS;
 	float BatchMS;
+
+	// Bytes uploaded per quad and how many quads a second batching and uploading keeps up with
+	int BytesPerQuad;
+	float QuadsPerSecond;
+
+	// Times the instance buffer had to wait for the GPU to finish with a part, and how long in total
+	int UploadStallCount;
+	float UploadStallMS;
 };
 
 class Renderer {
@@ -48,43 +62,43 @@ public:
 	static void DrawScreenSpaceQuadAtlas(const glm::vec2& pos, const glm::vec2& scale, float rot, Texture* texture, const glm::vec2& size, const glm::vec2& texid, bool transparent = false, const glm::vec4& tint = { 1, 1, 1, 1 });
 
 private:
-	static int FindGroup(Texture* texture, Camera* camera, bool transparent);
-	static void Submit(const glm::mat4& transform, const glm::vec2& size, const glm::vec2& texid, const glm::vec4& tint, Texture* texture, bool transparent);
+	static uint32_t FindTexture(Texture* texture);
+	static void Submit(const glm::vec2& position, const glm::vec2& scale, float rot, const glm::vec2& size, const glm::vec2& texid, const glm::vec4& tint, Texture* texture, bool transparent);
+	static void ScreenToWorldQuad(const glm::vec2& pos, const glm::vec2& scale, glm::vec2* worldPos, glm::vec2* worldScale);
+	// Points the per instance attributes of the sprite VAO at the instance buffer
+	static void SetInstanceAttributes();
 
 private:
 	struct Vertex {
 		glm::vec2 position;
 		glm::vec2 texCoord;
 	};
-	struct BatchVertex {
-		glm::vec2 position;
-		glm::vec2 texCoord;
-		glm::vec2 texID;
-		glm::vec4 tint;
-	};
-	struct RenderGroup {
-		Camera* Camera;
-		Texture* Texture;
-		glm::vec2 AtlasSize;
-		bool Transparent;
-
-		uint32_t LastVertexCount;
-		std::vector<BatchVertex> Vertices;
-		std::vector<uint32_t> Indices;
-
-		unsigned int VAO;
-		unsigned int VBO;
-		unsigned int EBO;
-	};
 	
 	struct RenderData {
 		std::function<void(Event&)> callback;
 
 		RenderDiagnosticInfo DiagnosticInfo;
 
-		std::vector<RenderGroup*> RenderGroups;
+		RenderQueue Queue;
 
 		Camera* CurrentCamera;
+		// Cameras used this frame in the order they were first used, index is the camera part of a sort key
+		std::vector<Camera*> FrameCameras;
+		std::vector<glm::vec4> FrameCameraBounds;
+		uint32_t CurrentCameraID;
+
+		// Index is the texture part of a sort key, textures keep their id for the whole run
+		std::unordered_map<Texture*, uint32_t> TextureIDs;
+		std::vector<Texture*> Textures;
+		Texture* LastTexture;
+		uint32_t LastTextureID;
+
+		// Shares the quad's vertex and index buffers, the instance buffer only ever grows
+		unsigned int SpriteVAO;
+		RingBuffer* Instances;
+
+		int ViewProjectionLocation;
+		int TextureLocation;
 
 		unsigned int MainFrameBuffer;
 		unsigned int ViewPortFrameBuffer;
@@ -100,6 +114,8 @@ private:
 		std::vector<Vertex> QuadVertices;
 		std::vector<uint32_t> QuadIndices;
 		unsigned int Quad;
+		unsigned int QuadVBO;
+		unsigned int QuadEBO;
 
 		Texture* BlankTexture;
 	};
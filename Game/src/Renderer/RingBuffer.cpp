@@ -0,0 +1,148 @@
+#include "RingBuffer.h"
+#include <stddef.h>
+#include <glad/glad.h>
+#include "Core/System.h"
+
+#define MAP_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+RingBuffer::RingBuffer(uint32_t frameSize, bool allowPersistent)
+{
+	// glBufferStorage is only loaded on OpenGL 4.4 and up
+	m_Persistent = allowPersistent && glBufferStorage != NULL;
+	m_Handle = 0;
+	m_Mapped = nullptr;
+
+	m_Frame = 0;
+	m_Cursor = 0;
+	m_Flushed = 0;
+	for (int i = 0; i < RING_BUFFER_FRAMES; ++i) m_Fences[i] = nullptr;
+
+	m_StallCount = 0;
+	m_StallMS = 0.0f;
+
+	Create(frameSize);
+}
+RingBuffer::~RingBuffer()
+{
+	for (uint32_t i = 0; i < RING_BUFFER_FRAMES; ++i) Wait(i);
+	Destroy();
+}
+
+void RingBuffer::Create(uint32_t frameSize)
+{
+	m_FrameSize = frameSize;
+	uint32_t size = frameSize * RING_BUFFER_FRAMES;
+
+	glGenBuffers(1, &m_Handle);
+	glBindBuffer(GL_ARRAY_BUFFER, m_Handle);
+	if (m_Persistent) {
+		glBufferStorage(GL_ARRAY_BUFFER, size, NULL, MAP_FLAGS);
+		m_Mapped = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, MAP_FLAGS);
+		if (!m_Mapped) {
+			// Falls back to glBufferSubData, slower but it still works
+			m_Persistent = false;
+			// Storage from glBufferStorage can't be respecified
+			glDeleteBuffers(1, &m_Handle);
+			glGenBuffers(1, &m_Handle);
+			glBindBuffer(GL_ARRAY_BUFFER, m_Handle);
+		}
+	}
+	if (!m_Persistent) {
+		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+		m_Staging.resize(size);
+		m_Mapped = m_Staging.data();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_Cursor = m_Frame * m_FrameSize;
+	m_Flushed = m_Cursor;
+}
+void RingBuffer::Destroy()
+{
+	if (m_Persistent && m_Mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_Handle);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &m_Handle);
+	m_Handle = 0;
+	m_Mapped = nullptr;
+}
+
+void RingBuffer::Wait(uint32_t frame)
+{
+	GLsync fence = (GLsync)m_Fences[frame];
+	if (!fence) return;
+
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		// Still being read from RING_BUFFER_FRAMES frames ago, the GPU is that far behind
+		float start = System::GetTime();
+		while (result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		m_StallCount += 1;
+		m_StallMS += (System::GetTime() - start) * 1000.0f;
+	}
+	glDeleteSync(fence);
+	m_Fences[frame] = nullptr;
+}
+
+void RingBuffer::BeginFrame()
+{
+	m_Frame = (m_Frame + 1) % RING_BUFFER_FRAMES;
+	m_Cursor = m_Frame * m_FrameSize;
+	m_Flushed = m_Cursor;
+	Wait(m_Frame);
+}
+
+void* RingBuffer::Allocate(uint32_t size, uint32_t stride, uint32_t* offset)
+{
+	uint32_t start = ((m_Cursor + stride - 1) / stride) * stride;
+	if (start + size > (m_Frame + 1) * m_FrameSize) return nullptr;
+
+	// Nothing is uploaded for the padding, skip it when flushing
+	if (m_Flushed == m_Cursor) m_Flushed = start;
+	m_Cursor = start + size;
+	*offset = start;
+	return m_Mapped + start;
+}
+
+void RingBuffer::Flush()
+{
+	if (m_Cursor == m_Flushed) return;
+	// Coherent mappings are seen by the GPU without doing anything
+	if (!m_Persistent) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_Handle);
+		glBufferSubData(GL_ARRAY_BUFFER, m_Flushed, m_Cursor - m_Flushed, m_Mapped + m_Flushed);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	m_Flushed = m_Cursor;
+}
+
+void RingBuffer::EndFrame()
+{
+	Flush();
+	if (m_Fences[m_Frame]) glDeleteSync((GLsync)m_Fences[m_Frame]);
+	m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool RingBuffer::Reserve(uint32_t frameSize)
+{
+	if (frameSize <= m_FrameSize) return false;
+
+	// Every part has to be free before the storage goes away
+	for (uint32_t i = 0; i < RING_BUFFER_FRAMES; ++i) Wait(i);
+	Destroy();
+	Create(frameSize > m_FrameSize * 2 ? frameSize : m_FrameSize * 2);
+	return true;
+}
+
+void RingBuffer::Bind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_Handle);
+}
+void RingBuffer::Unbind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
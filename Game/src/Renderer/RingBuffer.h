@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// Parts the ring is split into, a frame only writes to its own part while the GPU can still be reading the others
+#define RING_BUFFER_FRAMES 3
+
+// Vertex buffer for data that's written every frame and drawn straight away.
+// Persistently mapped with glBufferStorage when the driver has it, otherwise it's written to a copy
+// in memory and uploaded with glBufferSubData. Each part is fenced at the end of its frame and
+// waited on before it's written again, the waits are counted as stalls
+// The projects don't share code, VoxelGame/src/Renderer/RingBuffer.h is the same class so fixes go in both
+class RingBuffer {
+public:
+	RingBuffer(uint32_t frameSize, bool allowPersistent = true);
+	~RingBuffer();
+
+	// Moves on to the next part, waiting for the GPU if it's still reading it
+	void BeginFrame();
+	// size bytes of this frame's part starting at a multiple of stride, so offset / stride
+	// can be used as a base vertex or instance. Returns null if the part is full
+	void* Allocate(uint32_t size, uint32_t stride, uint32_t* offset);
+	// Makes everything written so far visible to the GPU, call before drawing from it
+	void Flush();
+	// Fences this frame's part
+	void EndFrame();
+
+	// Grows the parts to at least frameSize, only between BeginFrame and the first Allocate.
+	// Returns true if the buffer was recreated, anything pointing at the old handle has to be set up again
+	bool Reserve(uint32_t frameSize);
+
+	void Bind();
+	void Unbind();
+
+	uint32_t GetHandle() { return m_Handle; }
+	uint32_t GetFrameSize() { return m_FrameSize; }
+	bool IsPersistent() { return m_Persistent; }
+
+	uint32_t GetStallCount() { return m_StallCount; }
+	float GetStallMS() { return m_StallMS; }
+
+private:
+	void Create(uint32_t frameSize);
+	void Destroy();
+	void Wait(uint32_t frame);
+
+private:
+	uint32_t m_Handle;
+	uint32_t m_FrameSize;
+	bool m_Persistent;
+
+	uint8_t* m_Mapped;
+	// Only used when the buffer can't be persistently mapped
+	std::vector<uint8_t> m_Staging;
+
+	uint32_t m_Frame;
+	uint32_t m_Cursor;
+	uint32_t m_Flushed;
+	void* m_Fences[RING_BUFFER_FRAMES];
+
+	uint32_t m_StallCount;
+	float m_StallMS;
+};
@@ -0,0 +1,36 @@
+#include "SpriteBatch.h"
+
+namespace {
+	uint8_t ToByte(float value, float max) {
+		if (!(value > 0.0f)) return 0;
+		if (value >= max) return (uint8_t)max;
+		return (uint8_t)(value + 0.5f);
+	}
+	uint16_t ToUNorm16(float value) {
+		if (!(value > 0.0f)) return 0;
+		if (value >= 1.0f) return 65535;
+		return (uint16_t)(value * 65535.0f + 0.5f);
+	}
+}
+
+void SpriteBatch::Add(const glm::vec2& position, const glm::vec2& scale, float rotation, const glm::vec2& uvMin, const glm::vec2& uvSize, const glm::vec4& tint)
+{
+	SpriteInstance instance;
+	instance.Position = position;
+	instance.Scale = scale;
+	instance.Rotation = rotation;
+	instance.UV[0] = ToUNorm16(uvMin.x);
+	instance.UV[1] = ToUNorm16(uvMin.y);
+	instance.UV[2] = ToUNorm16(uvSize.x);
+	instance.UV[3] = ToUNorm16(uvSize.y);
+	instance.Tint = PackTint(tint);
+	m_Instances.push_back(instance);
+}
+
+uint32_t SpriteBatch::PackTint(const glm::vec4& tint)
+{
+	return (uint32_t)ToByte(tint.r * 255.0f, 255.0f)
+		| ((uint32_t)ToByte(tint.g * 255.0f, 255.0f) << 8)
+		| ((uint32_t)ToByte(tint.b * 255.0f, 255.0f) << 16)
+		| ((uint32_t)ToByte(tint.a * 255.0f, 255.0f) << 24);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <stdint.h>
+
+// One sprite as the GPU reads it, the vertex shader turns the shared unit quad into the sprite
+struct SpriteInstance {
+	glm::vec2 Position;
+	glm::vec2 Scale;
+	float Rotation;
+	// Min x, min y, width and height of the sprite's part of the texture, 0 to 65535 covers 0 to 1
+	uint16_t UV[4];
+	// RGBA8, red in the lowest byte
+	uint32_t Tint;
+};
+static_assert(sizeof(SpriteInstance) == 32, "SpriteInstance layout has to match the instance attributes");
+
+// Builds the instance list for one render group, doesn't touch OpenGL so it can run without a window
+class SpriteBatch {
+public:
+	void Add(const glm::vec2& position, const glm::vec2& scale, float rotation, const glm::vec2& uvMin, const glm::vec2& uvSize, const glm::vec4& tint);
+	void Clear() { m_Instances.clear(); }
+
+	bool Empty() const { return m_Instances.empty(); }
+	uint32_t GetCount() const { return (uint32_t)m_Instances.size(); }
+	size_t GetSizeInBytes() const { return m_Instances.size() * sizeof(SpriteInstance); }
+	const SpriteInstance* GetData() const { return m_Instances.data(); }
+
+	static uint32_t PackTint(const glm::vec4& tint);
+
+private:
+	std::vector<SpriteInstance> m_Instances;
+};
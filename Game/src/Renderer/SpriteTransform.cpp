@@ -0,0 +1,213 @@
+#include "SpriteTransform.h"
+#include <cmath>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define SPRITE_TRANSFORM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SPRITE_TRANSFORM_SSE
+#endif
+
+namespace {
+	// Sprite corners as the quad has them, before scaling by half the sprite's size
+	const float CornerX[4] = { 1, 1, -1, -1 };
+	const float CornerY[4] = { 1, -1, -1, 1 };
+
+#if defined(SPRITE_TRANSFORM_AVX)
+	struct Wide {
+		typedef __m256 Type;
+		static const uint32_t Width = 8;
+		static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+		static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+		static Type Set(float v) { return _mm256_set1_ps(v); }
+		static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+		static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+		static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+		static Type Abs(Type v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+		static Type Round(Type v) { return _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		static Type Floor(Type v) { return _mm256_floor_ps(v); }
+		static Type Equal(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+		static Type Select(Type mask, Type a, Type b) { return _mm256_blendv_ps(b, a, mask); }
+		static Type Or(Type a, Type b) { return _mm256_or_ps(a, b); }
+		static Type Xor(Type a, Type b) { return _mm256_xor_ps(a, b); }
+		static Type And(Type a, Type b) { return _mm256_and_ps(a, b); }
+	};
+#elif defined(SPRITE_TRANSFORM_SSE)
+	struct Wide {
+		typedef __m128 Type;
+		static const uint32_t Width = 4;
+		static Type Load(const float* p) { return _mm_loadu_ps(p); }
+		static void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+		static Type Set(float v) { return _mm_set1_ps(v); }
+		static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+		static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+		static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+		static Type Abs(Type v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+		static Type Round(Type v) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+		// SSE2 only truncates, step back one where that rounded up
+		static Type Floor(Type v) {
+			Type truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.0f)));
+		}
+		static Type Equal(Type a, Type b) { return _mm_cmpeq_ps(a, b); }
+		static Type Select(Type mask, Type a, Type b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		static Type Or(Type a, Type b) { return _mm_or_ps(a, b); }
+		static Type Xor(Type a, Type b) { return _mm_xor_ps(a, b); }
+		static Type And(Type a, Type b) { return _mm_and_ps(a, b); }
+	};
+#endif
+
+#if defined(SPRITE_TRANSFORM_AVX) || defined(SPRITE_TRANSFORM_SSE)
+	typedef Wide::Type Float;
+
+	// Sine and cosine to about 1e-7 for angles up to a few thousand radians. The angle is brought into
+	// [-pi/4, pi/4] by taking off the closest multiple of pi/2 in three parts, then the quarter turn
+	// it was in picks which polynomial is the sine and which signs flip
+	void SinCos(Float x, Float* sin, Float* cos) {
+		Float quadrant = Wide::Round(Wide::Mul(x, Wide::Set(0.63661977236f)));
+		Float y = Wide::Sub(x, Wide::Mul(quadrant, Wide::Set(1.5703125f)));
+		y = Wide::Sub(y, Wide::Mul(quadrant, Wide::Set(4.837512969970703125e-4f)));
+		y = Wide::Sub(y, Wide::Mul(quadrant, Wide::Set(7.54978995489188216e-8f)));
+		Float z = Wide::Mul(y, y);
+
+		Float s = Wide::Add(Wide::Mul(Wide::Set(-1.9515295891e-4f), z), Wide::Set(8.3321608736e-3f));
+		s = Wide::Add(Wide::Mul(s, z), Wide::Set(-1.6666654611e-1f));
+		s = Wide::Add(Wide::Mul(Wide::Mul(s, z), y), y);
+
+		Float c = Wide::Add(Wide::Mul(Wide::Set(2.443315711809948e-5f), z), Wide::Set(-1.388731625493765e-3f));
+		c = Wide::Add(Wide::Mul(c, z), Wide::Set(4.166664568298827e-2f));
+		c = Wide::Add(Wide::Sub(Wide::Mul(Wide::Mul(c, z), z), Wide::Mul(Wide::Set(0.5f), z)), Wide::Set(1.0f));
+
+		// quadrant mod 4
+		Float q = Wide::Sub(quadrant, Wide::Mul(Wide::Floor(Wide::Mul(quadrant, Wide::Set(0.25f))), Wide::Set(4.0f)));
+		Float is1 = Wide::Equal(q, Wide::Set(1.0f));
+		Float is2 = Wide::Equal(q, Wide::Set(2.0f));
+		Float is3 = Wide::Equal(q, Wide::Set(3.0f));
+		Float swap = Wide::Or(is1, is3);
+		Float sign = Wide::Set(-0.0f);
+
+		*sin = Wide::Xor(Wide::Select(swap, c, s), Wide::And(Wide::Or(is2, is3), sign));
+		*cos = Wide::Xor(Wide::Select(swap, s, c), Wide::And(Wide::Or(is1, is2), sign));
+	}
+#endif
+}
+
+void SpriteTransform::Corners(const SpriteTransforms& sprites, uint32_t count, glm::vec2* corners)
+{
+	uint32_t i = 0;
+#if defined(SPRITE_TRANSFORM_AVX) || defined(SPRITE_TRANSFORM_SSE)
+	const uint32_t width = Wide::Width;
+	Float half = Wide::Set(0.5f);
+	for (; i + width <= count; i += width) {
+		Float x = Wide::Load(sprites.PositionX + i);
+		Float y = Wide::Load(sprites.PositionY + i);
+		Float halfX = Wide::Mul(Wide::Load(sprites.ScaleX + i), half);
+		Float halfY = Wide::Mul(Wide::Load(sprites.ScaleY + i), half);
+		Float sin, cos;
+		SinCos(Wide::Load(sprites.Rotation + i), &sin, &cos);
+
+		// Rotated half extents, every corner is a sign flip of these
+		Float xc = Wide::Mul(halfX, cos), xs = Wide::Mul(halfX, sin);
+		Float yc = Wide::Mul(halfY, cos), ys = Wide::Mul(halfY, sin);
+
+		alignas(32) float cornerX[4][width];
+		alignas(32) float cornerY[4][width];
+		Wide::Store(cornerX[0], Wide::Add(x, Wide::Sub(xc, ys)));
+		Wide::Store(cornerY[0], Wide::Add(y, Wide::Add(xs, yc)));
+		Wide::Store(cornerX[1], Wide::Add(x, Wide::Add(xc, ys)));
+		Wide::Store(cornerY[1], Wide::Add(y, Wide::Sub(xs, yc)));
+		Wide::Store(cornerX[2], Wide::Sub(x, Wide::Sub(xc, ys)));
+		Wide::Store(cornerY[2], Wide::Sub(y, Wide::Add(xs, yc)));
+		Wide::Store(cornerX[3], Wide::Sub(x, Wide::Add(xc, ys)));
+		Wide::Store(cornerY[3], Wide::Sub(y, Wide::Sub(xs, yc)));
+
+		glm::vec2* out = corners + (size_t)i * 4;
+		for (uint32_t lane = 0; lane < width; ++lane) {
+			for (int corner = 0; corner < 4; ++corner) {
+				out[lane * 4 + corner] = { cornerX[corner][lane], cornerY[corner][lane] };
+			}
+		}
+	}
+#endif
+	// Whatever doesn't fill a whole register
+	SpriteTransforms rest = {
+		sprites.PositionX + i, sprites.PositionY + i, sprites.ScaleX + i, sprites.ScaleY + i, sprites.Rotation + i
+	};
+	CornersScalar(rest, count - i, corners + (size_t)i * 4);
+}
+
+void SpriteTransform::Bounds(const SpriteTransforms& sprites, uint32_t count, float* minX, float* minY, float* maxX, float* maxY)
+{
+	uint32_t i = 0;
+#if defined(SPRITE_TRANSFORM_AVX) || defined(SPRITE_TRANSFORM_SSE)
+	const uint32_t width = Wide::Width;
+	Float half = Wide::Set(0.5f);
+	for (; i + width <= count; i += width) {
+		Float x = Wide::Load(sprites.PositionX + i);
+		Float y = Wide::Load(sprites.PositionY + i);
+		Float halfX = Wide::Mul(Wide::Load(sprites.ScaleX + i), half);
+		Float halfY = Wide::Mul(Wide::Load(sprites.ScaleY + i), half);
+		Float sin, cos;
+		SinCos(Wide::Load(sprites.Rotation + i), &sin, &cos);
+
+		// Half the size of the box around the rotated sprite
+		Float extentX = Wide::Add(Wide::Abs(Wide::Mul(halfX, cos)), Wide::Abs(Wide::Mul(halfY, sin)));
+		Float extentY = Wide::Add(Wide::Abs(Wide::Mul(halfX, sin)), Wide::Abs(Wide::Mul(halfY, cos)));
+
+		Wide::Store(minX + i, Wide::Sub(x, extentX));
+		Wide::Store(minY + i, Wide::Sub(y, extentY));
+		Wide::Store(maxX + i, Wide::Add(x, extentX));
+		Wide::Store(maxY + i, Wide::Add(y, extentY));
+	}
+#endif
+	SpriteTransforms rest = {
+		sprites.PositionX + i, sprites.PositionY + i, sprites.ScaleX + i, sprites.ScaleY + i, sprites.Rotation + i
+	};
+	BoundsScalar(rest, count - i, minX + i, minY + i, maxX + i, maxY + i);
+}
+
+void SpriteTransform::CornersScalar(const SpriteTransforms& sprites, uint32_t count, glm::vec2* corners)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		float halfX = sprites.ScaleX[i] * 0.5f;
+		float halfY = sprites.ScaleY[i] * 0.5f;
+		float sin = std::sin(sprites.Rotation[i]);
+		float cos = std::cos(sprites.Rotation[i]);
+		for (int corner = 0; corner < 4; ++corner) {
+			float x = CornerX[corner] * halfX;
+			float y = CornerY[corner] * halfY;
+			corners[(size_t)i * 4 + corner] = {
+				sprites.PositionX[i] + x * cos - y * sin,
+				sprites.PositionY[i] + x * sin + y * cos
+			};
+		}
+	}
+}
+
+void SpriteTransform::BoundsScalar(const SpriteTransforms& sprites, uint32_t count, float* minX, float* minY, float* maxX, float* maxY)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		float halfX = sprites.ScaleX[i] * 0.5f;
+		float halfY = sprites.ScaleY[i] * 0.5f;
+		float sin = std::sin(sprites.Rotation[i]);
+		float cos = std::cos(sprites.Rotation[i]);
+		float extentX = std::abs(halfX * cos) + std::abs(halfY * sin);
+		float extentY = std::abs(halfX * sin) + std::abs(halfY * cos);
+		minX[i] = sprites.PositionX[i] - extentX;
+		minY[i] = sprites.PositionY[i] - extentY;
+		maxX[i] = sprites.PositionX[i] + extentX;
+		maxY[i] = sprites.PositionY[i] + extentY;
+	}
+}
+
+const char* SpriteTransform::GetKernelName()
+{
+#if defined(SPRITE_TRANSFORM_AVX)
+	return "AVX";
+#elif defined(SPRITE_TRANSFORM_SSE)
+	return "SSE";
+#else
+	return "Scalar";
+#endif
+}
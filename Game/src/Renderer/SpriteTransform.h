@@ -0,0 +1,30 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// Sprites as separate arrays, the way the kernels read them
+struct SpriteTransforms {
+	const float* PositionX;
+	const float* PositionY;
+	const float* ScaleX;
+	const float* ScaleY;
+	const float* Rotation;
+};
+
+// Works out where sprites end up in world space, several at a time with AVX or SSE when the compiler has them.
+// Matches what the sprite vertex shader does, so it can be used to cull sprites before they're uploaded.
+// Doesn't touch OpenGL so it can run without a window
+class SpriteTransform {
+public:
+	// Four corners per sprite in the same order as the quad's vertices, corners has to have room for count * 4
+	static void Corners(const SpriteTransforms& sprites, uint32_t count, glm::vec2* corners);
+	// Smallest box around each rotated sprite
+	static void Bounds(const SpriteTransforms& sprites, uint32_t count, float* minX, float* minY, float* maxX, float* maxY);
+
+	// One sprite at a time with std::sin and std::cos, what the SIMD kernels are checked against
+	static void CornersScalar(const SpriteTransforms& sprites, uint32_t count, glm::vec2* corners);
+	static void BoundsScalar(const SpriteTransforms& sprites, uint32_t count, float* minX, float* minY, float* maxX, float* maxY);
+
+	// "AVX", "SSE" or "Scalar"
+	static const char* GetKernelName();
+};
@@ -131,6 +131,18 @@ Texture::Texture(const TextureConfig& config)
 	//stbi_image_free(data);
 }
 
+Texture::Texture(Texture* page, const glm::vec2& uvMin, const glm::vec2& uvSize, uint32_t width, uint32_t height)
+{
+	m_Config = page->m_Config;
+	m_Handle = 0;
+	m_Width = width;
+	m_Height = height;
+
+	m_Page = page;
+	m_UVMin = uvMin;
+	m_UVSize = uvSize;
+}
+
 void Texture::Resize(uint32_t width, uint32_t height, void* data)
 {
 	m_Width = width;
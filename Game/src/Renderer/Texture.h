@@ -1,5 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <string>
+#include <stdint.h>
 
 enum class TexWrapMode
 {
@@ -56,17 +58,28 @@ public:
 
 	Texture(const std::string& path, const TextureConfig& config = {});
 	Texture(const TextureConfig& config = {});
+	// Part of another texture, nothing is created and the page's handle is used. uvMin and uvSize are where it is on the page
+	Texture(Texture* page, const glm::vec2& uvMin, const glm::vec2& uvSize, uint32_t width, uint32_t height);
 
 	void Resize(uint32_t width, uint32_t height, void* data = (void*)NULL);
 
-	unsigned int GetHandle() { return m_Handle; }
+	unsigned int GetHandle() { return m_Page ? m_Page->GetHandle() : m_Handle; }
 
 	uint32_t GetWidth() { return m_Width; }
 	uint32_t GetHeight() { return m_Height; }
 
+	// The texture that's actually bound, itself unless it's part of an atlas
+	Texture* GetPage() { return m_Page ? m_Page : this; }
+	const glm::vec2& GetUVMin() { return m_UVMin; }
+	const glm::vec2& GetUVSize() { return m_UVSize; }
+
 private:
 	unsigned int m_Handle;
 
+	Texture* m_Page = nullptr;
+	glm::vec2 m_UVMin = { 0, 0 };
+	glm::vec2 m_UVSize = { 1, 1 };
+
 	TextureConfig m_Config;
 	int m_Width;
 	int m_Height;
@@ -0,0 +1,122 @@
+#include "TextureAtlas.h"
+#include <cstring>
+// The implementation is in Texture.cpp, premake defines STB_IMAGE_IMPLEMENTATION for the whole project
+#undef STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+#include "Core/Application.h"
+#include "Core/Event/Event.h"
+#include "Core/System.h"
+
+namespace {
+	struct LoadedImage {
+		unsigned char* Data;
+		int Width;
+		int Height;
+	};
+
+	// Stands in for images that fail to load so they still get a region to draw with, like the renderer's blank texture
+	unsigned char s_MissingPixel[4] = { 255, 255, 255, 255 };
+
+	// Copies the image onto the page and repeats its edges into the padding around it
+	void Blit(std::vector<unsigned char>& page, uint32_t pageSize, const LoadedImage& image, const AtlasRect& rect, uint32_t padding) {
+		for (int y = -(int)padding; y < image.Height + (int)padding; ++y) {
+			int sourceY = y < 0 ? 0 : (y >= image.Height ? image.Height - 1 : y);
+			unsigned char* row = &page[((rect.Y + y) * pageSize + rect.X) * 4];
+			const unsigned char* sourceRow = image.Data + (size_t)sourceY * image.Width * 4;
+
+			std::memcpy(row, sourceRow, (size_t)image.Width * 4);
+			for (uint32_t x = 1; x <= padding; ++x) {
+				std::memcpy(row - x * 4, sourceRow, 4);
+				std::memcpy(row + (image.Width + x - 1) * 4, sourceRow + (image.Width - 1) * 4, 4);
+			}
+		}
+	}
+}
+
+TextureAtlas::TextureAtlas(uint32_t pageSize, uint32_t padding)
+{
+	m_PageSize = pageSize;
+	m_Padding = padding;
+	m_Occupancy = 0.0f;
+	m_PackMS = 0.0f;
+	m_BuildMS = 0.0f;
+}
+
+void TextureAtlas::Add(const std::string& path, bool flipY)
+{
+	if (m_Lookup.find(path) != m_Lookup.end()) return;
+	m_Lookup.insert({ path, (uint32_t)m_Images.size() });
+	m_Images.push_back({ path, flipY, nullptr });
+}
+
+void TextureAtlas::Build(const TextureConfig& config)
+{
+	float startTime = System::GetTime();
+
+	// Everything is loaded as RGBA so images with and without alpha can share a page
+	std::vector<LoadedImage> loaded(m_Images.size());
+	std::vector<AtlasRect> rects(m_Images.size());
+	for (size_t i = 0; i < m_Images.size(); ++i) {
+		int channels;
+		stbi_set_flip_vertically_on_load(!m_Images[i].FlipY);
+		loaded[i].Data = stbi_load(m_Images[i].Path.c_str(), &loaded[i].Width, &loaded[i].Height, &channels, 4);
+		if (!loaded[i].Data) {
+			ErrorEvent err("Failed to load texture ( " + m_Images[i].Path + " )");
+			Application::Get()->ProcEvent(err);
+			loaded[i].Data = s_MissingPixel;
+			loaded[i].Width = 1;
+			loaded[i].Height = 1;
+		}
+		rects[i] = { (uint32_t)loaded[i].Width, (uint32_t)loaded[i].Height, 0, 0, 0 };
+	}
+
+	float packStart = System::GetTime();
+	AtlasPacker packer(m_PageSize, m_PageSize, m_Padding);
+	packer.Pack(rects);
+	m_PackMS = (System::GetTime() - packStart) * 1000.0f;
+	m_Occupancy = packer.GetOccupancy();
+
+	std::vector<std::vector<unsigned char>> pages(packer.GetPageCount());
+	for (auto& page : pages) page.resize((size_t)m_PageSize * m_PageSize * 4, 0);
+	for (size_t i = 0; i < m_Images.size(); ++i) {
+		if (rects[i].Page == UINT32_MAX) continue;
+		Blit(pages[rects[i].Page], m_PageSize, loaded[i], rects[i], m_Padding);
+	}
+
+	TextureConfig pageConfig = config;
+	pageConfig.Format = TexFormat::RGBA;
+	pageConfig.InternalFormat = TexFormat::RGBA;
+	pageConfig.DataType = TexDataType::UNSIGNED_BYTE;
+	pageConfig.Width = m_PageSize;
+	pageConfig.Height = m_PageSize;
+	for (auto& page : pages) {
+		pageConfig.Data = page.data();
+		m_Pages.push_back(new Texture(pageConfig));
+	}
+
+	for (size_t i = 0; i < m_Images.size(); ++i) {
+		Image& image = m_Images[i];
+		const AtlasRect& rect = rects[i];
+		if (rect.Page == UINT32_MAX) {
+			// Too big for a page, it still works on its own
+			TextureConfig imageConfig = config;
+			imageConfig.FlipY = image.FlipY;
+			image.Region = new Texture(image.Path, imageConfig);
+		}
+		else {
+			glm::vec2 uvMin = { (float)rect.X / m_PageSize, (float)rect.Y / m_PageSize };
+			glm::vec2 uvSize = { (float)rect.Width / m_PageSize, (float)rect.Height / m_PageSize };
+			image.Region = new Texture(m_Pages[rect.Page], uvMin, uvSize, rect.Width, rect.Height);
+		}
+		if (loaded[i].Data != s_MissingPixel) stbi_image_free(loaded[i].Data);
+	}
+
+	m_BuildMS = (System::GetTime() - startTime) * 1000.0f;
+}
+
+Texture* TextureAtlas::Get(const std::string& path)
+{
+	auto it = m_Lookup.find(path);
+	if (it == m_Lookup.end()) return nullptr;
+	return m_Images[it->second].Region;
+}
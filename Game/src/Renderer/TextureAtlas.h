@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Texture.h"
+#include "AtlasPacker.h"
+
+// Loads a set of images onto as few pages as it can. Every image is handed back as a Texture that's
+// part of a page, the renderer puts sprites on the same page in the same draw call.
+// Atlas cells of an image still work, they're worked out inside the image's part of the page
+class TextureAtlas {
+public:
+	TextureAtlas(uint32_t pageSize = 2048, uint32_t padding = 1);
+
+	// Queues an image, flipY works the same as TextureConfig::FlipY
+	void Add(const std::string& path, bool flipY = false);
+	// Loads everything that was added, packs it and uploads the pages. Only the wrap and filter modes of config are used.
+	// Images bigger than a page are loaded as their own texture
+	void Build(const TextureConfig& config = {});
+
+	// Null if path was never added, images that failed to load get a 1x1 white region
+	Texture* Get(const std::string& path);
+
+	uint32_t GetImageCount() { return (uint32_t)m_Images.size(); }
+	uint32_t GetPageCount() { return (uint32_t)m_Pages.size(); }
+	float GetOccupancy() { return m_Occupancy; }
+	// Time spent packing, and time spent on the whole build including loading and uploading
+	float GetPackMS() { return m_PackMS; }
+	float GetBuildMS() { return m_BuildMS; }
+
+private:
+	struct Image {
+		std::string Path;
+		bool FlipY;
+		Texture* Region;
+	};
+
+	uint32_t m_PageSize;
+	uint32_t m_Padding;
+
+	std::vector<Image> m_Images;
+	std::unordered_map<std::string, uint32_t> m_Lookup;
+	std::vector<Texture*> m_Pages;
+
+	float m_Occupancy;
+	float m_PackMS;
+	float m_BuildMS;
+};
@@ -3,24 +3,16 @@ out vec4 FragColor;
 
 in vec2 TexCoord;
 
-uniform vec2 TextureID;
-uniform vec2 AtlasSize;
 uniform sampler2D tex;
 
 void main()
 {
     vec3 tint = vec3(1,1,1);
 
-    float unit_width = 1.0f / AtlasSize.x;
-    float unit_height = 1.0f / AtlasSize.y;
-
-    vec2 unit_coord = TexCoord;
-    unit_coord.x = TexCoord.x * unit_width + (unit_width * TextureID.x);
-    unit_coord.y = TexCoord.y * unit_height + (unit_height * ((AtlasSize.y - 1) - TextureID.y));
-
-    vec4 color = texture(tex, unit_coord);
+    // TexCoord already points into the atlas cell, it's worked out when the quad is batched
+    vec4 color = texture(tex, TexCoord);
 
     if(color.a < 0.5) discard;
 
     FragColor = color * vec4(tint, 1);
-} 
\ No newline at end of file
+}
\ No newline at end of file
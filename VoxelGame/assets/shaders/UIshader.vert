@@ -3,11 +3,10 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 
 uniform mat4 ViewProjection;
-uniform mat4 Model;
 
 out vec2 TexCoord;
 
 void main() {
     TexCoord = aTexCoord;
-    gl_Position = ViewProjection * Model * vec4(aPos, 1.0);
+    gl_Position = ViewProjection * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "AllocationTracker.h"
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+namespace {
+	bool s_Tracking;
+	size_t s_Allocations;
+	int64_t s_LiveBytes;
+	int64_t s_PeakBytes;
+
+	// Sizes come from the allocator so frees can be counted without a header on every block
+	size_t AllocationSize(void* memory) {
+#ifdef _WIN32
+		return _msize(memory);
+#else
+		return malloc_usable_size(memory);
+#endif
+	}
+
+	void Free(void* memory) {
+		if (s_Tracking && memory) s_LiveBytes -= AllocationSize(memory);
+		free(memory);
+	}
+}
+
+void AllocationTracker::Begin()
+{
+	s_Allocations = 0;
+	s_LiveBytes = 0;
+	s_PeakBytes = 0;
+	s_Tracking = true;
+}
+
+AllocationStats AllocationTracker::End()
+{
+	s_Tracking = false;
+	return { s_Allocations, s_PeakBytes };
+}
+
+void* operator new(size_t size)
+{
+	void* memory = malloc(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	if (s_Tracking) {
+		s_Allocations += 1;
+		s_LiveBytes += AllocationSize(memory);
+		if (s_LiveBytes > s_PeakBytes) s_PeakBytes = s_LiveBytes;
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	Free(memory);
+}
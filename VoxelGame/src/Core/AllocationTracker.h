@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+struct AllocationStats {
+	size_t allocations;
+	// Most bytes held at once since Begin, including the allocator's rounding
+	int64_t peakBytes;
+};
+
+// Counts what goes through operator new between Begin and End, for benchmarks. Replaces the global
+// operator new and delete, which cost one extra branch while nothing is being tracked
+class AllocationTracker {
+public:
+	static void Begin();
+	static AllocationStats End();
+};
@@ -0,0 +1,232 @@
+#include "Checks.h"
+#include "Core/JSON.h"
+#include "Core/AllocationTracker.h"
+#include "Core/ConfigBinding.h"
+#include "Game/Config.h"
+#include "Game/World.h"
+#include <iostream>
+#include <cstdio>
+#include <chrono>
+
+namespace {
+	int s_Failed;
+
+	void Check(bool passed, const std::string& name) {
+		std::cout << (passed ? "pass " : "FAIL ") << name << std::endl;
+		if (!passed) s_Failed += 1;
+	}
+
+	bool SameTree(const DataTree& a, const DataTree& b, const std::string& path, std::string* difference) {
+		if (a.type != b.type || a.value != b.value) {
+			*difference = path + " ( " + a.value + " vs " + b.value + " )";
+			return false;
+		}
+		if (a.elements.size() != b.elements.size() || a.children.size() != b.children.size()) {
+			*difference = path + " has a different number of children";
+			return false;
+		}
+		for (size_t i = 0; i < a.elements.size(); ++i) {
+			if (!SameTree(a.elements[i], b.elements[i], path + "[" + std::to_string(i) + "]", difference)) return false;
+		}
+		for (auto& [name, child] : a.children) {
+			auto other = b.children.find(name);
+			if (other == b.children.end()) {
+				*difference = path + "." + name + " is missing";
+				return false;
+			}
+			if (!SameTree(child, other->second, path + "." + name, difference)) return false;
+		}
+		return true;
+	}
+
+	// Writes every kind of value with JsonWriter, reads the file back with json::LoadFile
+	// and compares it to the same values built as a DataTree
+	void CheckJsonWriterRoundTrip(bool pretty, size_t bufferSize) {
+		std::string filename = "json_check.json";
+		{
+			JsonWriter writer(filename, pretty, bufferSize);
+			writer.BeginObject();
+			writer.Write("Name", "Voxel World");
+			writer.Write("Path", std::string("userdata/world/"));
+			writer.Write("Seed", -1234);
+			writer.Write("Gravity", 9.81f);
+			writer.Write("Infinite", true);
+			writer.Write("Loaded", false);
+			writer.WriteNull("Spawn");
+			writer.BeginObject("Empty");
+			writer.EndObject();
+			writer.BeginArray("Values");
+			writer.Write("chunk");
+			writer.Write(7);
+			writer.Write(-0.5f);
+			writer.Write(false);
+			writer.WriteNull();
+			writer.BeginArray();
+			writer.Write(1);
+			writer.Write(2);
+			writer.EndArray();
+			writer.BeginObject();
+			writer.Write("Id", 3);
+			writer.EndObject();
+			writer.EndArray();
+			writer.EndObject();
+			writer.Close();
+		}
+
+		DataTree nested(DataTreeType::Array);
+		nested.elements = { DataTree(1), DataTree(2) };
+		DataTree element(DataTreeType::Object);
+		element.children["Id"] = DataTree(3);
+		DataTree values(DataTreeType::Array);
+		values.elements = { DataTree(std::string("chunk")), DataTree(7), DataTree(-0.5f), DataTree(false), DataTree(DataTreeType::Null), nested, element };
+		values.elements[4].value = "null";
+
+		DataTree expected(DataTreeType::Object);
+		expected.children["Name"] = DataTree(std::string("Voxel World"));
+		expected.children["Path"] = DataTree(std::string("userdata/world/"));
+		expected.children["Seed"] = DataTree(-1234);
+		expected.children["Gravity"] = DataTree(9.81f);
+		expected.children["Infinite"] = DataTree(true);
+		expected.children["Loaded"] = DataTree(false);
+		expected.children["Spawn"] = DataTree(DataTreeType::Null);
+		expected.children["Spawn"].value = "null";
+		expected.children["Empty"] = DataTree(DataTreeType::Object);
+		expected.children["Values"] = values;
+
+		DataTree loaded;
+		json::LoadFile(filename, &loaded);
+		std::remove(filename.c_str());
+
+		std::string difference;
+		bool same = SameTree(expected, loaded, "root", &difference);
+		std::string name = std::string("JsonWriter round trip ( ") + (pretty ? "pretty" : "compact") + ", " + std::to_string(bufferSize) + " byte buffer )";
+		Check(same, same ? name : name + ": " + difference);
+	}
+
+	struct SaveResult {
+		double milliseconds;
+		size_t allocations;
+		double peakMB;
+	};
+
+	template<typename Function>
+	SaveResult TimeSave(Function save) {
+		auto start = std::chrono::steady_clock::now();
+		AllocationTracker::Begin();
+		save();
+		AllocationStats stats = AllocationTracker::End();
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return { milliseconds, stats.allocations, stats.peakBytes / (1024.0 * 1024.0) };
+	}
+
+	typedef std::vector<std::vector<std::pair<glm::vec3, uint32_t>>> AlteredVoxels;
+	typedef std::vector<std::pair<glm::vec2, uint32_t>> AlteredChunks;
+
+	// Edits spread over chunks a thousand at a time, the way World keeps them
+	void MakeEdits(uint32_t editCount, AlteredVoxels* alteredVoxels, AlteredChunks* alteredChunks) {
+		const uint32_t editsPerChunk = 1000;
+		alteredVoxels->assign(editCount / editsPerChunk, {});
+		alteredChunks->clear();
+		for (uint32_t chunk = 0; chunk < alteredVoxels->size(); ++chunk) {
+			alteredChunks->push_back({ glm::vec2(chunk % 32, chunk / 32), chunk });
+			for (uint32_t i = 0; i < editsPerChunk; ++i) {
+				(*alteredVoxels)[chunk].push_back({ glm::vec3(i % 16, (i / 16) % 64, i / 1024 + (i % 7)), i % 9 });
+			}
+		}
+	}
+
+	// How SaveWorld used to save, a DataTree with every edit in it handed to json::Serialize
+	void SaveThroughDataTree(const std::string& filename, const AlteredVoxels& alteredVoxels, const AlteredChunks& alteredChunks) {
+		DataTree save(DataTreeType::Object);
+		DataTree voxelLists(DataTreeType::Array);
+		for (auto& voxels : alteredVoxels) {
+			DataTree voxelsData(DataTreeType::Array);
+			for (auto& [position, id] : voxels) {
+				DataTree positionData(DataTreeType::Array);
+				positionData.elements.push_back(position.x);
+				positionData.elements.push_back(position.y);
+				positionData.elements.push_back(position.z);
+
+				DataTree voxelData(DataTreeType::Object);
+				voxelData.children.insert({ "Position", positionData });
+				voxelData.children.insert({ "Id", (int)id });
+				voxelsData.elements.push_back(voxelData);
+			}
+			voxelLists.elements.push_back(voxelsData);
+		}
+		save.children.insert({ "AlteredVoxels", voxelLists });
+
+		DataTree chunks(DataTreeType::Array);
+		for (auto& [position, id] : alteredChunks) {
+			DataTree positionData(DataTreeType::Array);
+			positionData.elements.push_back(position.x);
+			positionData.elements.push_back(position.y);
+
+			DataTree chunkData(DataTreeType::Object);
+			chunkData.children.insert({ "Position", positionData });
+			chunkData.children.insert({ "VoxelListID", (int)id });
+			chunks.elements.push_back(chunkData);
+		}
+		save.children.insert({ "AlteredChunks", chunks });
+		json::Serialize(filename, &save);
+	}
+
+	// Times World::WriteSave on a world with a million edits. The old DataTree save is timed on a tenth of
+	// that, at a million edits it holds about 1.5GB at once. Peak is the most memory the save held at once
+	void BenchmarkWorldSave() {
+		std::string filename = "save_benchmark.json";
+		AlteredVoxels alteredVoxels;
+		AlteredChunks alteredChunks;
+		auto report = [](const char* name, uint32_t editCount, const SaveResult& result) {
+			printf("time %s, %u edits: %.1f ms ( %zu allocations, %.2f MB peak )\n", name, editCount, result.milliseconds, result.allocations, result.peakMB);
+		};
+
+		MakeEdits(100000, &alteredVoxels, &alteredChunks);
+		report("DataTree save", 100000, TimeSave([&]() { SaveThroughDataTree(filename, alteredVoxels, alteredChunks); }));
+		report("World::WriteSave", 100000, TimeSave([&]() { World::WriteSave(filename, alteredVoxels, alteredChunks); }));
+		MakeEdits(1000000, &alteredVoxels, &alteredChunks);
+		report("World::WriteSave", 1000000, TimeSave([&]() { World::WriteSave(filename, alteredVoxels, alteredChunks); }));
+		std::remove(filename.c_str());
+	}
+
+	// What Game::StartUp does with the user config before anything else runs, loading the file and binding it
+	// into UserConfig. Has to be run from the project directory like the game
+	void CheckConfigStartup() {
+		const std::string filename = "userdata/config.json";
+		const int runs = 100;
+		double loadSeconds = 0.0, bindSeconds = 0.0;
+		bool valid = true;
+		for (int i = 0; i < runs; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			DataTree tree;
+			json::LoadFile(filename, &tree);
+			auto loaded = std::chrono::steady_clock::now();
+			UserConfig config;
+			ConfigErrors errors;
+			valid = ConfigBinder::Load(tree, config, errors) && errors.Unknown.empty();
+			auto bound = std::chrono::steady_clock::now();
+
+			loadSeconds += std::chrono::duration<double>(loaded - start).count();
+			bindSeconds += std::chrono::duration<double>(bound - loaded).count();
+		}
+		Check(valid, filename + " binds to UserConfig with no missing, unknown or mistyped keys");
+		printf("time Config startup: %.3f ms to load and parse, %.3f ms to bind ( average of %i )\n",
+			loadSeconds * 1000.0 / runs, bindSeconds * 1000.0 / runs, runs);
+	}
+}
+
+int RunChecks()
+{
+	s_Failed = 0;
+
+	CheckJsonWriterRoundTrip(true, 1 << 16);
+	CheckJsonWriterRoundTrip(false, 1 << 16);
+	// Smaller than most values so every write goes through a flush
+	CheckJsonWriterRoundTrip(true, 4);
+
+	CheckConfigStartup();
+	BenchmarkWorldSave();
+
+	std::cout << (s_Failed ? std::to_string(s_Failed) + " checks failed" : "All checks passed") << std::endl;
+	return s_Failed;
+}
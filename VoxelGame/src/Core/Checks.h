@@ -0,0 +1,4 @@
+#pragma once
+
+// Headless self checks, run with --check. Prints every result and returns the number that failed
+int RunChecks();
@@ -0,0 +1,176 @@
+#pragma once
+#include "Core/Core.h"
+#include "Core/JSON.h"
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <utility>
+#include <string>
+#include <vector>
+
+// Settings structs declare their fields once with a Bind function
+//
+//	template<typename Binder>
+//	void Bind(Binder& b) {
+//		b("ChunkSize", chunkSize);
+//		b("RenderDistance", renderDistance);
+//	}
+//
+// ConfigBinder::Load walks the struct and the data tree together and fills every
+// field directly. Missing, unknown and mistyped keys are collected so they can all
+// be reported at startup instead of one lookup at a time.
+// Structs with a layout Bind can't describe (like positional arrays) can provide
+// ReadConfig(const DataTree&, const std::string& path, ConfigErrors&) instead.
+
+struct ConfigErrors {
+	std::vector<std::string> Missing;
+	std::vector<std::string> Unknown;
+	std::vector<std::string> WrongType;
+
+	// Unknown keys are only a warning, the config can still be used
+	bool IsValid() const { return Missing.empty() && WrongType.empty(); }
+
+	void Report() const {
+		for (auto& key : Missing) SOFT_ERROR("Config is missing key ( " + key + " )");
+		for (auto& key : WrongType) SOFT_ERROR("Config key has the wrong type ( " + key + " )");
+		for (auto& key : Unknown) SOFT_ERROR("Config has unknown key ( " + key + " )");
+	}
+};
+
+class ConfigBinder;
+
+template<typename T, typename = void>
+struct HasConfigBind : std::false_type { };
+template<typename T>
+struct HasConfigBind<T, std::void_t<decltype(std::declval<T&>().Bind(std::declval<ConfigBinder&>()))>> : std::true_type { };
+
+template<typename T, typename = void>
+struct HasConfigRead : std::false_type { };
+template<typename T>
+struct HasConfigRead<T, std::void_t<decltype(std::declval<T&>().ReadConfig(
+	std::declval<const DataTree&>(), std::declval<const std::string&>(), std::declval<ConfigErrors&>()))>> : std::true_type { };
+
+class ConfigBinder {
+public:
+	ConfigBinder(const DataTree& tree, const std::string& path, ConfigErrors& errors)
+		: m_Tree(tree), m_Path(path), m_Errors(errors) { }
+
+	// Fills settings from tree, returns false if any key was missing or had the wrong type
+	template<typename T>
+	static bool Load(const DataTree& tree, T& settings, ConfigErrors& errors, const std::string& path = "") {
+		Read(tree, settings, path, errors);
+		return errors.IsValid();
+	}
+
+	// Required field
+	template<typename T>
+	void operator()(const char* key, T& value) {
+		m_Known.push_back(key);
+		auto it = m_Tree.children.find(key);
+		if (it == m_Tree.children.end()) {
+			m_Errors.Missing.push_back(Join(key));
+			return;
+		}
+		Read(it->second, value, Join(key), m_Errors);
+	}
+	// Optional field, uses fallback when the key doesn't exist
+	template<typename T>
+	void operator()(const char* key, T& value, const T& fallback) {
+		m_Known.push_back(key);
+		auto it = m_Tree.children.find(key);
+		if (it == m_Tree.children.end()) {
+			value = fallback;
+			return;
+		}
+		Read(it->second, value, Join(key), m_Errors);
+	}
+
+	static void Read(const DataTree& tree, int& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Int) {
+			errors.WrongType.push_back(path + " ( expected int )");
+			return;
+		}
+		value = std::stoi(tree.value);
+	}
+	static void Read(const DataTree& tree, float& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Float && tree.type != DataTreeType::Int) {
+			errors.WrongType.push_back(path + " ( expected float )");
+			return;
+		}
+		value = std::stof(tree.value);
+	}
+	static void Read(const DataTree& tree, bool& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Boolean) {
+			errors.WrongType.push_back(path + " ( expected bool )");
+			return;
+		}
+		value = (tree.value == "true");
+	}
+	static void Read(const DataTree& tree, std::string& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::String) {
+			errors.WrongType.push_back(path + " ( expected string )");
+			return;
+		}
+		value = tree.value;
+	}
+	static void Read(const DataTree& tree, glm::vec2& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Array || tree.elements.size() != 2) {
+			errors.WrongType.push_back(path + " ( expected [x, y] )");
+			return;
+		}
+		Read(tree.elements[0], value.x, path + "[0]", errors);
+		Read(tree.elements[1], value.y, path + "[1]", errors);
+	}
+
+	template<typename T>
+	static void Read(const DataTree& tree, std::vector<T>& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Array) {
+			errors.WrongType.push_back(path + " ( expected array )");
+			return;
+		}
+		value.resize(tree.elements.size());
+		for (size_t i = 0; i < tree.elements.size(); ++i) {
+			Read(tree.elements[i], value[i], path + "[" + std::to_string(i) + "]", errors);
+		}
+	}
+
+	template<typename T>
+	static std::enable_if_t<HasConfigBind<T>::value> Read(const DataTree& tree, T& value, const std::string& path, ConfigErrors& errors) {
+		if (tree.type != DataTreeType::Object) {
+			errors.WrongType.push_back((path.empty() ? "root" : path) + " ( expected object )");
+			return;
+		}
+		ConfigBinder binder(tree, path, errors);
+		value.Bind(binder);
+		binder.CheckUnknownKeys();
+	}
+
+	template<typename T>
+	static std::enable_if_t<HasConfigRead<T>::value> Read(const DataTree& tree, T& value, const std::string& path, ConfigErrors& errors) {
+		value.ReadConfig(tree, path, errors);
+	}
+
+private:
+	std::string Join(const char* key) const {
+		if (m_Path.empty()) return key;
+		return m_Path + "." + key;
+	}
+
+	void CheckUnknownKeys() {
+		for (auto& [name, child] : m_Tree.children) {
+			bool known = false;
+			for (auto& key : m_Known) {
+				if (name == key) {
+					known = true;
+					break;
+				}
+			}
+			if (!known) m_Errors.Unknown.push_back(Join(name.c_str()));
+		}
+	}
+
+private:
+	const DataTree& m_Tree;
+	std::string m_Path;
+	ConfigErrors& m_Errors;
+	std::vector<const char*> m_Known;
+};
@@ -1,7 +1,14 @@
 #include <iostream>
+#include <string>
 #include "Core/Application.h"
+#include "Core/Checks.h"
+
+int main(int argc, char** argv) {
+	// --check runs the headless self checks without opening a window
+	if (argc >= 2 && std::string(argv[1]) == "--check") {
+		return RunChecks();
+	}
 
-int main() {
 	Application* app = new Application();
 	app->Run();
 	delete(app);
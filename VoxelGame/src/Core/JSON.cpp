@@ -2,6 +2,8 @@
 #include "Core/System.h"
 #include <imgui.h>
 #include <misc/cpp/imgui_stdlib.h>
+#include <cstdio>
+#include <cstring>
 
 void json::RemoveWhiteSpace(Consumer& consumer) {
 	bool quoteFlag = false; // don't remove spaces inside quotes
@@ -245,58 +247,220 @@ void json::SerializeArray(std::ofstream& file, DataTree* tree, const std::string
 	file << std::endl << std::string(tab.begin(), tab.end() - 1) << "]";
 }
 
-void json::ImGuiInputDataTree(DataTree* tree, const std::string& name, int depthID)
+JsonWriter::JsonWriter(const std::string& filename, bool pretty, size_t bufferSize)
+{
+	m_Filename = filename;
+	m_Pretty = pretty;
+	m_HasKey = false;
+	m_BufferUsed = 0;
+	m_Buffer.resize(bufferSize);
+
+	m_File.open(filename, std::ios::binary);
+	if (!m_File.is_open()) {
+		WARNING("Failed to open file ( " + filename + " )");
+	}
+}
+JsonWriter::~JsonWriter()
+{
+	Close();
+}
+
+void JsonWriter::BeginObject() { OpenScope('{'); }
+void JsonWriter::BeginObject(const std::string& key) { WriteKey(key); OpenScope('{'); }
+void JsonWriter::EndObject() { CloseScope('}'); }
+
+void JsonWriter::BeginArray() { OpenScope('['); }
+void JsonWriter::BeginArray(const std::string& key) { WriteKey(key); OpenScope('['); }
+void JsonWriter::EndArray() { CloseScope(']'); }
+
+void JsonWriter::Write(int value)
+{
+	BeginValue();
+	char str[16];
+	int size = snprintf(str, sizeof(str), "%d", value);
+	Put(str, size);
+}
+void JsonWriter::Write(float value)
+{
+	BeginValue();
+	// Same format as std::to_string so files match json::Serialize
+	char str[64];
+	int size = snprintf(str, sizeof(str), "%f", value);
+	Put(str, size);
+}
+void JsonWriter::Write(bool value)
+{
+	BeginValue();
+	if (value) Put("true", 4);
+	else Put("false", 5);
+}
+void JsonWriter::Write(const std::string& value)
+{
+	BeginValue();
+	Put('\"');
+	Put(value.c_str(), value.size());
+	Put('\"');
+}
+void JsonWriter::Write(const char* value)
+{
+	BeginValue();
+	Put('\"');
+	Put(value, strlen(value));
+	Put('\"');
+}
+void JsonWriter::WriteNull()
+{
+	BeginValue();
+	Put("null", 4);
+}
+
+void JsonWriter::Write(const std::string& key, int value) { WriteKey(key); Write(value); }
+void JsonWriter::Write(const std::string& key, float value) { WriteKey(key); Write(value); }
+void JsonWriter::Write(const std::string& key, bool value) { WriteKey(key); Write(value); }
+void JsonWriter::Write(const std::string& key, const std::string& value) { WriteKey(key); Write(value); }
+void JsonWriter::Write(const std::string& key, const char* value) { WriteKey(key); Write(value); }
+void JsonWriter::WriteNull(const std::string& key) { WriteKey(key); WriteNull(); }
+
+void JsonWriter::Flush()
+{
+	if (m_BufferUsed == 0) return;
+	if (m_File.is_open()) m_File.write(m_Buffer.data(), m_BufferUsed);
+	m_BufferUsed = 0;
+}
+void JsonWriter::Close()
+{
+	if (!m_File.is_open()) return;
+	if (!m_FirstValue.empty()) {
+		WARNING("Closing json file ( " + m_Filename + " ) with unclosed objects or arrays");
+	}
+	Flush();
+	m_File.close();
+}
+
+void JsonWriter::BeginValue()
+{
+	// The key already wrote the separator for this value
+	if (m_HasKey) {
+		m_HasKey = false;
+		return;
+	}
+	if (m_FirstValue.empty()) return;
+
+	if (!m_FirstValue.back()) Put(',');
+	m_FirstValue.back() = false;
+	if (m_Pretty) {
+		Put('\n');
+		PutIndent();
+	}
+}
+void JsonWriter::WriteKey(const std::string& key)
+{
+	BeginValue();
+	Put('\"');
+	Put(key.c_str(), key.size());
+	Put('\"');
+	Put(':');
+	if (m_Pretty) Put(' ');
+	m_HasKey = true;
+}
+void JsonWriter::OpenScope(char c)
+{
+	BeginValue();
+	Put(c);
+	m_FirstValue.push_back(true);
+}
+void JsonWriter::CloseScope(char c)
+{
+	if (m_FirstValue.empty()) {
+		WARNING("Unbalanced end of object or array in ( " + m_Filename + " )");
+		return;
+	}
+	bool empty = m_FirstValue.back();
+	m_FirstValue.pop_back();
+	if (m_Pretty && !empty) {
+		Put('\n');
+		PutIndent();
+	}
+	Put(c);
+}
+
+void JsonWriter::Put(char c)
+{
+	if (m_BufferUsed == m_Buffer.size()) Flush();
+	m_Buffer[m_BufferUsed++] = c;
+}
+void JsonWriter::Put(const char* str, size_t size)
+{
+	if (m_BufferUsed + size > m_Buffer.size()) {
+		Flush();
+		// Bigger than the whole buffer, write it straight to the file
+		if (size > m_Buffer.size()) {
+			if (m_File.is_open()) m_File.write(str, size);
+			return;
+		}
+	}
+	memcpy(&m_Buffer[m_BufferUsed], str, size);
+	m_BufferUsed += size;
+}
+void JsonWriter::PutIndent()
+{
+	for (size_t i = 0; i < m_FirstValue.size(); ++i) Put((char)9);
+}
+
+bool json::ImGuiInputDataTree(DataTree* tree, const std::string& name, int depthID)
 {
 	if (tree->type == DataTreeType::Object) {
+		bool changed = false;
 		if (ImGui::TreeNode((name + std::to_string(depthID)).c_str(), name.c_str())) {
 			int id = 0;
 			for (auto& [name, child] : tree->children) {
 				id += 1;
-				ImGuiInputDataTree(&child, name, depthID + 1);
+				changed |= ImGuiInputDataTree(&child, name, depthID + 1);
 			}
 			ImGui::TreePop();
 		}
-		return;
+		return changed;
 	}
 
 	if (tree->type == DataTreeType::Array) {
+		bool changed = false;
 		if (ImGui::TreeNode((name + std::to_string(depthID)).c_str(), name.c_str())) {
 			int id = 0;
 			for (auto& element : tree->elements) {
 				id += 1;
-				ImGuiInputDataTree(&element, std::to_string(id), depthID + 1);
+				changed |= ImGuiInputDataTree(&element, std::to_string(id), depthID + 1);
 			}
 			ImGui::TreePop();
 		}
-		return;
+		return changed;
 	}
 
 	if (tree->type == DataTreeType::String) {
-		ImGui::InputText(name.c_str(), &tree->value);
-		return;
+		return ImGui::InputText(name.c_str(), &tree->value);
 	}
 	if (tree->type == DataTreeType::Int) {
 		int i = std::stoi(tree->value);
 		ImGui::InputInt(name.c_str(), &i);
-		if (std::stoi(tree->value) != i) tree->value = std::to_string(i);
-		return;
+		if (std::stoi(tree->value) == i) return false;
+		tree->value = std::to_string(i);
+		return true;
 	}
 	if (tree->type == DataTreeType::Float) {
 		float i = std::stof(tree->value);
 		ImGui::InputFloat(name.c_str(), &i);
-		if (std::stof(tree->value) != i) tree->value = std::to_string(i);
-		return;
+		if (std::stof(tree->value) == i) return false;
+		tree->value = std::to_string(i);
+		return true;
 	}
 	if (tree->type == DataTreeType::Boolean) {
 		bool i = tree->value == "true";
 		ImGui::Checkbox(name.c_str(), &i);
-		if ((tree->value == "true") != i) tree->value = (i) ? "true" : "false";
-		return;
+		if ((tree->value == "true") == i) return false;
+		tree->value = (i) ? "true" : "false";
+		return true;
 	}
 	if (tree->type == DataTreeType::Null) {
 		ImGui::Text("s% Null", name.c_str());
-		return;
 	}
+	return false;
 }
-
-
@@ -133,7 +133,8 @@ public:
 	static void Serialize(const std::string& filename, DataTree* tree);
 
 	// add the ability to add/remove nodes
-	static void ImGuiInputDataTree(DataTree* tree, const std::string& name = "", int depthID = 0);
+	// Returns true if any value was changed this frame
+	static bool ImGuiInputDataTree(DataTree* tree, const std::string& name = "", int depthID = 0);
 
 private:
 	static void SerializeObject(std::ofstream& file, DataTree* tree, const std::string& tab = "");
@@ -148,4 +149,64 @@ private:
 	static bool IsNumberValid(std::string& str, DataTreeType& type, Consumer& consumer);
 	static bool IsBooleanValid(std::string& str, Consumer& consumer);
 	static bool IsNullValid(std::string& str, Consumer& consumer);
+};
+
+// Writes json straight to a file without building a DataTree first.
+// Output goes through a large buffer that is only flushed when full or on Close()
+class JsonWriter {
+public:
+	JsonWriter(const std::string& filename, bool pretty = true, size_t bufferSize = 1 << 16);
+	~JsonWriter();
+
+	bool IsOpen() { return m_File.is_open(); }
+
+	void BeginObject();
+	void BeginObject(const std::string& key);
+	void EndObject();
+
+	void BeginArray();
+	void BeginArray(const std::string& key);
+	void EndArray();
+
+	// Array elements
+	void Write(int value);
+	void Write(float value);
+	void Write(bool value);
+	void Write(const std::string& value);
+	// String literals would pick the bool overload without this
+	void Write(const char* value);
+	void WriteNull();
+
+	// Object entries
+	void Write(const std::string& key, int value);
+	void Write(const std::string& key, float value);
+	void Write(const std::string& key, bool value);
+	void Write(const std::string& key, const std::string& value);
+	void Write(const std::string& key, const char* value);
+	void WriteNull(const std::string& key);
+
+	void Flush();
+	void Close();
+
+private:
+	void BeginValue();
+	void WriteKey(const std::string& key);
+	void OpenScope(char c);
+	void CloseScope(char c);
+
+	void Put(char c);
+	void Put(const char* str, size_t size);
+	void PutIndent();
+
+private:
+	std::ofstream m_File;
+	std::string m_Filename;
+
+	std::vector<char> m_Buffer;
+	size_t m_BufferUsed;
+
+	// One entry per open object/array, true until the first value is written
+	std::vector<bool> m_FirstValue;
+	bool m_Pretty;
+	bool m_HasKey;
 };
\ No newline at end of file
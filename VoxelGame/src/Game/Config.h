@@ -0,0 +1,100 @@
+#pragma once
+#include "Game/VoxelRenderer.h"
+#include "Game/Voxel.h"
+#include <string>
+#include <vector>
+
+// Typed mirror of userdata/config.json, filled once at startup by ConfigBinder
+
+struct ShaderSettings {
+	// [ vertex, pixel, geometry ]
+	std::vector<std::string> extention;
+	// [ path, name ]
+	std::vector<std::string> main;
+	std::vector<std::string> UI;
+	std::vector<std::string> selector;
+	std::vector<std::string> postProc;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("Extention", extention);
+		b("Main", main);
+		b("UI", UI);
+		b("Selector", selector);
+		b("PostProc", postProc);
+	}
+};
+
+struct TextureSettings {
+	std::string voxelAtlas;
+	std::string otherAtlas;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("VoxelAtlas", voxelAtlas);
+		b("OtherAtlas", otherAtlas);
+	}
+};
+
+struct RendererConfig {
+	ShaderSettings shaders;
+	TextureSettings textures;
+	VoxelRendererSettings voxelSettings;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("Shaders", shaders);
+		b("Textures", textures);
+		b("VoxelSettings", voxelSettings);
+	}
+};
+
+struct PlayerSettings {
+	float interactLength;
+	float speed;
+	float mouseSensitivity;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("InteractLength", interactLength);
+		b("Speed", speed);
+		b("MouseSensitivity", mouseSensitivity);
+	}
+};
+
+struct WorldSettings {
+	std::string worldType;
+	bool infiniteWorld;
+	std::string saveDirectory;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("WorldType", worldType);
+		b("InfiniteWorld", infiniteWorld);
+		b("SaveDirectory", saveDirectory);
+	}
+};
+
+struct GameSettings {
+	PlayerSettings player;
+	WorldSettings world;
+	std::vector<BlockDefinition> blocks;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("PlayerSettings", player);
+		b("WorldSettings", world);
+		b("BlockSettings", blocks);
+	}
+};
+
+struct UserConfig {
+	RendererConfig renderer;
+	GameSettings game;
+
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("Renderer", renderer);
+		b("Game", game);
+	}
+};
@@ -4,6 +4,7 @@
 #include "Core/Window/Window.h"
 #include "Core/Application.h"
 #include "Core/ImGuiHandler.h"
+#include "Core/ConfigBinding.h"
 
 #include "Game/VoxelRenderer.h"
 #include "Game/Voxel.h"
@@ -19,6 +20,16 @@ void Game::StartUp() {
 
 	json::LoadFile("userdata/config.json", &m_UserConfig);
 
+	// Report every config problem at once before anything uses it
+	ConfigErrors configErrors;
+	bool validConfig = ConfigBinder::Load(m_UserConfig, m_Config, configErrors);
+	configErrors.Report();
+	if (!validConfig) {
+		FATAL_ERROR("Invalid user config ( userdata/config.json )");
+	}
+
+	s_VoxelData = new VoxelData(m_Config.game.blocks);
+
 	VoxelRenderer::Init();
 
 	auto& settings = VoxelRenderer::GetSettings();
@@ -40,6 +51,20 @@ void Game::ShutDown() {
 	delete(m_MainCamera);
 }
 
+void Game::ApplyConfig() {
+	// Bound into a copy so a bad edit doesn't leave the settings half changed
+	UserConfig config;
+	ConfigErrors configErrors;
+	if (!ConfigBinder::Load(m_UserConfig, config, configErrors)) {
+		configErrors.Report();
+		return;
+	}
+	m_Config = config;
+
+	// Player settings apply straight away, everything else is only read at startup
+	m_Player->ApplySettings(m_Config.game.player);
+}
+
 void Game::OnEvent(Event::Event& e) {
 	Event::EventHandler handler(e);
 	handler.Dispatch<Event::WindowResize>(CLASS_BIND_ARGS_1(Game::OnWindowResize));
@@ -84,6 +109,7 @@ void Game::ImGui() {
 
 		ImGui::Text("Draw Call Count: %i", renderInfo->DrawCallCount);
 		ImGui::Text("Clear Count: %i", renderInfo->ClearCount);
+		ImGui::Text("Upload Stalls: %i ( %f MS )", renderInfo->UploadStallCount, renderInfo->UploadStallMS);
 		ImGui::Text("FPS: %f", appInfo->FPS);
 		ImGui::Text("MS: %f", appInfo->MS);
 		ImGui::Text("Update MS: %f", appInfo->UpdateMS);
@@ -95,7 +121,7 @@ void Game::ImGui() {
 
 	m_Player->ImGui();
 
-	json::ImGuiInputDataTree(&m_UserConfig, "User Config");
+	if (json::ImGuiInputDataTree(&m_UserConfig, "User Config")) ApplyConfig();
 
 	if (ImGui::Button("Save Game")) {
 		m_World->SaveWorld();
@@ -9,13 +9,14 @@
 
 #include "Game/Player.h"
 #include "Game/World.h"
+#include "Game/Config.h"
 
 class Game {
 public:
 	Game() { }
 
 	static World* GetWorld() { return s_Instance->m_World; }
-	static DataTree& GetConfig() { return s_Instance->m_UserConfig; }
+	static const UserConfig& GetConfig() { return s_Instance->m_Config; }
 
 	void StartUp();
 	void ShutDown();
@@ -27,6 +28,10 @@ public:
 	void Render();
 	void ImGui();
 
+private:
+	// Binds the raw tree again after it's been edited
+	void ApplyConfig();
+
 private:
 	World* m_World;
 
@@ -34,7 +39,9 @@ private:
 	Camera* m_UICamera;
 	Player* m_Player;
 
+	// Raw tree is kept for the ImGui config editor, edits are bound into m_Config by ApplyConfig
 	DataTree m_UserConfig;
+	UserConfig m_Config;
 
 private:
 	inline static Game* s_Instance;
@@ -11,15 +11,16 @@
 
 Player::Player(Camera* camera)
 {
-	m_SavePath = Game::GetConfig()["Game"]["WorldSettings"]["SaveDirectory"].GetValue();
+	m_SavePath = Game::GetConfig().game.world.saveDirectory;
 	m_SavePath.append("save.json");
-	json::LoadFile(m_SavePath, &m_Save);
+	DataTree save;
+	json::LoadFile(m_SavePath, &save);
 	m_Position = { 
-		(float)m_Save["Player"]["Position"].At(0).GetValue(),
-		(float)m_Save["Player"]["Position"].At(1).GetValue(),
-		(float)m_Save["Player"]["Position"].At(2).GetValue()
+		(float)save["Player"]["Position"].At(0).GetValue(),
+		(float)save["Player"]["Position"].At(1).GetValue(),
+		(float)save["Player"]["Position"].At(2).GetValue()
 	};
-	m_VoxelSelector = (int)m_Save["Player"]["VoxelSelector"].GetValue();
+	m_VoxelSelector = (int)save["Player"]["VoxelSelector"].GetValue();
 
 	m_EyeOffset = { 0,1,0 };
 	m_ColliderSize = { 0.75,1.9,0.75 };
@@ -34,11 +35,14 @@ Player::Player(Camera* camera)
 	m_HasFocus = false;
 	m_FocusLastFrame = false;
 
-	DataTree& playerSettings = Game::GetConfig()["Game"]["PlayerSettings"];
-	m_InteractLength   = playerSettings["InteractLength"].GetValue();
-	m_Speed			   = playerSettings["Speed"].GetValue();
-	m_MouseSensitivity = playerSettings["MouseSensitivity"].GetValue();
+	ApplySettings(Game::GetConfig().game.player);
+}
 
+void Player::ApplySettings(const PlayerSettings& settings)
+{
+	m_InteractLength   = settings.interactLength;
+	m_Speed			   = settings.speed;
+	m_MouseSensitivity = settings.mouseSensitivity;
 }
 
 void Player::OnInput(Event::Event& e)
@@ -195,12 +199,20 @@ void Player::RenderUI()
 
 void Player::Save()
 {
-	m_Save["Player"]["Position"].At(0) = m_Position.x;
-	m_Save["Player"]["Position"].At(1) = m_Position.y;
-	m_Save["Player"]["Position"].At(2) = m_Position.z;
-	m_Save["Player"]["VoxelSelector"] = m_VoxelSelector;
-
-	json::Serialize(m_SavePath, &m_Save);
+	JsonWriter save(m_SavePath);
+	if (!save.IsOpen()) return;
+
+	save.BeginObject();
+	save.BeginObject("Player");
+	save.BeginArray("Position");
+	save.Write(m_Position.x);
+	save.Write(m_Position.y);
+	save.Write(m_Position.z);
+	save.EndArray();
+	save.Write("VoxelSelector", m_VoxelSelector);
+	save.EndObject();
+	save.EndObject();
+	save.Close();
 }
 
 void Player::ImGui()
@@ -5,10 +5,15 @@
 #include "Renderer/Camera.h"
 #include "Core/JSON.h"
 
+struct PlayerSettings;
+
 class Player {
 public:
 	Player(Camera* camera);
 
+	// Called again whenever the config is edited
+	void ApplySettings(const PlayerSettings& settings);
+
 	void OnInput(Event::Event& e);
 	void OnClick(Event::MouseButton& e);
 	void OnScroll(Event::MouseScroll& e);
@@ -30,7 +35,6 @@ private:
 	Camera* m_Camera;
 
 	std::string m_SavePath;
-	DataTree m_Save;
 
 	glm::vec3 m_Position;
 	glm::vec3 m_Direction;
@@ -1,67 +1,47 @@
 #include "Game/Voxel.h"
 #include "Core/JSON.h"
+#include "Core/ConfigBinding.h"
 #include <algorithm>
 
-VoxelData::VoxelData()
+void BlockDefinition::ReadConfig(const DataTree& tree, const std::string& path, ConfigErrors& errors)
+{
+    size_t count = tree.elements.size();
+    if (tree.type != DataTreeType::Array || (count != 5 && count != 7)) {
+        errors.WrongType.push_back(path + " ( expected block array of 5 or 7 elements )");
+        return;
+    }
+
+    ConfigBinder::Read(tree.elements[0], name, path + "[0]", errors);
+    ConfigBinder::Read(tree.elements[1], previewTexture, path + "[1]", errors);
+    ConfigBinder::Read(tree.elements[2], sideTexture, path + "[2]", errors);
+    if (count == 7) {
+        ConfigBinder::Read(tree.elements[3], topTexture, path + "[3]", errors);
+        ConfigBinder::Read(tree.elements[4], bottomTexture, path + "[4]", errors);
+    }
+    else {
+        topTexture = sideTexture;
+        bottomTexture = sideTexture;
+    }
+    ConfigBinder::Read(tree.elements[count - 2], isFoliage, path + "[" + std::to_string(count - 2) + "]", errors);
+    ConfigBinder::Read(tree.elements[count - 1], isTransparent, path + "[" + std::to_string(count - 1) + "]", errors);
+}
+
+VoxelData::VoxelData(const std::vector<BlockDefinition>& blocks)
 {
     // Block data
     {
-        auto index = [](const glm::vec2& pos) { return (uint32_t)(pos.x + 10 * pos.y); };
-
         VoxelInfo.push_back({ 0, false,{0,0},{0,0},{0,0},{0,0},{0,0},{0,0} });
         VoxelPreview.push_back({ 9,15 });
 
-        DataTree data;
-        json::LoadFile("userdata/config.json", &data);
-        DataTree& BlockData = data["Game"]["BlockSettings"];
-        
-        for (auto& block : BlockData.elements) {
-            int count = block.elements.size();
-            if (count == 5) {
-                std::string name = block.At(0).GetValue();
-                glm::vec2 previewTexture = {
-                    (int)block.At(1).At(0).GetValue(),
-                    (int)block.At(1).At(1).GetValue()
-                };
-                glm::vec2 sideTexture = {
-                    (int)block.At(2).At(0).GetValue(),
-                    (int)block.At(2).At(1).GetValue()
-                };
-                bool isFoliage = block.At(3).GetValue();
-                bool isTransparent = block.At(4).GetValue();
-                if (isFoliage) TransparentVoxels.push_back((uint32_t)VoxelInfo.size());
-                if (isTransparent) TransparentVoxels.push_back((uint32_t)VoxelInfo.size());
-                VoxelMap.insert({ name, (uint32_t)VoxelInfo.size() });
-                VoxelInfo.push_back({ (uint32_t)VoxelInfo.size(), isFoliage, sideTexture,sideTexture,sideTexture,sideTexture,sideTexture,sideTexture });
-                VoxelPreview.push_back(previewTexture);
-            }
-            else if (count == 7) {
-                std::string name = block.At(0).GetValue();
-                glm::vec2 previewTexture = {
-                    (int)block.At(1).At(0).GetValue(),
-                    (int)block.At(1).At(1).GetValue()
-                };
-                glm::vec2 sideTexture = {
-                    (int)block.At(2).At(0).GetValue(),
-                    (int)block.At(2).At(1).GetValue()
-                };
-                glm::vec2 topTexture = {
-                    (int)block.At(3).At(0).GetValue(),
-                    (int)block.At(3).At(1).GetValue()
-                };
-                glm::vec2 bottomTexture = {
-                    (int)block.At(4).At(0).GetValue(),
-                    (int)block.At(4).At(1).GetValue()
-                };
-                bool isFoliage = block.At(5).GetValue();
-                bool isTransparent = block.At(6).GetValue();
-                if (isFoliage) TransparentVoxels.push_back((uint32_t)VoxelInfo.size());
-                if (isTransparent) TransparentVoxels.push_back((uint32_t)VoxelInfo.size());
-                VoxelMap.insert({ name, (uint32_t)VoxelInfo.size() });
-                VoxelInfo.push_back({ (uint32_t)VoxelInfo.size(), isFoliage, sideTexture,sideTexture,sideTexture,sideTexture,topTexture,bottomTexture });
-                VoxelPreview.push_back(previewTexture);
-            }
-
+        for (auto& block : blocks) {
+            uint32_t id = (uint32_t)VoxelInfo.size();
+            if (block.isFoliage) TransparentVoxels.push_back(id);
+            if (block.isTransparent) TransparentVoxels.push_back(id);
+            VoxelMap.insert({ block.name, id });
+            VoxelInfo.push_back({ id, block.isFoliage,
+                block.sideTexture, block.sideTexture, block.sideTexture, block.sideTexture,
+                block.topTexture, block.bottomTexture });
+            VoxelPreview.push_back(block.previewTexture);
         }
 
         BlockCount = VoxelInfo.size();
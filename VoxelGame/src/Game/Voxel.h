@@ -3,6 +3,11 @@
 #include <stdint.h>
 #include <glm/glm.hpp>
 #include <map>
+#include <string>
+#include <vector>
+
+struct DataTree;
+struct ConfigErrors;
 
 struct VoxelVertex {
 	glm::vec3 position;
@@ -41,6 +46,22 @@ struct Voxel {
         TopTextureID(Top), BottomTextureID(Bottom) { }
 };
 
+// One entry of Game.BlockSettings in the user config
+// Blocks are stored as arrays, either
+// [ name, preview, side, isFoliage, isTransparent ] or
+// [ name, preview, side, top, bottom, isFoliage, isTransparent ]
+struct BlockDefinition {
+    std::string name;
+    glm::vec2 previewTexture = { 0,0 };
+    glm::vec2 sideTexture = { 0,0 };
+    glm::vec2 topTexture = { 0,0 };
+    glm::vec2 bottomTexture = { 0,0 };
+    bool isFoliage = false;
+    bool isTransparent = false;
+
+    void ReadConfig(const DataTree& tree, const std::string& path, ConfigErrors& errors);
+};
+
 struct VoxelData {
     std::map<std::string, uint32_t> VoxelMap;
     std::vector<Voxel> VoxelInfo;
@@ -106,8 +127,9 @@ struct VoxelData {
         uint32_t* VoxelIndices;
     } Foliage;
 
-    VoxelData();
+    VoxelData(const std::vector<BlockDefinition>& blocks);
 };
-static VoxelData* s_VoxelData = new VoxelData();
+// Created by Game::StartUp once the user config is loaded
+inline VoxelData* s_VoxelData = nullptr;
 
 VertexArray* GetVoxelMesh(uint32_t voxel);
\ No newline at end of file
@@ -14,10 +14,8 @@ void VoxelRenderer::Init()
 	}
 	s_Data = new RendererData();
 
-	DataTree& renderTree = Game::GetConfig()["Renderer"];
-	s_Data->settings.renderDistance = renderTree["VoxelSettings"]["RenderDistance"].GetValue();
-	s_Data->settings.chunkSize = renderTree["VoxelSettings"]["ChunkSize"].GetValue();
-	s_Data->settings.chunkHeight = renderTree["VoxelSettings"]["ChunkHeight"].GetValue();
+	auto& config = Game::GetConfig().renderer;
+	s_Data->settings = config.voxelSettings;
 	s_Data->settings.chunkArea = s_Data->settings.chunkSize * s_Data->settings.chunkSize;
 	s_Data->settings.chunkVolume = s_Data->settings.chunkArea * s_Data->settings.chunkHeight;
 
@@ -30,29 +28,29 @@ void VoxelRenderer::Init()
 
 	// Load Shader
 	{
-		std::string vertex_extention = renderTree["Shaders"]["Extention"].At(0).GetValue();
-		std::string pixel_extention = renderTree["Shaders"]["Extention"].At(1).GetValue();
+		auto& shaders = config.shaders;
+		if (shaders.extention.size() < 2 || shaders.main.empty() || shaders.UI.empty() || shaders.selector.empty() || shaders.postProc.empty()) {
+			FATAL_ERROR("Shader config is missing entries");
+		}
+		const std::string& vertex_extention = shaders.extention[0];
+		const std::string& pixel_extention = shaders.extention[1];
 
 		ShaderConfig shaderConfig;
 
-		std::string path = renderTree["Shaders"]["Main"].At(0).GetValue();
-		shaderConfig.vertexShader = path + vertex_extention;
-		shaderConfig.pixelShader = path + pixel_extention;
+		shaderConfig.vertexShader = shaders.main[0] + vertex_extention;
+		shaderConfig.pixelShader = shaders.main[0] + pixel_extention;
 		s_Data->mainShader = new Shader(shaderConfig);
 
-		path = renderTree["Shaders"]["UI"].At(0).GetValue();
-		shaderConfig.vertexShader = path + vertex_extention;
-		shaderConfig.pixelShader = path + pixel_extention;
+		shaderConfig.vertexShader = shaders.UI[0] + vertex_extention;
+		shaderConfig.pixelShader = shaders.UI[0] + pixel_extention;
 		s_Data->UIShader = new Shader(shaderConfig);
 
-		path = renderTree["Shaders"]["Selector"].At(0).GetValue();
-		shaderConfig.vertexShader = path + vertex_extention;
-		shaderConfig.pixelShader = path + pixel_extention;
+		shaderConfig.vertexShader = shaders.selector[0] + vertex_extention;
+		shaderConfig.pixelShader = shaders.selector[0] + pixel_extention;
 		s_Data->selectorShader = new Shader(shaderConfig);
 
-		path = renderTree["Shaders"]["PostProc"].At(0).GetValue();
-		shaderConfig.vertexShader = path + vertex_extention;
-		shaderConfig.pixelShader = path + pixel_extention;
+		shaderConfig.vertexShader = shaders.postProc[0] + vertex_extention;
+		shaderConfig.pixelShader = shaders.postProc[0] + pixel_extention;
 		s_Data->postProcShader = new Shader(shaderConfig);
 	}
 
@@ -62,11 +60,11 @@ void VoxelRenderer::Init()
 		textureConfig.slot = 0;
 		textureConfig.minFilter = TexFilterMode::Nearest;
 		textureConfig.magFilter = TexFilterMode::Nearest;
-		s_Data->voxelAtlas = new Texture("assets/tilemap.png", textureConfig);
-		s_Data->otherAtlas = new Texture("assets/MiscAtlas.png", textureConfig);
+		s_Data->voxelAtlas = new Texture(config.textures.voxelAtlas, textureConfig);
+		s_Data->otherAtlas = new Texture(config.textures.otherAtlas, textureConfig);
 	}
 
-	// Load Quad ( used for ui )
+	// Load Quad ( used for post processing )
 	{
 		struct vertex {
 			glm::vec3 position;
@@ -159,6 +157,33 @@ void VoxelRenderer::Init()
 		s_Data->selector->Unbind();
 	}
 
+	// Load UI quads, vertices are written every frame and the indices never change
+	{
+		s_Data->UIVertices = new RingBuffer(MAX_UI_QUADS * 4 * sizeof(UIVertex));
+
+		std::vector<uint32_t> indices;
+		indices.reserve(MAX_UI_QUADS * 6);
+		for (uint32_t quad = 0; quad < MAX_UI_QUADS; ++quad) {
+			uint32_t first = quad * 4;
+			uint32_t pattern[] = { 0, 3, 1, 1, 3, 2 };
+			for (uint32_t index : pattern) indices.push_back(first + index);
+		}
+
+		s_Data->UIQuads = new VertexArray();
+		s_Data->UIQuads->Bind();
+
+		s_Data->UIVertices->Bind();
+		VertexLayout({ DataType::Float3, DataType::Float2 }).SetAttributes();
+
+		ElementBuffer* ebo = new ElementBuffer();
+		ebo->SetData(indices);
+		ebo->Initialize();
+		s_Data->UIQuads->AttachBuffer(ebo);
+
+		s_Data->UIQuads->Unbind();
+		s_Data->UIVertices->Unbind();
+	}
+
 	GenerateVoxelPreview();
 
 	FrameBuffer::Config frameBufferConfig;
@@ -185,6 +210,11 @@ void VoxelRenderer::StartFrame(Camera* camera)
 
 	s_Data->currentCamera = camera;
 
+	s_Data->UIVertices->BeginFrame();
+	s_Data->UIDraws.clear();
+	renderInfo->UploadStallCount = s_Data->UIVertices->GetStallCount();
+	renderInfo->UploadStallMS = s_Data->UIVertices->GetStallMS();
+
 	RenderAPI::ClearColor({ (102.0f / 255.0f), (178.0f / 255.0f), 1, 1 });
 	RenderAPI::SetClearMask(ClearMask::ColorBufferBit | ClearMask::DepthBufferBit);
 	RenderAPI::Clear();
@@ -212,6 +242,9 @@ void VoxelRenderer::StartUIFrame(Camera* camera)
 }
 void VoxelRenderer::EndFrame()
 {
+	DrawUI();
+	s_Data->UIVertices->EndFrame();
+
 	s_Data->postProcBuffer->Unbind();
 
 	s_Data->postProcShader->Bind();
@@ -316,20 +349,49 @@ void VoxelRenderer::DrawUIElement(const glm::vec2& offset, uint32_t alignment, c
 
 	position += glm::vec3(offset, 0);
 
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, position);
-	model = glm::scale(model, glm::vec3(scale, 1));
+	uint32_t vertexOffset;
+	UIVertex* vertices = (UIVertex*)s_Data->UIVertices->Allocate(4 * sizeof(UIVertex), sizeof(UIVertex), &vertexOffset);
+	if (!vertices) {
+		WARNING("Too many UI elements in one frame ( " + std::to_string(MAX_UI_QUADS) + " max )");
+		return;
+	}
 
-	s_Data->UIShader->SetUniform("Model",     (void*)&model);
-	s_Data->UIShader->SetUniform("TextureID", (void*)&textureID);
-	s_Data->UIShader->SetUniform("AtlasSize", (void*)&size);
-	s_Data->UIShader->SetUniform("tex",		  (void*)&texture);
+	// Same corners as the quad, atlas rows are counted from the top
+	glm::vec2 corners[] = { { 1, 1 }, { 1, -1 }, { -1, -1 }, { -1, 1 } };
+	glm::vec2 cellSize = 1.0f / size;
+	glm::vec2 cellStart = { textureID.x * cellSize.x, ((size.y - 1) - textureID.y) * cellSize.y };
+	for (int i = 0; i < 4; ++i) {
+		vertices[i].position = position + glm::vec3(corners[i] * scale, 0);
+		vertices[i].texCoord = cellStart + ((corners[i] + 1.0f) * 0.5f) * cellSize;
+	}
 
-	texture->Bind();
-	s_Data->quad->Bind();
-	RenderAPI::DrawElements(6, DataType::UnsignedInt, NULL);
-	s_Data->quad->Unbind();
-	texture->Unbind();
+	uint32_t baseVertex = vertexOffset / sizeof(UIVertex);
+	if (!s_Data->UIDraws.empty()) {
+		UIDraw& last = s_Data->UIDraws.back();
+		if (last.texture == texture && last.baseVertex + last.quadCount * 4 == baseVertex) {
+			last.quadCount += 1;
+			return;
+		}
+	}
+	s_Data->UIDraws.push_back({ texture, baseVertex, 1 });
+}
+
+void VoxelRenderer::DrawUI()
+{
+	if (s_Data->UIDraws.empty()) return;
+	s_Data->UIVertices->Flush();
+
+	s_Data->UIShader->Bind();
+	s_Data->UIQuads->Bind();
+	for (UIDraw& draw : s_Data->UIDraws) {
+		s_Data->UIShader->SetUniform("tex", (void*)draw.texture);
+
+		draw.texture->Bind();
+		RenderAPI::DrawElementsBaseVertex(draw.quadCount * 6, DataType::UnsignedInt, NULL, draw.baseVertex);
+		draw.texture->Unbind();
+	}
+	s_Data->UIQuads->Unbind();
+	s_Data->UIShader->Unbind();
 }
 
 void VoxelRenderer::GenerateVoxelPreview()
@@ -3,9 +3,13 @@
 #include "Renderer/Shader.h"
 #include "Renderer/Texture.h"
 #include "Renderer/VertexArray.h"
+#include "Renderer/RingBuffer.h"
 
 #include "Game/Chunk.h"
 
+// Most UI elements drawn in one frame
+#define MAX_UI_QUADS 1024
+
 enum Alignment {
 	AlignMiddle = BIT(0),
 	AlignLeft = BIT(1),
@@ -22,6 +26,14 @@ public:
 	int chunkVolume;
 
 	int renderDistance;
+
+	// chunkArea and chunkVolume are derived from the bound values
+	template<typename Binder>
+	void Bind(Binder& b) {
+		b("ChunkSize", chunkSize);
+		b("ChunkHeight", chunkHeight);
+		b("RenderDistance", renderDistance);
+	}
 };
 
 class VoxelRenderer {
@@ -51,6 +63,20 @@ public:
 	static void GenerateVoxelPreview();
 
 private:
+	static void DrawUI();
+
+private:
+	struct UIVertex {
+		glm::vec3 position;
+		glm::vec2 texCoord;
+	};
+	// UI quads next to each other in the ring buffer that use the same texture
+	struct UIDraw {
+		Texture* texture;
+		uint32_t baseVertex;
+		uint32_t quadCount;
+	};
+
 	struct RendererData {
 		VoxelRendererSettings settings;
 
@@ -71,6 +97,11 @@ private:
 		Texture* otherAtlas;
 
 		std::vector<Texture*> voxelPreviews;
+
+		// UI elements are batched and drawn at the end of the frame
+		RingBuffer* UIVertices;
+		VertexArray* UIQuads;
+		std::vector<UIDraw> UIDraws;
 	};
 	inline static RendererData* s_Data;
 };
\ No newline at end of file
@@ -14,9 +14,9 @@ World::World(Player* player)
 	};
 	m_ViewBox.lastPos = { 0,0 };
 
-	DataTree& worldSettings = Game::GetConfig()["Game"]["WorldSettings"];
-	m_SaveLocation = worldSettings["SaveDirectory"].GetValue();
-	m_InfiniteWorld = worldSettings["InfiniteWorld"].GetValue();
+	auto& worldSettings = Game::GetConfig().game.world;
+	m_SaveLocation = worldSettings.saveDirectory;
+	m_InfiniteWorld = worldSettings.infiniteWorld;
 	m_SaveLocation.append("worldData.json");
 }
 
@@ -224,42 +224,48 @@ void World::PushAlteredVoxel(const glm::vec2& chunkPos, const glm::vec3& positio
 
 void World::SaveWorld()
 {
-	DataTree save(DataTreeType::Object);
+	WriteSave(m_SaveLocation, m_AlteredVoxels, m_AlteredChunks);
+}
 
-	DataTree alteredVoxels(DataTreeType::Array);
-	for (auto& voxels : m_AlteredVoxels) {
-		DataTree voxelsData(DataTreeType::Array);
-		for (auto& [position, id] : voxels) {
-			DataTree positionData(DataTreeType::Array);
-			positionData.elements.push_back(position.x);
-			positionData.elements.push_back(position.y);
-			positionData.elements.push_back(position.z);
+void World::WriteSave(const std::string& path, const std::vector<std::vector<std::pair<glm::vec3, uint32_t>>>& alteredVoxels,
+	const std::vector<std::pair<glm::vec2, uint32_t>>& alteredChunks)
+{
+	JsonWriter save(path);
+	if (!save.IsOpen()) return;
 
-			DataTree voxelData(DataTreeType::Object);
-			voxelData.children.insert({ "Position", positionData });
-			voxelData.children.insert({ "Id", (int)id });
+	save.BeginObject();
 
-			voxelsData.elements.push_back(voxelData);
+	save.BeginArray("AlteredVoxels");
+	for (auto& voxels : alteredVoxels) {
+		save.BeginArray();
+		for (auto& [position, id] : voxels) {
+			save.BeginObject();
+			save.Write("Id", (int)id);
+			save.BeginArray("Position");
+			save.Write(position.x);
+			save.Write(position.y);
+			save.Write(position.z);
+			save.EndArray();
+			save.EndObject();
 		}
-		alteredVoxels.elements.push_back(voxelsData);
+		save.EndArray();
 	}
-	save.children.insert({ "AlteredVoxels", alteredVoxels });
-
-	DataTree alteredChunks(DataTreeType::Array);
-	for (auto& [position, id] : m_AlteredChunks) {
-		DataTree positionData(DataTreeType::Array);
-		positionData.elements.push_back(position.x);
-		positionData.elements.push_back(position.y);
-
-		DataTree chunkData(DataTreeType::Object);
-		chunkData.children.insert({ "Position", positionData });
-		chunkData.children.insert({ "VoxelListID", (int)id });
-
-		alteredChunks.elements.push_back(chunkData);
+	save.EndArray();
+
+	save.BeginArray("AlteredChunks");
+	for (auto& [position, id] : alteredChunks) {
+		save.BeginObject();
+		save.BeginArray("Position");
+		save.Write(position.x);
+		save.Write(position.y);
+		save.EndArray();
+		save.Write("VoxelListID", (int)id);
+		save.EndObject();
 	}
-	save.children.insert({ "AlteredChunks", alteredChunks });
+	save.EndArray();
 
-	json::Serialize(m_SaveLocation, &save);
+	save.EndObject();
+	save.Close();
 }
 
 void World::SetVoxel(const glm::vec3& position, uint32_t voxelID)
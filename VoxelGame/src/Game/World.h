@@ -19,6 +19,9 @@ public:
 	void PushAlteredVoxel(const glm::vec2& chunkPos, const glm::vec3& position, uint32_t voxelID);
 	
 	void SaveWorld();
+	// Streams edits to path in the world save format, static so it can be timed without a world
+	static void WriteSave(const std::string& path, const std::vector<std::vector<std::pair<glm::vec3, uint32_t>>>& alteredVoxels,
+		const std::vector<std::pair<glm::vec2, uint32_t>>& alteredChunks);
 
 	void SetVoxel(const glm::vec3& position, uint32_t voxelID);
 	uint32_t GetVoxel(const glm::vec3& position);
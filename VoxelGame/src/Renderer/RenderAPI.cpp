@@ -263,3 +263,10 @@ void RenderAPI::DrawElements(uint32_t count, DataType type, const void* indices)
 	s_DiagnosticInstance->DrawCallCount += 1;
 #endif
 }
+void RenderAPI::DrawElementsBaseVertex(uint32_t count, DataType type, const void* indices, int32_t baseVertex)
+{
+	glDrawElementsBaseVertex(s_Data->drawMode, count, GL_DataType(type), (void*)indices, baseVertex);
+#ifdef DEBUG
+	s_DiagnosticInstance->DrawCallCount += 1;
+#endif
+}
\ No newline at end of file
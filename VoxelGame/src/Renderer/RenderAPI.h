@@ -6,6 +6,9 @@
 struct RenderAPIDiagnostic {
 	int DrawCallCount = 0;
 	int ClearCount    = 0;
+	// Times a ring buffer had to wait for the GPU, and how long it waited in total
+	int UploadStallCount = 0;
+	float UploadStallMS  = 0.0f;
 };
 
 class RenderAPI {
@@ -26,6 +29,7 @@ public:
 
 	static void SetDrawMode(DrawMode mode);
 	static void DrawElements(uint32_t count, DataType type, const void* indices);
+	static void DrawElementsBaseVertex(uint32_t count, DataType type, const void* indices, int32_t baseVertex);
 
 private:
 	struct RenderAPIData {